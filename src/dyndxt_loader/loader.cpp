@@ -32,7 +32,8 @@ namespace DynDXTLoader {
 constexpr const char kLoggingTagTracer[] = "DDXTLOADER";
 #define LOG_LOADER(lvl) LOG_TAGGED(lvl, kLoggingTagTracer)
 
-static bool SetMemoryUnsafe(const std::shared_ptr<XBDMContext>& context,
+static bool SetMemoryUnsafe(const std::shared_ptr<XBDMDebugger>& debugger,
+                            const std::shared_ptr<XBDMContext>& context,
                             uint32_t address, const std::vector<uint8_t>& data);
 static bool InvokeL1Bootstrap(const std::shared_ptr<XBDMContext>& context,
                               const uint32_t parameter);
@@ -153,7 +154,7 @@ bool Loader::InjectLoader(XBOXInterface& base_interface) {
     return false;
   }
 
-  if (!SetMemoryUnsafe(xbdm, kDmResumeThread, bootstrap_l1)) {
+  if (!SetMemoryUnsafe(debugger, xbdm, kDmResumeThread, bootstrap_l1)) {
     LOG_LOADER(error) << "Failed to patch target function with l1 bootstrap.";
     return false;
   }
@@ -165,7 +166,8 @@ bool Loader::InjectLoader(XBOXInterface& base_interface) {
   }
 
 cleanup:
-  if (!SetMemoryUnsafe(xbdm, kDmResumeThread, original_function.value())) {
+  if (!SetMemoryUnsafe(debugger, xbdm, kDmResumeThread,
+                       original_function.value())) {
     LOG_LOADER(error) << "Failed to restore target function.";
     return false;
   }
@@ -204,7 +206,7 @@ bool Loader::InstallL2Loader(const std::shared_ptr<XBDMDebugger>& debugger,
 
   // Upload the L2 bootloader.
   auto load_start = std::chrono::high_resolution_clock::now();
-  if (!SetMemoryUnsafe(context, l2_entrypoint, bootstrap_l2)) {
+  if (!SetMemoryUnsafe(debugger, context, l2_entrypoint, bootstrap_l2)) {
     LOG_LOADER(error) << "Failed to upload l2 bootstrap loader.";
     return false;
   }
@@ -218,7 +220,7 @@ bool Loader::InstallL2Loader(const std::shared_ptr<XBDMDebugger>& debugger,
                    << ((double)bootstrap_l2.size() * 1000 / elapsed) << " Bps.";
 
   // Instruct the L1 loader to call into the memory allocated by the call above.
-  if (!SetL1LoaderExecuteMode(context)) {
+  if (!SetL1LoaderExecuteMode(debugger, context)) {
     // TODO: Free pool.
     return false;
   }
@@ -373,7 +375,11 @@ bool Loader::InstallDynamicDXTLoader(XBOXInterface& base_interface) {
     return false;
   }
 
-  if (!L2BootstrapInstall(interface, lib.GetEntrypoint(), lib.GetImage())) {
+  bool installed =
+      L2BootstrapInstall(interface, lib.GetEntrypoint(), lib.GetImage());
+  // The image is written by the target itself rather than via SetMem.
+  debugger->InvalidateCode(target, lib.GetImageSize());
+  if (!installed) {
     // TODO: Free pool.
     return false;
   }
@@ -399,7 +405,7 @@ uint32_t Loader::L1BootstrapAllocatePool(
   {
     auto data = reinterpret_cast<uint8_t*>(&size);
     std::vector<uint8_t> size_request(data, data + 4);
-    if (!SetMemoryUnsafe(context, io_address, size_request)) {
+    if (!SetMemoryUnsafe(debugger, context, io_address, size_request)) {
       LOG_LOADER(error) << "Failed to set allocation size.";
       return 0;
     }
@@ -410,6 +416,8 @@ uint32_t Loader::L1BootstrapAllocatePool(
     LOG_LOADER(error) << "Failed to allocate memory.";
     return 0;
   }
+  // The L1 bootstrap stores the allocated address within its own code.
+  debugger->InvalidateCode(io_address, 4);
 
   // The target address is stored in the last 4 bytes of the L1 bootloader.
   auto target_address = debugger->GetDWORD(io_address);
@@ -423,6 +431,7 @@ uint32_t Loader::L1BootstrapAllocatePool(
 }
 
 bool Loader::SetL1LoaderExecuteMode(
+    const std::shared_ptr<XBDMDebugger>& debugger,
     const std::shared_ptr<XBDMContext>& context) const {
   // Set the L1 loader into execute mode.
   const uint32_t io_address =
@@ -431,7 +440,7 @@ bool Loader::SetL1LoaderExecuteMode(
   uint32_t size = 0;
   auto data = reinterpret_cast<uint8_t*>(&size);
   std::vector<uint8_t> size_request(data, data + 4);
-  if (!SetMemoryUnsafe(context, io_address, size_request)) {
+  if (!SetMemoryUnsafe(debugger, context, io_address, size_request)) {
     LOG_LOADER(error) << "Failed to set L1 loader to execute mode.";
     return false;
   }
@@ -621,12 +630,16 @@ uint32_t Loader::GetExport(const std::string& module, uint32_t ordinal) const {
   return entry->second;
 }
 
-static bool SetMemoryUnsafe(const std::shared_ptr<XBDMContext>& context,
+static bool SetMemoryUnsafe(const std::shared_ptr<XBDMDebugger>& debugger,
+                            const std::shared_ptr<XBDMContext>& context,
                             uint32_t address,
                             const std::vector<uint8_t>& data) {
+  // The data patches code, so the debugger's cached disassembly of each
+  // written range must be discarded as it is written.
   if (data.size() <= SetMem::kMaximumDataSize) {
     auto request = std::make_shared<SetMem>(address, data);
     context->SendCommandSync(request);
+    debugger->InvalidateCode(address, data.size());
     return request->IsOK();
   }
 
@@ -636,6 +649,7 @@ static bool SetMemoryUnsafe(const std::shared_ptr<XBDMContext>& context,
     std::vector<uint8_t> slice(first, last);
     auto request = std::make_shared<SetMem>(address, slice);
     context->SendCommandSync(request);
+    debugger->InvalidateCode(address, slice.size());
     if (!request->IsOK()) {
       return false;
     }
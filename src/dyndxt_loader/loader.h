@@ -50,6 +50,7 @@ class Loader {
       const std::shared_ptr<XBDMContext>& context, uint32_t size) const;
 
   [[nodiscard]] bool SetL1LoaderExecuteMode(
+      const std::shared_ptr<XBDMDebugger>& debugger,
       const std::shared_ptr<XBDMContext>& context) const;
 
   // Resolves a list of import thunks to actual addresses on the XBOX.
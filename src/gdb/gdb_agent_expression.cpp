@@ -0,0 +1,472 @@
+#include "gdb_agent_expression.h"
+
+#include <algorithm>
+#include <boost/algorithm/hex.hpp>
+#include <cstdio>
+#include <iterator>
+
+namespace {
+
+// Opcodes from gdb/common/ax.def.
+enum Opcode : uint8_t {
+  OP_FLOAT = 0x01,
+  OP_ADD = 0x02,
+  OP_SUB = 0x03,
+  OP_MUL = 0x04,
+  OP_DIV_SIGNED = 0x05,
+  OP_DIV_UNSIGNED = 0x06,
+  OP_REM_SIGNED = 0x07,
+  OP_REM_UNSIGNED = 0x08,
+  OP_LSH = 0x09,
+  OP_RSH_SIGNED = 0x0A,
+  OP_RSH_UNSIGNED = 0x0B,
+  OP_TRACE = 0x0C,
+  OP_TRACE_QUICK = 0x0D,
+  OP_LOG_NOT = 0x0E,
+  OP_BIT_AND = 0x0F,
+  OP_BIT_OR = 0x10,
+  OP_BIT_XOR = 0x11,
+  OP_BIT_NOT = 0x12,
+  OP_EQUAL = 0x13,
+  OP_LESS_SIGNED = 0x14,
+  OP_LESS_UNSIGNED = 0x15,
+  OP_EXT = 0x16,
+  OP_REF8 = 0x17,
+  OP_REF16 = 0x18,
+  OP_REF32 = 0x19,
+  OP_REF64 = 0x1A,
+  OP_IF_GOTO = 0x20,
+  OP_GOTO = 0x21,
+  OP_CONST8 = 0x22,
+  OP_CONST16 = 0x23,
+  OP_CONST32 = 0x24,
+  OP_CONST64 = 0x25,
+  OP_REG = 0x26,
+  OP_END = 0x27,
+  OP_DUP = 0x28,
+  OP_POP = 0x29,
+  OP_ZERO_EXT = 0x2A,
+  OP_SWAP = 0x2B,
+  OP_TRACEV = 0x2E,
+  OP_TRACENZ = 0x2F,
+  OP_TRACE16 = 0x30,
+  OP_PICK = 0x32,
+  OP_ROT = 0x33,
+};
+
+}  // namespace
+
+std::optional<GDBAgentExpression> GDBAgentExpression::Parse(
+    const std::string& encoded) {
+  size_t offset = 0;
+  auto ret = Parse(encoded, offset);
+  if (offset != encoded.size()) {
+    return std::nullopt;
+  }
+  return ret;
+}
+
+std::optional<std::vector<GDBAgentExpression>> GDBAgentExpression::ParseList(
+    const std::string& encoded) {
+  std::vector<GDBAgentExpression> ret;
+  size_t offset = 0;
+  while (offset < encoded.size()) {
+    auto expression = Parse(encoded, offset);
+    if (!expression) {
+      return std::nullopt;
+    }
+    ret.push_back(std::move(*expression));
+  }
+  return ret;
+}
+
+std::optional<GDBAgentExpression> GDBAgentExpression::Parse(
+    const std::string& encoded, size_t& offset) {
+  if (offset + 1 >= encoded.size() || encoded[offset] != 'X') {
+    return std::nullopt;
+  }
+
+  auto comma = encoded.find(',', offset);
+  if (comma == std::string::npos || comma == offset + 1) {
+    return std::nullopt;
+  }
+
+  char* end = nullptr;
+  auto length = strtoul(encoded.c_str() + offset + 1, &end, 16);
+  if (end != encoded.c_str() + comma) {
+    return std::nullopt;
+  }
+
+  auto hex_start = comma + 1;
+  if (encoded.size() - hex_start < length * 2) {
+    return std::nullopt;
+  }
+
+  std::vector<uint8_t> bytecode;
+  bytecode.reserve(length);
+  try {
+    auto begin = encoded.begin() + static_cast<ptrdiff_t>(hex_start);
+    boost::algorithm::unhex(begin, begin + static_cast<ptrdiff_t>(length * 2),
+                            std::back_inserter(bytecode));
+  } catch (boost::algorithm::hex_decode_error&) {
+    return std::nullopt;
+  }
+
+  offset = hex_start + length * 2;
+  return GDBAgentExpression(std::move(bytecode));
+}
+
+std::expected<int64_t, std::string> GDBAgentExpression::Evaluate(
+    const RegisterReader& read_register, const MemoryReader& read_memory,
+    const MemoryCollector& collect_memory) const {
+  std::vector<int64_t> stack;
+  size_t pc = 0;
+
+  auto fetch_operand = [this, &pc](size_t bytes, uint64_t& value) {
+    if (pc + bytes > bytecode_.size()) {
+      return false;
+    }
+    // Operands are big endian.
+    value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+      value = (value << 8) | bytecode_[pc++];
+    }
+    return true;
+  };
+
+#define POP(var)                                                  \
+  if (stack.empty()) {                                            \
+    return std::unexpected("Stack underflow at offset " +         \
+                           std::to_string(pc - 1));               \
+  }                                                               \
+  int64_t var = stack.back();                                     \
+  stack.pop_back()
+
+#define PUSH(value)                                               \
+  if (stack.size() >= kMaxStackDepth) {                           \
+    return std::unexpected(std::string("Stack overflow"));        \
+  }                                                               \
+  stack.push_back(value)
+
+#define OPERAND(bytes, var)                                       \
+  uint64_t var;                                                   \
+  if (!fetch_operand(bytes, var)) {                               \
+    return std::unexpected(std::string("Truncated operand"));     \
+  }
+
+  for (uint32_t executed = 0; executed < kMaxInstructions; ++executed) {
+    if (pc >= bytecode_.size()) {
+      return std::unexpected(std::string("Expression has no end opcode"));
+    }
+
+    uint8_t opcode = bytecode_[pc++];
+    switch (opcode) {
+      case OP_ADD: {
+        POP(b);
+        POP(a);
+        PUSH(static_cast<int64_t>(static_cast<uint64_t>(a) +
+                                  static_cast<uint64_t>(b)));
+      } break;
+
+      case OP_SUB: {
+        POP(b);
+        POP(a);
+        PUSH(static_cast<int64_t>(static_cast<uint64_t>(a) -
+                                  static_cast<uint64_t>(b)));
+      } break;
+
+      case OP_MUL: {
+        POP(b);
+        POP(a);
+        PUSH(static_cast<int64_t>(static_cast<uint64_t>(a) *
+                                  static_cast<uint64_t>(b)));
+      } break;
+
+      case OP_DIV_SIGNED:
+      case OP_DIV_UNSIGNED:
+      case OP_REM_SIGNED:
+      case OP_REM_UNSIGNED: {
+        POP(b);
+        POP(a);
+        if (!b) {
+          return std::unexpected(std::string("Division by zero"));
+        }
+        auto ua = static_cast<uint64_t>(a);
+        auto ub = static_cast<uint64_t>(b);
+        if (opcode == OP_DIV_SIGNED) {
+          PUSH(b == -1 ? static_cast<int64_t>(0 - ua) : a / b);
+        } else if (opcode == OP_DIV_UNSIGNED) {
+          PUSH(static_cast<int64_t>(ua / ub));
+        } else if (opcode == OP_REM_SIGNED) {
+          PUSH(b == -1 ? 0 : a % b);
+        } else {
+          PUSH(static_cast<int64_t>(ua % ub));
+        }
+      } break;
+
+      case OP_LSH: {
+        POP(b);
+        POP(a);
+        // Counts are treated as unsigned so that negative values are out of
+        // range rather than undefined.
+        auto count = static_cast<uint64_t>(b);
+        PUSH(count >= 64
+                 ? 0
+                 : static_cast<int64_t>(static_cast<uint64_t>(a) << count));
+      } break;
+
+      case OP_RSH_SIGNED: {
+        POP(b);
+        POP(a);
+        auto count = static_cast<uint64_t>(b);
+        PUSH(a >> std::min<uint64_t>(count, 63));
+      } break;
+
+      case OP_RSH_UNSIGNED: {
+        POP(b);
+        POP(a);
+        auto count = static_cast<uint64_t>(b);
+        PUSH(count >= 64
+                 ? 0
+                 : static_cast<int64_t>(static_cast<uint64_t>(a) >> count));
+      } break;
+
+      case OP_LOG_NOT: {
+        POP(a);
+        PUSH(!a);
+      } break;
+
+      case OP_BIT_AND: {
+        POP(b);
+        POP(a);
+        PUSH(a & b);
+      } break;
+
+      case OP_BIT_OR: {
+        POP(b);
+        POP(a);
+        PUSH(a | b);
+      } break;
+
+      case OP_BIT_XOR: {
+        POP(b);
+        POP(a);
+        PUSH(a ^ b);
+      } break;
+
+      case OP_BIT_NOT: {
+        POP(a);
+        PUSH(~a);
+      } break;
+
+      case OP_EQUAL: {
+        POP(b);
+        POP(a);
+        PUSH(a == b);
+      } break;
+
+      case OP_LESS_SIGNED: {
+        POP(b);
+        POP(a);
+        PUSH(a < b);
+      } break;
+
+      case OP_LESS_UNSIGNED: {
+        POP(b);
+        POP(a);
+        PUSH(static_cast<uint64_t>(a) < static_cast<uint64_t>(b));
+      } break;
+
+      case OP_EXT:
+      case OP_ZERO_EXT: {
+        OPERAND(1, bits);
+        POP(a);
+        if (bits && bits < 64) {
+          uint32_t shift = 64 - bits;
+          if (opcode == OP_EXT) {
+            a = static_cast<int64_t>(static_cast<uint64_t>(a) << shift) >>
+                shift;
+          } else {
+            a = static_cast<int64_t>(static_cast<uint64_t>(a) &
+                                     (~0ULL >> shift));
+          }
+        }
+        PUSH(a);
+      } break;
+
+      case OP_REF8:
+      case OP_REF16:
+      case OP_REF32:
+      case OP_REF64: {
+        POP(address);
+        uint32_t size = 1 << (opcode - OP_REF8);
+        if (!read_memory) {
+          return std::unexpected(std::string("Memory is not readable"));
+        }
+        auto data = read_memory(static_cast<uint32_t>(address), size);
+        if (!data) {
+          return std::unexpected(data.error());
+        }
+        if (data->size() != size) {
+          return std::unexpected(std::string("Short memory read"));
+        }
+        uint64_t value = 0;
+        for (uint32_t i = 0; i < size; ++i) {
+          value |= static_cast<uint64_t>((*data)[i]) << (i * 8);
+        }
+        PUSH(static_cast<int64_t>(value));
+      } break;
+
+      case OP_IF_GOTO: {
+        OPERAND(2, target);
+        POP(a);
+        if (a) {
+          pc = target;
+        }
+      } break;
+
+      case OP_GOTO: {
+        OPERAND(2, target);
+        pc = target;
+      } break;
+
+      case OP_CONST8:
+      case OP_CONST16:
+      case OP_CONST32:
+      case OP_CONST64: {
+        OPERAND(1 << (opcode - OP_CONST8), value);
+        PUSH(static_cast<int64_t>(value));
+      } break;
+
+      case OP_REG: {
+        OPERAND(2, index);
+        auto value =
+            read_register ? read_register(index) : std::optional<uint64_t>();
+        if (!value) {
+          return std::unexpected("Register " + std::to_string(index) +
+                                 " is not available");
+        }
+        PUSH(static_cast<int64_t>(*value));
+      } break;
+
+      case OP_END:
+        if (stack.empty()) {
+          return std::unexpected(std::string("Expression left no value"));
+        }
+        return stack.back();
+
+      case OP_DUP: {
+        POP(a);
+        PUSH(a);
+        PUSH(a);
+      } break;
+
+      case OP_POP: {
+        POP(a);
+        (void)a;
+      } break;
+
+      case OP_SWAP: {
+        POP(b);
+        POP(a);
+        PUSH(b);
+        PUSH(a);
+      } break;
+
+      case OP_PICK: {
+        OPERAND(1, depth);
+        if (depth >= stack.size()) {
+          return std::unexpected(std::string("Stack underflow in pick"));
+        }
+        PUSH(stack[stack.size() - 1 - depth]);
+      } break;
+
+      case OP_ROT: {
+        // a b c => c a b
+        POP(c);
+        POP(b);
+        POP(a);
+        PUSH(c);
+        PUSH(a);
+        PUSH(b);
+      } break;
+
+      // Collection is only performed if a collector is provided, as when
+      // running tracepoint actions, but the stack effects of the trace opcodes
+      // are always honored.
+      case OP_TRACE: {
+        POP(size);
+        POP(address);
+        if (collect_memory) {
+          auto result = collect_memory(static_cast<uint32_t>(address),
+                                       static_cast<uint32_t>(size));
+          if (!result.has_value()) {
+            return std::unexpected(result.error());
+          }
+        }
+      } break;
+
+      case OP_TRACENZ: {
+        POP(size);
+        POP(address);
+        if (collect_memory && size > 0) {
+          // Collect up to and including the first zero byte.
+          if (!read_memory) {
+            return std::unexpected(std::string("Memory is not readable"));
+          }
+          auto data = read_memory(static_cast<uint32_t>(address),
+                                  static_cast<uint32_t>(size));
+          if (!data) {
+            return std::unexpected(data.error());
+          }
+          auto zero = std::find(data->begin(), data->end(), 0);
+          auto length = std::distance(data->begin(), zero);
+          if (zero != data->end()) {
+            ++length;
+          }
+          auto result = collect_memory(static_cast<uint32_t>(address),
+                                       static_cast<uint32_t>(length));
+          if (!result.has_value()) {
+            return std::unexpected(result.error());
+          }
+        }
+      } break;
+
+      case OP_TRACE_QUICK:
+      case OP_TRACE16: {
+        OPERAND(opcode == OP_TRACE_QUICK ? 1 : 2, size);
+        if (stack.empty()) {
+          return std::unexpected("Stack underflow at offset " +
+                                 std::to_string(pc - 1));
+        }
+        if (collect_memory) {
+          auto result = collect_memory(static_cast<uint32_t>(stack.back()),
+                                       static_cast<uint32_t>(size));
+          if (!result.has_value()) {
+            return std::unexpected(result.error());
+          }
+        }
+      } break;
+
+      // Trace state variables are not supported, so there is nothing to
+      // collect.
+      case OP_TRACEV: {
+        OPERAND(2, variable);
+        (void)variable;
+      } break;
+
+      default: {
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer),
+                 "Unsupported opcode 0x%02x at offset %zu", opcode, pc - 1);
+        return std::unexpected(std::string(buffer));
+      }
+    }
+  }
+
+#undef OPERAND
+#undef PUSH
+#undef POP
+
+  return std::unexpected(std::string("Instruction limit exceeded"));
+}
@@ -0,0 +1,67 @@
+#ifndef XBDM_GDB_BRIDGE_SRC_GDB_GDB_AGENT_EXPRESSION_H_
+#define XBDM_GDB_BRIDGE_SRC_GDB_GDB_AGENT_EXPRESSION_H_
+
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+//! Evaluates GDB agent expression bytecode, as attached to conditional
+//! breakpoints by `Z` packets.
+//!
+//! See
+//! https://sourceware.org/gdb/current/onlinedocs/gdb.html/Agent-Expressions.html
+class GDBAgentExpression {
+ public:
+  //! Returns the value of the register with the given GDB index.
+  typedef std::function<std::optional<uint64_t>(uint32_t gdb_index)>
+      RegisterReader;
+  typedef std::function<std::expected<std::vector<uint8_t>, std::string>(
+      uint32_t address, uint32_t size)>
+      MemoryReader;
+  //! Records the given block of memory when a trace opcode is executed.
+  typedef std::function<std::expected<void, std::string>(uint32_t address,
+                                                         uint32_t size)>
+      MemoryCollector;
+
+  static constexpr uint32_t kMaxStackDepth = 256;
+  //! Bounds the number of instructions that may be executed so that a
+  //! malformed expression cannot loop forever.
+  static constexpr uint32_t kMaxInstructions = 10000;
+
+  explicit GDBAgentExpression(std::vector<uint8_t> bytecode)
+      : bytecode_(std::move(bytecode)) {}
+
+  //! Parses an expression in the `X<len>,<hex bytecode>` form used by GDB
+  //! packets.
+  static std::optional<GDBAgentExpression> Parse(const std::string& encoded);
+
+  //! Parses a sequence of concatenated expressions, as sent by GDB for the
+  //! conditions of a breakpoint.
+  static std::optional<std::vector<GDBAgentExpression>> ParseList(
+      const std::string& encoded);
+
+  //! Parses the expression starting at `offset`, advancing it past the end of
+  //! the expression.
+  static std::optional<GDBAgentExpression> Parse(const std::string& encoded,
+                                                 size_t& offset);
+
+  //! Runs the expression and returns the value on top of the stack when it
+  //! reaches the `end` opcode. If `collect_memory` is provided, it is invoked
+  //! for the memory named by any trace opcodes, as used by tracepoint
+  //! collection actions.
+  [[nodiscard]] std::expected<int64_t, std::string> Evaluate(
+      const RegisterReader& read_register, const MemoryReader& read_memory,
+      const MemoryCollector& collect_memory = nullptr) const;
+
+  [[nodiscard]] const std::vector<uint8_t>& Bytecode() const {
+    return bytecode_;
+  }
+
+ private:
+  std::vector<uint8_t> bytecode_;
+};
+
+#endif  // XBDM_GDB_BRIDGE_SRC_GDB_GDB_AGENT_EXPRESSION_H_
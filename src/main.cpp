@@ -133,5 +133,7 @@ int main(int argc, char* argv[]) {
   std::vector<std::vector<std::string>> commands =
       command_line_command_tokenizer::SplitCommands(additional_commands);
 
-  return main_(xbox_addr, commands, run_shell || commands.empty());
+  auto ret = main_(xbox_addr, commands, run_shell || commands.empty());
+  logging::ShutdownLogging();
+  return ret;
 }
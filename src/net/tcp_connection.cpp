@@ -4,8 +4,9 @@
 #include <unistd.h>
 
 #include <algorithm>
-#include <boost/algorithm/string/trim.hpp>
 #include <boost/log/trivial.hpp>
+#include <cctype>
+#include <string_view>
 
 #include "configure.h"
 #include "util/logging.h"
@@ -131,6 +132,36 @@ bool TCPConnection::DoReceive() {
   return true;
 }
 
+#ifdef ENABLE_HIGH_VERBOSITY_LOGGING
+//! The number of leading bytes inspected to decide whether a send is binary.
+static constexpr size_t kBinarySniffBytes = 256;
+//! Textual sends longer than this are truncated in the log.
+static constexpr size_t kMaxLoggedSendBytes = 1024;
+
+static void LogSentBytes(const std::string& name, const uint8_t* data,
+                         size_t len) {
+  // Special case XBDM message terminators to condense log.
+  auto end = data + len;
+  while (end != data && std::isspace(end[-1])) {
+    --end;
+  }
+
+  auto sniff_end = data + std::min<size_t>(end - data, kBinarySniffBytes);
+  auto is_binary = [](uint8_t c) { return !std::isprint(c); };
+  if (std::any_of(data, sniff_end, is_binary)) {
+    LOG_TAGGED(trace, name)
+        << "-> Sent " << len << " bytes (binary)" << std::endl;
+    return;
+  }
+
+  auto text_len = std::min<size_t>(end - data, kMaxLoggedSendBytes);
+  std::string_view text(reinterpret_cast<const char*>(data), text_len);
+  LOG_TAGGED(trace, name) << "-> Sent " << len << " bytes" << std::endl
+                          << text << (data + text_len < end ? "..." : "")
+                          << std::endl;
+}
+#endif
+
 void TCPConnection::DoSend() {
   const std::lock_guard socket_lock(socket_lock_);
   const std::lock_guard write_lock(write_lock_);
@@ -145,29 +176,8 @@ void TCPConnection::DoSend() {
   }
 
 #ifdef ENABLE_HIGH_VERBOSITY_LOGGING
-  {
-    std::string data(write_buffer_.begin(), write_buffer_.begin() + bytes_sent);
-    // Special case XBDM message terminators to condense log.
-    boost::algorithm::trim_right(data);
-
-    bool maybeBinary = false;
-    auto bytes_checked = 0;
-    const auto data_end = data.end();
-    for (auto i = data.begin(); i != data_end && bytes_checked < 256;
-         ++i, ++bytes_checked) {
-      if (!std::isprint(*i)) {
-        maybeBinary = true;
-        break;
-      }
-    }
-    if (maybeBinary) {
-      LOG_TAGGED(trace, name_)
-          << "-> Sent " << bytes_sent << " bytes (binary)" << std::endl;
-    } else {
-      LOG_TAGGED(trace, name_)
-          << "-> Sent " << bytes_sent << " bytes" << std::endl
-          << data << std::endl;
-    }
+  if (logging::ShouldLog(boost::log::trivial::trace, name_)) {
+    LogSentBytes(name_, write_buffer_.data(), bytes_sent);
   }
 #endif
 
@@ -189,12 +199,15 @@ std::vector<uint8_t>::iterator TCPConnection::FirstIndexOf(
 }
 
 void TCPConnection::FlushAndClose() {
-  const std::lock_guard write_lock(write_lock_);
-
-  if (write_buffer_.empty()) {
-    Close();
-    return;
+  // Close takes the socket lock, which the SelectThread holds while taking the
+  // write lock, so the write lock must be released first.
+  {
+    const std::lock_guard write_lock(write_lock_);
+    if (!write_buffer_.empty()) {
+      close_after_flush_ = true;
+      return;
+    }
   }
 
-  close_after_flush_ = true;
+  Close();
 }
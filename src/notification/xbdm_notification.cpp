@@ -1,14 +1,15 @@
 #include "xbdm_notification.h"
 
 #include <cassert>
+#include <cctype>
+#include <cstdint>
 #include <cstring>
 #include <mutex>
 #include <ostream>
-#include <regex>
+#include <string_view>
 
 #include "rdcp/rdcp_response_processors.h"
 #include "util/logging.h"
-#include "util/parsing.h"
 
 static bool StartsWith(const char* buffer, long buffer_len, const char* prefix,
                        long prefix_len);
@@ -17,47 +18,70 @@ static bool StartsWith(const char* buffer, long buffer_len, const char* prefix,
 static std::recursive_mutex customNotificationMutex;
 
 //! Map of prefix to custom notification constructor functions.
-static std::map<std::string, XBDMNotificationConstructor>
+static std::map<std::string, XBDMNotificationConstructor, std::less<>>
     customNotificationConstructors;
 
 std::shared_ptr<XBDMNotification> ParseXBDMNotification(const char* buffer,
                                                         long buffer_len) {
+  if (buffer_len <= 0) {
+    return {};
+  }
+
 #define SETIF(prefix, type)                                         \
   if (StartsWith(buffer, buffer_len, prefix, sizeof(prefix) - 1)) { \
     return std::make_shared<type>(buffer + sizeof(prefix) - 1,      \
                                   buffer + buffer_len);             \
   }
 
-  SETIF("vx!", NotificationVX)
-  SETIF("debugstr ", NotificationDebugStr)
-  SETIF("modload ", NotificationModuleLoaded)
-  SETIF("sectload ", NotificationSectionLoaded)
-  SETIF("sectunload ", NotificationSectionUnloaded)
-  SETIF("create ", NotificationThreadCreated)
-  SETIF("terminate ", NotificationThreadTerminated)
-  SETIF("execution ", NotificationExecutionStateChanged)
-  SETIF("break ", NotificationBreakpoint)
-  SETIF("data ", NotificationWatchpoint)
-  SETIF("singlestep ", NotificationSingleStep)
-  SETIF("exception ", NotificationException)
+  // Dispatch on the first byte so that at most three prefixes are compared
+  // for any built-in notification.
+  switch (buffer[0]) {
+    case 'b':
+      SETIF("break ", NotificationBreakpoint)
+      break;
+    case 'c':
+      SETIF("create ", NotificationThreadCreated)
+      break;
+    case 'd':
+      SETIF("debugstr ", NotificationDebugStr)
+      SETIF("data ", NotificationWatchpoint)
+      break;
+    case 'e':
+      SETIF("execution ", NotificationExecutionStateChanged)
+      SETIF("exception ", NotificationException)
+      break;
+    case 'm':
+      SETIF("modload ", NotificationModuleLoaded)
+      break;
+    case 's':
+      SETIF("sectload ", NotificationSectionLoaded)
+      SETIF("sectunload ", NotificationSectionUnloaded)
+      SETIF("singlestep ", NotificationSingleStep)
+      break;
+    case 't':
+      SETIF("terminate ", NotificationThreadTerminated)
+      break;
+    case 'v':
+      SETIF("vx!", NotificationVX)
+      break;
+    default:
+      break;
+  }
 #undef SETIF
 
-  {
-    const std::lock_guard lock(customNotificationMutex);
-
-    auto delimiter = strchr(buffer, '!');
-    if (!delimiter) {
-      return {};
-    }
-
-    auto prefix = std::string(buffer, delimiter);
-    auto entry = customNotificationConstructors.find(prefix);
-    if (entry == customNotificationConstructors.end()) {
-      return {};
-    }
+  auto delimiter = static_cast<const char*>(memchr(buffer, '!', buffer_len));
+  if (!delimiter) {
+    return {};
+  }
 
-    return entry->second(delimiter + 1, buffer + buffer_len);
+  const std::lock_guard lock(customNotificationMutex);
+  auto entry = customNotificationConstructors.find(
+      std::string_view(buffer, delimiter - buffer));
+  if (entry == customNotificationConstructors.end()) {
+    return {};
   }
+
+  return entry->second(delimiter + 1, buffer + buffer_len);
 }
 
 //! Registers an XBDMNotification constructor for a custom event prefix.
@@ -111,16 +135,71 @@ std::ostream& NotificationVX::WriteStream(std::ostream& os) const {
   return os;
 }
 
-// "thread=4 lf string=Test string with newline"
-static std::regex notification_regex(
-    R"(thread=(\d+)\s+(lf|cr|crlf)?\s*string=(.*))");
+//! Advances `pos` past `token` if the remaining input begins with it.
+static bool Consume(const char*& pos, const char* end, std::string_view token) {
+  if (end - pos < static_cast<long>(token.size()) ||
+      memcmp(pos, token.data(), token.size()) != 0) {
+    return false;
+  }
+  pos += token.size();
+  return true;
+}
+
+static void SkipWhitespace(const char*& pos, const char* end) {
+  while (pos < end && isspace(static_cast<unsigned char>(*pos))) {
+    ++pos;
+  }
+}
+
+//! Parses the body of a debugstr notification, e.g.
+//! "thread=4 lf string=Test string with newline"
+static bool ParseDebugStr(const char* pos, const char* end, int& thread_id,
+                          const char*& termination, const char*& text) {
+  if (!Consume(pos, end, "thread=")) {
+    return false;
+  }
+
+  auto digits_start = pos;
+  int64_t value = 0;
+  while (pos < end && isdigit(static_cast<unsigned char>(*pos))) {
+    value = value * 10 + (*pos - '0');
+    if (value > INT32_MAX) {
+      return false;
+    }
+    ++pos;
+  }
+  if (pos == digits_start || pos == end ||
+      !isspace(static_cast<unsigned char>(*pos))) {
+    return false;
+  }
+  thread_id = static_cast<int>(value);
+  SkipWhitespace(pos, end);
+
+  termination = "";
+  if (Consume(pos, end, "crlf")) {
+    termination = "\r\n";
+  } else if (Consume(pos, end, "cr")) {
+    termination = "\r";
+  } else if (Consume(pos, end, "lf")) {
+    termination = "\n";
+  }
+  SkipWhitespace(pos, end);
+
+  if (!Consume(pos, end, "string=")) {
+    return false;
+  }
+  text = pos;
+  return true;
+}
 
 NotificationDebugStr::NotificationDebugStr(const char* buffer_start,
                                            const char* buffer_end) {
-  std::string buffer(buffer_start, buffer_end);
-  std::smatch match;
-  if (!std::regex_match(buffer, match, notification_regex)) {
-    LOG(error) << "Regex match failed on notification buffer '" << buffer
+  const char* terminator;
+  const char* text_start;
+  if (!ParseDebugStr(buffer_start, buffer_end, thread_id, terminator,
+                     text_start)) {
+    LOG(error) << "Failed to parse debugstr notification '"
+               << std::string_view(buffer_start, buffer_end - buffer_start)
                << "'";
     thread_id = -1;
     text = "";
@@ -129,16 +208,8 @@ NotificationDebugStr::NotificationDebugStr(const char* buffer_start,
     return;
   }
 
-  thread_id = ParseInt32(match[1]);
-  text = match[3];
-
-  if (match[2] == "lf") {
-    termination = "\n";
-  } else if (match[2] == "cr") {
-    termination = "\r";
-  } else if (match[2] == "crlf") {
-    termination = "\r\n";
-  }
+  text.assign(text_start, buffer_end);
+  termination = terminator;
   is_terminated = !termination.empty();
 }
 
@@ -199,6 +270,11 @@ std::ostream& NotificationThreadTerminated::WriteStream(
   return os;
 }
 
+std::ostream& NotificationReconnected::WriteStream(std::ostream& os) const {
+  os << "Notification channel reconnected";
+  return os;
+}
+
 NotificationExecutionStateChanged::NotificationExecutionStateChanged(
     const char* buffer_start, const char* buffer_end) {
   RDCPMapResponse parsed(buffer_start, buffer_end);
@@ -26,6 +26,8 @@ enum NotificationType {
   NT_WATCHPOINT,
   NT_SINGLE_STEP,
   NT_EXCEPTION,
+  // Generated locally when XBDM reestablishes a notification channel.
+  NT_RECONNECTED,
   // A custom event type that must be string matched.
   NT_CUSTOM,
 };
@@ -173,6 +175,16 @@ struct NotificationException : XBDMNotification {
   std::set<std::string> flags;
 };
 
+//! Generated by the bridge, rather than sent by XBDM, when a notification
+//! channel replaces an earlier one. Any notifications sent while no channel
+//! was connected are lost, so state maintained from them must be refetched.
+struct NotificationReconnected : XBDMNotification {
+  [[nodiscard]] NotificationType Type() const override {
+    return NT_RECONNECTED;
+  }
+  std::ostream& WriteStream(std::ostream& os) const override;
+};
+
 std::shared_ptr<XBDMNotification> ParseXBDMNotification(const char* message,
                                                         long message_len);
 
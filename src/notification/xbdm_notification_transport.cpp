@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <cstring>
+#include <string_view>
 #include <utility>
 
 #include "util/logging.h"
@@ -29,6 +30,12 @@ void XBDMNotificationTransport::Close() {
   }
 #endif
   TCPConnection::Close();
+  capture_.Close();
+}
+
+void XBDMNotificationTransport::SetCapture(
+    const std::shared_ptr<SessionCaptureWriter>& writer) {
+  capture_.SetWriter(writer, Name());
 }
 
 void XBDMNotificationTransport::OnBytesRead() {
@@ -46,6 +53,8 @@ void XBDMNotificationTransport::OnBytesRead() {
     long packet_len = message_len + kTerminatorLen;
     bytes_processed += packet_len;
 
+    capture_.Record(session_capture::RecordType::NOTIFICATION, buffer,
+                    packet_len);
     HandleNotification(buffer, message_len);
     buffer += packet_len;
     message_end = ParseMessage(buffer, buffer_end);
@@ -75,9 +84,9 @@ void XBDMNotificationTransport::HandleNotification(const char* message,
   }
 
 #ifdef ENABLE_HIGH_VERBOSITY_LOGGING
-  std::string msg_str(message, message_len);
   LOG_NOTIF(trace) << "Notification channel [" << name_
-                   << "]: message received '" << msg_str << "'";
+                   << "]: message received '"
+                   << std::string_view(message, message_len) << "'";
 #endif
 
   notification_handler_(notification);
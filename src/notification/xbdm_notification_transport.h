@@ -5,6 +5,7 @@
 #include <memory>
 
 #include "net/tcp_connection.h"
+#include "rdcp/session_capture.h"
 #include "xbdm_notification.h"
 
 class XBDMNotificationTransport : public TCPConnection {
@@ -21,6 +22,10 @@ class XBDMNotificationTransport : public TCPConnection {
 
   void Close() override;
 
+  //! Records all subsequent notifications to the given writer. Passing
+  //! nullptr stops recording.
+  void SetCapture(const std::shared_ptr<SessionCaptureWriter>& writer);
+
  protected:
   void OnBytesRead() override;
   void HandleNotification(const char* message, long message_len);
@@ -28,6 +33,8 @@ class XBDMNotificationTransport : public TCPConnection {
  private:
   NotificationHandler notification_handler_;
   bool hello_received_;
+
+  SessionCaptureStream capture_{session_capture::StreamKind::NOTIFICATION};
 };
 
 #endif  // XBDM_GDB_BRIDGE_XBDMNOTIFICATIONTRANSPORT_H
@@ -15,22 +15,51 @@ void RDCPProcessedRequest::Complete(
 
   ProcessResponse(response);
 
-  completed_.notify_all();
+  SignalCompleted();
 }
 
-void RDCPProcessedRequest::Abandon() {
-  status = StatusCode::ERR_ABANDONED;
+void RDCPProcessedRequest::Abandon() { Fail(StatusCode::ERR_ABANDONED); }
+
+void RDCPProcessedRequest::Fail(StatusCode failure_status) {
+  status = failure_status;
+  SignalCompleted();
+}
+
+void RDCPProcessedRequest::SetCompletionHandler(CompletionHandler handler) {
+  const std::lock_guard lock(mutex_);
+  is_completed_ = false;
+  completion_handler_ = std::move(handler);
+}
+
+bool RDCPProcessedRequest::IsCompleted() {
+  const std::lock_guard lock(mutex_);
+  return is_completed_;
+}
+
+void RDCPProcessedRequest::SignalCompleted() {
+  CompletionHandler handler;
+  {
+    const std::lock_guard lock(mutex_);
+    is_completed_ = true;
+    // The handler commonly captures a reference to this request, so it is
+    // released here to avoid a reference cycle.
+    handler.swap(completion_handler_);
+  }
   completed_.notify_all();
+
+  if (handler) {
+    handler();
+  }
 }
 
 void RDCPProcessedRequest::WaitUntilCompleted() {
   std::unique_lock<std::mutex> lock(mutex_);
-  completed_.wait(lock);
+  completed_.wait(lock, [this]() { return is_completed_; });
 }
 
 bool RDCPProcessedRequest::WaitUntilCompleted(int max_wait_milliseconds) {
   std::unique_lock<std::mutex> lock(mutex_);
-  auto result = completed_.wait_for(
-      lock, std::chrono::milliseconds(max_wait_milliseconds));
-  return result == std::cv_status::no_timeout;
+  return completed_.wait_for(lock,
+                             std::chrono::milliseconds(max_wait_milliseconds),
+                             [this]() { return is_completed_; });
 }
@@ -2,6 +2,7 @@
 #define XBDM_GDB_BRIDGE_RDCP_PROCESSED_REQUEST_H
 
 #include <condition_variable>
+#include <functional>
 #include <map>
 #include <mutex>
 #include <string>
@@ -13,6 +14,10 @@
 #include "rdcp_status_code.h"
 
 struct RDCPProcessedRequest : public RDCPRequest {
+ public:
+  //! Invoked exactly once when the request is completed or abandoned.
+  typedef std::function<void()> CompletionHandler;
+
  public:
   explicit RDCPProcessedRequest(std::string command)
       : RDCPRequest(std::move(command)) {}
@@ -25,6 +30,19 @@ struct RDCPProcessedRequest : public RDCPRequest {
 
   void Abandon() final;
 
+  //! Completes the request with the given status without a response from
+  //! XBDM (e.g., because it could not be sent).
+  void Fail(StatusCode failure_status);
+
+  //! Resets the completion state of this request and registers a handler to
+  //! be called when it completes. Must be called before the request is sent.
+  //!
+  //! The handler is invoked from the thread that completes the request,
+  //! typically the SelectThread, so it must not block.
+  void SetCompletionHandler(CompletionHandler handler);
+
+  [[nodiscard]] bool IsCompleted();
+
   void WaitUntilCompleted();
   bool WaitUntilCompleted(int max_wait_milliseconds);
 
@@ -36,9 +54,14 @@ struct RDCPProcessedRequest : public RDCPRequest {
   StatusCode status{INVALID};
   std::string message;
 
+ protected:
+  void SignalCompleted();
+
  protected:
   std::mutex mutex_;
   std::condition_variable completed_;
+  bool is_completed_{false};
+  CompletionHandler completion_handler_;
 };
 
 #endif  // XBDM_GDB_BRIDGE_RDCP_PROCESSED_REQUEST_H
@@ -20,6 +20,8 @@ class RDCPRequest {
 
   explicit operator std::vector<uint8_t>() const;
 
+  [[nodiscard]] const std::string& Command() const { return command_; }
+
   virtual void Complete(const std::shared_ptr<RDCPResponse>& response) = 0;
   virtual void Abandon() = 0;
 
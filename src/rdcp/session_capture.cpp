@@ -0,0 +1,204 @@
+#include "session_capture.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace session_capture {
+
+static constexpr size_t kMagicLen = sizeof(kMagic) - 1;
+
+static bool ReadVarint(FILE* file, uint64_t& value) {
+  value = 0;
+  for (uint32_t shift = 0; shift < 64; shift += 7) {
+    int byte = fgetc(file);
+    if (byte == EOF) {
+      return false;
+    }
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ReadCapture(const std::filesystem::path& path,
+                 std::vector<Record>& records) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (!file) {
+    return false;
+  }
+
+  char header[kMagicLen + 1];
+  if (fread(header, 1, sizeof(header), file) != sizeof(header) ||
+      memcmp(header, kMagic, kMagicLen) != 0 ||
+      static_cast<uint8_t>(header[kMagicLen]) != kVersion) {
+    fclose(file);
+    return false;
+  }
+
+  std::error_code error;
+  auto file_size = std::filesystem::file_size(path, error);
+  if (error) {
+    fclose(file);
+    return false;
+  }
+
+  uint64_t timestamp_us = 0;
+  while (true) {
+    uint64_t type;
+    uint64_t stream_id;
+    uint64_t delta_us;
+    uint64_t len;
+    if (!ReadVarint(file, type) || !ReadVarint(file, stream_id) ||
+        !ReadVarint(file, delta_us) || !ReadVarint(file, len)) {
+      break;
+    }
+
+    // A corrupt length must not be allowed to allocate more than the file
+    // could possibly contain.
+    auto position = ftell(file);
+    if (position < 0 || len > file_size - static_cast<uint64_t>(position)) {
+      break;
+    }
+
+    timestamp_us += delta_us;
+    Record record{static_cast<RecordType>(type),
+                  static_cast<uint32_t>(stream_id), timestamp_us, {}};
+    record.data.resize(len);
+    if (len && fread(record.data.data(), 1, len, file) != len) {
+      break;
+    }
+    records.push_back(std::move(record));
+  }
+
+  fclose(file);
+  return true;
+}
+
+}  // namespace session_capture
+
+using namespace session_capture;
+
+std::shared_ptr<SessionCaptureWriter> SessionCaptureWriter::Create(
+    const std::filesystem::path& path) {
+  FILE* file = fopen(path.c_str(), "wb");
+  if (!file) {
+    return nullptr;
+  }
+
+  return std::shared_ptr<SessionCaptureWriter>(
+      new SessionCaptureWriter(file, path));
+}
+
+SessionCaptureWriter::SessionCaptureWriter(FILE* file,
+                                           std::filesystem::path path)
+    : path_(std::move(path)),
+      file_(file),
+      start_time_(std::chrono::steady_clock::now()) {
+  fwrite(kMagic, 1, kMagicLen, file_);
+  fputc(kVersion, file_);
+  bytes_written_ = kMagicLen + 1;
+}
+
+SessionCaptureWriter::~SessionCaptureWriter() { fclose(file_); }
+
+uint32_t SessionCaptureWriter::OpenStream(StreamKind kind,
+                                          const std::string& name) {
+  uint32_t stream_id;
+  {
+    const std::lock_guard lock(lock_);
+    stream_id = next_stream_id_++;
+  }
+
+  std::vector<uint8_t> payload;
+  payload.reserve(name.size() + 1);
+  payload.push_back(static_cast<uint8_t>(kind));
+  payload.insert(payload.end(), name.begin(), name.end());
+  Record(stream_id, RecordType::STREAM_OPENED, payload.data(), payload.size());
+  return stream_id;
+}
+
+void SessionCaptureWriter::Record(uint32_t stream_id, RecordType type,
+                                  const void* data, size_t len) {
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start_time_);
+
+  const std::lock_guard lock(lock_);
+  // Records from different threads may race to the lock, so timestamps are
+  // clamped to remain monotonic.
+  auto timestamp_us = std::max<uint64_t>(
+      static_cast<uint64_t>(elapsed.count()), last_timestamp_us_);
+  WriteVarint(static_cast<uint64_t>(type));
+  WriteVarint(stream_id);
+  WriteVarint(timestamp_us - last_timestamp_us_);
+  WriteVarint(len);
+  if (len) {
+    fwrite(data, 1, len, file_);
+  }
+  bytes_written_ += len;
+  last_timestamp_us_ = timestamp_us;
+}
+
+void SessionCaptureWriter::Flush() {
+  const std::lock_guard lock(lock_);
+  fflush(file_);
+}
+
+uint64_t SessionCaptureWriter::BytesWritten() const {
+  const std::lock_guard lock(lock_);
+  return bytes_written_;
+}
+
+void SessionCaptureWriter::WriteVarint(uint64_t value) {
+  uint8_t buffer[10];
+  size_t len = 0;
+  do {
+    auto byte = static_cast<uint8_t>(value & 0x7F);
+    value >>= 7;
+    if (value) {
+      byte |= 0x80;
+    }
+    buffer[len++] = byte;
+  } while (value);
+
+  fwrite(buffer, 1, len, file_);
+  bytes_written_ += len;
+}
+
+void SessionCaptureStream::SetWriter(
+    const std::shared_ptr<SessionCaptureWriter>& writer,
+    const std::string& name) {
+  const std::lock_guard lock(lock_);
+  if (writer == writer_) {
+    return;
+  }
+  if (writer_) {
+    writer_->Record(stream_id_, RecordType::STREAM_CLOSED, nullptr, 0);
+  }
+
+  writer_ = writer;
+  if (writer_) {
+    stream_id_ = writer_->OpenStream(kind_, name);
+  }
+  active_ = writer_ != nullptr;
+}
+
+void SessionCaptureStream::Close() {
+  const std::lock_guard lock(lock_);
+  if (!writer_) {
+    return;
+  }
+
+  writer_->Record(stream_id_, RecordType::STREAM_CLOSED, nullptr, 0);
+  writer_.reset();
+  active_ = false;
+}
+
+void SessionCaptureStream::RecordSlow(RecordType type, const void* data,
+                                      size_t len) {
+  const std::lock_guard lock(lock_);
+  if (writer_) {
+    writer_->Record(stream_id_, type, data, len);
+  }
+}
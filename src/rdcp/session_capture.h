@@ -0,0 +1,142 @@
+#ifndef XBDM_GDB_BRIDGE_SRC_RDCP_SESSION_CAPTURE_H_
+#define XBDM_GDB_BRIDGE_SRC_RDCP_SESSION_CAPTURE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//! Records the traffic of an XBDM session so that it may be served back by a
+//! SessionReplayServer.
+//!
+//! A capture file begins with kMagic followed by a version byte
+//! and then consists of a sequence of records, each of which is a series of
+//! unsigned LEB128 values (type, stream ID, microseconds since the previous
+//! record, payload length) followed by the payload.
+//!
+//! Records are framed by message rather than by socket read so that each
+//! request may be matched to its response during replay.
+namespace session_capture {
+
+constexpr char kMagic[] = "XBDMCAP";
+constexpr uint8_t kVersion = 1;
+
+enum class StreamKind : uint8_t {
+  //! A connection from the bridge to XBDM on port 731.
+  CONTROL = 0,
+  //! A notification stream opened by XBDM in response to `notifyat`.
+  NOTIFICATION = 1,
+};
+
+enum class RecordType : uint8_t {
+  //! The payload is the StreamKind followed by the stream's name.
+  STREAM_OPENED = 0,
+  STREAM_CLOSED = 1,
+  //! A serialized request sent to XBDM, including its terminator.
+  REQUEST = 2,
+  //! A binary payload sent to XBDM after it responded with
+  //! OK_SEND_BINARY_DATA.
+  BINARY_PAYLOAD = 3,
+  //! A complete response from XBDM, including any multiline or binary body.
+  RESPONSE = 4,
+  //! Bytes from XBDM that did not form a valid response.
+  DISCARDED = 5,
+  //! A single notification, including its terminator.
+  NOTIFICATION = 6,
+};
+
+struct Record {
+  RecordType type;
+  uint32_t stream_id;
+  //! Microseconds since the start of the capture.
+  uint64_t timestamp_us;
+  std::vector<uint8_t> data;
+};
+
+//! Reads every record from the given capture file. Returns false if the file
+//! cannot be opened or is not a capture. A truncated final record is ignored.
+bool ReadCapture(const std::filesystem::path& path,
+                 std::vector<Record>& records);
+
+}  // namespace session_capture
+
+//! Appends records to a capture file. May be shared by any number of streams
+//! and is safe to call from any thread.
+class SessionCaptureWriter {
+ public:
+  //! Returns nullptr if the file cannot be created.
+  static std::shared_ptr<SessionCaptureWriter> Create(
+      const std::filesystem::path& path);
+
+  //! Flushes and closes the file.
+  ~SessionCaptureWriter();
+
+  //! Records the opening of a new stream and returns its ID.
+  uint32_t OpenStream(session_capture::StreamKind kind,
+                      const std::string& name);
+
+  void Record(uint32_t stream_id, session_capture::RecordType type,
+              const void* data, size_t len);
+
+  void Flush();
+
+  [[nodiscard]] const std::filesystem::path& Path() const { return path_; }
+  [[nodiscard]] uint64_t BytesWritten() const;
+
+ private:
+  SessionCaptureWriter(FILE* file, std::filesystem::path path);
+
+  void WriteVarint(uint64_t value);
+
+ private:
+  std::filesystem::path path_;
+
+  mutable std::mutex lock_;
+  FILE* file_;
+  uint32_t next_stream_id_{0};
+  std::chrono::steady_clock::time_point start_time_;
+  uint64_t last_timestamp_us_{0};
+  uint64_t bytes_written_{0};
+};
+
+//! Associates a single transport with a SessionCaptureWriter. Recording is a
+//! single atomic load when no writer is attached.
+class SessionCaptureStream {
+ public:
+  explicit SessionCaptureStream(session_capture::StreamKind kind)
+      : kind_(kind) {}
+
+  //! Attaches the given writer, closing the stream on any previous writer.
+  //! Passing nullptr stops recording.
+  void SetWriter(const std::shared_ptr<SessionCaptureWriter>& writer,
+                 const std::string& name);
+
+  void Record(session_capture::RecordType type, const void* data,
+              size_t len) {
+    if (active_.load(std::memory_order_relaxed)) {
+      RecordSlow(type, data, len);
+    }
+  }
+
+  //! Records the closing of the stream and detaches the writer.
+  void Close();
+
+ private:
+  void RecordSlow(session_capture::RecordType type, const void* data,
+                  size_t len);
+
+ private:
+  const session_capture::StreamKind kind_;
+
+  std::atomic<bool> active_{false};
+  std::mutex lock_;
+  std::shared_ptr<SessionCaptureWriter> writer_;
+  uint32_t stream_id_{0};
+};
+
+#endif  // XBDM_GDB_BRIDGE_SRC_RDCP_SESSION_CAPTURE_H_
@@ -0,0 +1,497 @@
+#include "session_replay_server.h"
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <boost/algorithm/string/case_conv.hpp>
+#include <chrono>
+#include <cstring>
+
+#include "net/delegating_server.h"
+#include "net/select_thread.h"
+#include "net/task_connection.h"
+#include "net/tcp_connection.h"
+#include "rdcp/rdcp_response_processors.h"
+#include "rdcp/rdcp_status_code.h"
+#include "rdcp/session_capture.h"
+#include "util/logging.h"
+
+using session_capture::RecordType;
+using session_capture::StreamKind;
+
+static constexpr char kDefaultBanner[] = "201- connected\r\n";
+static constexpr char kTerminator[] = "\r\n";
+
+//! A connection to the replay client. Data is sent in the order it was
+//! scheduled, regardless of the order in which delayed tasks fire.
+class SessionReplayServer::ReplayConnection
+    : public TCPConnection,
+      public std::enable_shared_from_this<ReplayConnection> {
+ public:
+  typedef std::function<void(ReplayConnection&)> BytesReceivedHandler;
+
+  ReplayConnection(std::string name, int sock, const IPAddress& address,
+                   BytesReceivedHandler bytes_received_handler)
+      : TCPConnection(std::move(name), sock, address),
+        bytes_received_handler_(std::move(bytes_received_handler)) {}
+
+  //! Returns the time at which data scheduled after `earliest` may be sent
+  //! without overtaking previously scheduled data.
+  std::chrono::steady_clock::time_point Reserve(
+      std::chrono::steady_clock::time_point earliest) {
+    const std::lock_guard lock(schedule_lock_);
+    last_scheduled_ = std::max(last_scheduled_, earliest);
+    return last_scheduled_;
+  }
+
+  void Schedule(std::chrono::steady_clock::time_point when,
+                std::string bytes) {
+    const std::lock_guard lock(schedule_lock_);
+    scheduled_.emplace_back(when, std::move(bytes));
+  }
+
+  //! Sends everything that was scheduled at or before now.
+  void SendDue() {
+    auto now = std::chrono::steady_clock::now();
+    const std::lock_guard lock(schedule_lock_);
+    while (!scheduled_.empty() && scheduled_.front().first <= now) {
+      Send(scheduled_.front().second);
+      scheduled_.pop_front();
+    }
+  }
+
+  std::recursive_mutex& ReadLock() { return read_lock_; }
+  std::vector<uint8_t>& ReadBuffer() { return read_buffer_; }
+
+  //! The exchange awaiting a binary payload from the client, if any.
+  int pending_exchange{-1};
+  size_t pending_step{0};
+  size_t pending_payload_bytes{0};
+
+ protected:
+  void OnBytesRead() override {
+    if (bytes_received_handler_) {
+      bytes_received_handler_(*this);
+    }
+  }
+
+ private:
+  BytesReceivedHandler bytes_received_handler_;
+
+  std::mutex schedule_lock_;
+  std::chrono::steady_clock::time_point last_scheduled_{};
+  std::deque<std::pair<std::chrono::steady_clock::time_point, std::string>>
+      scheduled_;
+};
+
+static std::string CommandName(const std::string& request) {
+  auto end = request.find(' ');
+  return boost::algorithm::to_lower_copy(request.substr(0, end));
+}
+
+static std::string StripTerminator(const std::vector<uint8_t>& data) {
+  std::string ret(data.begin(), data.end());
+  while (!ret.empty() && (ret.back() == '\n' || ret.back() == '\r')) {
+    ret.pop_back();
+  }
+  return ret;
+}
+
+SessionReplayServer::SessionReplayServer(double latency_scale)
+    : latency_scale_(std::max(latency_scale, 0.0)) {}
+
+SessionReplayServer::~SessionReplayServer() { Stop(); }
+
+bool SessionReplayServer::Load(const std::filesystem::path& path) {
+  std::vector<session_capture::Record> records;
+  if (!session_capture::ReadCapture(path, records)) {
+    return false;
+  }
+
+  struct StreamState {
+    StreamKind kind;
+    bool saw_request{false};
+    //! Exchanges awaiting a response, oldest first, along with the time of
+    //! the event that the next response step is measured from.
+    std::deque<std::pair<size_t, uint64_t>> pending;
+    uint64_t opened_us{0};
+    size_t notification_stream{0};
+  };
+  std::map<uint32_t, StreamState> streams;
+
+  const std::lock_guard lock(lock_);
+  for (const auto& record : records) {
+    if (record.type == RecordType::STREAM_OPENED) {
+      if (record.data.empty()) {
+        continue;
+      }
+      StreamState state{static_cast<StreamKind>(record.data.front()), false,
+                        {}, record.timestamp_us, 0};
+      if (state.kind == StreamKind::NOTIFICATION) {
+        state.notification_stream = notification_streams_.size();
+        notification_streams_.emplace_back();
+      }
+      streams[record.stream_id] = std::move(state);
+      continue;
+    }
+
+    auto stream = streams.find(record.stream_id);
+    if (stream == streams.end()) {
+      continue;
+    }
+    auto& state = stream->second;
+
+    switch (record.type) {
+      case RecordType::NOTIFICATION:
+        notification_streams_[state.notification_stream].push_back(
+            {record.timestamp_us - state.opened_us,
+             std::string(record.data.begin(), record.data.end())});
+        break;
+
+      case RecordType::REQUEST: {
+        state.saw_request = true;
+        Exchange exchange;
+        exchange.request = StripTerminator(record.data);
+        state.pending.emplace_back(exchanges_.size(), record.timestamp_us);
+        exchanges_.push_back(std::move(exchange));
+        break;
+      }
+
+      case RecordType::BINARY_PAYLOAD:
+        if (!state.pending.empty()) {
+          auto& [index, reference_us] = state.pending.front();
+          auto& steps = exchanges_[index].steps;
+          if (!steps.empty()) {
+            steps.back().payload_bytes += record.data.size();
+          }
+          reference_us = record.timestamp_us;
+        }
+        break;
+
+      case RecordType::RESPONSE:
+      case RecordType::DISCARDED: {
+        std::string bytes(record.data.begin(), record.data.end());
+        if (state.pending.empty()) {
+          if (!state.saw_request && banner_.empty() &&
+              record.type == RecordType::RESPONSE) {
+            banner_ = std::move(bytes);
+          }
+          break;
+        }
+
+        auto& [index, reference_us] = state.pending.front();
+        exchanges_[index].steps.push_back(
+            {record.timestamp_us - reference_us, std::move(bytes)});
+        reference_us = record.timestamp_us;
+
+        // OK_SEND_BINARY_DATA is followed by the client's payload and then
+        // the final response.
+        auto is_send_binary = record.data.size() >= 3 &&
+                              !memcmp(record.data.data(), "204", 3);
+        if (record.type == RecordType::RESPONSE && !is_send_binary) {
+          state.pending.pop_front();
+        }
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+
+  for (size_t i = 0; i < exchanges_.size(); ++i) {
+    const auto& request = exchanges_[i].request;
+    auto command = CommandName(request);
+    by_request_[request].push_back(i);
+    by_command_[command].push_back(i);
+    last_by_request_[request] = i;
+    last_by_command_[command] = i;
+  }
+
+  if (banner_.empty()) {
+    banner_ = kDefaultBanner;
+  }
+  return true;
+}
+
+bool SessionReplayServer::Start(const IPAddress& address) {
+  if (running_) {
+    return true;
+  }
+
+  select_thread_ = std::make_shared<SelectThread>("ST_ReplayXBDMSrv");
+  task_queue_ = std::make_shared<TaskConnection>("ReplayTaskQueue");
+  select_thread_->AddConnection(task_queue_);
+  server_ = std::make_shared<DelegatingServer>(
+      "ReplayXBDMServer", [this](int sock, IPAddress& address) {
+        this->OnClientConnected(sock, address);
+      });
+  select_thread_->AddConnection(server_);
+  if (!server_->Listen(address)) {
+    return false;
+  }
+
+  select_thread_->Start();
+  running_ = true;
+  return true;
+}
+
+void SessionReplayServer::Stop() {
+  if (!running_) {
+    return;
+  }
+  running_ = false;
+
+  server_->Close();
+  select_thread_->Stop();
+
+  std::vector<std::shared_ptr<ReplayConnection>> connections;
+  {
+    const std::lock_guard lock(lock_);
+    connections.swap(connections_);
+  }
+  for (auto& connection : connections) {
+    connection->Close();
+  }
+}
+
+const IPAddress& SessionReplayServer::Address() const {
+  return server_->Address();
+}
+
+SessionReplayServer::Stats SessionReplayServer::GetStats() const {
+  const std::lock_guard lock(lock_);
+  return stats_;
+}
+
+void SessionReplayServer::OnClientConnected(int sock, IPAddress& address) {
+  auto connection = std::make_shared<ReplayConnection>(
+      "ReplayClient", sock, address, [this](ReplayConnection& connection) {
+        OnClientBytesReceived(connection);
+      });
+  if (!running_) {
+    connection->Close();
+    return;
+  }
+
+  {
+    const std::lock_guard lock(lock_);
+    connections_.push_back(connection);
+  }
+  select_thread_->AddConnection(connection, [this, connection]() {
+    const std::lock_guard lock(lock_);
+    std::erase(connections_, connection);
+  });
+
+  connection->Send(banner_);
+}
+
+void SessionReplayServer::OnClientBytesReceived(ReplayConnection& connection) {
+  const std::lock_guard read_lock(connection.ReadLock());
+  auto& read_buffer = connection.ReadBuffer();
+  auto buffer = reinterpret_cast<const char*>(read_buffer.data());
+  auto buffer_end = buffer + read_buffer.size();
+  auto cursor = buffer;
+
+  const std::lock_guard lock(lock_);
+  while (cursor < buffer_end) {
+    if (connection.pending_payload_bytes) {
+      auto available = static_cast<size_t>(buffer_end - cursor);
+      auto consumed = std::min(available, connection.pending_payload_bytes);
+      cursor += consumed;
+      connection.pending_payload_bytes -= consumed;
+      if (!connection.pending_payload_bytes) {
+        ScheduleSteps(connection, connection.pending_exchange,
+                      connection.pending_step);
+      }
+      continue;
+    }
+
+    auto line_end = std::search(cursor, buffer_end, kTerminator,
+                                kTerminator + sizeof(kTerminator) - 1);
+    if (line_end == buffer_end) {
+      break;
+    }
+
+    std::string request(cursor, line_end);
+    cursor = line_end + sizeof(kTerminator) - 1;
+    if (request.empty()) {
+      continue;
+    }
+
+    ++stats_.requests;
+    auto index = FindExchange(request);
+    if (index < 0) {
+      ++stats_.unmatched_requests;
+      LOG(warning) << "Replay: no recorded response for '" << request << "'";
+      auto when = connection.Reserve(std::chrono::steady_clock::now());
+      connection.Schedule(when, std::to_string(ERR_UNKNOWN_COMMAND) +
+                                    "- no recorded response\r\n");
+      task_queue_->Post([weak = connection.weak_from_this()]() {
+        if (auto connection = weak.lock()) {
+          connection->SendDue();
+        }
+      });
+      continue;
+    }
+
+    ScheduleSteps(connection, index, 0);
+
+    if (CommandName(request) == "notifyat") {
+      auto space = request.find(' ');
+      RDCPMapResponse params(
+          space == std::string::npos ? "" : request.substr(space + 1));
+      auto port = params.GetOptionalDWORD("port");
+      if (port.has_value() && !params.HasKey("drop")) {
+        auto address =
+            connection.Address().WithPort(static_cast<uint16_t>(*port));
+        auto when = connection.Reserve(std::chrono::steady_clock::now());
+        task_queue_->PostDelayed(
+            when - std::chrono::steady_clock::now(),
+            [this, address]() { StartNotificationStream(address); });
+      }
+    }
+  }
+
+  connection.ShiftReadBuffer(cursor - buffer);
+}
+
+std::chrono::steady_clock::duration SessionReplayServer::ScaledDelay(
+    uint64_t microseconds) const {
+  return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double, std::micro>(
+          static_cast<double>(microseconds) * latency_scale_));
+}
+
+int SessionReplayServer::FindExchange(const std::string& request) {
+  auto take_unused = [this](std::map<std::string, std::deque<size_t>>& index,
+                            const std::string& key) -> int {
+    auto it = index.find(key);
+    if (it == index.end()) {
+      return -1;
+    }
+    auto& candidates = it->second;
+    while (!candidates.empty() && exchanges_[candidates.front()].used) {
+      candidates.pop_front();
+    }
+    if (candidates.empty()) {
+      return -1;
+    }
+    auto ret = candidates.front();
+    candidates.pop_front();
+    exchanges_[ret].used = true;
+    return static_cast<int>(ret);
+  };
+
+  auto command = CommandName(request);
+  auto ret = take_unused(by_request_, request);
+  if (ret < 0) {
+    ret = take_unused(by_command_, command);
+  }
+  if (ret >= 0) {
+    return ret;
+  }
+
+  auto last = last_by_request_.find(request);
+  if (last == last_by_request_.end()) {
+    last = last_by_command_.find(command);
+    if (last == last_by_command_.end()) {
+      return -1;
+    }
+  }
+  ++stats_.reused_exchanges;
+  return static_cast<int>(last->second);
+}
+
+void SessionReplayServer::ScheduleSteps(ReplayConnection& connection,
+                                        int exchange, size_t first_step) {
+  const auto& steps = exchanges_[exchange].steps;
+  auto weak = connection.weak_from_this();
+  auto now = std::chrono::steady_clock::now();
+  auto reference = now;
+
+  for (auto i = first_step; i < steps.size(); ++i) {
+    const auto& step = steps[i];
+    reference += ScaledDelay(step.delay_us);
+    auto when = connection.Reserve(reference);
+    connection.Schedule(when, step.bytes);
+    task_queue_->PostDelayed(when - now, [weak]() {
+      if (auto connection = weak.lock()) {
+        connection->SendDue();
+      }
+    });
+
+    if (step.payload_bytes) {
+      connection.pending_exchange = exchange;
+      connection.pending_step = i + 1;
+      connection.pending_payload_bytes = step.payload_bytes;
+      return;
+    }
+  }
+  connection.pending_exchange = -1;
+}
+
+void SessionReplayServer::StartNotificationStream(const IPAddress& address) {
+  NotificationStream* stream = nullptr;
+  {
+    const std::lock_guard lock(lock_);
+    if (next_notification_stream_ < notification_streams_.size()) {
+      stream = &notification_streams_[next_notification_stream_++];
+    }
+    ++stats_.notification_streams;
+  }
+
+  int sock = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (sock < 0) {
+    return;
+  }
+
+  // This runs on the select thread, so the connection is completed by it
+  // rather than blocking here. Data is only sent once the socket becomes
+  // writable, and a failed connection is closed by the first send or recv.
+  int flags = fcntl(sock, F_GETFL, 0);
+  if (flags < 0 || fcntl(sock, F_SETFL, flags | O_NONBLOCK) < 0) {
+    LOG(error) << "Replay: failed to make notification socket non-blocking "
+               << errno;
+    close(sock);
+    return;
+  }
+
+  const struct sockaddr_in& addr = address.Address();
+  if (connect(sock, reinterpret_cast<struct sockaddr const*>(&addr),
+              sizeof(addr)) &&
+      errno != EINPROGRESS) {
+    LOG(error) << "Replay: notification connect to " << address
+               << " failed " << errno;
+    close(sock);
+    return;
+  }
+
+  auto connection = std::make_shared<ReplayConnection>("ReplayNotification",
+                                                       sock, address, nullptr);
+  {
+    const std::lock_guard lock(lock_);
+    connections_.push_back(connection);
+  }
+  select_thread_->AddConnection(connection, [this, connection]() {
+    const std::lock_guard lock(lock_);
+    std::erase(connections_, connection);
+  });
+  if (!stream) {
+    return;
+  }
+
+  auto weak = std::weak_ptr<ReplayConnection>(connection);
+  auto now = std::chrono::steady_clock::now();
+  for (const auto& message : *stream) {
+    auto when = connection->Reserve(now + ScaledDelay(message.offset_us));
+    connection->Schedule(when, message.bytes);
+    task_queue_->PostDelayed(when - now, [weak]() {
+      if (auto connection = weak.lock()) {
+        connection->SendDue();
+      }
+    });
+  }
+}
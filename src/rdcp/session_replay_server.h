@@ -0,0 +1,124 @@
+#ifndef XBDM_GDB_BRIDGE_SRC_RDCP_SESSION_REPLAY_SERVER_H_
+#define XBDM_GDB_BRIDGE_SRC_RDCP_SESSION_REPLAY_SERVER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "net/ip_address.h"
+
+class DelegatingServer;
+class SelectThread;
+class TaskConnection;
+
+//! Emulates XBDM by serving back the responses and notifications recorded by
+//! a SessionCaptureWriter, so that realistic sessions may be benchmarked
+//! without hardware.
+//!
+//! Each request line is matched against the recorded requests with the same
+//! text, in the order they were recorded, falling back to requests for the
+//! same command and then to the last matching exchange once all have been
+//! consumed. Responses are delayed by the recorded latency multiplied by the
+//! latency scale. A `notifyat` request causes the next recorded notification
+//! stream to be played back to the requested port with its original timing.
+class SessionReplayServer {
+ public:
+  struct Stats {
+    uint64_t requests{0};
+    //! Requests that were answered by replaying an exchange a second time.
+    uint64_t reused_exchanges{0};
+    //! Requests for which no exchange was recorded.
+    uint64_t unmatched_requests{0};
+    uint64_t notification_streams{0};
+  };
+
+  class ReplayConnection;
+
+  //! `latency_scale` multiplies all recorded delays; 0 serves responses
+  //! immediately.
+  explicit SessionReplayServer(double latency_scale = 1.0);
+  ~SessionReplayServer();
+
+  //! Loads the given capture. Must be called before Start.
+  bool Load(const std::filesystem::path& path);
+
+  bool Start(const IPAddress& address);
+  void Stop();
+
+  [[nodiscard]] const IPAddress& Address() const;
+  [[nodiscard]] Stats GetStats() const;
+
+ private:
+  //! A chunk of bytes sent to the client in response to a request.
+  struct ResponseStep {
+    //! Microseconds after the request (or preceding binary payload) was
+    //! received.
+    uint64_t delay_us{0};
+    std::string bytes;
+    //! The length of the binary payload that the client sends after this
+    //! step, before the following step is sent.
+    size_t payload_bytes{0};
+  };
+
+  struct Exchange {
+    std::string request;
+    std::vector<ResponseStep> steps;
+    bool used{false};
+  };
+
+  struct NotificationMessage {
+    //! Microseconds after the notification stream was opened.
+    uint64_t offset_us;
+    std::string bytes;
+  };
+  typedef std::vector<NotificationMessage> NotificationStream;
+
+  void OnClientConnected(int sock, IPAddress& address);
+  void OnClientBytesReceived(ReplayConnection& connection);
+
+  [[nodiscard]] std::chrono::steady_clock::duration ScaledDelay(
+      uint64_t microseconds) const;
+
+  //! Returns the index of the exchange to replay for the given request or -1.
+  int FindExchange(const std::string& request);
+
+  //! Queues the steps of the given exchange to be sent to the connection,
+  //! stopping after any step that awaits a binary payload.
+  void ScheduleSteps(ReplayConnection& connection, int exchange,
+                     size_t first_step);
+
+  void StartNotificationStream(const IPAddress& address);
+
+ private:
+  double latency_scale_;
+
+  std::shared_ptr<SelectThread> select_thread_;
+  std::shared_ptr<TaskConnection> task_queue_;
+  std::shared_ptr<DelegatingServer> server_;
+  bool running_{false};
+
+  mutable std::mutex lock_;
+  std::string banner_;
+  std::vector<Exchange> exchanges_;
+  //! Indices into `exchanges_` that have not yet been used, keyed by request
+  //! text and by command.
+  std::map<std::string, std::deque<size_t>> by_request_;
+  std::map<std::string, std::deque<size_t>> by_command_;
+  //! The last recorded exchange for each request text and command.
+  std::map<std::string, size_t> last_by_request_;
+  std::map<std::string, size_t> last_by_command_;
+
+  std::vector<NotificationStream> notification_streams_;
+  size_t next_notification_stream_{0};
+
+  std::vector<std::shared_ptr<ReplayConnection>> connections_;
+  Stats stats_;
+};
+
+#endif  // XBDM_GDB_BRIDGE_SRC_RDCP_SESSION_REPLAY_SERVER_H_
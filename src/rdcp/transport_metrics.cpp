@@ -0,0 +1,353 @@
+#include "transport_metrics.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iomanip>
+#include <vector>
+
+//! Histogram bucket boundaries used for Prometheus export, in microseconds.
+static constexpr uint64_t kPrometheusBucketBoundaries[] = {
+    100,    250,    500,     1000,    2500,    5000,    10000,    25000,
+    50000,  100000, 250000,  500000,  1000000, 2500000, 5000000, 10000000,
+};
+
+void LatencyHistogram::Record(uint64_t microseconds) {
+  ++counts_[BucketIndex(microseconds)];
+  ++count_;
+  sum_ += microseconds;
+  min_ = std::min(min_, microseconds);
+  max_ = std::max(max_, microseconds);
+}
+
+void LatencyHistogram::Record(std::chrono::steady_clock::duration duration) {
+  auto microseconds =
+      std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+  Record(static_cast<uint64_t>(std::max<int64_t>(microseconds, 0)));
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+  for (uint32_t i = 0; i < kBucketCount; ++i) {
+    counts_[i] += other.counts_[i];
+  }
+  count_ += other.count_;
+  sum_ += other.sum_;
+  min_ = std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+}
+
+double LatencyHistogram::MeanMicroseconds() const {
+  if (!count_) {
+    return 0;
+  }
+  return static_cast<double>(sum_) / static_cast<double>(count_);
+}
+
+uint64_t LatencyHistogram::ValueAtPercentile(double percentile) const {
+  if (!count_) {
+    return 0;
+  }
+
+  auto target = static_cast<uint64_t>(
+      std::ceil(std::clamp(percentile, 0.0, 100.0) / 100.0 *
+                static_cast<double>(count_)));
+  target = std::clamp<uint64_t>(target, 1, count_);
+
+  uint64_t cumulative = 0;
+  for (uint32_t i = 0; i < kBucketCount; ++i) {
+    cumulative += counts_[i];
+    if (cumulative >= target) {
+      return std::min(BucketUpperBound(i), max_);
+    }
+  }
+  return max_;
+}
+
+uint64_t LatencyHistogram::CountAtOrBelow(uint64_t microseconds) const {
+  if (!count_ || microseconds < min_) {
+    return 0;
+  }
+  if (microseconds >= max_) {
+    return count_;
+  }
+
+  uint64_t ret = 0;
+  for (uint32_t i = 0; i < kBucketCount; ++i) {
+    auto upper = BucketUpperBound(i);
+    if (upper <= microseconds) {
+      ret += counts_[i];
+      continue;
+    }
+
+    // The bucket straddles the boundary, so assume its values are spread
+    // evenly over the part of it that lies within [min, max].
+    auto lower = std::max(BucketLowerBound(i), min_);
+    upper = std::min(upper, max_);
+    if (counts_[i] && lower <= microseconds) {
+      auto fraction = static_cast<double>(microseconds - lower + 1) /
+                      static_cast<double>(upper - lower + 1);
+      ret += static_cast<uint64_t>(static_cast<double>(counts_[i]) * fraction);
+    }
+    break;
+  }
+  return ret;
+}
+
+uint32_t LatencyHistogram::BucketIndex(uint64_t value) {
+  if (value < kSubBucketCount) {
+    return static_cast<uint32_t>(value);
+  }
+
+  auto shift = static_cast<uint32_t>(std::bit_width(value)) - 1 -
+               kSubBucketBits;
+  auto sub_bucket = static_cast<uint32_t>(value >> shift) - kSubBucketCount;
+  return kSubBucketCount + shift * kSubBucketCount + sub_bucket;
+}
+
+uint64_t LatencyHistogram::BucketLowerBound(uint32_t index) {
+  if (index < kSubBucketCount) {
+    return index;
+  }
+
+  auto shift = (index - kSubBucketCount) / kSubBucketCount;
+  auto sub_bucket = (index - kSubBucketCount) % kSubBucketCount;
+  return static_cast<uint64_t>(kSubBucketCount + sub_bucket) << shift;
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(uint32_t index) {
+  if (index < kSubBucketCount) {
+    return index;
+  }
+
+  auto shift = (index - kSubBucketCount) / kSubBucketCount;
+  return BucketLowerBound(index) + ((uint64_t{1} << shift) - 1);
+}
+
+void TransportMetrics::RecordQueueDepth(size_t depth) {
+  const std::lock_guard lock(lock_);
+  stats_.queue_depth = depth;
+  stats_.max_queue_depth = std::max<uint64_t>(stats_.max_queue_depth, depth);
+}
+
+void TransportMetrics::RecordQueueWait(
+    std::chrono::steady_clock::duration duration) {
+  const std::lock_guard lock(lock_);
+  stats_.queue_wait.Record(duration);
+}
+
+void TransportMetrics::RecordExecutorWait(
+    std::chrono::steady_clock::duration duration) {
+  const std::lock_guard lock(lock_);
+  stats_.executor_wait.Record(duration);
+}
+
+void TransportMetrics::RecordCompletion(
+    const std::string& command, uint64_t bytes_sent, uint64_t bytes_received,
+    std::chrono::steady_clock::duration round_trip) {
+  const std::lock_guard lock(lock_);
+  auto& stats = stats_.commands[command];
+  ++stats.count;
+  stats.bytes_sent += bytes_sent;
+  stats.bytes_received += bytes_received;
+  stats.round_trip.Record(round_trip);
+}
+
+TransportMetrics::Snapshot TransportMetrics::GetSnapshot() const {
+  const std::lock_guard lock(lock_);
+  return stats_;
+}
+
+void TransportMetrics::Reset() {
+  const std::lock_guard lock(lock_);
+  auto queue_depth = stats_.queue_depth;
+  stats_ = Snapshot();
+  stats_.queue_depth = queue_depth;
+  stats_.max_queue_depth = queue_depth;
+}
+
+static double ToMilliseconds(uint64_t microseconds) {
+  return static_cast<double>(microseconds) / 1000.0;
+}
+
+static void PrintHistogramSummary(std::ostream& os,
+                                  const LatencyHistogram& histogram) {
+  os << histogram.Count() << " mean "
+     << histogram.MeanMicroseconds() / 1000.0 << " ms p50 "
+     << ToMilliseconds(histogram.ValueAtPercentile(50)) << " ms p99 "
+     << ToMilliseconds(histogram.ValueAtPercentile(99)) << " ms max "
+     << ToMilliseconds(histogram.MaxMicroseconds()) << " ms";
+}
+
+void PrintTransportMetrics(
+    std::ostream& os,
+    const std::map<std::string, TransportMetrics::Snapshot>& metrics) {
+  auto flags = os.flags();
+  auto precision = os.precision();
+  os << std::fixed << std::setprecision(3);
+
+  for (const auto& [transport, snapshot] : metrics) {
+    os << transport << ": queue depth " << snapshot.queue_depth << " (max "
+       << snapshot.max_queue_depth << ")" << std::endl;
+    os << "  queue wait: ";
+    PrintHistogramSummary(os, snapshot.queue_wait);
+    os << std::endl << "  executor wait: ";
+    PrintHistogramSummary(os, snapshot.executor_wait);
+    os << std::endl;
+
+    if (snapshot.commands.empty()) {
+      continue;
+    }
+
+    // List the commands that account for the most time first.
+    std::vector<const decltype(snapshot.commands)::value_type*> commands;
+    for (const auto& entry : snapshot.commands) {
+      commands.push_back(&entry);
+    }
+    std::sort(commands.begin(), commands.end(), [](auto a, auto b) {
+      return a->second.round_trip.SumMicroseconds() >
+             b->second.round_trip.SumMicroseconds();
+    });
+
+    os << "  " << std::left << std::setw(20) << "command" << std::right
+       << std::setw(8) << "count" << std::setw(12) << "sent" << std::setw(12)
+       << "received" << std::setw(12) << "total ms" << std::setw(10)
+       << "p50 ms" << std::setw(10) << "p99 ms" << std::setw(10) << "max ms"
+       << std::endl;
+    for (auto entry : commands) {
+      const auto& stats = entry->second;
+      os << "  " << std::left << std::setw(20) << entry->first << std::right
+         << std::setw(8) << stats.count << std::setw(12) << stats.bytes_sent
+         << std::setw(12) << stats.bytes_received << std::setw(12)
+         << ToMilliseconds(stats.round_trip.SumMicroseconds())
+         << std::setw(10)
+         << ToMilliseconds(stats.round_trip.ValueAtPercentile(50))
+         << std::setw(10)
+         << ToMilliseconds(stats.round_trip.ValueAtPercentile(99))
+         << std::setw(10) << ToMilliseconds(stats.round_trip.MaxMicroseconds())
+         << std::endl;
+    }
+  }
+
+  os.flags(flags);
+  os.precision(precision);
+}
+
+static std::string EscapeLabelValue(const std::string& value) {
+  std::string ret;
+  ret.reserve(value.size());
+  for (auto c : value) {
+    switch (c) {
+      case '\\':
+        ret += "\\\\";
+        break;
+      case '"':
+        ret += "\\\"";
+        break;
+      case '\n':
+        ret += "\\n";
+        break;
+      default:
+        ret += c;
+    }
+  }
+  return ret;
+}
+
+static void WritePrometheusHistogram(std::ostream& os, const char* name,
+                                     const std::string& labels,
+                                     const LatencyHistogram& histogram) {
+  for (auto boundary : kPrometheusBucketBoundaries) {
+    os << name << "_bucket{" << labels << ",le=\""
+       << static_cast<double>(boundary) / 1e6 << "\"} "
+       << histogram.CountAtOrBelow(boundary) << "\n";
+  }
+  os << name << "_bucket{" << labels << ",le=\"+Inf\"} " << histogram.Count()
+     << "\n";
+  os << name << "_sum{" << labels << "} "
+     << static_cast<double>(histogram.SumMicroseconds()) / 1e6 << "\n";
+  os << name << "_count{" << labels << "} " << histogram.Count() << "\n";
+}
+
+void WritePrometheusMetrics(
+    std::ostream& os,
+    const std::map<std::string, TransportMetrics::Snapshot>& metrics) {
+  auto write_header = [&os](const char* name, const char* type,
+                            const char* help) {
+    os << "# HELP " << name << " " << help << "\n";
+    os << "# TYPE " << name << " " << type << "\n";
+  };
+
+  auto for_each_command = [&metrics](auto&& visitor) {
+    for (const auto& [transport, snapshot] : metrics) {
+      auto transport_label = "transport=\"" + EscapeLabelValue(transport) +
+                             "\"";
+      for (const auto& [command, stats] : snapshot.commands) {
+        visitor(transport_label + ",command=\"" + EscapeLabelValue(command) +
+                    "\"",
+                stats);
+      }
+    }
+  };
+
+  write_header("xbdm_command_requests_total", "counter",
+               "Completed XBDM requests.");
+  for_each_command([&os](const std::string& labels, const auto& stats) {
+    os << "xbdm_command_requests_total{" << labels << "} " << stats.count
+       << "\n";
+  });
+
+  write_header("xbdm_command_sent_bytes_total", "counter",
+               "Bytes written for XBDM requests, including binary payloads.");
+  for_each_command([&os](const std::string& labels, const auto& stats) {
+    os << "xbdm_command_sent_bytes_total{" << labels << "} "
+       << stats.bytes_sent << "\n";
+  });
+
+  write_header("xbdm_command_received_bytes_total", "counter",
+               "Bytes read for XBDM responses.");
+  for_each_command([&os](const std::string& labels, const auto& stats) {
+    os << "xbdm_command_received_bytes_total{" << labels << "} "
+       << stats.bytes_received << "\n";
+  });
+
+  write_header("xbdm_command_round_trip_seconds", "histogram",
+               "Time from an XBDM request being sent until its response.");
+  for_each_command([&os](const std::string& labels, const auto& stats) {
+    WritePrometheusHistogram(os, "xbdm_command_round_trip_seconds", labels,
+                             stats.round_trip);
+  });
+
+  write_header("xbdm_transport_queue_depth", "gauge",
+               "Requests queued on the XBDM transport.");
+  for (const auto& [transport, snapshot] : metrics) {
+    os << "xbdm_transport_queue_depth{transport=\""
+       << EscapeLabelValue(transport) << "\"} " << snapshot.queue_depth
+       << "\n";
+  }
+
+  write_header("xbdm_transport_max_queue_depth", "gauge",
+               "Maximum requests queued on the XBDM transport.");
+  for (const auto& [transport, snapshot] : metrics) {
+    os << "xbdm_transport_max_queue_depth{transport=\""
+       << EscapeLabelValue(transport) << "\"} " << snapshot.max_queue_depth
+       << "\n";
+  }
+
+  write_header("xbdm_transport_queue_wait_seconds", "histogram",
+               "Time from a request being queued until it was sent.");
+  for (const auto& [transport, snapshot] : metrics) {
+    WritePrometheusHistogram(
+        os, "xbdm_transport_queue_wait_seconds",
+        "transport=\"" + EscapeLabelValue(transport) + "\"",
+        snapshot.queue_wait);
+  }
+
+  write_header("xbdm_executor_wait_seconds", "histogram",
+               "Time from a command being dispatched until it was executed.");
+  for (const auto& [transport, snapshot] : metrics) {
+    WritePrometheusHistogram(
+        os, "xbdm_executor_wait_seconds",
+        "transport=\"" + EscapeLabelValue(transport) + "\"",
+        snapshot.executor_wait);
+  }
+}
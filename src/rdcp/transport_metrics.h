@@ -0,0 +1,113 @@
+#ifndef XBDM_GDB_BRIDGE_SRC_RDCP_TRANSPORT_METRICS_H_
+#define XBDM_GDB_BRIDGE_SRC_RDCP_TRANSPORT_METRICS_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+//! Records a distribution of durations in microseconds with bounded relative
+//! error, in the style of HdrHistogram.
+//!
+//! Values below kSubBucketCount are recorded exactly. Larger values fall into
+//! one of kSubBucketCount linear sub-buckets per power of two, so any value
+//! reported by ValueAtPercentile is within 1 / kSubBucketCount of the
+//! recorded value.
+class LatencyHistogram {
+ public:
+  static constexpr uint32_t kSubBucketBits = 4;
+  static constexpr uint32_t kSubBucketCount = 1 << kSubBucketBits;
+  static constexpr uint32_t kBucketCount =
+      kSubBucketCount + (64 - kSubBucketBits) * kSubBucketCount;
+
+  void Record(uint64_t microseconds);
+  void Record(std::chrono::steady_clock::duration duration);
+  void Merge(const LatencyHistogram& other);
+
+  [[nodiscard]] uint64_t Count() const { return count_; }
+  [[nodiscard]] uint64_t SumMicroseconds() const { return sum_; }
+  [[nodiscard]] uint64_t MinMicroseconds() const { return count_ ? min_ : 0; }
+  [[nodiscard]] uint64_t MaxMicroseconds() const { return max_; }
+  [[nodiscard]] double MeanMicroseconds() const;
+
+  //! Returns the smallest recorded value such that `percentile` percent of
+  //! recorded values are less than or equal to it, rounded up to the bucket's
+  //! upper bound.
+  [[nodiscard]] uint64_t ValueAtPercentile(double percentile) const;
+
+  //! Returns the number of recorded values at or below `microseconds`. Values
+  //! in the bucket containing `microseconds` are assumed to be evenly
+  //! distributed across it.
+  [[nodiscard]] uint64_t CountAtOrBelow(uint64_t microseconds) const;
+
+ private:
+  static uint32_t BucketIndex(uint64_t value);
+  static uint64_t BucketLowerBound(uint32_t index);
+  static uint64_t BucketUpperBound(uint32_t index);
+
+ private:
+  std::array<uint64_t, kBucketCount> counts_{};
+  uint64_t count_{0};
+  uint64_t sum_{0};
+  uint64_t min_{UINT64_MAX};
+  uint64_t max_{0};
+};
+
+//! Always-on request statistics for a single XBDM connection, retained across
+//! reconnects.
+class TransportMetrics {
+ public:
+  struct CommandStats {
+    uint64_t count{0};
+    uint64_t bytes_sent{0};
+    uint64_t bytes_received{0};
+    //! Time from the request being written to the socket until its final
+    //! response was parsed.
+    LatencyHistogram round_trip;
+  };
+
+  struct Snapshot {
+    //! Keyed by RDCP command name.
+    std::map<std::string, CommandStats> commands;
+    //! The number of requests queued on the transport, including those
+    //! awaiting a response.
+    uint64_t queue_depth{0};
+    uint64_t max_queue_depth{0};
+    //! Time from a request being queued on the transport until it was written
+    //! to the socket.
+    LatencyHistogram queue_wait;
+    //! Time from a command being dispatched to the channel's executor until
+    //! the executor began processing it.
+    LatencyHistogram executor_wait;
+  };
+
+  void RecordQueueDepth(size_t depth);
+  void RecordQueueWait(std::chrono::steady_clock::duration duration);
+  void RecordExecutorWait(std::chrono::steady_clock::duration duration);
+  void RecordCompletion(const std::string& command, uint64_t bytes_sent,
+                        uint64_t bytes_received,
+                        std::chrono::steady_clock::duration round_trip);
+
+  [[nodiscard]] Snapshot GetSnapshot() const;
+  void Reset();
+
+ private:
+  mutable std::mutex lock_;
+  Snapshot stats_;
+};
+
+//! Prints a human readable summary of the given per-transport metrics.
+void PrintTransportMetrics(
+    std::ostream& os,
+    const std::map<std::string, TransportMetrics::Snapshot>& metrics);
+
+//! Writes the given per-transport metrics in the Prometheus text exposition
+//! format.
+void WritePrometheusMetrics(
+    std::ostream& os,
+    const std::map<std::string, TransportMetrics::Snapshot>& metrics);
+
+#endif  // XBDM_GDB_BRIDGE_SRC_RDCP_TRANSPORT_METRICS_H_
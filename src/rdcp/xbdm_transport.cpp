@@ -13,11 +13,16 @@ bool XBDMTransport::Connect(const IPAddress& address) {
   }
 
   LOG_XBDM(trace) << Name() << " connecting to XBDM at " << address;
+  connect_timer_.Start();
   socket_ = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
   if (socket_ < 0) {
     return false;
   }
 
+  // Commands may not be sent until XBDM sends its connection banner, which may
+  // be processed by the SelectThread before connect() returns.
+  SetState(ConnectionState::INIT);
+
   address_ = address;
   const struct sockaddr_in& addr = address.Address();
   if (connect(socket_, reinterpret_cast<struct sockaddr const*>(&addr),
@@ -25,70 +30,216 @@ bool XBDMTransport::Connect(const IPAddress& address) {
     LOG_XBDM(error) << Name() << " connect failed " << errno;
     close(socket_);
     socket_ = -1;
+    SetState(ConnectionState::DISCONNECTED);
     return false;
   }
 
   LOG_XBDM(trace) << Name() << " connected.";
-
   SignalProcessingNeeded();
 
   return true;
 }
 
 void XBDMTransport::Close() {
-  state_ = ConnectionState::INIT;
+  auto previous_state = state_.exchange(ConnectionState::DISCONNECTED);
   TCPConnection::Close();
 
-  const std::lock_guard lock(request_queue_lock_);
-  for (auto& request : request_queue_) {
-    request->Abandon();
+  {
+    const std::lock_guard lock(request_queue_lock_);
+    // Requests that have been written may or may not have been processed by
+    // XBDM, so they cannot safely be resent.
+    auto first_unsent = request_queue_.begin() +
+                        static_cast<std::ptrdiff_t>(requests_written_);
+    for (auto it = request_queue_.begin(); it != first_unsent; ++it) {
+      it->request->Abandon();
+    }
+    request_queue_.erase(request_queue_.begin(), first_unsent);
+    requests_written_ = 0;
+
+    if (!hold_unsent_requests_) {
+      AbandonUnsentRequests();
+    }
+    metrics_->RecordQueueDepth(request_queue_.size());
   }
-  request_queue_.clear();
+  capture_.Close();
 
+  if (previous_state != ConnectionState::DISCONNECTED) {
+    NotifyStateChanged();
+  }
   SignalProcessingNeeded();
 }
 
 void XBDMTransport::SetConnected() {
   if (state_ < ConnectionState::CONNECTED) {
-    state_ = ConnectionState::CONNECTED;
+    SetState(ConnectionState::CONNECTED);
   }
 }
 
-void XBDMTransport::Send(const std::shared_ptr<RDCPRequest>& request) {
-  const std::lock_guard lock(request_queue_lock_);
-  request_queue_.push_back(request);
+void XBDMTransport::SetState(ConnectionState state) {
+  if (state_.exchange(state) != state) {
+    NotifyStateChanged();
+  }
+}
 
-  WriteNextRequest();
+void XBDMTransport::NotifyStateChanged() {
+  StateChangedHandler handler;
+  {
+    // Taking the lock ensures that any waiter has either not yet evaluated the
+    // state or is blocked and will receive the notification.
+    const std::lock_guard lock(state_lock_);
+    handler = state_changed_handler_;
+  }
+  state_changed_.notify_all();
+
+  if (handler) {
+    handler(*this);
+  }
 }
 
-void XBDMTransport::WriteNextRequest() {
-  if (state_ != ConnectionState::CONNECTED) {
+bool XBDMTransport::WaitUntilConnected(int max_wait_milliseconds) {
+  std::unique_lock lock(state_lock_);
+  state_changed_.wait_for(
+      lock, std::chrono::milliseconds(max_wait_milliseconds),
+      [this]() { return state_ != ConnectionState::INIT; });
+  return CanProcessCommands();
+}
+
+void XBDMTransport::SetStateChangedHandler(StateChangedHandler handler) {
+  const std::lock_guard lock(state_lock_);
+  state_changed_handler_ = std::move(handler);
+}
+
+void XBDMTransport::SetMetrics(std::shared_ptr<TransportMetrics> metrics) {
+  metrics_ = std::move(metrics);
+}
+
+void XBDMTransport::SetCapture(
+    const std::shared_ptr<SessionCaptureWriter>& writer) {
+  capture_.SetWriter(writer, Name());
+}
+
+bool XBDMTransport::HasUnsentRequests() {
+  const std::lock_guard lock(request_queue_lock_);
+  return request_queue_.size() > requests_written_;
+}
+
+void XBDMTransport::TakeUnsentRequests(XBDMTransport& previous) {
+  std::deque<QueuedRequest> unsent;
+  {
+    const std::lock_guard lock(previous.request_queue_lock_);
+    auto first_unsent =
+        previous.request_queue_.begin() +
+        static_cast<std::ptrdiff_t>(previous.requests_written_);
+    unsent.assign(std::make_move_iterator(first_unsent),
+                  std::make_move_iterator(previous.request_queue_.end()));
+    previous.request_queue_.erase(first_unsent, previous.request_queue_.end());
+  }
+
+  if (unsent.empty()) {
     return;
   }
 
+  LOG_XBDM(trace) << Name() << " holding " << unsent.size()
+                  << " requests from " << previous.Name();
+  const std::lock_guard lock(request_queue_lock_);
+  request_queue_.insert(request_queue_.begin() +
+                            static_cast<std::ptrdiff_t>(requests_written_),
+                        std::make_move_iterator(unsent.begin()),
+                        std::make_move_iterator(unsent.end()));
+  WriteNextRequests();
+}
+
+void XBDMTransport::AbandonUnsentRequests() {
+  const std::lock_guard lock(request_queue_lock_);
+  auto first_unsent = request_queue_.begin() +
+                      static_cast<std::ptrdiff_t>(requests_written_);
+  for (auto it = first_unsent; it != request_queue_.end(); ++it) {
+    it->request->Abandon();
+  }
+  request_queue_.erase(first_unsent, request_queue_.end());
+}
+
+void XBDMTransport::Send(const std::shared_ptr<RDCPRequest>& request) {
+  const std::lock_guard lock(request_queue_lock_);
+  Enqueue(request, false);
+
+  WriteNextRequests();
+}
+
+void XBDMTransport::SendPipelined(
+    const std::vector<std::shared_ptr<RDCPRequest>>& requests) {
   const std::lock_guard lock(request_queue_lock_);
-  if (request_queue_.empty()) {
+  for (const auto& request : requests) {
+    Enqueue(request, true);
+  }
+
+  WriteNextRequests();
+}
+
+void XBDMTransport::Enqueue(const std::shared_ptr<RDCPRequest>& request,
+                            bool pipelined) {
+  QueuedRequest entry{request, pipelined, std::chrono::steady_clock::now()};
+  request_queue_.push_back(std::move(entry));
+  metrics_->RecordQueueDepth(request_queue_.size());
+}
+
+bool XBDMTransport::CanWriteNextRequest() const {
+  if (requests_written_ >= request_queue_.size()) {
+    return false;
+  }
+  if (!requests_written_) {
+    return true;
+  }
+
+  // Only pipelined requests may be written while others are outstanding, and
+  // never behind one that may need to send a binary payload.
+  const auto& previous = request_queue_[requests_written_ - 1];
+  return request_queue_[requests_written_].pipelined && previous.pipelined &&
+         !previous.request->BinaryPayload();
+}
+
+void XBDMTransport::WriteNextRequests() {
+  if (state_ != ConnectionState::CONNECTED) {
     return;
   }
 
-  const auto& request = request_queue_.front();
+  const std::lock_guard lock(request_queue_lock_);
+  while (CanWriteNextRequest()) {
+    auto& entry = request_queue_[requests_written_++];
 #ifdef ENABLE_HIGH_VERBOSITY_LOGGING
-  LOG_XBDM(trace) << "XBDM request: '" << *request << "'";
-  request_sent_.Start();
+    LOG_XBDM(trace) << "XBDM request: '" << *entry.request << "'";
 #endif
-  std::vector<uint8_t> buffer = static_cast<std::vector<uint8_t>>(*request);
-  TCPConnection::Send(buffer);
+    std::vector<uint8_t> buffer =
+        static_cast<std::vector<uint8_t>>(*entry.request);
+    entry.written_at = std::chrono::steady_clock::now();
+    entry.bytes_sent = buffer.size();
+    metrics_->RecordQueueWait(entry.written_at - entry.queued_at);
+    capture_.Record(session_capture::RecordType::REQUEST, buffer.data(),
+                    buffer.size());
+    TCPConnection::Send(buffer);
+  }
 }
 
 void XBDMTransport::OnBytesRead() {
   TCPConnection::OnBytesRead();
 
+  // Pipelined requests may cause several responses to arrive in one read.
+  while (ProcessNextResponse()) {
+  }
+}
+
+bool XBDMTransport::ProcessNextResponse() {
   const std::lock_guard read_lock(read_lock_);
   char const* char_buffer = reinterpret_cast<char*>(read_buffer_.data());
 
+  // Responses are only expected for requests that have been written; anything
+  // else is the unsolicited response sent by XBDM on connection.
   std::shared_ptr<RDCPRequest> request;
-  if (!request_queue_.empty()) {
-    request = request_queue_.front();
+  {
+    const std::lock_guard lock(request_queue_lock_);
+    if (requests_written_) {
+      request = request_queue_.front().request;
+    }
   }
   std::shared_ptr<RDCPResponse> response;
 
@@ -100,17 +251,23 @@ void XBDMTransport::OnBytesRead() {
   auto bytes_consumed = RDCPResponse::Parse(response, char_buffer,
                                             read_buffer_.size(), size_parser);
   if (!bytes_consumed) {
-    return;
+    return false;
   }
 
   if (bytes_consumed < 0) {
     bytes_consumed *= -1;
     LOG_XBDM(trace) << "Discarding " << bytes_consumed << " bytes";
   }
+  capture_.Record(response ? session_capture::RecordType::RESPONSE
+                           : session_capture::RecordType::DISCARDED,
+                  char_buffer, bytes_consumed);
 
   ShiftReadBuffer(bytes_consumed);
+  if (!response) {
+    return true;
+  }
 
-  if (request_queue_.empty()) {
+  if (!request) {
     // On initial connection, XBDM will send an unsolicited OK response.
     HandleInitialConnectResponse(response);
   } else {
@@ -123,27 +280,67 @@ void XBDMTransport::OnBytesRead() {
         assert(!"Binary payload requested from remote but not attached to request.");
       }
 
+      {
+        const std::lock_guard lock(request_queue_lock_);
+        if (!IsOutstandingHead(request)) {
+          LOG_XBDM(trace) << "Dropping response to abandoned request.";
+          return true;
+        }
+        auto& entry = request_queue_.front();
+        entry.bytes_sent += payload->size();
+        entry.bytes_received += bytes_consumed;
+      }
+      capture_.Record(session_capture::RecordType::BINARY_PAYLOAD,
+                      payload->data(), payload->size());
       TCPConnection::Send(*payload);
 
       // The request will be finished by the response to the binary being sent.
-      return;
+      return true;
+    }
+
+    QueuedRequest completed;
+    {
+      const std::lock_guard lock(request_queue_lock_);
+      // The queue may have been cleared by Close() since the request was
+      // looked up, in which case the request has already been abandoned.
+      if (!IsOutstandingHead(request)) {
+        LOG_XBDM(trace) << "Dropping response to abandoned request.";
+        return true;
+      }
+      completed = std::move(request_queue_.front());
+      request_queue_.pop_front();
+      --requests_written_;
+      metrics_->RecordQueueDepth(request_queue_.size());
+      WriteNextRequests();
     }
 
-    request_queue_.pop_front();
-    WriteNextRequest();
+    auto round_trip = std::chrono::steady_clock::now() - completed.written_at;
+    metrics_->RecordCompletion(request->Command(), completed.bytes_sent,
+                               completed.bytes_received + bytes_consumed,
+                               round_trip);
 
 #ifdef ENABLE_HIGH_VERBOSITY_LOGGING
     LOG_XBDM(trace) << "Request '" << *request << "' round trip "
-                    << request_sent_.FractionalMillisecondsElapsed() << " ms";
+                    << std::chrono::duration<double, std::milli>(round_trip)
+                           .count()
+                    << " ms";
     LOG_XBDM(trace) << "Response: " << *response;
-    request_sent_.Start();
+    Timer completion_timer;
 #endif
     request->Complete(response);
 #ifdef ENABLE_HIGH_VERBOSITY_LOGGING
     LOG_XBDM(trace) << "Completion of request '" << *request << "' took "
-                    << request_sent_.FractionalMillisecondsElapsed() << " ms";
+                    << completion_timer.FractionalMillisecondsElapsed()
+                    << " ms";
 #endif
   }
+
+  return true;
+}
+
+bool XBDMTransport::IsOutstandingHead(
+    const std::shared_ptr<RDCPRequest>& request) const {
+  return requests_written_ && request_queue_.front().request == request;
 }
 
 void XBDMTransport::HandleInitialConnectResponse(
@@ -153,7 +350,11 @@ void XBDMTransport::HandleInitialConnectResponse(
 #endif
 
   if (response->Status() == StatusCode::OK_CONNECTED) {
-    state_ = ConnectionState::CONNECTED;
+    last_connect_milliseconds_ = connect_timer_.FractionalMillisecondsElapsed();
+    LOG_XBDM(trace) << Name() << " accepted after "
+                    << last_connect_milliseconds_.load() << " ms";
+    SetState(ConnectionState::CONNECTED);
+    WriteNextRequests();
     return;
   }
 
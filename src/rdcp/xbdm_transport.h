@@ -1,16 +1,20 @@
 #ifndef XBDM_GDB_BRIDGE_SRC_RDCP_XBDM_TRANSPORT_H_
 #define XBDM_GDB_BRIDGE_SRC_RDCP_XBDM_TRANSPORT_H_
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <deque>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 #include "configure.h"
 #include "net/tcp_connection.h"
-
-#ifdef ENABLE_HIGH_VERBOSITY_LOGGING
+#include "rdcp/session_capture.h"
+#include "rdcp/transport_metrics.h"
 #include "util/timer.h"
-#endif
 
 class RDCPRequest;
 class RDCPResponse;
@@ -19,11 +23,16 @@ class XBDMTransport : public TCPConnection {
  public:
   enum class ConnectionState {
     DISCONNECTED = -1,
+    //! The socket is connected but XBDM has not yet sent its banner.
     INIT = 0,
     CONNECTED,
     AWAITING_RESPONSE
   };
 
+  //! Invoked whenever the connection state changes. May be called from the
+  //! SelectThread and must not block.
+  typedef std::function<void(XBDMTransport&)> StateChangedHandler;
+
  public:
   explicit XBDMTransport(std::string name) : TCPConnection(std::move(name)) {}
 
@@ -37,30 +46,104 @@ class XBDMTransport : public TCPConnection {
 
   void SetConnected();
 
+  //! Blocks until XBDM has accepted the connection, the transport is closed,
+  //! or the timeout expires. Returns true if commands may be processed.
+  bool WaitUntilConnected(int max_wait_milliseconds);
+
+  void SetStateChangedHandler(StateChangedHandler handler);
+
+  //! Sets the object into which per-command statistics are recorded so that
+  //! they may be shared by successive transports for the same channel. Must be
+  //! called before Connect.
+  void SetMetrics(std::shared_ptr<TransportMetrics> metrics);
+
+  //! Records all subsequent traffic on this transport to the given writer.
+  //! Passing nullptr stops recording.
+  void SetCapture(const std::shared_ptr<SessionCaptureWriter>& writer);
+
+  //! Milliseconds between the last call to Connect and the XBDM banner.
+  [[nodiscard]] double LastConnectMilliseconds() const {
+    return last_connect_milliseconds_;
+  }
+
+  //! When set, requests that have not yet been written to the socket survive
+  //! Close() so that they may be moved to a replacement transport via
+  //! TakeUnsentRequests. Requests awaiting a response are always abandoned,
+  //! as XBDM may or may not have processed them.
+  void SetHoldUnsentRequests(bool hold) { hold_unsent_requests_ = hold; }
+  [[nodiscard]] bool HasUnsentRequests();
+  //! Moves any unsent requests from `previous` to the front of this
+  //! transport's queue.
+  void TakeUnsentRequests(XBDMTransport& previous);
+  void AbandonUnsentRequests();
+
   void Send(const std::shared_ptr<RDCPRequest>& request);
 
+  //! Queues the given requests and writes them to the socket back to back
+  //! rather than waiting for each response before sending the next request.
+  //!
+  //! Requests that carry a binary payload are not pipelined past, since XBDM
+  //! would otherwise interpret the following requests as payload data.
+  void SendPipelined(const std::vector<std::shared_ptr<RDCPRequest>>& requests);
+
   void NotifyRemoved() override {
-    state_ = ConnectionState::DISCONNECTED;
     is_shutdown_ = true;
+    SetState(ConnectionState::DISCONNECTED);
   }
 
  protected:
   void OnBytesRead() override;
+  //! Parses and dispatches a single response from the read buffer. Returns
+  //! false if the buffer does not contain a complete response.
+  bool ProcessNextResponse();
   void HandleInitialConnectResponse(
       const std::shared_ptr<RDCPResponse>& response);
 
  private:
-  void WriteNextRequest();
+  void SetState(ConnectionState state);
+  void NotifyStateChanged();
+
+  //! Writes as many queued requests as may be outstanding at once.
+  void WriteNextRequests();
+  [[nodiscard]] bool CanWriteNextRequest() const;
+  //! Returns true if `request` is the oldest written request. Must be called
+  //! with request_queue_lock_ held.
+  [[nodiscard]] bool IsOutstandingHead(
+      const std::shared_ptr<RDCPRequest>& request) const;
 
  private:
-  ConnectionState state_{ConnectionState::INIT};
+  struct QueuedRequest {
+    std::shared_ptr<RDCPRequest> request;
+    bool pipelined;
+    std::chrono::steady_clock::time_point queued_at;
+    std::chrono::steady_clock::time_point written_at{};
+    uint64_t bytes_sent{0};
+    uint64_t bytes_received{0};
+  };
+
+  //! Queues `request` on the transport. request_queue_lock_ must be held.
+  void Enqueue(const std::shared_ptr<RDCPRequest>& request, bool pipelined);
+
+  std::atomic<ConnectionState> state_{ConnectionState::DISCONNECTED};
+  std::mutex state_lock_;
+  std::condition_variable state_changed_;
+  StateChangedHandler state_changed_handler_;
+
+  Timer connect_timer_;
+  std::atomic<double> last_connect_milliseconds_{0};
+
+  bool hold_unsent_requests_{false};
 
   std::recursive_mutex request_queue_lock_;
-  std::deque<std::shared_ptr<RDCPRequest>> request_queue_;
+  std::deque<QueuedRequest> request_queue_;
+  //! The number of requests at the front of request_queue_ that have been
+  //! written to the socket and are awaiting a response.
+  size_t requests_written_{0};
+
+  std::shared_ptr<TransportMetrics> metrics_{
+      std::make_shared<TransportMetrics>()};
 
-#ifdef ENABLE_HIGH_VERBOSITY_LOGGING
-  Timer request_sent_;
-#endif
+  SessionCaptureStream capture_{session_capture::StreamKind::CONTROL};
 };
 
 #endif  // XBDM_GDB_BRIDGE_SRC_RDCP_XBDM_TRANSPORT_H_
@@ -88,7 +88,7 @@ Command::Result CommandBreak::operator()(XBOXInterface& interface,
 
   if (parser.IsCommand("a", "addr", "Address")) {
     uint32_t address;
-    if (!parser.Parse(0, address)) {
+    if (!parser.Parse(0, address, interface.GetExpressionParser())) {
       out << "Missing required Address argument." << std::endl;
       PrintUsage();
       return HANDLED;
@@ -101,7 +101,7 @@ Command::Result CommandBreak::operator()(XBOXInterface& interface,
 
   if (parser.IsCommand("r", "read")) {
     uint32_t address;
-    if (!parser.Parse(0, address)) {
+    if (!parser.Parse(0, address, interface.GetExpressionParser())) {
       out << "Missing required Address argument." << std::endl;
       PrintUsage();
       return HANDLED;
@@ -116,7 +116,7 @@ Command::Result CommandBreak::operator()(XBOXInterface& interface,
 
   if (parser.IsCommand("w", "write")) {
     uint32_t address;
-    if (!parser.Parse(0, address)) {
+    if (!parser.Parse(0, address, interface.GetExpressionParser())) {
       out << "Missing required Address argument." << std::endl;
       PrintUsage();
       return HANDLED;
@@ -131,7 +131,7 @@ Command::Result CommandBreak::operator()(XBOXInterface& interface,
 
   if (parser.IsCommand("e", "exec", "execute")) {
     uint32_t address;
-    if (!parser.Parse(0, address)) {
+    if (!parser.Parse(0, address, interface.GetExpressionParser())) {
       out << "Missing required Address argument." << std::endl;
       PrintUsage();
       return HANDLED;
@@ -1147,6 +1147,12 @@ Command::Result CommandSetMem::operator()(XBOXInterface& interface,
   }
 
   SendAndPrintMessage(interface, std::make_shared<SetMem>(address, value), out);
+
+  GET_DEBUGGERXBOXINTERFACE(interface, debugger_interface);
+  auto debugger = debugger_interface.Debugger();
+  if (debugger && value.size() >= 2) {
+    debugger->InvalidateCode(address, value.size() / 2);
+  }
   return HANDLED;
 }
 
@@ -45,6 +45,10 @@ struct CommandBreak : Command {
                 "    E.g., addr 0x12345   # sets a breakpoint at 0x12345\n"
                 "          -addr 0x12345  # clears the breakpoint\n"
                 "\n"
+                "Addresses may be expressions referencing symbols loaded via "
+                "/symbols.\n"
+                "    E.g., addr _main+0x10\n"
+                "\n"
                 "addr/read/write/execute breakpoints may be conditionally "
                 "ignored by providing a trailing IF\n"
                 "condition. The condition may reference basic registers using "
@@ -2,13 +2,17 @@
 
 #include <capstone/capstone.h>
 
+#include <cstdlib>
+#include <fstream>
 #include <iomanip>
 
 #include "commands.h"
 #include "rdcp/xbdm_requests.h"
 #include "shell/file_util.h"
 #include "util/parsing.h"
+#include "util/timer.h"
 #include "xbox/debugger/debugger_xbox_interface.h"
+#include "xbox/debugger/symbol_index.h"
 #include "xbox/debugger/xbdm_debugger.h"
 #include "xboxkrnl/xboxdef.h"
 
@@ -23,6 +27,39 @@ static constexpr uint32_t kVideoBase = 0xFD000000;
 static constexpr uint32_t kPRAMINOffset = 0x00700000;
 static constexpr uint32_t kPRAMINAddress = kVideoBase + kPRAMINOffset;
 
+//! Returns " <symbol+offset>" if the address is covered by a loaded symbol.
+static std::string SymbolSuffix(
+    const std::shared_ptr<const SymbolIndex>& symbols, uint32_t address) {
+  if (!symbols) {
+    return {};
+  }
+  auto location = symbols->Describe(address);
+  if (location.empty()) {
+    return {};
+  }
+  return " <" + location + ">";
+}
+
+//! Returns the target of a direct call, jump or loop instruction.
+static std::optional<uint32_t> DirectBranchTarget(const cs_insn& insn) {
+  std::string_view mnemonic(insn.mnemonic);
+  if (mnemonic != "call" && !mnemonic.starts_with('j') &&
+      !mnemonic.starts_with("loop")) {
+    return std::nullopt;
+  }
+
+  std::string_view operand(insn.op_str);
+  if (!operand.starts_with("0x")) {
+    return std::nullopt;
+  }
+  char* end = nullptr;
+  auto target = std::strtoul(insn.op_str, &end, 16);
+  if (*end) {
+    return std::nullopt;
+  }
+  return static_cast<uint32_t>(target);
+}
+
 static bool DebugXBE(XBOXInterface& base_interface, const ArgParser& args,
                      bool wait_forever, XBDMDebugger::LaunchMode launch_mode,
                      std::ostream& out) {
@@ -156,45 +193,37 @@ Command::Result DebuggerCommandDisassemble::operator()(
     address = static_cast<uint32_t>(thread->context->eip.value());
   }
 
-  uint32_t bytes_to_read = kDisassemblyOpCount * kMaxInstructionBytes;
-  auto memory = debugger->GetMemory(address, bytes_to_read);
-
-  if (!memory) {
-    out << "Failed to read memory at 0x" << std::hex << address << std::dec
-        << std::endl;
+  auto instructions = debugger->Disassemble(address, kDisassemblyOpCount);
+  if (instructions.empty()) {
+    out << "Failed to disassemble memory at 0x" << std::hex << address
+        << std::dec << std::endl;
     return HANDLED;
   }
 
-  csh handle;
-  if (cs_open(CS_ARCH_X86, CS_MODE_32, &handle) != CS_ERR_OK) {
-    out << "Failed to initialize Capstone." << std::endl;
-    return HANDLED;
-  }
-
-  struct CapstoneGuard {
-    csh h;
-    ~CapstoneGuard() { cs_close(&h); }
-  } guard{handle};
-
-  cs_insn* insn;
-  size_t count_dis = cs_disasm(handle, memory->data(), memory->size(), address,
-                               kDisassemblyOpCount, &insn);
-
-  if (count_dis > 0) {
-    for (size_t i = 0; i < count_dis; i++) {
-      out << "0x" << std::hex << insn[i].address << ": ";
-      for (int j = 0; j < insn[i].size; ++j) {
-        out << std::setw(2) << std::setfill('0') << (int)insn[i].bytes[j]
-            << " ";
-      }
-      for (int j = insn[i].size; j < kMaxInstructionBytes; ++j) {
-        out << "   ";
+  auto symbols = interface.Symbols();
+  for (size_t i = 0; i < instructions.size(); i++) {
+    auto& insn = instructions[i];
+    // Label the first instruction and the start of each symbol.
+    if (symbols) {
+      auto match = symbols->Lookup(insn.address);
+      if (match && (!i || !match->offset)) {
+        out << match->ToString() << ":" << std::endl;
       }
-      out << insn[i].mnemonic << " " << insn[i].op_str << std::dec << std::endl;
     }
-    cs_free(insn, count_dis);
-  } else {
-    out << "Failed to disassemble." << std::endl;
+
+    out << "0x" << std::hex << insn.address << ": ";
+    for (int j = 0; j < insn.size; ++j) {
+      out << std::setw(2) << std::setfill('0') << (int)insn.bytes[j] << " ";
+    }
+    for (int j = insn.size; j < kMaxInstructionBytes; ++j) {
+      out << "   ";
+    }
+    out << insn.mnemonic << " " << insn.op_str;
+    auto target = DirectBranchTarget(insn);
+    if (target) {
+      out << SymbolSuffix(symbols, *target);
+    }
+    out << std::dec << std::endl;
   }
 
   return HANDLED;
@@ -260,6 +289,20 @@ Command::Result DebuggerCommandStepFunction::operator()(
 
 namespace {
 
+void PrintThreadLocation(const Thread& thread,
+                         const DebuggerXBOXInterface& interface,
+                         std::ostream& out) {
+  auto symbols = interface.Symbols();
+  if (!symbols || !thread.context || !thread.context->eip.has_value()) {
+    return;
+  }
+  auto eip = static_cast<uint32_t>(*thread.context->eip);
+  auto location = symbols->Describe(eip);
+  if (!location.empty()) {
+    out << "Location: " << location << std::endl;
+  }
+}
+
 Command::Result PrintThreadContext(const std::shared_ptr<Thread>& thread,
                                    DebuggerXBOXInterface& interface,
                                    const ArgParser& args, std::ostream& out) {
@@ -291,7 +334,7 @@ Command::Result DebuggerCommandGetThreads::operator()(
   bool print_context = args.ArgExists("context", "ctx", "c");
 
   auto active_thread_id = debugger->ActiveThreadID();
-  for (auto& thread : debugger->Threads()) {
+  for (auto& [thread_id, thread] : debugger->Threads()) {
     if (active_thread_id && thread->thread_id == *active_thread_id) {
       out << "[Active thread]" << std::endl;
     }
@@ -314,8 +357,8 @@ Command::Result DebuggerCommandWhichThread::operator()(
     return HANDLED;
   }
 
-  if (!debugger->FetchThreads()) {
-    out << "Failed to fetch threads." << std::endl;
+  if (!debugger->FetchMissingThreadInfo()) {
+    out << "Failed to fetch thread info." << std::endl;
     return HANDLED;
   }
 
@@ -325,7 +368,7 @@ Command::Result DebuggerCommandWhichThread::operator()(
     return HANDLED;
   }
 
-  for (auto& thread : debugger->Threads()) {
+  for (auto& [thread_id, thread] : debugger->Threads()) {
     if (thread->HasStack(address)) {
       out << *thread << std::endl;
       PrintThreadContext(thread, interface, {}, out);
@@ -359,6 +402,7 @@ Command::Result DebuggerCommandGetThreadInfo::operator()(
   thread->FetchFloatContextSync(*context);
 
   out << *thread << std::endl;
+  PrintThreadLocation(*thread, interface, out);
   return HANDLED;
 }
 
@@ -383,6 +427,7 @@ Command::Result DebuggerCommandGetThreadInfoAndContext::operator()(
   thread->FetchFloatContextSync(*context);
 
   out << *thread << std::endl;
+  PrintThreadLocation(*thread, interface, out);
 
   return PrintThreadContext(thread, interface, args, out);
 }
@@ -404,6 +449,58 @@ Command::Result DebuggerCommandSetAutoInfo::operator()(
   return HANDLED;
 }
 
+Command::Result DebuggerCommandDebugStr::operator()(
+    XBOXInterface& base_interface, const ArgParser& args, std::ostream& out) {
+  GET_DEBUGGERXBOXINTERFACE(base_interface, interface);
+  auto debugger = interface.Debugger();
+  if (!debugger) {
+    out << "Debugger not attached." << std::endl;
+    return HANDLED;
+  }
+
+  auto& sink = debugger->DebugStrOutput();
+  for (int i = 0; i < static_cast<int>(args.size()); i += 2) {
+    std::string option;
+    args.Parse(i, option);
+    boost::algorithm::to_lower(option);
+
+    if (option == "rate") {
+      uint32_t lines_per_second;
+      if (!args.Parse(i + 1, lines_per_second)) {
+        out << "Invalid rate argument." << std::endl;
+        PrintUsage();
+        return HANDLED;
+      }
+      sink.SetMaxLinesPerSecond(lines_per_second);
+    } else if (option == "log") {
+      std::string path;
+      if (!args.Parse(i + 1, path)) {
+        out << "Missing log path argument." << std::endl;
+        PrintUsage();
+        return HANDLED;
+      }
+      if (boost::algorithm::iequals(path, "off")) {
+        sink.CloseLogFile();
+      } else if (!sink.OpenLogFile(path)) {
+        out << "Failed to open " << path << std::endl;
+        return HANDLED;
+      }
+    } else {
+      out << "Unknown option " << option << std::endl;
+      PrintUsage();
+      return HANDLED;
+    }
+  }
+
+  auto stats = sink.GetStats();
+  out << "Rate limit: " << sink.MaxLinesPerSecond() << " lines/s" << std::endl;
+  out << "Lines: " << stats.lines << " displayed: " << stats.displayed_lines
+      << " suppressed: " << stats.suppressed_lines << std::endl;
+  out << "Logged: " << stats.logged_lines
+      << " dropped: " << stats.log_dropped_lines << std::endl;
+  return HANDLED;
+}
+
 Command::Result DebuggerCommandHaltAll::operator()(
     XBOXInterface& base_interface, const ArgParser&, std::ostream& out) {
   GET_DEBUGGERXBOXINTERFACE(base_interface, interface);
@@ -622,6 +719,7 @@ Command::Result DebuggerCommandGuessBackTrace::operator()(
 
   auto sections = debugger->Sections();
   auto module_ranges = debugger->ModuleRanges();
+  auto symbols = interface.Symbols();
 
   // Fetch active thread context for EIP
   auto thread = debugger->GetThread(thread_id);
@@ -629,8 +727,9 @@ Command::Result DebuggerCommandGuessBackTrace::operator()(
     auto context = interface.Context();
     if (thread->FetchContextSync(*context)) {
       if (thread->context && thread->context->eip.has_value()) {
-        out << "EIP: 0x" << std::hex << *thread->context->eip << std::dec
-            << std::endl;
+        auto eip = static_cast<uint32_t>(*thread->context->eip);
+        out << "EIP: 0x" << std::hex << eip << std::dec
+            << SymbolSuffix(symbols, eip) << std::endl;
       }
     }
   }
@@ -643,7 +742,7 @@ Command::Result DebuggerCommandGuessBackTrace::operator()(
       out << " ";
     }
     out << " " << frame.chain_id << "      " << "0x" << std::hex << addr
-        << std::dec;
+        << std::dec << SymbolSuffix(symbols, addr);
 
     std::string location;
     auto section_it = sections.upper_bound(addr);
@@ -671,11 +770,13 @@ Command::Result DebuggerCommandGuessBackTrace::operator()(
 
     if (frame.call_target) {
       out << " ";
+      auto target_symbol = SymbolSuffix(symbols, *frame.call_target);
       if (frame.is_suspicious) {
-        out << "? " << "0x" << std::hex << *frame.call_target << " ?"
-            << std::dec;
+        out << "? " << "0x" << std::hex << *frame.call_target << std::dec
+            << target_symbol << " ?";
       } else {
-        out << "[ 0x" << std::hex << *frame.call_target << " ]" << std::dec;
+        out << "[ 0x" << std::hex << *frame.call_target << std::dec
+            << target_symbol << " ]";
       }
     }
 
@@ -735,4 +836,620 @@ Command::Result DebuggerCommandLookupNV2ADMADescriptor::operator()(
   return HANDLED;
 }
 
+Command::Result DebuggerCommandMemSearch::operator()(
+    XBOXInterface& base_interface, const ArgParser& args, std::ostream& out) {
+  GET_DEBUGGERXBOXINTERFACE(base_interface, interface);
+  auto debugger = interface.Debugger();
+  if (!debugger) {
+    out << "Debugger not attached." << std::endl;
+    return HANDLED;
+  }
+
+  std::string kind;
+  if (!args.Parse(0, kind)) {
+    PrintUsage();
+    return HANDLED;
+  }
+  boost::algorithm::to_lower(kind);
+
+  std::optional<MemorySearchPattern> pattern;
+  int next_arg = 2;
+  if (kind == "byte" || kind == "word" || kind == "dword") {
+    uint32_t value;
+    if (!args.Parse(1, value)) {
+      out << "Invalid value argument." << std::endl;
+      PrintUsage();
+      return HANDLED;
+    }
+    uint32_t size = kind == "byte" ? 1 : (kind == "word" ? 2 : 4);
+    pattern = MemorySearchPattern::FromValue(value, size);
+  } else if (kind == "string") {
+    std::string text;
+    if (!args.Parse(1, text) || text.empty()) {
+      out << "Missing text argument." << std::endl;
+      PrintUsage();
+      return HANDLED;
+    }
+    pattern =
+        MemorySearchPattern(std::vector<uint8_t>(text.begin(), text.end()));
+  } else {
+    pattern = MemorySearchPattern::ParseHex(kind);
+    if (!pattern) {
+      out << "Invalid hex pattern." << std::endl;
+      PrintUsage();
+      return HANDLED;
+    }
+    next_arg = 1;
+  }
+
+  uint32_t alignment = pattern->Alignment();
+  uint32_t start = 0;
+  uint64_t end = 0x100000000ULL;
+  uint32_t max_hits = XBDMDebugger::kDefaultMemorySearchMaxHits;
+  for (int i = next_arg; i < static_cast<int>(args.size()); ++i) {
+    std::string option;
+    args.Parse(i, option);
+    boost::algorithm::to_lower(option);
+
+    if (option == "align") {
+      if (!args.Parse(++i, alignment) || !alignment) {
+        out << "Invalid align argument." << std::endl;
+        PrintUsage();
+        return HANDLED;
+      }
+    } else if (option == "range") {
+      uint32_t range_end;
+      if (!args.Parse(i + 1, start) || !args.Parse(i + 2, range_end)) {
+        out << "Invalid range argument." << std::endl;
+        PrintUsage();
+        return HANDLED;
+      }
+      i += 2;
+      end = range_end;
+    } else if (option == "max") {
+      if (!args.Parse(++i, max_hits) || !max_hits) {
+        out << "Invalid max argument." << std::endl;
+        PrintUsage();
+        return HANDLED;
+      }
+    } else {
+      out << "Unknown option " << option << std::endl;
+      PrintUsage();
+      return HANDLED;
+    }
+  }
+
+  pattern->SetAlignment(alignment);
+
+  Timer timer;
+  auto result = debugger->SearchMemory(*pattern, start, end, max_hits);
+  auto elapsed = timer.MillisecondsElapsed();
+
+  for (auto& hit : result.hits) {
+    out << "0x" << std::hex << std::setw(8) << std::setfill('0')
+        << hit.address;
+    if (hit.region) {
+      out << " in 0x" << std::setw(8) << hit.region->start << " - 0x"
+          << std::setw(8) << hit.region->end << " protect 0x"
+          << hit.region->protect;
+    }
+    out << std::dec << std::setfill(' ') << std::endl;
+  }
+
+  out << result.hits.size() << (result.truncated ? "+" : "") << " matches. "
+      << "Scanned " << result.bytes_scanned << " bytes in "
+      << result.regions_scanned << " regions in " << elapsed << " ms."
+      << std::endl;
+  if (result.failed_reads) {
+    out << "Failed to read " << result.failed_reads << " chunks." << std::endl;
+  }
+  return HANDLED;
+}
+
+static std::shared_ptr<MemorySnapshot> CaptureSnapshot(
+    XBDMDebugger& debugger, const std::shared_ptr<MemorySnapshot>& baseline,
+    std::ostream& out) {
+  Timer timer;
+  auto result = debugger.CaptureMemorySnapshot(baseline);
+  auto elapsed = timer.MillisecondsElapsed();
+
+  if (!result.snapshot) {
+    out << "Failed to fetch memory map." << std::endl;
+    return nullptr;
+  }
+
+  auto& snapshot = *result.snapshot;
+  out << "Captured " << snapshot.BlockCount() << " blocks ("
+      << snapshot.DataSize() << " bytes), downloaded "
+      << result.blocks_downloaded << " and reused " << result.blocks_reused
+      << " in " << elapsed << " ms." << std::endl;
+  if (result.failed_reads) {
+    out << "Failed to read " << result.failed_reads << " ranges." << std::endl;
+  }
+  return result.snapshot;
+}
+
+static void PrintSnapshotRanges(
+    const char* label, const std::vector<MemorySnapshot::Range>& ranges,
+    std::ostream& out) {
+  constexpr size_t kMaxRangesPerLabel = 200;
+
+  for (size_t i = 0; i < ranges.size() && i < kMaxRangesPerLabel; ++i) {
+    auto& range = ranges[i];
+    out << label << " 0x" << std::hex << std::setw(8) << std::setfill('0')
+        << range.address << " - 0x" << std::setw(8)
+        << range.address + range.length << std::dec << std::setfill(' ')
+        << " (" << range.length << " bytes)" << std::endl;
+  }
+  if (ranges.size() > kMaxRangesPerLabel) {
+    out << "... " << ranges.size() - kMaxRangesPerLabel << " more " << label
+        << " ranges" << std::endl;
+  }
+}
+
+Command::Result DebuggerCommandSnapshot::operator()(
+    XBOXInterface& base_interface, const ArgParser& args, std::ostream& out) {
+  GET_DEBUGGERXBOXINTERFACE(base_interface, interface);
+  auto debugger = interface.Debugger();
+
+  auto maybe_parser = args.ExtractSubcommand();
+  if (!maybe_parser.has_value()) {
+    PrintUsage();
+    return HANDLED;
+  }
+  auto& parser = *maybe_parser;
+
+  std::string path;
+  if (!parser.Parse(0, path)) {
+    out << "Missing required path argument." << std::endl;
+    PrintUsage();
+    return HANDLED;
+  }
+
+  std::string second_path;
+  std::shared_ptr<MemorySnapshot> second_snapshot;
+  if (parser.Parse(1, second_path)) {
+    second_snapshot = MemorySnapshot::Load(second_path);
+    if (!second_snapshot) {
+      out << "Failed to load snapshot from " << second_path << std::endl;
+      return HANDLED;
+    }
+  }
+
+  if (parser.IsCommand("take")) {
+    if (!debugger) {
+      out << "Debugger not attached." << std::endl;
+      return HANDLED;
+    }
+
+    auto snapshot = CaptureSnapshot(*debugger, second_snapshot, out);
+    if (snapshot && !snapshot->Save(path)) {
+      out << "Failed to save snapshot to " << path << std::endl;
+    }
+    return HANDLED;
+  }
+
+  if (parser.IsCommand("diff")) {
+    auto before = MemorySnapshot::Load(path);
+    if (!before) {
+      out << "Failed to load snapshot from " << path << std::endl;
+      return HANDLED;
+    }
+
+    auto after = second_snapshot;
+    if (!after) {
+      if (!debugger) {
+        out << "Debugger not attached." << std::endl;
+        return HANDLED;
+      }
+      after = CaptureSnapshot(*debugger, before, out);
+      if (!after) {
+        return HANDLED;
+      }
+    } else if (after->BlockSize() != before->BlockSize()) {
+      out << "Snapshots have different block sizes." << std::endl;
+      return HANDLED;
+    }
+
+    auto diff = MemorySnapshot::Compare(*before, *after);
+    PrintSnapshotRanges("changed", diff.changed, out);
+    PrintSnapshotRanges("added", diff.added, out);
+    PrintSnapshotRanges("removed", diff.removed, out);
+    out << diff.changed.size() << " changed ranges (" << diff.bytes_changed
+        << " bytes), " << diff.added.size() << " added, "
+        << diff.removed.size() << " removed." << std::endl;
+    return HANDLED;
+  }
+
+  out << "Invalid subcommand." << std::endl;
+  PrintUsage();
+  return HANDLED;
+}
+
+Command::Result DebuggerCommandCoreDump::operator()(
+    XBOXInterface& base_interface, const ArgParser& args, std::ostream& out) {
+  GET_DEBUGGERXBOXINTERFACE(base_interface, interface);
+  auto debugger = interface.Debugger();
+  if (!debugger) {
+    out << "Debugger not attached." << std::endl;
+    return HANDLED;
+  }
+
+  std::string path;
+  if (!args.Parse(0, path)) {
+    out << "Missing required path argument." << std::endl;
+    PrintUsage();
+    return HANDLED;
+  }
+
+  std::ofstream of(path, std::ofstream::binary | std::ofstream::trunc);
+  if (!of) {
+    out << "Failed to open " << path << " for writing." << std::endl;
+    return HANDLED;
+  }
+
+  Timer timer;
+  auto result = debugger->WriteCoreDump(of);
+  auto elapsed = timer.MillisecondsElapsed();
+  if (!result.has_value()) {
+    out << result.error() << std::endl;
+    return HANDLED;
+  }
+
+  out << "Wrote " << result->bytes_written << " bytes with "
+      << result->regions << " regions and " << result->threads
+      << " threads in " << elapsed << " ms." << std::endl;
+  if (result->failed_reads) {
+    out << "Failed to read " << result->failed_reads
+        << " chunks, which were written as zeroes." << std::endl;
+  }
+  return HANDLED;
+}
+
+static const char* TraceStopReasonName(XBDMDebugger::TraceStopReason reason) {
+  switch (reason) {
+    case XBDMDebugger::TraceStopReason::NOT_RUN:
+      return "not run";
+    case XBDMDebugger::TraceStopReason::REQUESTED:
+      return "stopped";
+    case XBDMDebugger::TraceStopReason::PASS_COUNT:
+      return "pass count reached";
+    case XBDMDebugger::TraceStopReason::BUFFER_FULL:
+      return "buffer full";
+    case XBDMDebugger::TraceStopReason::TARGET_REBOOTED:
+      return "target rebooted";
+  }
+  return "unknown";
+}
+
+static void PrintTracepoints(XBDMDebugger& debugger, std::ostream& out) {
+  auto status = debugger.GetTraceStatus();
+  out << "Tracing: "
+      << (status.running ? "running" : TraceStopReasonName(status.stop_reason))
+      << " frames: " << status.frames << " buffer: " << status.buffer_used
+      << "/" << status.buffer_size << " bytes" << std::endl;
+
+  for (auto& tracepoint : debugger.Tracepoints()) {
+    out << "#" << tracepoint.number << " 0x" << std::hex << std::setw(8)
+        << std::setfill('0') << tracepoint.address << std::dec
+        << std::setfill(' ') << (tracepoint.enabled ? "" : " disabled")
+        << " hits: " << tracepoint.hits << " frames: " << tracepoint.frames;
+    if (tracepoint.pass_count) {
+      out << "/" << tracepoint.pass_count;
+    }
+    if (tracepoint.hits) {
+      out << " overhead per hit: "
+          << tracepoint.total_overhead_us / tracepoint.hits << "us avg, "
+          << tracepoint.max_overhead_us << "us max";
+    }
+    out << std::endl;
+
+    for (auto& description : tracepoint.action_descriptions) {
+      out << "\t" << description << std::endl;
+    }
+  }
+}
+
+static void PrintTraceFrame(const TraceFrame& frame, std::ostream& out) {
+  out << "Tracepoint " << frame.tracepoint << " thread " << frame.thread_id
+      << " @ 0x" << std::hex << frame.address << std::dec << std::endl;
+  if (frame.registers) {
+    out << *frame.registers << std::endl;
+  }
+  for (auto& [address, data] : frame.memory) {
+    out << "0x" << std::hex << std::setw(8) << std::setfill('0') << address
+        << ":";
+    for (auto byte : data) {
+      out << " " << std::setw(2) << static_cast<uint32_t>(byte);
+    }
+    out << std::dec << std::setfill(' ') << std::endl;
+  }
+  for (auto& [expression, value] : frame.values) {
+    out << expression << " = 0x" << std::hex << value << std::dec << " ("
+        << value << ")" << std::endl;
+  }
+}
+
+Command::Result DebuggerCommandTracepoint::operator()(
+    XBOXInterface& base_interface, const ArgParser& initial_args,
+    std::ostream& out) {
+  GET_DEBUGGERXBOXINTERFACE(base_interface, interface);
+  auto debugger = interface.Debugger();
+  if (!debugger) {
+    out << "Debugger not attached." << std::endl;
+    return HANDLED;
+  }
+
+  ArgParser args;
+  ArgParser conditional_args;
+  bool has_conditional = initial_args.SplitAt(args, conditional_args, "if");
+
+  auto maybe_parser = args.ExtractSubcommand();
+  if (!maybe_parser.has_value() || maybe_parser->IsCommand("list")) {
+    PrintTracepoints(*debugger, out);
+    return HANDLED;
+  }
+  auto& parser = *maybe_parser;
+
+  if (has_conditional && !parser.IsCommand("add")) {
+    out << "Conditions may only be provided for `add`." << std::endl;
+    PrintUsage();
+    return HANDLED;
+  }
+
+  if (parser.IsCommand("add")) {
+    XBDMDebugger::Tracepoint tracepoint;
+    if (!parser.Parse(0, tracepoint.address)) {
+      out << "Missing required address argument." << std::endl;
+      PrintUsage();
+      return HANDLED;
+    }
+
+    for (int i = 1; i < static_cast<int>(parser.size()); ++i) {
+      std::string option;
+      parser.Parse(i, option);
+      boost::algorithm::to_lower(option);
+
+      if (option == "regs") {
+        tracepoint.actions.emplace_back(trace_actions::CollectRegisters());
+        tracepoint.action_descriptions.emplace_back("regs");
+      } else if (option == "mem") {
+        std::string expression;
+        uint32_t length;
+        if (!parser.Parse(i + 1, expression) ||
+            !parser.Parse(i + 2, length) || !length) {
+          out << "Invalid mem argument." << std::endl;
+          PrintUsage();
+          return HANDLED;
+        }
+        i += 2;
+        tracepoint.actions.emplace_back(
+            trace_actions::CollectMemory(expression, length));
+        tracepoint.action_descriptions.emplace_back(
+            "mem " + expression + " " + std::to_string(length));
+      } else if (option == "expr") {
+        std::string expression;
+        if (!parser.Parse(++i, expression)) {
+          out << "Missing expression argument." << std::endl;
+          PrintUsage();
+          return HANDLED;
+        }
+        tracepoint.actions.emplace_back(
+            trace_actions::CollectExpression(expression));
+        tracepoint.action_descriptions.emplace_back("expr " + expression);
+      } else if (option == "pass") {
+        uint32_t pass_count;
+        if (!parser.Parse(++i, pass_count)) {
+          out << "Invalid pass argument." << std::endl;
+          PrintUsage();
+          return HANDLED;
+        }
+        tracepoint.pass_count = pass_count;
+      } else {
+        out << "Unknown option " << option << std::endl;
+        PrintUsage();
+        return HANDLED;
+      }
+    }
+
+    if (has_conditional) {
+      auto condition = conditional_args.Flatten();
+      tracepoint.conditions.emplace_back(
+          [condition](
+              const ThreadContext& context, uint32_t thread_id,
+              const DebuggerExpressionParser::MemoryReader& memory_reader)
+              -> std::expected<bool, std::string> {
+            DebuggerExpressionParser parser(context, thread_id,
+                                            memory_reader);
+            auto result = parser.Parse(condition);
+            if (!result.has_value()) {
+              return std::unexpected(result.error());
+            }
+            return *result != 0;
+          });
+      tracepoint.action_descriptions.emplace_back("if " + condition);
+    }
+
+    tracepoint.number = debugger->NextTracepointNumber();
+    debugger->SetTracepoint(tracepoint);
+    out << "Tracepoint " << tracepoint.number << " at 0x" << std::hex
+        << tracepoint.address << std::dec << std::endl;
+    if (debugger->GetTraceStatus().running) {
+      out << "Tracing is running, the tracepoint will take effect when it is "
+             "restarted."
+          << std::endl;
+    }
+    return HANDLED;
+  }
+
+  if (parser.IsCommand("remove", "rm")) {
+    uint32_t number;
+    if (!parser.Parse(0, number)) {
+      out << "Missing required number argument." << std::endl;
+      PrintUsage();
+      return HANDLED;
+    }
+    if (!debugger->RemoveTracepoint(number)) {
+      out << "No tracepoint " << number << std::endl;
+    }
+    return HANDLED;
+  }
+
+  if (parser.IsCommand("clear")) {
+    debugger->ClearTracepoints();
+    return HANDLED;
+  }
+
+  if (parser.IsCommand("start")) {
+    if (!debugger->StartTracing()) {
+      out << "Failed to start tracing." << std::endl;
+    }
+    return HANDLED;
+  }
+
+  if (parser.IsCommand("stop")) {
+    debugger->StopTracing();
+    PrintTracepoints(*debugger, out);
+    return HANDLED;
+  }
+
+  if (parser.IsCommand("frames")) {
+    uint32_t index;
+    if (parser.Parse(0, index)) {
+      auto frame = debugger->GetTraceFrame(index);
+      if (!frame) {
+        out << "No frame " << index << std::endl;
+        return HANDLED;
+      }
+      PrintTraceFrame(*frame, out);
+      return HANDLED;
+    }
+
+    auto status = debugger->GetTraceStatus();
+    for (size_t i = 0; i < status.frames; ++i) {
+      auto frame = debugger->GetTraceFrame(i);
+      if (!frame) {
+        break;
+      }
+      out << "Frame " << i << ": tracepoint " << frame->tracepoint
+          << " thread " << frame->thread_id << " @ 0x" << std::hex
+          << frame->address << std::dec << std::endl;
+    }
+    return HANDLED;
+  }
+
+  PrintUsage();
+  return HANDLED;
+}
+
 #undef GET_MASK
+
+Command::Result DebuggerCommandSymbols::operator()(
+    XBOXInterface& base_interface, const ArgParser& args, std::ostream& out) {
+  GET_DEBUGGERXBOXINTERFACE(base_interface, interface);
+  auto symbols = interface.Symbols();
+
+  auto maybe_parser = args.ExtractSubcommand();
+  if (!maybe_parser.has_value()) {
+    if (!symbols) {
+      out << "No symbols loaded." << std::endl;
+    } else {
+      out << symbols->SymbolCount() << " symbols and "
+          << symbols->SectionCount() << " sections loaded." << std::endl;
+    }
+    return HANDLED;
+  }
+  auto& parser = *maybe_parser;
+
+  if (parser.IsCommand("load")) {
+    if (parser.empty()) {
+      out << "Missing required path argument." << std::endl;
+      PrintUsage();
+      return HANDLED;
+    }
+
+    Timer timer;
+    std::shared_ptr<const SymbolIndex> loaded;
+    std::string path;
+    if (parser.size() == 1 && parser.Parse(0, path) &&
+        SymbolIndex::IsCacheFile(path)) {
+      loaded = SymbolIndex::Open(path);
+      if (!loaded) {
+        out << "Failed to load symbol cache " << path << std::endl;
+        return HANDLED;
+      }
+    } else {
+      SymbolIndex::Builder builder;
+      for (auto& file : parser) {
+        if (SymbolIndex::IsCacheFile(file)) {
+          out << "Symbol caches must be loaded on their own." << std::endl;
+          return HANDLED;
+        }
+        if (!builder.Load(file)) {
+          out << "Failed to load symbols from " << file << std::endl;
+          return HANDLED;
+        }
+      }
+      loaded = builder.Build();
+    }
+
+    interface.SetSymbolIndex(loaded);
+    out << "Loaded " << loaded->SymbolCount() << " symbols and "
+        << loaded->SectionCount() << " sections in "
+        << timer.MillisecondsElapsed() << " ms." << std::endl;
+    return HANDLED;
+  }
+
+  if (parser.IsCommand("clear")) {
+    interface.SetSymbolIndex(nullptr);
+    out << "OK" << std::endl;
+    return HANDLED;
+  }
+
+  if (!symbols) {
+    out << "No symbols loaded." << std::endl;
+    return HANDLED;
+  }
+
+  if (parser.IsCommand("save")) {
+    std::string path;
+    if (!parser.Parse(0, path)) {
+      out << "Missing required path argument." << std::endl;
+      PrintUsage();
+      return HANDLED;
+    }
+    if (!symbols->Save(path)) {
+      out << "Failed to save symbols to " << path << std::endl;
+    }
+    return HANDLED;
+  }
+
+  if (parser.IsCommand("lookup")) {
+    std::string name;
+    if (!parser.Parse(0, name)) {
+      out << "Missing required address or symbol argument." << std::endl;
+      PrintUsage();
+      return HANDLED;
+    }
+
+    auto address = symbols->FindAddress(name);
+    if (address) {
+      out << name << " = 0x" << std::hex << *address << std::dec << std::endl;
+      return HANDLED;
+    }
+
+    uint32_t value;
+    if (!parser.Parse(0, value, interface.GetExpressionParser())) {
+      out << "Unknown symbol " << name << std::endl;
+      return HANDLED;
+    }
+    auto location = symbols->Describe(value);
+    out << "0x" << std::hex << value << std::dec << " = "
+        << (location.empty() ? "??" : location) << std::endl;
+    return HANDLED;
+  }
+
+  out << "Invalid subcommand." << std::endl;
+  PrintUsage();
+  return HANDLED;
+}
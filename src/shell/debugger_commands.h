@@ -167,6 +167,22 @@ struct DebuggerCommandSetAutoInfo : Command {
                     std::ostream& out) override;
 };
 
+struct DebuggerCommandDebugStr : Command {
+  DebuggerCommandDebugStr()
+      : Command("Configure handling of debugstr output.",
+                "[rate <lines_per_second>] [log <path>|off]\n"
+                "\n"
+                "Prints debugstr statistics after applying any options.\n"
+                "\n"
+                "rate <lines_per_second> - Limit the number of debugstr "
+                "lines displayed per second. 0 disables the limit.\n"
+                "log <path> - Record all debugstr lines, including those "
+                "that are not displayed, to the given file.\n"
+                "log off - Stop recording debugstr lines.") {}
+  Result operator()(XBOXInterface& interface, const ArgParser& args,
+                    std::ostream& out) override;
+};
+
 struct DebuggerCommandHaltAll : Command {
   DebuggerCommandHaltAll() : Command("Halt all threads.") {}
   Result operator()(XBOXInterface& interface, const ArgParser&,
@@ -286,4 +302,125 @@ struct DebuggerCommandLookupNV2ADMADescriptor : Command {
                     std::ostream& out) override;
 };
 
+struct DebuggerCommandMemSearch : Command {
+  DebuggerCommandMemSearch()
+      : Command(
+            "Search target memory for a pattern.",
+            "<hex_pattern>|byte <value>|word <value>|dword <value>|string "
+            "<text> [align <alignment>] [range <start> <end>] [max "
+            "<max_hits>]\n"
+            "\n"
+            "Scans all readable memory regions and prints the address and "
+            "region of each match.\n"
+            "\n"
+            "<hex_pattern> - Hex bytes to search for. `?` matches any value "
+            "for a nibble, e.g. \"8b45??0f\".\n"
+            "byte|word|dword <value> - Search for the given little endian "
+            "value, aligned to its size.\n"
+            "string <text> - Search for the given text.\n"
+            "align <alignment> - Only report matches at addresses that are a "
+            "multiple of <alignment>.\n"
+            "range <start> <end> - Restrict the search to [start, end).\n"
+            "max <max_hits> - Stop after <max_hits> matches. Default 1000.") {}
+  Result operator()(XBOXInterface& interface, const ArgParser& args,
+                    std::ostream& out) override;
+};
+
+struct DebuggerCommandSnapshot : Command {
+  DebuggerCommandSnapshot()
+      : Command(
+            "Capture and compare snapshots of target memory.",
+            "take <path> [<baseline_path>]\n"
+            "diff <before_path> [<after_path>]\n"
+            "\n"
+            "Snapshots contain every readable memory region along with the "
+            "XBDM checksum of each 4 KiB block.\n"
+            "\n"
+            "take - Captures a snapshot and saves it to <path>. If "
+            "<baseline_path> is given, only blocks whose checksum differs from "
+            "the baseline are downloaded.\n"
+            "diff - Prints the ranges that differ between two snapshots. If "
+            "<after_path> is omitted, the target is compared against "
+            "<before_path> directly.") {}
+  Result operator()(XBOXInterface& interface, const ArgParser& args,
+                    std::ostream& out) override;
+};
+
+struct DebuggerCommandCoreDump : Command {
+  DebuggerCommandCoreDump()
+      : Command("Write an ELF core file for offline analysis.",
+                "<path>\n"
+                "\n"
+                "Writes an ELF32 i386 core file containing every readable "
+                "memory region and the registers of each thread to <path>. The "
+                "target should be stopped to obtain a consistent image.") {}
+  Result operator()(XBOXInterface& interface, const ArgParser& args,
+                    std::ostream& out) override;
+};
+
+struct DebuggerCommandSymbols : Command {
+  DebuggerCommandSymbols()
+      : Command(
+            "Manage the symbols used to describe addresses.",
+            "[load <path>...]\n"
+            "save <cache_path>\n"
+            "lookup <address|symbol>\n"
+            "clear\n"
+            "\n"
+            "Loaded symbols are shown in disassembly, backtraces and thread "
+            "info and may be used in address expressions, e.g. `/break addr "
+            "_main`.\n"
+            "\n"
+            "load - Replaces the loaded symbols with those in the given files. "
+            "Files may be MSVC linker map files, XBE images (for section "
+            "names), text symbol dumps such as `nm` output, or a cache "
+            "written by `save`, which is memory mapped rather than parsed.\n"
+            "save - Writes the loaded symbols to a cache file.\n"
+            "lookup - Prints the symbol containing an address or the address "
+            "of a symbol.\n"
+            "clear - Unloads all symbols.\n"
+            "\n"
+            "With no arguments, prints the number of loaded symbols.") {}
+  Result operator()(XBOXInterface& interface, const ArgParser& args,
+                    std::ostream& out) override;
+};
+
+struct DebuggerCommandTracepoint : Command {
+  DebuggerCommandTracepoint()
+      : Command(
+            "Manage tracepoints, which collect data without stopping the "
+            "target.",
+            "[list]\n"
+            "add <address> [regs] [mem <address> <length>]... [expr "
+            "<expression>]... [pass <count>] [if <condition>]\n"
+            "remove <number>\n"
+            "clear\n"
+            "start\n"
+            "stop\n"
+            "frames [index]\n"
+            "\n"
+            "Tracepoints take effect when tracing is started. Each time the "
+            "target hits one, the requested data is recorded into a trace "
+            "frame and the thread is resumed.\n"
+            "\n"
+            "add - Defines a tracepoint at <address>.\n"
+            "  regs - Collect the general purpose registers.\n"
+            "  mem <address> <length> - Collect <length> bytes at the "
+            "<address> expression.\n"
+            "  expr <expression> - Collect the value of <expression>.\n"
+            "  pass <count> - Stop tracing after <count> frames are "
+            "collected.\n"
+            "  if <condition> - Only collect when <condition> is true.\n"
+            "remove <number> - Removes the given tracepoint.\n"
+            "clear - Stops tracing and removes all tracepoints and frames.\n"
+            "start - Discards any collected frames and starts tracing.\n"
+            "stop - Stops tracing.\n"
+            "list - Prints tracepoints with their hit counts and the "
+            "overhead per hit.\n"
+            "frames [index] - Lists collected frames or prints the content "
+            "of the given frame.") {}
+  Result operator()(XBOXInterface& interface, const ArgParser& args,
+                    std::ostream& out) override;
+};
+
 #endif  // XBDM_GDB_BRIDGE_DEBUGGER_COMMANDS_H
@@ -69,6 +69,8 @@ Shell::Shell(std::shared_ptr<XBOXInterface>& interface)
   commands_["!"] = nullptr;
   REGISTER("trace", ShellCommandTrace);
   REGISTER("reconnect", ShellCommandReconnect);
+  REGISTER("metrics", ShellCommandMetrics);
+  REGISTER("capture", ShellCommandCapture);
   REGISTER("quit", ShellCommandQuit);
   ALIAS("quit", "exit");
 
@@ -87,6 +89,7 @@ Shell::Shell(std::shared_ptr<XBOXInterface>& interface)
   REGISTER("/infowithcontext", DebuggerCommandGetThreadInfoAndContext);
   ALIAS("/infowithcontext", "/ic");
   REGISTER("/autoinfo", DebuggerCommandSetAutoInfo);
+  REGISTER("/debugstr", DebuggerCommandDebugStr);
   REGISTER("/haltall", DebuggerCommandHaltAll);
   REGISTER("/halt", DebuggerCommandHalt);
   REGISTER("/continueall", DebuggerCommandContinueAll);
@@ -112,6 +115,15 @@ Shell::Shell(std::shared_ptr<XBOXInterface>& interface)
   REGISTER("/guessbacktrace", DebuggerCommandGuessBackTrace);
   ALIAS("/guessbacktrace", "/gbt");
 
+  REGISTER("/tracepoint", DebuggerCommandTracepoint);
+  ALIAS("/tracepoint", "/tp");
+  REGISTER("/memsearch", DebuggerCommandMemSearch);
+  ALIAS("/memsearch", "/ms");
+  REGISTER("/snapshot", DebuggerCommandSnapshot);
+  REGISTER("/coredump", DebuggerCommandCoreDump);
+  REGISTER("/symbols", DebuggerCommandSymbols);
+  ALIAS("/symbols", "/sym");
+
   REGISTER("@bootstrap", DynDXTCommandLoadBootstrap);
   REGISTER("@hello", DynDXTCommandHello);
   REGISTER("@load", DynDXTCommandLoad);
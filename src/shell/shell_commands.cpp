@@ -1,9 +1,12 @@
 #include "shell_commands.h"
 
 #include <boost/algorithm/string/case_conv.hpp>
+#include <fstream>
 
+#include "rdcp/session_capture.h"
 #include "tracer_commands.h"
 #include "util/parsing.h"
+#include "xbox/xbdm_context.h"
 
 Command::Result ShellCommandReconnect::operator()(XBOXInterface& interface,
                                                   const ArgParser&,
@@ -16,6 +19,94 @@ Command::Result ShellCommandReconnect::operator()(XBOXInterface& interface,
   return Result::HANDLED;
 }
 
+Command::Result ShellCommandCapture::operator()(XBOXInterface& interface,
+                                                const ArgParser& args,
+                                                std::ostream& out) {
+  auto context = interface.Context();
+  if (!context) {
+    out << "Not connected." << std::endl;
+    return Result::HANDLED;
+  }
+
+  if (args.empty()) {
+    auto capture = context->GetCapture();
+    if (!capture) {
+      out << "Not capturing." << std::endl;
+    } else {
+      out << "Capturing to " << capture->Path() << " ("
+          << capture->BytesWritten() << " bytes)" << std::endl;
+    }
+    return Result::HANDLED;
+  }
+
+  std::string path;
+  args.Parse(0, path);
+  if (boost::algorithm::to_lower_copy(path) == "off") {
+    auto capture = context->GetCapture();
+    context->StopCapture();
+    if (capture) {
+      out << "Wrote " << capture->BytesWritten() << " bytes to "
+          << capture->Path() << std::endl;
+    }
+    return Result::HANDLED;
+  }
+
+  if (!context->StartCapture(path)) {
+    out << "Failed to create " << path << std::endl;
+  } else {
+    out << "Capturing to " << path << std::endl;
+  }
+  return Result::HANDLED;
+}
+
+Command::Result ShellCommandMetrics::operator()(XBOXInterface& interface,
+                                                const ArgParser& args,
+                                                std::ostream& out) {
+  auto context = interface.Context();
+  if (!context) {
+    out << "Not connected." << std::endl;
+    return Result::HANDLED;
+  }
+
+  std::string export_path;
+  bool reset = false;
+  auto it = args.begin();
+  while (it != args.end()) {
+    auto key = boost::algorithm::to_lower_copy(*it++);
+    if (key == "reset") {
+      reset = true;
+    } else if (key == "export") {
+      if (it == args.end()) {
+        out << "Missing required path for 'export'." << std::endl;
+        return Result::HANDLED;
+      }
+      export_path = *it++;
+    } else {
+      out << "Invalid argument '" << key << "'" << std::endl;
+      PrintUsage();
+      return Result::HANDLED;
+    }
+  }
+
+  auto metrics = context->GetTransportMetrics();
+  PrintTransportMetrics(out, metrics);
+
+  if (!export_path.empty()) {
+    std::ofstream export_file(export_path, std::ios::trunc);
+    WritePrometheusMetrics(export_file, metrics);
+    if (!export_file) {
+      out << "Failed to write " << export_path << std::endl;
+    } else {
+      out << "Wrote " << export_path << std::endl;
+    }
+  }
+
+  if (reset) {
+    context->ResetTransportMetrics();
+  }
+  return Result::HANDLED;
+}
+
 Command::Result ShellCommandTrace::operator()(XBOXInterface& interface,
                                               const ArgParser& args,
                                               std::ostream& out) {
@@ -31,7 +122,8 @@ Command::Result ShellCommandTrace::operator()(XBOXInterface& interface,
       return HANDLED;
     }
 
-    if (key == "path" || key == "frames") {
+    if (key == "path" || key == "frames" || key == "stream" ||
+        key == "images") {
       trace_args.emplace_back(key);
       trace_args.emplace_back(*it++);
     } else if (key == "nodiscard") {
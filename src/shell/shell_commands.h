@@ -20,6 +20,39 @@ struct ShellCommandReconnect : Command {
                     std::ostream& out) override;
 };
 
+struct ShellCommandCapture : Command {
+  ShellCommandCapture()
+      : Command("Record XBDM traffic for offline replay.",
+                "[<path>|off]\n"
+                "\n"
+                "Records every request, response and notification to the "
+                "given file, with timestamps, until 'capture off' is given. "
+                "Without arguments, prints the state of any capture in "
+                "progress.\n"
+                "\n"
+                "Captures may be served by the xbdm_replay_server utility. "
+                "Start the capture as an initial command to include the "
+                "connection handshake.") {}
+  Result operator()(XBOXInterface& interface, const ArgParser& args,
+                    std::ostream& out) override;
+};
+
+struct ShellCommandMetrics : Command {
+  ShellCommandMetrics()
+      : Command("Print XBDM request statistics.",
+                "[reset] [export <path>]\n"
+                "\n"
+                "Prints the number of requests, bytes transferred and "
+                "round trip latency for each XBDM command, along with queue "
+                "depth and time spent waiting to be sent.\n"
+                "\n"
+                "reset - Clear all statistics after printing them.\n"
+                "export <path> - Also write the statistics to the given "
+                "file in the Prometheus text exposition format.") {}
+  Result operator()(XBOXInterface& interface, const ArgParser& args,
+                    std::ostream& out) override;
+};
+
 struct ShellCommandTrace : Command {
   ShellCommandTrace()
       : Command("Inject the nv2a tracer and capture one or more frames.",
@@ -33,6 +66,10 @@ struct ShellCommandTrace : Command {
                 "Default: 1.\n"
                 "  nodiscard - Starts capture immediately without seeking the "
                 "start of a new frame.\n"
+                "  stream <path> - Unix domain socket or named pipe to which "
+                "trace records are streamed as they are retrieved.\n"
+                "  images <png|fastpng|raw|qoi> - Format used for decoded "
+                "surfaces and textures. Default: png.\n"
                 "  tex <on|off> - Enables or disables capture of raw "
                 "textures. Default: on.\n"
                 "  depth <on|off> - Enables or disables capture of the depth "
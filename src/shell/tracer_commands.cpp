@@ -4,6 +4,7 @@
 #include <filesystem>
 #include <vector>
 
+#include "tracer/trace_stream.h"
 #include "tracer/tracer.h"
 #include "util/parsing.h"
 
@@ -75,6 +76,8 @@ Command::Result TracerCommandTraceFrames::operator()(XBOXInterface& interface,
   auto num_frames = 1;
   auto verbose = false;
   auto nodiscard = false;
+  std::shared_ptr<NTRCTracer::TraceStream> stream;
+  auto image_format = ImageOutputFormat::PNG;
 
   auto it = args.begin();
   while (it != args.end()) {
@@ -117,6 +120,18 @@ Command::Result TracerCommandTraceFrames::operator()(XBOXInterface& interface,
       }
     } else if (key == "nodiscard") {
       nodiscard = true;
+    } else if (key == "images") {
+      auto format_name = boost::algorithm::to_lower_copy(*it++);
+      if (!ParseImageOutputFormat(format_name, image_format)) {
+        out << "Invalid '" << key << "' argument." << std::endl;
+        return HANDLED;
+      }
+    } else if (key == "stream") {
+      stream = NTRCTracer::TraceStream::Open(*it++);
+      if (!stream) {
+        out << "Failed to open stream target." << std::endl;
+        return HANDLED;
+      }
     } else {
       out << "Unknown config argument '" << key << "'" << std::endl;
     }
@@ -127,8 +142,18 @@ Command::Result TracerCommandTraceFrames::operator()(XBOXInterface& interface,
     return HANDLED;
   }
 
-  if (!NTRCTracer::Tracer::TraceFrames(interface, local_artifact_path,
-                                       num_frames, verbose, nodiscard)) {
+  auto succeeded =
+      NTRCTracer::Tracer::TraceFrames(interface, local_artifact_path,
+                                      num_frames, verbose, nodiscard, stream,
+                                      image_format);
+
+  if (stream) {
+    stream->Close();
+    out << "Streamed " << stream->frames_written() << " records, dropped "
+        << stream->frames_dropped() << "." << std::endl;
+  }
+
+  if (!succeeded) {
     out << "Failed to trace frames." << std::endl;
     return HANDLED;
   }
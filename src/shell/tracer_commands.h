@@ -69,7 +69,15 @@ struct TracerCommandTraceFrames : Command {
                 "  nodiscard - Starts capture immediately without seeking the "
                 "start of a new frame.\n"
                 "  verbose - Emits more verbose information into the capture "
-                "log.") {}
+                "log.\n"
+                "  stream <path> - Unix domain socket or named pipe to which "
+                "PGRAPH commands and aux headers are streamed as they are "
+                "retrieved. A reader must already be listening.\n"
+                "  images <png|fastpng|raw|qoi> - Format used for decoded "
+                "surfaces and textures. 'fastpng', 'raw' (with a JSON sidecar) "
+                "and 'qoi' trade artifact size for capture speed and may be "
+                "converted to optimized PNGs afterwards with "
+                "util/capture_image_optimizer. Default: png.") {}
   Result operator()(XBOXInterface& interface, const ArgParser&,
                     std::ostream& out) override;
 };
@@ -1,12 +1,12 @@
 #include "frame_capture.h"
 
 #include "dyndxt_loader/dyndxt_requests.h"
+#include "image_util.h"
 #include "lodepng.h"
 #include "ntrc_dyndxt.h"
-extern "C" {
-#include "swizzle.h"
-}
-#include "image_util.h"
+#include "trace_stream.h"
+#include "unswizzle.h"
+#include "util/hash.h"
 #include "util/logging.h"
 #include "xbox/xbox_interface.h"
 
@@ -273,8 +273,12 @@ static const std::map<uint32_t, std::string> kTextureFormatNames = {
     {NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_R8G8B8A8, "LU_IMAGE_R8G8B8A8"},
 };
 
+const char FrameCapture::kPGRAPHChannel[] = NTRC_HANDLER_NAME;
+const char FrameCapture::kAuxChannel[] = NTRC_HANDLER_NAME "_aux";
+
 void FrameCapture::Setup(const std::filesystem::path& artifact_path,
-                         bool verbose) {
+                         bool verbose,
+                         const std::filesystem::path& texture_store_path) {
   artifact_path_ = artifact_path;
   verbose_logging_ = verbose;
   nv2a_log_ = std::ofstream(artifact_path_ / "nv2a_log.txt",
@@ -283,16 +287,39 @@ void FrameCapture::Setup(const std::filesystem::path& artifact_path,
 
   pgraph_parameter_map.clear();
   pgraph_commands.clear();
+
+  auto store_path = texture_store_path.empty() ? artifact_path_ / "textures"
+                                               : texture_store_path;
+  if (store_path != texture_store_path_) {
+    texture_store_path_ = store_path;
+    stored_texture_files_.clear();
+  }
+  if (!exists(texture_store_path_)) {
+    create_directories(texture_store_path_);
+  }
+  texture_store_reference_ =
+      std::filesystem::relative(texture_store_path_, artifact_path_)
+          .generic_string();
+  texture_count_ = 0;
+  duplicate_texture_count_ = 0;
 }
 
-void FrameCapture::Close() { nv2a_log_.close(); }
+void FrameCapture::Close() {
+  nv2a_log_.close();
+
+  if (texture_count_) {
+    LOG_CAP(info) << "Captured " << texture_count_ << " textures, "
+                  << duplicate_texture_count_
+                  << " of which were already in the texture store.";
+  }
+}
 
 FrameCapture::FetchResult FrameCapture::FetchPGRAPHTraceData(
     XBOXInterface& interface) {
   auto request =
       std::make_shared<DynDXTLoader::InvokeReceiveSizePrefixedBinary>(
           NTRC_HANDLER_NAME "!read_pgraph maxsize=0x1000000");
-  interface.SendCommandSync(request, NTRC_HANDLER_NAME);
+  interface.SendCommandSync(request, kPGRAPHChannel);
   if (!request->IsOK()) {
     // A notification of data availability may have triggered this fetch while a
     // read operation retrieved the data, so it is not considered an error for
@@ -325,7 +352,7 @@ FrameCapture::FetchResult FrameCapture::FetchAuxTraceData(
     auto request =
         std::make_shared<DynDXTLoader::InvokeReceiveSizePrefixedBinary>(
             NTRC_HANDLER_NAME "!read_aux maxsize=0x1000000");
-    interface.SendCommandSync(request, NTRC_HANDLER_NAME);
+    interface.SendCommandSync(request, kAuxChannel);
     if (!request->IsOK()) {
       if (request->status == ERR_DATA_NOT_AVAILABLE) {
         break;
@@ -388,6 +415,7 @@ void FrameCapture::ProcessPGRAPHBuffer() {
     pgraph_commands.emplace_back(packet);
 
     LogPacket(packet);
+    StreamPacket(packet);
   }
 
   if (bytes_consumed > 0) {
@@ -483,6 +511,20 @@ void FrameCapture::LogPacket(const PushBufferCommandTraceInfo& packet) {
   }
 }
 
+void FrameCapture::StreamPacket(const PushBufferCommandTraceInfo& packet) {
+  if (!stream_) {
+    return;
+  }
+
+  if (packet.command.valid && packet.data.data_state == PBCPDS_HEAP_BUFFER &&
+      packet.command.parameter_count) {
+    const auto& params = pgraph_parameter_map[packet.data.data.data_id];
+    stream_->WritePGRAPHCommand(packet, params.data(), params.size());
+  } else {
+    stream_->WritePGRAPHCommand(packet, nullptr, 0);
+  }
+}
+
 void FrameCapture::ProcessAuxBuffer() {
   const auto header_size = sizeof(AuxDataHeader);
   ssize_t bytes_consumed = 0;
@@ -501,6 +543,10 @@ void FrameCapture::ProcessAuxBuffer() {
     auto packet_data_start =
         aux_trace_buffer_.begin() + bytes_consumed + header_size;
 
+    if (stream_) {
+      stream_->WriteAuxHeader(packet);
+    }
+
     switch (packet.data_type) {
       case ADT_PGRAPH_DUMP:
         LogPGRAPH(packet, packet.len, packet_data_start);
@@ -611,47 +657,69 @@ void FrameCapture::LogRDI(const NTRCTracer::AuxDataHeader& packet,
   os.close();
 }
 
+//! Writes an encoded image to `base_path` with an extension appropriate for
+//! the given format and layout.
+static void WriteImage(const std::filesystem::path& base_path,
+                       const uint8_t* pixels, uint32_t width, uint32_t height,
+                       uint32_t channels, uint32_t bit_depth,
+                       ImageOutputFormat format) {
+  std::vector<uint8_t> encoded_data;
+  auto error = EncodeImage(encoded_data, pixels, width, height, channels,
+                           bit_depth, format);
+  if (error) {
+    auto error_message = lodepng_error_text(error);
+    LOG_CAP(error) << " Image encoding failed " << error_message << std::endl;
+    return;
+  }
+
+  auto image_path = base_path;
+  image_path += ".";
+  image_path += GetImageExtension(format, channels, bit_depth);
+  auto os = std::ofstream(image_path, std::ios_base::out |
+                                          std::ios_base::trunc |
+                                          std::ios_base::binary);
+  os.write(reinterpret_cast<const char*>(encoded_data.data()),
+           static_cast<std::streamsize>(encoded_data.size()));
+  os.close();
+
+  if (format == ImageOutputFormat::RAW) {
+    image_path += ".json";
+    os = std::ofstream(image_path, std::ios_base::out | std::ios_base::trunc);
+    os << DescribeRawImage(width, height, channels, bit_depth);
+    os.close();
+  }
+}
+
 static void SaveSurfaceImage(const void* raw, uint32_t data_len,
-                             std::ofstream& os, uint32_t surface_type,
-                             uint32_t width, uint32_t height, uint32_t pitch,
-                             bool swizzle) {
+                             const std::filesystem::path& base_path,
+                             ImageOutputFormat image_format,
+                             uint32_t surface_type, uint32_t width,
+                             uint32_t height, uint32_t pitch, bool swizzle) {
   auto surface_format_entry = kSurfaceFormats.find(surface_type);
   assert(surface_format_entry != kSurfaceFormats.end());
   const auto& surface_format = surface_format_entry->second;
 
-  std::unique_ptr<uint8_t[]> buffer;
-
+  const auto* input = static_cast<const uint8_t*>(raw);
   if (swizzle) {
-    buffer = std::unique_ptr<uint8_t[]>(new uint8_t[data_len]);
-    unswizzle_rect(static_cast<const uint8_t*>(raw), width, height,
-                   buffer.get(), pitch, surface_format.bytes_per_pixel);
+    auto buffer = GetUnswizzleScratchBuffer(data_len);
+    UnswizzleRect(input, width, height, buffer, pitch,
+                  surface_format.bytes_per_pixel);
+    input = buffer;
   }
 
-  const uint8_t* input =
-      buffer ? buffer.get() : static_cast<const uint8_t*>(raw);
   std::shared_ptr<uint8_t[]> converted_buffer;
   if (surface_format.converter) {
     converted_buffer = surface_format.converter(input, data_len);
     input = converted_buffer.get();
   }
 
-  std::vector<unsigned char> png_data;
-  unsigned error = 0;
-
   if (surface_type == SURFACE_FORMAT_Y8 || surface_type == SURFACE_FORMAT_Y16) {
-    error = lodepng::encode(png_data, input, width, height, LCT_GREY,
-                            surface_format.bytes_per_pixel * 8);
+    WriteImage(base_path, input, width, height, 1,
+               surface_format.bytes_per_pixel * 8, image_format);
   } else if (surface_format.has_alpha) {
-    error = lodepng::encode(png_data, input, width, height, LCT_RGBA, 8);
+    WriteImage(base_path, input, width, height, 4, 8, image_format);
   } else {
-    error = lodepng::encode(png_data, input, width, height, LCT_RGB, 8);
-  }
-
-  if (error) {
-    auto error_message = lodepng_error_text(error);
-    LOG_CAP(error) << " PNG encoding failed " << error_message << std::endl;
-  } else {
-    os.write(reinterpret_cast<const char*>(png_data.data()), png_data.size());
+    WriteImage(base_path, input, width, height, 3, 8, image_format);
   }
 }
 
@@ -757,78 +825,114 @@ void FrameCapture::LogSurface(const NTRCTracer::AuxDataHeader& packet,
     os.close();
 
     if (surface_format) {
-      snprintf(filename, sizeof(filename), "%010u_%u_%u_Surface_%s.png",
+      snprintf(filename, sizeof(filename), "%010u_%u_%u_Surface_%s",
                packet.packet_index, packet.draw_index,
                header->save_context.surface_dump_index, surface_type.c_str());
-      os = std::ofstream(artifact_path_ / filename, std::ios_base::out |
-                                                        std::ios_base::trunc |
-                                                        std::ios_base::binary);
-      SaveSurfaceImage(d, data_len, os, surface_format, header->width,
-                       header->height, header->pitch, header->swizzle);
-      os.close();
+      SaveSurfaceImage(d, data_len, artifact_path_ / filename, image_format_,
+                       surface_format, header->width, header->height,
+                       header->pitch, header->swizzle);
     }
   }
 }
 
+//! Returns the channel count and bit depth of the decoded form of an
+//! uncompressed texture.
+static void GetTextureImageLayout(uint32_t texture_type,
+                                  const TextureFormatDefinition& texture_format,
+                                  uint32_t& channels, uint32_t& bit_depth) {
+  if (texture_type == NV097_SET_TEXTURE_FORMAT_COLOR_SZ_Y8 ||
+      texture_type == NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_Y16 ||
+      texture_type == NV097_SET_TEXTURE_FORMAT_COLOR_SZ_A8) {
+    channels = 1;
+    bit_depth = texture_format.bytes_per_pixel * 8;
+  } else {
+    channels = texture_format.has_alpha ? 4 : 3;
+    bit_depth = 8;
+  }
+}
+
+//! Returns the extension of the image file written for a texture.
+static const char* GetTextureImageExtension(
+    uint32_t texture_type, const TextureFormatDefinition& texture_format,
+    ImageOutputFormat image_format) {
+  if (texture_format.compressed) {
+    return "dds";
+  }
+
+  uint32_t channels;
+  uint32_t bit_depth;
+  GetTextureImageLayout(texture_type, texture_format, channels, bit_depth);
+  return GetImageExtension(image_format, channels, bit_depth);
+}
+
 static void SaveTextureImage(const void* raw, uint32_t data_len,
-                             std::ofstream& os, uint32_t texture_type,
+                             const std::filesystem::path& base_path,
+                             ImageOutputFormat image_format,
+                             uint32_t texture_type,
                              const TextureFormatDefinition& texture_format,
                              uint32_t mipmap_count, uint32_t width,
                              uint32_t height, uint32_t depth, uint32_t pitch) {
-  std::unique_ptr<uint8_t[]> buffer;
-
+  const auto* input = static_cast<const uint8_t*>(raw);
   if (texture_format.swizzled) {
-    buffer = std::unique_ptr<uint8_t[]>(new uint8_t[data_len]);
-    unswizzle_rect(static_cast<const uint8_t*>(raw), width, height,
-                   buffer.get(), pitch, texture_format.bytes_per_pixel);
+    auto buffer = GetUnswizzleScratchBuffer(data_len);
+    UnswizzleRect(input, width, height, buffer, pitch,
+                  texture_format.bytes_per_pixel);
+    input = buffer;
   }
 
-  const uint8_t* input =
-      buffer ? buffer.get() : static_cast<const uint8_t*>(raw);
-
   std::shared_ptr<uint8_t[]> converted_buffer;
   if (texture_format.converter) {
     converted_buffer = texture_format.converter(input, data_len);
     input = converted_buffer.get();
   }
 
-  std::vector<uint8_t> png_data;
-  uint32_t error = 0;
+  if (!texture_format.compressed) {
+    uint32_t channels;
+    uint32_t bit_depth;
+    GetTextureImageLayout(texture_type, texture_format, channels, bit_depth);
+    WriteImage(base_path, input, width, height, channels, bit_depth,
+               image_format);
+    return;
+  }
 
-  if (texture_format.compressed) {
-    auto compression = DXTCompression::INVALID;
-    if (texture_type == NV097_SET_TEXTURE_FORMAT_COLOR_L_DXT1_A1R5G5B5) {
-      compression = DXTCompression::DXT1;
-    } else if (texture_type ==
-               NV097_SET_TEXTURE_FORMAT_COLOR_L_DXT23_A8R8G8B8) {
-      compression = DXTCompression::DXT3;
-    } else if (texture_type ==
-               NV097_SET_TEXTURE_FORMAT_COLOR_L_DXT45_A8R8G8B8) {
-      compression = DXTCompression::DXT5;
-    }
-    error = EncodeDDS(png_data, input, data_len, width, height, compression);
-  } else if (texture_type == NV097_SET_TEXTURE_FORMAT_COLOR_SZ_Y8 ||
-             texture_type == NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_Y16 ||
-             texture_type == NV097_SET_TEXTURE_FORMAT_COLOR_SZ_A8) {
-    error = lodepng::encode(png_data, input, width, height, LCT_GREY,
-                            texture_format.bytes_per_pixel * 8);
-  } else if (texture_format.has_alpha) {
-    error = lodepng::encode(png_data, input, width, height, LCT_RGBA, 8);
-  } else {
-    error = lodepng::encode(png_data, input, width, height, LCT_RGB, 8);
+  auto compression = DXTCompression::INVALID;
+  if (texture_type == NV097_SET_TEXTURE_FORMAT_COLOR_L_DXT1_A1R5G5B5) {
+    compression = DXTCompression::DXT1;
+  } else if (texture_type == NV097_SET_TEXTURE_FORMAT_COLOR_L_DXT23_A8R8G8B8) {
+    compression = DXTCompression::DXT3;
+  } else if (texture_type == NV097_SET_TEXTURE_FORMAT_COLOR_L_DXT45_A8R8G8B8) {
+    compression = DXTCompression::DXT5;
   }
 
-  if (error) {
-    auto error_message = lodepng_error_text(error);
-    LOG_CAP(error) << " PNG encoding failed " << error_message << std::endl;
-  } else {
-    os.write(reinterpret_cast<const char*>(png_data.data()), png_data.size());
+  std::vector<uint8_t> dds_data;
+  if (EncodeDDS(dds_data, input, data_len, width, height, compression)) {
+    LOG_CAP(error) << " DDS encoding failed" << std::endl;
+    return;
   }
+
+  auto image_path = base_path;
+  image_path += ".dds";
+  auto os = std::ofstream(image_path, std::ios_base::out |
+                                          std::ios_base::trunc |
+                                          std::ios_base::binary);
+  os.write(reinterpret_cast<const char*>(dds_data.data()),
+           static_cast<std::streamsize>(dds_data.size()));
+  os.close();
+}
+
+//! Computes a content hash for a texture, taking into account the parameters
+//! that determine how the payload is decoded.
+static uint64_t HashTextureContent(const TextureHeader& header,
+                                   const char* data, uint32_t data_len) {
+  const uint32_t layout[] = {header.format, header.width, header.height,
+                             header.depth, header.pitch};
+  auto seed = XXHash64(layout, sizeof(layout));
+  return XXHash64(data, data_len, seed);
 }
 
 void FrameCapture::LogTexture(const NTRCTracer::AuxDataHeader& packet,
                               uint32_t data_len,
-                              std::vector<uint8_t>::const_iterator data) const {
+                              std::vector<uint8_t>::const_iterator data) {
   const char* d = reinterpret_cast<const char*>(&data[0]);
   auto header = reinterpret_cast<const TextureHeader*>(d);
 
@@ -838,95 +942,157 @@ void FrameCapture::LogTexture(const NTRCTracer::AuxDataHeader& packet,
   uint32_t texture_type = (header->format >> 8) & 0x7F;
   uint32_t mipmap_levels = (header->format >> 16) & 0x0F;
 
-  {
-    char filename[64];
-    snprintf(filename, sizeof(filename), "%010u_%u_%u_Texture_%d_%d.txt",
-             packet.packet_index, packet.draw_index,
-             header->save_context.surface_dump_index, header->stage,
-             header->layer);
+  auto texture_format_entry = kTextureFormats.find(texture_type);
+  assert(texture_format_entry != kTextureFormats.end());
+  const auto& texture_format = texture_format_entry->second;
 
-    auto os = std::ofstream(artifact_path_ / filename,
+  auto content_name = HashToString(HashTextureContent(*header, d, data_len));
+  std::string image_filename;
+  if (header->width && header->height) {
+    image_filename = content_name + "." +
+                     GetTextureImageExtension(texture_type, texture_format,
+                                              image_format_);
+  }
+
+  ++texture_count_;
+  bool content_stored = IsInTextureStore(content_name + ".bin");
+  bool image_stored =
+      image_filename.empty() || IsInTextureStore(image_filename);
+  if (!content_stored) {
+    StoreTextureContent(content_name, *header, d, data_len);
+  }
+  if (!image_stored) {
+    StoreTextureImage(content_name, *header, d, data_len);
+  }
+  if (content_stored && image_stored) {
+    ++duplicate_texture_count_;
+  }
+  stored_texture_files_.insert(content_name + ".bin");
+  if (!image_filename.empty()) {
+    stored_texture_files_.insert(image_filename);
+  }
+
+  char filename[64];
+  snprintf(filename, sizeof(filename), "%010u_%u_%u_Texture_%d_%d.txt",
+           packet.packet_index, packet.draw_index,
+           header->save_context.surface_dump_index, header->stage,
+           header->layer);
+
+  auto os = std::ofstream(artifact_path_ / filename,
+                          std::ios_base::out | std::ios_base::trunc);
+  os << "{" << std::endl;
+  os << "  \"texture\": {" << std::endl;
+  os << R"(    "stage": ")" << header->stage << "\"," << std::endl;
+  os << R"(    "layer": ")" << header->layer << "\"," << std::endl;
+  os << R"(    "draw": )" << packet.draw_index << "," << std::endl;
+  os << R"(    "surface_dump": )" << header->save_context.surface_dump_index
+     << "," << std::endl;
+  auto provoking_command =
+      kProvokingCommandNames.find(header->save_context.provoking_command);
+  if (provoking_command != kProvokingCommandNames.end()) {
+    os << R"(    "provoking_command": ")" << provoking_command->second << "\","
+       << std::endl;
+  }
+  os << R"(    "provoking_command_hex": "0x)" << std::hex << std::setw(8)
+     << std::setfill('0') << header->save_context.provoking_command << std::dec
+     << "\"," << std::endl;
+
+  auto content_path = texture_store_reference_ + "/" + content_name;
+  os << R"(    "content_hash": ")" << content_name << "\"," << std::endl;
+  os << R"(    "content_bin": ")" << content_path << ".bin\"," << std::endl;
+  if (!image_filename.empty()) {
+    os << R"(    "content_image": ")" << texture_store_reference_ << "/"
+       << image_filename << "\"," << std::endl;
+  }
+
+  os << R"(    "width": )" << header->width << "," << std::endl;
+  os << R"(    "height": )" << header->height << "," << std::endl;
+  os << R"(    "depth": )" << header->depth << "," << std::endl;
+  os << R"(    "pitch": )" << header->pitch << "," << std::endl;
+  os << R"(    "mipmap_levels": )" << mipmap_levels << "," << std::endl;
+
+  auto format_name = kTextureFormatNames.find(texture_type);
+  if (format_name != kTextureFormatNames.end()) {
+    os << R"(    "type": ")" << format_name->second << "\"," << std::endl;
+  }
+  os << R"(    "type_hex": "0x)" << std::hex << std::setw(8) << std::setfill('0')
+     << texture_type << std::dec << "\"," << std::endl;
+
+  os << R"(    "format": )" << header->format << "," << std::endl;
+  os << R"(    "format_hex": "0x)" << std::hex << std::setw(8)
+     << std::setfill('0') << header->format << std::dec << "\"," << std::endl;
+  os << R"(    "imagerect_hex": "0x)" << std::hex << std::setw(8)
+     << std::setfill('0') << header->image_rect << std::dec << "\","
+     << std::endl;
+  os << R"(    "control0": )" << header->control0 << "," << std::endl;
+  os << R"(    "control0_hex": "0x)" << std::hex << std::setw(8)
+     << std::setfill('0') << header->control0 << std::dec << "\"," << std::endl;
+  os << R"(    "control1": )" << header->control1 << "," << std::endl;
+  os << R"(    "control1_hex": "0x)" << std::hex << std::setw(8)
+     << std::setfill('0') << header->control1 << std::dec << "\"" << std::endl;
+
+  os << "  }" << std::endl;
+  os << "}" << std::endl;
+  os.close();
+}
+
+void FrameCapture::StoreTextureContent(const std::string& content_name,
+                                       const TextureHeader& header,
+                                       const char* data,
+                                       uint32_t data_len) const {
+  uint32_t texture_type = (header.format >> 8) & 0x7F;
+  uint32_t mipmap_levels = (header.format >> 16) & 0x0F;
+
+  // The description allows the store to be processed by tools that pair
+  // `.bin` payloads with `.txt` descriptions (e.g., surface_pngify).
+  {
+    auto os = std::ofstream(texture_store_path_ / (content_name + ".txt"),
                             std::ios_base::out | std::ios_base::trunc);
     os << "{" << std::endl;
     os << "  \"texture\": {" << std::endl;
-    os << R"(    "stage": ")" << header->stage << "\"," << std::endl;
-    os << R"(    "layer": ")" << header->layer << "\"," << std::endl;
-    os << R"(    "draw": )" << packet.draw_index << "," << std::endl;
-    os << R"(    "surface_dump": )" << header->save_context.surface_dump_index
-       << "," << std::endl;
-    auto provoking_command =
-        kProvokingCommandNames.find(header->save_context.provoking_command);
-    if (provoking_command != kProvokingCommandNames.end()) {
-      os << R"(    "provoking_command": ")" << provoking_command->second
-         << "\"," << std::endl;
-    }
-    os << R"(    "provoking_command_hex": "0x)" << std::hex << std::setw(8)
-       << std::setfill('0') << header->save_context.provoking_command
-       << std::dec << "\"," << std::endl;
-
-    os << R"(    "width": )" << header->width << "," << std::endl;
-    os << R"(    "height": )" << header->height << "," << std::endl;
-    os << R"(    "depth": )" << header->depth << "," << std::endl;
-    os << R"(    "pitch": )" << header->pitch << "," << std::endl;
+    os << R"(    "content_hash": ")" << content_name << "\"," << std::endl;
+    os << R"(    "width": )" << header.width << "," << std::endl;
+    os << R"(    "height": )" << header.height << "," << std::endl;
+    os << R"(    "depth": )" << header.depth << "," << std::endl;
+    os << R"(    "pitch": )" << header.pitch << "," << std::endl;
     os << R"(    "mipmap_levels": )" << mipmap_levels << "," << std::endl;
-
     auto format_name = kTextureFormatNames.find(texture_type);
     if (format_name != kTextureFormatNames.end()) {
       os << R"(    "type": ")" << format_name->second << "\"," << std::endl;
     }
-    os << R"(    "type_hex": "0x)" << std::hex << std::setw(8)
-       << std::setfill('0') << texture_type << std::dec << "\"," << std::endl;
-
-    os << R"(    "format": )" << header->format << "," << std::endl;
+    os << R"(    "format": )" << header.format << "," << std::endl;
     os << R"(    "format_hex": "0x)" << std::hex << std::setw(8)
-       << std::setfill('0') << header->format << std::dec << "\"," << std::endl;
-    os << R"(    "imagerect_hex": "0x)" << std::hex << std::setw(8)
-       << std::setfill('0') << header->image_rect << std::dec << "\","
-       << std::endl;
-    os << R"(    "control0": )" << header->control0 << "," << std::endl;
-    os << R"(    "control0_hex": "0x)" << std::hex << std::setw(8)
-       << std::setfill('0') << header->control0 << std::dec << "\","
-       << std::endl;
-    os << R"(    "control1": )" << header->control1 << "," << std::endl;
-    os << R"(    "control1_hex": "0x)" << std::hex << std::setw(8)
-       << std::setfill('0') << header->control1 << std::dec << "\""
-       << std::endl;
-
+       << std::setfill('0') << header.format << std::dec << "\"" << std::endl;
     os << "  }" << std::endl;
     os << "}" << std::endl;
     os.close();
   }
 
-  {
-    char filename[64];
-    snprintf(filename, sizeof(filename), "%010u_%u_%u_Texture_%d_%d.bin",
-             packet.packet_index, packet.draw_index,
-             header->save_context.surface_dump_index, header->stage,
-             header->layer);
-    auto os = std::ofstream(
-        artifact_path_ / filename,
-        std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
-    os.write(d, data_len);
-    os.close();
+  auto os = std::ofstream(
+      texture_store_path_ / (content_name + ".bin"),
+      std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+  os.write(data, data_len);
+  os.close();
+}
 
-    auto texture_format_entry = kTextureFormats.find(texture_type);
-    assert(texture_format_entry != kTextureFormats.end());
-    const auto& texture_format = texture_format_entry->second;
+void FrameCapture::StoreTextureImage(const std::string& content_name,
+                                     const TextureHeader& header,
+                                     const char* data,
+                                     uint32_t data_len) const {
+  uint32_t texture_type = (header.format >> 8) & 0x7F;
+  uint32_t mipmap_levels = (header.format >> 16) & 0x0F;
+  const auto& texture_format = kTextureFormats.find(texture_type)->second;
+
+  SaveTextureImage(data, data_len, texture_store_path_ / content_name,
+                   image_format_, texture_type, texture_format, mipmap_levels,
+                   header.width, header.height, header.depth, header.pitch);
+}
 
-    snprintf(filename, sizeof(filename), "%010u_%u_%u_Texture_%d_%d.%s",
-             packet.packet_index, packet.draw_index,
-             header->save_context.surface_dump_index, header->stage,
-             header->layer, texture_format.compressed ? "dds" : "png");
-    os = std::ofstream(artifact_path_ / filename, std::ios_base::out |
-                                                      std::ios_base::trunc |
-                                                      std::ios_base::binary);
-    if (header->width && header->height) {
-      SaveTextureImage(d, data_len, os, texture_type, texture_format,
-                       mipmap_levels, header->width, header->height,
-                       header->depth, header->pitch);
-    }
-    os.close();
-  }
+bool FrameCapture::IsInTextureStore(const std::string& filename) const {
+  // Files written by an earlier capture sharing the store are only found on
+  // disk.
+  return stored_texture_files_.contains(filename) ||
+         exists(texture_store_path_ / filename);
 }
 
 }  // namespace NTRCTracer
@@ -5,36 +5,69 @@
 #include <fstream>
 #include <list>
 #include <map>
+#include <memory>
+#include <string>
+#include <unordered_set>
 #include <vector>
 
+#include "image_util.h"
 #include "tracer_xbox_shared.h"
 
 class XBOXInterface;
 
 namespace NTRCTracer {
 
+class TraceStream;
+
 class FrameCapture {
   friend class FrameCaptureTestFixture;
 
  public:
   //! Prepares this FrameCapture for use, creating artifacts within the given
   //! path.
-  void Setup(const std::filesystem::path& artifact_path, bool verbose = false);
+  //!
+  //! Texture content is stored once per unique payload within
+  //! `texture_store_path`, which may be shared between captures. If empty, a
+  //! "textures" subdirectory of `artifact_path` is used.
+  void Setup(const std::filesystem::path& artifact_path, bool verbose = false,
+             const std::filesystem::path& texture_store_path = {});
 
   //! Closes this capture and flushes any pending writes.
   void Close();
 
+  //! Sets a stream to which PGRAPH commands and aux headers will be written as
+  //! they are processed, in addition to the on-disk artifacts.
+  void SetStream(std::shared_ptr<TraceStream> stream) {
+    stream_ = std::move(stream);
+  }
+
+  //! Sets the format used when writing decoded surfaces and textures.
+  void SetImageOutputFormat(ImageOutputFormat format) {
+    image_format_ = format;
+  }
+
   enum class FetchResult {
     NO_DATA_AVAILABLE,
     ERROR,
     DATA_FETCHED,
   };
-  //! Retrieves and consumes PGRAPH trace data from the given XBOX.
+  //! Retrieves and consumes PGRAPH trace data from the given XBOX via the
+  //! kPGRAPHChannel dedicated connection.
+  //!
+  //! PGRAPH and aux data are processed into disjoint state, so this may be
+  //! called concurrently with FetchAuxTraceData.
   FetchResult FetchPGRAPHTraceData(XBOXInterface& interface);
 
-  //! Retrieves and consumes graphics trace information from the given XBOX.
+  //! Retrieves and consumes graphics trace information from the given XBOX via
+  //! the kAuxChannel dedicated connection.
   FetchResult FetchAuxTraceData(XBOXInterface& interface);
 
+  //! Name of the dedicated channel used to retrieve PGRAPH trace data.
+  static const char kPGRAPHChannel[];
+
+  //! Name of the dedicated channel used to retrieve aux trace data.
+  static const char kAuxChannel[];
+
  private:
   //! Reads as many PushBufferCommandTraceInfo instances from
   //! pgraph_trace_buffer_ as possible, erasing consumed bytes.
@@ -43,6 +76,9 @@ class FrameCapture {
   //! Writes information about the given packet to the nv2a_log.
   void LogPacket(const PushBufferCommandTraceInfo& packet);
 
+  //! Writes the given packet and its parameters to stream_, if set.
+  void StreamPacket(const PushBufferCommandTraceInfo& packet);
+
   //! Reads as many aux data structures from aux_trace_buffer_ as possible,
   //! erasing consumed bytes.
   void ProcessAuxBuffer();
@@ -60,7 +96,22 @@ class FrameCapture {
                   std::vector<uint8_t>::const_iterator data) const;
 
   void LogTexture(const AuxDataHeader& packet, uint32_t data_len,
-                  std::vector<uint8_t>::const_iterator data) const;
+                  std::vector<uint8_t>::const_iterator data);
+
+  //! Writes the raw form of a texture payload and its description into the
+  //! texture store under the given content name.
+  void StoreTextureContent(const std::string& content_name,
+                           const TextureHeader& header, const char* data,
+                           uint32_t data_len) const;
+
+  //! Writes the decoded form of a texture payload into the texture store under
+  //! the given content name, in the current `image_format_`.
+  void StoreTextureImage(const std::string& content_name,
+                         const TextureHeader& header, const char* data,
+                         uint32_t data_len) const;
+
+  //! Returns true if the named file is known to be in the texture store.
+  bool IsInTextureStore(const std::string& filename) const;
 
  public:
   //! Map of arbitrary ID to a vector of parameters for some PGRAPH command.
@@ -81,6 +132,31 @@ class FrameCapture {
   //! Whether or not to write verbose nv2a logs.
   bool verbose_logging_;
 
+  //! The path at which deduplicated texture content will be stored.
+  std::filesystem::path texture_store_path_;
+
+  //! `texture_store_path_` relative to `artifact_path_`, as referenced from
+  //! texture descriptions.
+  std::string texture_store_reference_;
+
+  //! Names of the files that are known to be in the texture store. Images are
+  //! tracked separately from the raw content, as the image for a given hash
+  //! differs by `image_format_`.
+  std::unordered_set<std::string> stored_texture_files_;
+
+  //! The number of textures logged since the last Setup.
+  uint32_t texture_count_{0};
+
+  //! The number of textures logged since the last Setup whose content and
+  //! image were already in the texture store.
+  uint32_t duplicate_texture_count_{0};
+
+  //! The format used when writing decoded surfaces and textures.
+  ImageOutputFormat image_format_{ImageOutputFormat::PNG};
+
+  //! Optional stream receiving processed packets.
+  std::shared_ptr<TraceStream> stream_;
+
   //! Stores bytes that were not consumed as part of the last trace fetch.
   std::vector<uint8_t> pgraph_trace_buffer_;
 
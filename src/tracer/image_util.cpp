@@ -1,6 +1,9 @@
 #include "image_util.h"
 
 #include <cstring>
+#include <sstream>
+
+#include "lodepng.h"
 
 // DDS file support
 // See
@@ -311,3 +314,306 @@ uint32_t EncodeDDS(std::vector<uint8_t>& encoded_data, const void* input,
 
   return 0;
 }
+
+bool ParseImageOutputFormat(const std::string& name,
+                            ImageOutputFormat& format) {
+  if (name == "png") {
+    format = ImageOutputFormat::PNG;
+  } else if (name == "fastpng") {
+    format = ImageOutputFormat::PNG_FAST;
+  } else if (name == "raw") {
+    format = ImageOutputFormat::RAW;
+  } else if (name == "qoi") {
+    format = ImageOutputFormat::QOI;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static bool SupportsQOI(uint32_t channels, uint32_t bit_depth) {
+  return bit_depth == 8 && (channels == 3 || channels == 4);
+}
+
+const char* GetImageExtension(ImageOutputFormat format, uint32_t channels,
+                              uint32_t bit_depth) {
+  switch (format) {
+    case ImageOutputFormat::RAW:
+      return "raw";
+    case ImageOutputFormat::QOI:
+      if (SupportsQOI(channels, bit_depth)) {
+        return "qoi";
+      }
+      return "png";
+    default:
+      return "png";
+  }
+}
+
+static LodePNGColorType ColorTypeForChannels(uint32_t channels) {
+  switch (channels) {
+    case 1:
+      return LCT_GREY;
+    case 3:
+      return LCT_RGB;
+    default:
+      return LCT_RGBA;
+  }
+}
+
+static uint32_t EncodeFastPNG(std::vector<uint8_t>& encoded_data,
+                              const uint8_t* pixels, uint32_t width,
+                              uint32_t height, LodePNGColorType color_type,
+                              uint32_t bit_depth) {
+  lodepng::State state;
+  state.info_raw.colortype = color_type;
+  state.info_raw.bitdepth = bit_depth;
+  state.info_png.color.colortype = color_type;
+  state.info_png.color.bitdepth = bit_depth;
+
+  // Skip the palette/bit depth reduction scan and per-row filter selection,
+  // and limit the LZ77 search effort.
+  state.encoder.auto_convert = 0;
+  state.encoder.filter_strategy = LFS_ZERO;
+  state.encoder.zlibsettings.windowsize = 512;
+  state.encoder.zlibsettings.nicematch = 32;
+  state.encoder.zlibsettings.lazymatching = 0;
+
+  return lodepng::encode(encoded_data, pixels, width, height, state);
+}
+
+uint32_t EncodeImage(std::vector<uint8_t>& encoded_data, const uint8_t* pixels,
+                     uint32_t width, uint32_t height, uint32_t channels,
+                     uint32_t bit_depth, ImageOutputFormat format) {
+  auto color_type = ColorTypeForChannels(channels);
+
+  switch (format) {
+    case ImageOutputFormat::PNG:
+      return lodepng::encode(encoded_data, pixels, width, height, color_type,
+                             bit_depth);
+
+    case ImageOutputFormat::RAW:
+      encoded_data.assign(
+          pixels, pixels + width * height * channels * (bit_depth / 8));
+      return 0;
+
+    case ImageOutputFormat::QOI:
+      if (SupportsQOI(channels, bit_depth)) {
+        EncodeQOI(encoded_data, pixels, width, height, channels);
+        return 0;
+      }
+      [[fallthrough]];
+
+    case ImageOutputFormat::PNG_FAST:
+      return EncodeFastPNG(encoded_data, pixels, width, height, color_type,
+                           bit_depth);
+  }
+
+  return 1;
+}
+
+std::string DescribeRawImage(uint32_t width, uint32_t height,
+                             uint32_t channels, uint32_t bit_depth) {
+  std::stringstream os;
+  os << "{" << std::endl;
+  os << R"(  "width": )" << width << "," << std::endl;
+  os << R"(  "height": )" << height << "," << std::endl;
+  os << R"(  "channels": )" << channels << "," << std::endl;
+  os << R"(  "bit_depth": )" << bit_depth << "," << std::endl;
+  // Multibyte samples are stored as lodepng expects them for PNG encoding.
+  os << R"(  "byte_order": "big")" << std::endl;
+  os << "}" << std::endl;
+  return os.str();
+}
+
+// QOI support
+// See https://qoiformat.org/qoi-specification.pdf
+static constexpr uint8_t kQOIOpIndex = 0x00;
+static constexpr uint8_t kQOIOpDiff = 0x40;
+static constexpr uint8_t kQOIOpLuma = 0x80;
+static constexpr uint8_t kQOIOpRun = 0xC0;
+static constexpr uint8_t kQOIOpRGB = 0xFE;
+static constexpr uint8_t kQOIOpRGBA = 0xFF;
+static constexpr uint8_t kQOIMask2 = 0xC0;
+static constexpr uint32_t kQOIHeaderSize = 14;
+static constexpr uint8_t kQOIEndMarker[] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+namespace {
+struct QOIPixel {
+  uint8_t r{0};
+  uint8_t g{0};
+  uint8_t b{0};
+  uint8_t a{255};
+
+  bool operator==(const QOIPixel& other) const = default;
+
+  [[nodiscard]] uint32_t Hash() const {
+    return (r * 3 + g * 5 + b * 7 + a * 11) % 64;
+  }
+};
+}  // namespace
+
+static void WriteBigEndian32(std::vector<uint8_t>& out, uint32_t value) {
+  out.push_back(value >> 24);
+  out.push_back((value >> 16) & 0xFF);
+  out.push_back((value >> 8) & 0xFF);
+  out.push_back(value & 0xFF);
+}
+
+static uint32_t ReadBigEndian32(const uint8_t* in) {
+  return (in[0] << 24) | (in[1] << 16) | (in[2] << 8) | in[3];
+}
+
+void EncodeQOI(std::vector<uint8_t>& encoded_data, const uint8_t* pixels,
+               uint32_t width, uint32_t height, uint32_t channels) {
+  encoded_data.clear();
+  encoded_data.reserve(kQOIHeaderSize + width * height * (channels + 1) +
+                       sizeof(kQOIEndMarker));
+  encoded_data.insert(encoded_data.end(), {'q', 'o', 'i', 'f'});
+  WriteBigEndian32(encoded_data, width);
+  WriteBigEndian32(encoded_data, height);
+  encoded_data.push_back(channels);
+  // sRGB with linear alpha.
+  encoded_data.push_back(0);
+
+  QOIPixel index[64]{};
+  QOIPixel prev;
+  uint32_t run = 0;
+  const uint32_t num_pixels = width * height;
+
+  for (uint32_t i = 0; i < num_pixels; ++i) {
+    const uint8_t* src = pixels + i * channels;
+    QOIPixel px{src[0], src[1], src[2],
+                static_cast<uint8_t>(channels == 4 ? src[3] : 255)};
+
+    if (px == prev) {
+      ++run;
+      if (run == 62 || i == num_pixels - 1) {
+        encoded_data.push_back(kQOIOpRun | (run - 1));
+        run = 0;
+      }
+      continue;
+    }
+
+    if (run) {
+      encoded_data.push_back(kQOIOpRun | (run - 1));
+      run = 0;
+    }
+
+    auto hash = px.Hash();
+    if (index[hash] == px) {
+      encoded_data.push_back(kQOIOpIndex | hash);
+    } else {
+      index[hash] = px;
+
+      if (px.a == prev.a) {
+        int8_t vr = static_cast<int8_t>(px.r - prev.r);
+        int8_t vg = static_cast<int8_t>(px.g - prev.g);
+        int8_t vb = static_cast<int8_t>(px.b - prev.b);
+        int8_t vg_r = static_cast<int8_t>(vr - vg);
+        int8_t vg_b = static_cast<int8_t>(vb - vg);
+
+        if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+          encoded_data.push_back(kQOIOpDiff | (vr + 2) << 4 | (vg + 2) << 2 |
+                                 (vb + 2));
+        } else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 &&
+                   vg_b > -9 && vg_b < 8) {
+          encoded_data.push_back(kQOIOpLuma | (vg + 32));
+          encoded_data.push_back((vg_r + 8) << 4 | (vg_b + 8));
+        } else {
+          encoded_data.insert(encoded_data.end(), {kQOIOpRGB, px.r, px.g, px.b});
+        }
+      } else {
+        encoded_data.insert(encoded_data.end(),
+                            {kQOIOpRGBA, px.r, px.g, px.b, px.a});
+      }
+    }
+
+    prev = px;
+  }
+
+  encoded_data.insert(encoded_data.end(), std::begin(kQOIEndMarker),
+                      std::end(kQOIEndMarker));
+}
+
+bool DecodeQOI(const std::vector<uint8_t>& encoded_data,
+               std::vector<uint8_t>& pixels, uint32_t& width, uint32_t& height,
+               uint32_t& channels) {
+  if (encoded_data.size() < kQOIHeaderSize + sizeof(kQOIEndMarker) ||
+      memcmp(encoded_data.data(), "qoif", 4) != 0) {
+    return false;
+  }
+
+  const uint8_t* in = encoded_data.data();
+  width = ReadBigEndian32(in + 4);
+  height = ReadBigEndian32(in + 8);
+  channels = in[12];
+  if (!width || !height || (channels != 3 && channels != 4)) {
+    return false;
+  }
+
+  const uint32_t num_pixels = width * height;
+  pixels.resize(num_pixels * channels);
+
+  const size_t chunks_end = encoded_data.size() - sizeof(kQOIEndMarker);
+  size_t pos = kQOIHeaderSize;
+  QOIPixel index[64]{};
+  QOIPixel px;
+  uint32_t run = 0;
+
+  for (uint32_t i = 0; i < num_pixels; ++i) {
+    if (run) {
+      --run;
+    } else if (pos < chunks_end) {
+      uint8_t b1 = in[pos++];
+
+      if (b1 == kQOIOpRGB) {
+        if (pos + 3 > chunks_end) {
+          return false;
+        }
+        px.r = in[pos++];
+        px.g = in[pos++];
+        px.b = in[pos++];
+      } else if (b1 == kQOIOpRGBA) {
+        if (pos + 4 > chunks_end) {
+          return false;
+        }
+        px.r = in[pos++];
+        px.g = in[pos++];
+        px.b = in[pos++];
+        px.a = in[pos++];
+      } else if ((b1 & kQOIMask2) == kQOIOpIndex) {
+        px = index[b1];
+      } else if ((b1 & kQOIMask2) == kQOIOpDiff) {
+        px.r += ((b1 >> 4) & 0x03) - 2;
+        px.g += ((b1 >> 2) & 0x03) - 2;
+        px.b += (b1 & 0x03) - 2;
+      } else if ((b1 & kQOIMask2) == kQOIOpLuma) {
+        if (pos >= chunks_end) {
+          return false;
+        }
+        uint8_t b2 = in[pos++];
+        int vg = (b1 & 0x3F) - 32;
+        px.r += vg - 8 + ((b2 >> 4) & 0x0F);
+        px.g += vg;
+        px.b += vg - 8 + (b2 & 0x0F);
+      } else {
+        run = b1 & 0x3F;
+      }
+
+      index[px.Hash()] = px;
+    } else {
+      return false;
+    }
+
+    uint8_t* dst = pixels.data() + i * channels;
+    dst[0] = px.r;
+    dst[1] = px.g;
+    dst[2] = px.b;
+    if (channels == 4) {
+      dst[3] = px.a;
+    }
+  }
+
+  return true;
+}
@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 
 std::shared_ptr<uint8_t[]> RGB565ToRGB88(const void* src, uint32_t src_size);
@@ -28,4 +29,47 @@ uint32_t EncodeDDS(std::vector<uint8_t>& encoded_data, const void* input,
                    uint32_t input_len, uint32_t width, uint32_t height,
                    DXTCompression compression);
 
+//! Container used when writing decoded images.
+enum class ImageOutputFormat {
+  //! PNG using lodepng's default, size optimized, settings.
+  PNG,
+  //! PNG using a small deflate window and no filter heuristics.
+  PNG_FAST,
+  //! Unencoded pixels, described by a JSON sidecar file.
+  RAW,
+  //! The "Quite OK Image" format. Only 8-bit RGB and RGBA images are supported;
+  //! other layouts fall back to PNG_FAST.
+  QOI,
+};
+
+//! Parses a user supplied format name ("png", "fastpng", "raw", or "qoi").
+bool ParseImageOutputFormat(const std::string& name, ImageOutputFormat& format);
+
+//! Returns the file extension (without a leading '.') used when an image with
+//! the given layout is encoded in `format`.
+const char* GetImageExtension(ImageOutputFormat format, uint32_t channels,
+                              uint32_t bit_depth);
+
+//! Encodes `pixels` in the given format.
+//!
+//! `channels` must be 1 (grey), 3 (RGB), or 4 (RGBA). Returns 0 on success or
+//! a lodepng error code.
+uint32_t EncodeImage(std::vector<uint8_t>& encoded_data, const uint8_t* pixels,
+                     uint32_t width, uint32_t height, uint32_t channels,
+                     uint32_t bit_depth, ImageOutputFormat format);
+
+//! Returns the JSON sidecar describing an ImageOutputFormat::RAW image.
+std::string DescribeRawImage(uint32_t width, uint32_t height,
+                             uint32_t channels, uint32_t bit_depth);
+
+//! Encodes 8-bit RGB or RGBA pixels as a QOI image.
+void EncodeQOI(std::vector<uint8_t>& encoded_data, const uint8_t* pixels,
+               uint32_t width, uint32_t height, uint32_t channels);
+
+//! Decodes a QOI image into 8-bit pixels with the channel count stored in the
+//! image.
+bool DecodeQOI(const std::vector<uint8_t>& encoded_data,
+               std::vector<uint8_t>& pixels, uint32_t& width, uint32_t& height,
+               uint32_t& channels);
+
 #endif  // IMAGE_UTIL_H
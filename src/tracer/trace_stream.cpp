@@ -0,0 +1,222 @@
+#include "trace_stream.h"
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <csignal>
+#include <cstring>
+
+#include "util/logging.h"
+
+constexpr const char kLoggingTagStream[] = "TRC_STR";
+#define LOG_STREAM(lvl) LOG_TAGGED(lvl, kLoggingTagStream)
+
+namespace NTRCTracer {
+
+static int ConnectUnixSocket(const std::filesystem::path& path) {
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  const auto& native = path.native();
+  if (native.size() >= sizeof(addr.sun_path)) {
+    LOG_STREAM(error) << "Socket path too long: " << path;
+    return -1;
+  }
+  memcpy(addr.sun_path, native.c_str(), native.size() + 1);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    LOG_STREAM(error) << "Failed to create socket: " << strerror(errno);
+    return -1;
+  }
+
+  if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr))) {
+    LOG_STREAM(error) << "Failed to connect to " << path << ": "
+                      << strerror(errno);
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+static int OpenNamedPipe(const std::filesystem::path& path) {
+  // Opening non-blocking fails immediately if there is no reader rather than
+  // hanging the shell.
+  int fd = open(path.c_str(), O_WRONLY | O_NONBLOCK);
+  if (fd < 0) {
+    LOG_STREAM(error) << "Failed to open " << path << ": " << strerror(errno);
+    return -1;
+  }
+
+  // Writes are done from a dedicated thread, so blocking is preferable to
+  // spinning on EAGAIN.
+  int flags = fcntl(fd, F_GETFL);
+  fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+  return fd;
+}
+
+std::shared_ptr<TraceStream> TraceStream::Open(
+    const std::filesystem::path& path, size_t max_buffered_bytes) {
+  struct stat info {};
+  if (stat(path.c_str(), &info)) {
+    LOG_STREAM(error) << "Stream target " << path
+                      << " does not exist: " << strerror(errno);
+    return nullptr;
+  }
+
+  int fd;
+  if (S_ISSOCK(info.st_mode)) {
+    fd = ConnectUnixSocket(path);
+  } else if (S_ISFIFO(info.st_mode)) {
+    fd = OpenNamedPipe(path);
+  } else {
+    LOG_STREAM(error) << "Stream target " << path
+                      << " is not a Unix socket or named pipe.";
+    return nullptr;
+  }
+
+  if (fd < 0) {
+    return nullptr;
+  }
+
+  return std::shared_ptr<TraceStream>(new TraceStream(fd, max_buffered_bytes));
+}
+
+TraceStream::TraceStream(int fd, size_t max_buffered_bytes)
+    : fd_(fd), max_buffered_bytes_(max_buffered_bytes) {
+  writer_thread_ = std::thread(&TraceStream::WriterThreadMain, this);
+}
+
+TraceStream::~TraceStream() { Close(); }
+
+void TraceStream::Close() {
+  {
+    const std::lock_guard lock(queue_lock_);
+    if (closing_) {
+      return;
+    }
+    closing_ = true;
+  }
+  queue_condition_.notify_all();
+
+  if (writer_thread_.joinable()) {
+    writer_thread_.join();
+  }
+
+  close(fd_);
+  fd_ = -1;
+
+  if (frames_dropped_) {
+    LOG_STREAM(warning) << "Trace stream dropped " << frames_dropped_
+                        << " frames (" << bytes_dropped_ << " bytes).";
+  }
+}
+
+void TraceStream::WritePGRAPHCommand(const PushBufferCommandTraceInfo& packet,
+                                     const uint32_t* params,
+                                     uint32_t param_count) {
+  Enqueue(TSFT_PGRAPH_COMMAND, &packet, sizeof(packet), params,
+          params ? param_count * sizeof(*params) : 0);
+}
+
+void TraceStream::WriteAuxHeader(const AuxDataHeader& header) {
+  Enqueue(TSFT_AUX_HEADER, &header, sizeof(header));
+}
+
+void TraceStream::Enqueue(TraceStreamFrameType type, const void* data,
+                          size_t data_len, const void* extra_data,
+                          size_t extra_data_len) {
+  auto payload_len = data_len + extra_data_len;
+  auto frame_len = sizeof(TraceStreamFrameHeader) + payload_len;
+
+  {
+    const std::lock_guard lock(queue_lock_);
+    auto sequence = next_sequence_++;
+
+    if (closing_ || failed_ ||
+        buffered_bytes_ + frame_len > max_buffered_bytes_) {
+      ++frames_dropped_;
+      bytes_dropped_ += frame_len;
+      return;
+    }
+
+    TraceStreamFrameHeader header{kTraceStreamMagic, type, sequence,
+                                  static_cast<uint32_t>(payload_len)};
+
+    std::vector<uint8_t> frame(frame_len);
+    auto* dest = frame.data();
+    memcpy(dest, &header, sizeof(header));
+    dest += sizeof(header);
+    memcpy(dest, data, data_len);
+    if (extra_data_len) {
+      memcpy(dest + data_len, extra_data, extra_data_len);
+    }
+
+    buffered_bytes_ += frame_len;
+    queue_.emplace_back(std::move(frame));
+  }
+  queue_condition_.notify_one();
+}
+
+void TraceStream::WriterThreadMain() {
+  // A consumer disconnecting should fail the write rather than terminate the
+  // bridge.
+  sigset_t sigpipe_mask;
+  sigemptyset(&sigpipe_mask);
+  sigaddset(&sigpipe_mask, SIGPIPE);
+  pthread_sigmask(SIG_BLOCK, &sigpipe_mask, nullptr);
+
+  while (true) {
+    std::vector<uint8_t> frame;
+    {
+      std::unique_lock lock(queue_lock_);
+      queue_condition_.wait(lock,
+                            [this]() { return closing_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      frame = std::move(queue_.front());
+      queue_.pop_front();
+      buffered_bytes_ -= frame.size();
+    }
+
+    const uint8_t* data = frame.data();
+    size_t remaining = frame.size();
+    while (remaining) {
+      auto written = write(fd_, data, remaining);
+      if (written < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        break;
+      }
+      data += written;
+      remaining -= written;
+    }
+
+    if (!remaining) {
+      ++frames_written_;
+      continue;
+    }
+
+    LOG_STREAM(error) << "Trace stream write failed: " << strerror(errno);
+    if (errno == EPIPE) {
+      // Consume the pending SIGPIPE generated by the failed write.
+      timespec no_wait{0, 0};
+      sigtimedwait(&sigpipe_mask, nullptr, &no_wait);
+    }
+
+    const std::lock_guard lock(queue_lock_);
+    failed_ = true;
+    frames_dropped_ += queue_.size() + 1;
+    bytes_dropped_ += buffered_bytes_ + frame.size();
+    queue_.clear();
+    buffered_bytes_ = 0;
+    return;
+  }
+}
+
+}  // namespace NTRCTracer
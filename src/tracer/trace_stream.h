@@ -0,0 +1,110 @@
+#ifndef XBDM_GDB_BRIDGE_SRC_TRACER_TRACE_STREAM_H_
+#define XBDM_GDB_BRIDGE_SRC_TRACER_TRACE_STREAM_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "tracer_xbox_shared.h"
+
+namespace NTRCTracer {
+
+//! Header preceding every frame written to a TraceStream.
+//!
+//! All values are in host byte order.
+typedef struct TraceStreamFrameHeader {
+  //! Always kTraceStreamMagic.
+  uint32_t magic;
+
+  //! A value from TraceStreamFrameType.
+  uint32_t type;
+
+  //! Monotonically increasing frame counter. Gaps indicate dropped frames.
+  uint32_t sequence;
+
+  //! The number of payload bytes immediately following this header.
+  uint32_t len;
+} TraceStreamFrameHeader;
+static_assert(sizeof(TraceStreamFrameHeader) == 16);
+
+//! Magic value identifying a TraceStreamFrameHeader ("NTRS").
+constexpr uint32_t kTraceStreamMagic = 0x5352544E;
+
+typedef enum TraceStreamFrameType {
+  //! A PushBufferCommandTraceInfo followed by its parameters (if any were
+  //! captured), as `command.parameter_count` uint32_t's.
+  TSFT_PGRAPH_COMMAND = 1,
+  //! An AuxDataHeader. The aux payload itself is not streamed.
+  TSFT_AUX_HEADER = 2,
+} TraceStreamFrameType;
+
+//! Pushes decoded trace records to a local Unix domain socket or named pipe as
+//! they are retrieved from the XBOX.
+//!
+//! Frames are queued and written from a dedicated thread. If the consumer
+//! cannot keep up and the queue exceeds its byte budget, new frames are dropped
+//! and counted rather than stalling the capture.
+class TraceStream {
+ public:
+  static constexpr size_t kDefaultMaxBufferedBytes = 4 * 1024 * 1024;
+
+  //! Connects to the Unix domain socket or opens the named pipe at the given
+  //! path. A reader must already be listening on/have opened the path.
+  //!
+  //! Returns nullptr on failure.
+  static std::shared_ptr<TraceStream> Open(
+      const std::filesystem::path& path,
+      size_t max_buffered_bytes = kDefaultMaxBufferedBytes);
+
+  ~TraceStream();
+
+  //! Flushes any queued frames and closes the stream.
+  void Close();
+
+  //! Queues a PGRAPH command and its parameters.
+  void WritePGRAPHCommand(const PushBufferCommandTraceInfo& packet,
+                          const uint32_t* params, uint32_t param_count);
+
+  //! Queues an aux data header.
+  void WriteAuxHeader(const AuxDataHeader& header);
+
+  [[nodiscard]] uint64_t frames_written() const { return frames_written_; }
+  [[nodiscard]] uint64_t frames_dropped() const { return frames_dropped_; }
+  [[nodiscard]] uint64_t bytes_dropped() const { return bytes_dropped_; }
+
+ private:
+  TraceStream(int fd, size_t max_buffered_bytes);
+
+  void Enqueue(TraceStreamFrameType type, const void* data, size_t data_len,
+               const void* extra_data = nullptr, size_t extra_data_len = 0);
+
+  void WriterThreadMain();
+
+ private:
+  int fd_;
+  size_t max_buffered_bytes_;
+
+  std::mutex queue_lock_;
+  std::condition_variable queue_condition_;
+  std::deque<std::vector<uint8_t>> queue_;
+  size_t buffered_bytes_{0};
+  uint32_t next_sequence_{0};
+  bool closing_{false};
+  bool failed_{false};
+
+  std::thread writer_thread_;
+
+  std::atomic<uint64_t> frames_written_{0};
+  std::atomic<uint64_t> frames_dropped_{0};
+  std::atomic<uint64_t> bytes_dropped_{0};
+};
+
+}  // namespace NTRCTracer
+
+#endif  // XBDM_GDB_BRIDGE_SRC_TRACER_TRACE_STREAM_H_
@@ -3,6 +3,7 @@
 #include <filesystem>
 #include <fstream>
 #include <memory>
+#include <thread>
 
 #include "dyndxt_loader/dyndxt_requests.h"
 #include "dyndxt_loader/loader.h"
@@ -47,7 +48,8 @@ bool Tracer::Install(XBOXInterface& interface) {
               std::dynamic_pointer_cast<NotificationNTRC>(notification);
 
           this->OnNotification(ntrc_notification, context);
-        });
+        },
+        NTRC_HANDLER_NAME);
     RegisterXBDMNotificationConstructor(
         NTRC_HANDLER_NAME, MakeXBDMNotificationConstructor<NotificationNTRC>());
   }
@@ -68,6 +70,17 @@ bool Tracer::Install(XBOXInterface& interface) {
     }
   }
 
+  // Aux data is retrieved over a second connection so that large transfers do
+  // not block retrieval of PGRAPH data.
+  {
+    auto request = std::make_shared<Dedicate>(NTRC_HANDLER_NAME);
+    interface.SendCommandSync(request, FrameCapture::kAuxChannel);
+    if (!request->IsOK()) {
+      LOG_TRACER(error) << "Failed to dedicate aux channel " << *request;
+      return false;
+    }
+  }
+
   return true;
 }
 
@@ -121,10 +134,13 @@ void Tracer::OnNotification(
     OnNewState(content.GetDWORD("new_state"), context);
   } else if (content.HasKey("req_processed")) {
     request_processed_ = true;
+    NotifyFetchThreads();
   } else if (content.HasKey("w_pgraph")) {
     pgraph_data_available_ = true;
+    NotifyFetchThreads();
   } else if (content.HasKey("w_aux")) {
     aux_data_available_ = true;
+    NotifyFetchThreads();
   } else {
     LOG_TRACER(error) << "Notification handler called with unknown type: "
                       << *notification;
@@ -136,6 +152,7 @@ void Tracer::OnNewState(int new_state, XBDMContext& context) {
   case val:                         \
     LOG_TRACER(lvl) << #val;        \
     request_failed_ = true;         \
+    NotifyFetchThreads();           \
     return
 
   switch (new_state) {
@@ -195,6 +212,11 @@ void Tracer::OnNewState(int new_state, XBDMContext& context) {
 }
 
 void Tracer::OnShutdown(XBDMContext& context) {
+  // No further notifications will arrive for an in-progress trace, so any
+  // fetch threads must be released rather than left waiting for completion.
+  request_failed_ = true;
+  NotifyFetchThreads();
+
   context.UnregisterNotificationHandler(notification_handler_id_);
   notification_handler_id_ = 0;
   UnregisterXBDMNotificationConstructor(NTRC_HANDLER_NAME);
@@ -260,19 +282,26 @@ bool Tracer::BreakOnFrameStart_(XBOXInterface& interface, bool require_flip) {
 
 bool Tracer::TraceFrames(XBOXInterface& interface,
                          const std::string& artifact_path, uint32_t num_frames,
-                         bool verbose, bool allow_partial_frame) {
+                         bool verbose, bool allow_partial_frame,
+                         const std::shared_ptr<TraceStream>& stream,
+                         ImageOutputFormat image_format) {
   Tracer* instance = singleton_;
   if (!instance) {
     LOG_TRACER(error) << "Tracer not initialized.";
     return false;
   }
 
+  // Textures are shared between frames so that content that is reused across
+  // frames is only stored once.
+  auto texture_store_path = std::filesystem::path(artifact_path) / "textures";
+
   for (auto i = 0; i < num_frames; ++i) {
     char frame_name[32];
     snprintf(frame_name, sizeof(frame_name), "frame_%d", i + 1);
     auto output_path = std::filesystem::path(artifact_path) / frame_name;
     if (!instance->TraceFrame(interface, output_path, verbose,
-                              allow_partial_frame)) {
+                              allow_partial_frame, texture_store_path,
+                              stream, image_format)) {
       return false;
     }
 
@@ -283,12 +312,17 @@ bool Tracer::TraceFrames(XBOXInterface& interface,
 
 bool Tracer::TraceFrame(XBOXInterface& interface,
                         const std::filesystem::path& artifact_path,
-                        bool verbose, bool allow_partial_frame) {
+                        bool verbose, bool allow_partial_frame,
+                        const std::filesystem::path& texture_store_path,
+                        const std::shared_ptr<TraceStream>& stream,
+                        ImageOutputFormat image_format) {
   if (!exists(artifact_path)) {
     create_directories(artifact_path);
   }
 
-  in_progress_frame_.Setup(artifact_path, verbose);
+  in_progress_frame_.Setup(artifact_path, verbose, texture_store_path);
+  in_progress_frame_.SetStream(stream);
+  in_progress_frame_.SetImageOutputFormat(image_format);
 
   request_processed_ = false;
   request_failed_ = false;
@@ -307,54 +341,76 @@ bool Tracer::TraceFrame(XBOXInterface& interface,
     return false;
   }
 
-  while (!request_processed_) {
-    if (request_failed_) {
-      return false;
-    }
-    if (pgraph_data_available_.exchange(false)) {
-      if (in_progress_frame_.FetchPGRAPHTraceData(interface) ==
-          FrameCapture::FetchResult::ERROR) {
-        // TODO: Handle error.
-        LOG_TRACER(error) << "FetchPGRAPHTraceData failed.";
-      }
-    }
+  FetchTraceData(interface);
+
+  in_progress_frame_.Close();
+  in_progress_frame_.SetStream(nullptr);
+
+  return !request_failed_;
+}
+
+void Tracer::FetchTraceData(XBOXInterface& interface) {
+  // PGRAPH and aux data are retrieved on independent connections so that
+  // neither stream stalls the other.
+  std::thread pgraph_thread([this, &interface]() {
+    RunFetchLoop(
+        pgraph_data_available_,
+        [this, &interface]() {
+          return in_progress_frame_.FetchPGRAPHTraceData(interface);
+        },
+        "PGRAPH");
+  });
+  std::thread aux_thread([this, &interface]() {
+    RunFetchLoop(
+        aux_data_available_,
+        [this, &interface]() {
+          return in_progress_frame_.FetchAuxTraceData(interface);
+        },
+        "aux");
+  });
+
+  pgraph_thread.join();
+  aux_thread.join();
+}
 
-    if (aux_data_available_.exchange(false)) {
-      if (in_progress_frame_.FetchAuxTraceData(interface) ==
-          FrameCapture::FetchResult::ERROR) {
+void Tracer::RunFetchLoop(
+    std::atomic_bool& data_available,
+    const std::function<FrameCapture::FetchResult()>& fetch,
+    const char* stream_name) {
+  while (!request_processed_ && !request_failed_) {
+    if (data_available.exchange(false)) {
+      if (fetch() == FrameCapture::FetchResult::ERROR) {
         // TODO: Handle error.
-        LOG_TRACER(error) << "FetchPGRAPHTraceData failed.";
+        LOG_TRACER(error) << "Fetching " << stream_name << " data failed.";
       }
+      continue;
     }
-  }
 
-  // Consume any remaining PGRAPH data.
-  while (!request_failed_) {
-    auto result = in_progress_frame_.FetchPGRAPHTraceData(interface);
-    if (result == FrameCapture::FetchResult::NO_DATA_AVAILABLE) {
-      break;
-    }
-    if (result == FrameCapture::FetchResult::ERROR) {
-      // TODO: Handle error
-      LOG_TRACER(error) << "FetchPGRAPHTraceData failed.";
-    }
+    std::unique_lock lock(fetch_mutex_);
+    fetch_condition_.wait_for(lock, std::chrono::milliseconds(10), [&]() {
+      return data_available || request_processed_ || request_failed_;
+    });
   }
 
-  // Consume any remaining graphics data.
+  // Consume any remaining data.
   while (!request_failed_) {
-    auto result = in_progress_frame_.FetchAuxTraceData(interface);
+    auto result = fetch();
     if (result == FrameCapture::FetchResult::NO_DATA_AVAILABLE) {
       break;
     }
     if (result == FrameCapture::FetchResult::ERROR) {
       // TODO: Handle error
-      LOG_TRACER(error) << "FetchAuxTraceData failed.";
+      LOG_TRACER(error) << "Fetching " << stream_name << " data failed.";
     }
   }
+}
 
-  in_progress_frame_.Close();
-
-  return true;
+void Tracer::NotifyFetchThreads() {
+  {
+    // Synchronize with RunFetchLoop to prevent a lost wakeup.
+    const std::lock_guard lock(fetch_mutex_);
+  }
+  fetch_condition_.notify_all();
 }
 
 }  // namespace NTRCTracer
@@ -2,8 +2,11 @@
 #define XBDM_GDB_BRIDGE_SRC_TRACER_TRACER_H_
 
 #include <atomic>
+#include <condition_variable>
 #include <filesystem>
+#include <functional>
 #include <memory>
+#include <mutex>
 
 #include "frame_capture.h"
 #include "notification_ntrc.h"
@@ -17,6 +20,8 @@ namespace NTRCTracer {
 //! Handles interaction with the ntrc_dyndxt, facilitating tracing of pushbuffer
 //! messages and dumping of graphics related buffers.
 class Tracer {
+  friend class TracerTestFixture;
+
  public:
   //! Initializes the Tracer singleton.
   static bool Initialize(XBOXInterface& interface);
@@ -42,10 +47,16 @@ class Tracer {
   static bool BreakOnFrameStart(XBOXInterface& interface, bool require_flip);
 
   //! Trace one or more consecutive frames.
-  static bool TraceFrames(XBOXInterface& interface,
-                          const std::string& artifact_path,
-                          uint32_t num_frames = 1, bool verbose = false,
-                          bool allow_partial_frame = false);
+  //!
+  //! If `stream` is set, PGRAPH commands and aux headers are also written to it
+  //! as they are retrieved. Decoded surfaces and textures are written in
+  //! `image_format`.
+  static bool TraceFrames(
+      XBOXInterface& interface, const std::string& artifact_path,
+      uint32_t num_frames = 1, bool verbose = false,
+      bool allow_partial_frame = false,
+      const std::shared_ptr<TraceStream>& stream = nullptr,
+      ImageOutputFormat image_format = ImageOutputFormat::PNG);
 
  private:
   //! Installs the ntrc_dyndxt if necessary and registers for notifications.
@@ -66,10 +77,29 @@ class Tracer {
   //  //! the next frame, even if currently at the start of a frame.
   bool BreakOnFrameStart_(XBOXInterface& interface, bool require_flip);
 
+  //! Retrieves PGRAPH and aux data for `in_progress_frame_` concurrently until
+  //! the active trace request completes or fails.
+  void FetchTraceData(XBOXInterface& interface);
+
+  //! Repeatedly invokes `fetch` whenever `data_available` is signaled until the
+  //! active trace request completes, then drains any remaining data.
+  void RunFetchLoop(std::atomic_bool& data_available,
+                    const std::function<FrameCapture::FetchResult()>& fetch,
+                    const char* stream_name);
+
+  //! Wakes any threads blocked in RunFetchLoop.
+  void NotifyFetchThreads();
+
   //! Traces a single frame.
+  //!
+  //! Texture content is written to `texture_store_path`, which defaults to a
+  //! "textures" directory within `artifact_path`.
   bool TraceFrame(XBOXInterface& interface,
                   const std::filesystem::path& artifact_path,
-                  bool verbose = false, bool allow_partial_frame = false);
+                  bool verbose = false, bool allow_partial_frame = false,
+                  const std::filesystem::path& texture_store_path = {},
+                  const std::shared_ptr<TraceStream>& stream = nullptr,
+                  ImageOutputFormat image_format = ImageOutputFormat::PNG);
 
  private:
   static Tracer* singleton_;
@@ -80,6 +110,10 @@ class Tracer {
   std::atomic_bool pgraph_data_available_{false};
   std::atomic_bool aux_data_available_{false};
 
+  //! Used to wake fetch threads when one of the above flags changes.
+  std::mutex fetch_mutex_;
+  std::condition_variable fetch_condition_;
+
   FrameCapture in_progress_frame_{};
   std::list<FrameCapture> captured_frames_;
 };
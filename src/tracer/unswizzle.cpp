@@ -0,0 +1,193 @@
+#include "unswizzle.h"
+
+#include <algorithm>
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <cstring>
+#include <latch>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+//! Images with fewer pixels than this are unswizzled on the calling thread.
+constexpr uint32_t kMinParallelPixels = 256 * 256;
+
+//! The minimum number of rows processed by each parallel band.
+constexpr uint32_t kMinRowsPerBand = 32;
+
+//! The number of offset tables that may be cached before the cache is flushed.
+constexpr size_t kMaxCachedTables = 64;
+
+//! Byte offsets into a swizzled image, such that the pixel at linear (x, y) is
+//! found at `x_offsets[x] + y_offsets[y]`.
+struct OffsetTables {
+  std::vector<uint32_t> x_offsets;
+  std::vector<uint32_t> y_offsets;
+};
+
+//! Builds the masks describing how linear x and y coordinates are interleaved
+//! into a swizzled offset. See `generate_swizzle_masks` in swizzle.c.
+void GenerateSwizzleMasks(uint32_t width, uint32_t height, uint32_t& mask_x,
+                          uint32_t& mask_y) {
+  mask_x = 0;
+  mask_y = 0;
+  uint32_t bit = 1;
+  uint32_t mask_bit = 1;
+  bool done;
+  do {
+    done = true;
+    if (bit < width) {
+      mask_x |= mask_bit;
+      mask_bit <<= 1;
+      done = false;
+    }
+    if (bit < height) {
+      mask_y |= mask_bit;
+      mask_bit <<= 1;
+      done = false;
+    }
+    bit <<= 1;
+  } while (!done);
+}
+
+std::vector<uint32_t> BuildOffsets(uint32_t count, uint32_t mask,
+                                   uint32_t bytes_per_pixel) {
+  std::vector<uint32_t> ret(count);
+  uint32_t offset = 0;
+  for (auto& entry : ret) {
+    entry = offset * bytes_per_pixel;
+    // Increment the offset, letting the carry ripple through bits that are not
+    // in the mask.
+    offset = (offset - mask) & mask;
+  }
+  return ret;
+}
+
+std::shared_ptr<const OffsetTables> GetOffsetTables(uint32_t width,
+                                                    uint32_t height,
+                                                    uint32_t bytes_per_pixel) {
+  static std::mutex cache_lock;
+  static std::map<std::tuple<uint32_t, uint32_t, uint32_t>,
+                  std::shared_ptr<const OffsetTables>>
+      cache;
+
+  auto key = std::make_tuple(width, height, bytes_per_pixel);
+  const std::lock_guard lock(cache_lock);
+  auto it = cache.find(key);
+  if (it != cache.end()) {
+    return it->second;
+  }
+
+  uint32_t mask_x;
+  uint32_t mask_y;
+  GenerateSwizzleMasks(width, height, mask_x, mask_y);
+
+  auto tables = std::make_shared<OffsetTables>();
+  tables->x_offsets = BuildOffsets(width, mask_x, bytes_per_pixel);
+  tables->y_offsets = BuildOffsets(height, mask_y, bytes_per_pixel);
+
+  if (cache.size() >= kMaxCachedTables) {
+    cache.clear();
+  }
+  cache.emplace(key, tables);
+  return tables;
+}
+
+//! Unswizzles rows [first_row, end_row). Specialized on the pixel size so that
+//! the per-pixel copy compiles down to a single load/store for common formats.
+template <uint32_t BytesPerPixel>
+void UnswizzleRows(const uint8_t* src, uint8_t* dst, uint32_t pitch,
+                   const OffsetTables& tables, uint32_t first_row,
+                   uint32_t end_row, uint32_t bytes_per_pixel) {
+  if constexpr (BytesPerPixel) {
+    bytes_per_pixel = BytesPerPixel;
+  }
+
+  const auto* x_offsets = tables.x_offsets.data();
+  const auto width = static_cast<uint32_t>(tables.x_offsets.size());
+  for (auto y = first_row; y < end_row; ++y) {
+    const uint8_t* src_row = src + tables.y_offsets[y];
+    uint8_t* dst_row = dst + y * pitch;
+    for (uint32_t x = 0; x < width; ++x) {
+      memcpy(dst_row, src_row + x_offsets[x], bytes_per_pixel);
+      dst_row += bytes_per_pixel;
+    }
+  }
+}
+
+void UnswizzleBand(const uint8_t* src, uint8_t* dst, uint32_t pitch,
+                   const OffsetTables& tables, uint32_t first_row,
+                   uint32_t end_row, uint32_t bytes_per_pixel) {
+  switch (bytes_per_pixel) {
+    case 1:
+      UnswizzleRows<1>(src, dst, pitch, tables, first_row, end_row, 1);
+      break;
+    case 2:
+      UnswizzleRows<2>(src, dst, pitch, tables, first_row, end_row, 2);
+      break;
+    case 4:
+      UnswizzleRows<4>(src, dst, pitch, tables, first_row, end_row, 4);
+      break;
+    default:
+      UnswizzleRows<0>(src, dst, pitch, tables, first_row, end_row,
+                       bytes_per_pixel);
+  }
+}
+
+boost::asio::thread_pool& GetUnswizzleExecutor() {
+  static boost::asio::thread_pool executor(
+      std::max(1u, std::thread::hardware_concurrency()));
+  return executor;
+}
+
+}  // namespace
+
+void UnswizzleRect(const uint8_t* src, uint32_t width, uint32_t height,
+                   uint8_t* dst, uint32_t pitch, uint32_t bytes_per_pixel) {
+  if (!width || !height) {
+    return;
+  }
+
+  auto tables = GetOffsetTables(width, height, bytes_per_pixel);
+
+  uint32_t num_bands = 1;
+  if (width * height >= kMinParallelPixels) {
+    num_bands = std::min(std::max(1u, std::thread::hardware_concurrency()),
+                         height / kMinRowsPerBand);
+    num_bands = std::max(1u, num_bands);
+  }
+
+  if (num_bands == 1) {
+    UnswizzleBand(src, dst, pitch, *tables, 0, height, bytes_per_pixel);
+    return;
+  }
+
+  const uint32_t rows_per_band = (height + num_bands - 1) / num_bands;
+  std::latch pending(num_bands - 1);
+  auto& executor = GetUnswizzleExecutor();
+  for (uint32_t band = 1; band < num_bands; ++band) {
+    auto first_row = band * rows_per_band;
+    auto end_row = std::min(height, first_row + rows_per_band);
+    boost::asio::post(executor, [&, first_row, end_row]() {
+      UnswizzleBand(src, dst, pitch, *tables, first_row, end_row,
+                    bytes_per_pixel);
+      pending.count_down();
+    });
+  }
+
+  UnswizzleBand(src, dst, pitch, *tables, 0, rows_per_band, bytes_per_pixel);
+  pending.wait();
+}
+
+uint8_t* GetUnswizzleScratchBuffer(uint32_t size) {
+  thread_local std::vector<uint8_t> scratch;
+  if (scratch.size() < size) {
+    scratch.resize(size);
+  }
+  return scratch.data();
+}
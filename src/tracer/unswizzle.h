@@ -0,0 +1,19 @@
+#ifndef XBDM_GDB_BRIDGE_SRC_TRACER_UNSWIZZLE_H_
+#define XBDM_GDB_BRIDGE_SRC_TRACER_UNSWIZZLE_H_
+
+#include <cstdint>
+
+//! Converts a swizzled (Z-ordered) image into a linear one with the given
+//! pitch.
+//!
+//! Produces the same output as `unswizzle_rect`, but looks up swizzled offsets
+//! in tables that are cached per (width, height, bytes_per_pixel) and splits
+//! large images into row bands that are processed in parallel.
+void UnswizzleRect(const uint8_t* src, uint32_t width, uint32_t height,
+                   uint8_t* dst, uint32_t pitch, uint32_t bytes_per_pixel);
+
+//! Returns a buffer of at least `size` bytes that is owned by the calling
+//! thread and reused by subsequent calls from that thread.
+uint8_t* GetUnswizzleScratchBuffer(uint32_t size);
+
+#endif  // XBDM_GDB_BRIDGE_SRC_TRACER_UNSWIZZLE_H_
@@ -0,0 +1,104 @@
+#include "hash.h"
+
+#include <cstdio>
+#include <cstring>
+
+// See https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+static constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+static constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+static constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+static constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+static constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t RotateLeft(uint64_t value, int bits) {
+  return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t Read64(const uint8_t* ptr) {
+  uint64_t ret;
+  memcpy(&ret, ptr, sizeof(ret));
+  return ret;
+}
+
+static inline uint32_t Read32(const uint8_t* ptr) {
+  uint32_t ret;
+  memcpy(&ret, ptr, sizeof(ret));
+  return ret;
+}
+
+static inline uint64_t Round(uint64_t accumulator, uint64_t input) {
+  accumulator += input * kPrime2;
+  accumulator = RotateLeft(accumulator, 31);
+  return accumulator * kPrime1;
+}
+
+static inline uint64_t MergeRound(uint64_t accumulator, uint64_t value) {
+  accumulator ^= Round(0, value);
+  return accumulator * kPrime1 + kPrime4;
+}
+
+uint64_t XXHash64(const void* data, size_t len, uint64_t seed) {
+  const auto* ptr = static_cast<const uint8_t*>(data);
+  const uint8_t* const end = ptr + len;
+  uint64_t ret;
+
+  if (len >= 32) {
+    const uint8_t* const stripe_limit = end - 32;
+    uint64_t v1 = seed + kPrime1 + kPrime2;
+    uint64_t v2 = seed + kPrime2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - kPrime1;
+
+    do {
+      v1 = Round(v1, Read64(ptr));
+      v2 = Round(v2, Read64(ptr + 8));
+      v3 = Round(v3, Read64(ptr + 16));
+      v4 = Round(v4, Read64(ptr + 24));
+      ptr += 32;
+    } while (ptr <= stripe_limit);
+
+    ret = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) +
+          RotateLeft(v4, 18);
+    ret = MergeRound(ret, v1);
+    ret = MergeRound(ret, v2);
+    ret = MergeRound(ret, v3);
+    ret = MergeRound(ret, v4);
+  } else {
+    ret = seed + kPrime5;
+  }
+
+  ret += static_cast<uint64_t>(len);
+
+  while (ptr + 8 <= end) {
+    ret ^= Round(0, Read64(ptr));
+    ret = RotateLeft(ret, 27) * kPrime1 + kPrime4;
+    ptr += 8;
+  }
+
+  if (ptr + 4 <= end) {
+    ret ^= static_cast<uint64_t>(Read32(ptr)) * kPrime1;
+    ret = RotateLeft(ret, 23) * kPrime2 + kPrime3;
+    ptr += 4;
+  }
+
+  while (ptr < end) {
+    ret ^= static_cast<uint64_t>(*ptr) * kPrime5;
+    ret = RotateLeft(ret, 11) * kPrime1;
+    ++ptr;
+  }
+
+  ret ^= ret >> 33;
+  ret *= kPrime2;
+  ret ^= ret >> 29;
+  ret *= kPrime3;
+  ret ^= ret >> 32;
+
+  return ret;
+}
+
+std::string HashToString(uint64_t hash) {
+  char buffer[17];
+  snprintf(buffer, sizeof(buffer), "%016llx",
+           static_cast<unsigned long long>(hash));
+  return buffer;
+}
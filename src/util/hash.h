@@ -0,0 +1,17 @@
+#ifndef XBDM_GDB_BRIDGE_SRC_UTIL_HASH_H_
+#define XBDM_GDB_BRIDGE_SRC_UTIL_HASH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//! Computes the 64-bit xxHash (XXH64) of the given buffer.
+//!
+//! This is a non-cryptographic hash intended for content-addressing large
+//! buffers (e.g., texture payloads) at close to memory bandwidth.
+uint64_t XXHash64(const void* data, size_t len, uint64_t seed = 0);
+
+//! Returns the given hash as a zero-padded, 16 character lowercase hex string.
+std::string HashToString(uint64_t hash);
+
+#endif  // XBDM_GDB_BRIDGE_SRC_UTIL_HASH_H_
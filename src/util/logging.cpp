@@ -3,11 +3,13 @@
 #include <atomic>
 #include <boost/log/core.hpp>
 #include <boost/log/expressions.hpp>
-#include <boost/log/sinks/sync_frontend.hpp>
+#include <boost/log/sinks/async_frontend.hpp>
 #include <boost/log/sinks/text_ostream_backend.hpp>
-#include <boost/log/utility/setup/common_attributes.hpp>
 #include <filesystem>
 #include <iostream>
+#include <mutex>
+
+#include "mpsc_queue.h"
 
 namespace expr = boost::log::expressions;
 namespace sinks = boost::log::sinks;
@@ -16,21 +18,21 @@ namespace logging {
 
 static std::string base_path(__FILE__);
 
-const char kLoggingTagAttribute[] = "Tag";
-const char kLoggingFileAttribute[] = "Filename";
-const char kLoggingLineAttribute[] = "LineNumber";
-const char kLoggingThreadAttribute[] = "Thread";
+const char kLoggingSourceAttribute[] = "Source";
 const char kLoggingTagGDB[] = "GDB";
 const char kLoggingTagXBDM[] = "XBDM";
 const char kLoggingTagXBDMNotification[] = "XBDM_N";
 const char kLoggingTagDebugger[] = "DEBUGGER";
 
-static uint32_t verbosity_level = boost::log::trivial::severity_level::warning;
-static bool enable_gdb_messages = true;
-static bool enable_xbdm_messages = true;
-static bool enable_debugger_messages = true;
-static bool enable_colorized_output = true;
-static bool enable_log_location_info = true;
+namespace detail {
+std::atomic<int> min_severity{boost::log::trivial::trace};
+}  // namespace detail
+
+static std::atomic<bool> enable_gdb_messages{true};
+static std::atomic<bool> enable_xbdm_messages{true};
+static std::atomic<bool> enable_debugger_messages{true};
+static std::atomic<bool> enable_colorized_output{true};
+static std::atomic<bool> enable_log_location_info{true};
 
 static constexpr const char ANSI_BLACK[] = "\x1b[30m";
 static constexpr const char ANSI_RED[] = "\x1b[31m";
@@ -80,6 +82,67 @@ static std::atomic<uint32_t> next_thread_name{1};
 typedef sinks::basic_formatted_sink_backend<char, sinks::synchronized_feeding>
     SynchronizedSink;
 
+//! Queueing strategy for sinks::asynchronous_sink that hands records to the
+//! feeding thread through a lock-free queue rather than the two-lock queue and
+//! per-record event signal used by sinks::unbounded_fifo_queue.
+class LockFreeRecordQueue {
+ protected:
+  LockFreeRecordQueue() = default;
+
+  template <typename ArgsT>
+  explicit LockFreeRecordQueue(ArgsT const&) {}
+
+  void enqueue(boost::log::record_view const& rec) {
+    queue_.Push(rec);
+    // notify_one only enters the kernel if the feeding thread is waiting.
+    wake_sequence_.fetch_add(1, std::memory_order_release);
+    wake_sequence_.notify_one();
+  }
+
+  bool try_enqueue(boost::log::record_view const& rec) {
+    enqueue(rec);
+    return true;
+  }
+
+  bool try_dequeue_ready(boost::log::record_view& rec) { return TryPop(rec); }
+
+  bool try_dequeue(boost::log::record_view& rec) { return TryPop(rec); }
+
+  bool dequeue_ready(boost::log::record_view& rec) {
+    while (true) {
+      auto observed = wake_sequence_.load(std::memory_order_acquire);
+      if (TryPop(rec)) {
+        return true;
+      }
+      if (interruption_requested_.exchange(false, std::memory_order_acquire)) {
+        return false;
+      }
+      wake_sequence_.wait(observed, std::memory_order_acquire);
+    }
+  }
+
+  void interrupt_dequeue() {
+    interruption_requested_.store(true, std::memory_order_release);
+    wake_sequence_.fetch_add(1, std::memory_order_release);
+    wake_sequence_.notify_one();
+  }
+
+ private:
+  bool TryPop(boost::log::record_view& rec) {
+    auto next = queue_.Pop();
+    if (!next) {
+      return false;
+    }
+    rec = std::move(*next);
+    return true;
+  }
+
+ private:
+  MPSCQueue<boost::log::record_view> queue_;
+  std::atomic<uint32_t> wake_sequence_{0};
+  std::atomic<bool> interruption_requested_{false};
+};
+
 class LoggerSink : public SynchronizedSink {
  public:
   static void consume(boost::log::record_view const& rec,
@@ -89,53 +152,36 @@ class LoggerSink : public SynchronizedSink {
 
   static void format(boost::log::record_view const& rec,
                      boost::log::formatting_ostream& strm) {
-    auto tag = boost::log::extract<std::string>(kLoggingTagAttribute, rec);
+    auto source = rec[source_attr];
     auto severity = rec[boost::log::trivial::severity];
+    std::string_view tag;
 
-    // Ideally this would be done in filter() but attributes are not set until
-    // after the filtering operation.
-    // https://www.boost.org/doc/libs/1_58_0/libs/log/doc/html/log/rationale/why_attribute_manips_dont_affect_filters.html
-    // TODO: Consider moving to scoped logs and doing this in the filter.
-    if (!tag.empty() && severity.get() < boost::log::trivial::warning) {
-      if (tag == kLoggingTagGDB && !enable_gdb_messages) {
-        return;
-      } else if ((tag == kLoggingTagXBDM ||
-                  tag == kLoggingTagXBDMNotification) &&
-                 !enable_xbdm_messages) {
-        return;
-      } else if (tag == kLoggingTagDebugger && !enable_debugger_messages) {
-        return;
-      }
-    }
+    if (source) {
+      const auto& info = source.get();
+      tag = info.tag;
 
-    if (enable_log_location_info) {
-      auto filename =
-          boost::log::extract<std::string>(kLoggingFileAttribute, rec);
-      auto line_num =
-          boost::log::extract<unsigned int>(kLoggingLineAttribute, rec);
-      if (!filename.empty()) {
+      if (enable_log_location_info) {
         // Drop the leading absolute path.
-        std::string path = filename.get().substr(base_path.size());
+        std::string_view path(info.file);
+        if (path.starts_with(base_path)) {
+          path.remove_prefix(base_path.size());
+        }
 
         char buf[64] = {0};
-        snprintf(buf, 63, "%s:%d", path.c_str(), line_num.get());
+        snprintf(buf, 63, "%.*s:%u", static_cast<int>(path.size()),
+                 path.data(), info.line);
 
         strm << std::left << std::setfill(' ') << std::setw(42) << buf;
         strm << std::right << " ";
       }
-    }
 
-    auto thread =
-        boost::log::extract<std::thread::id>(kLoggingThreadAttribute, rec);
-    if (!thread.empty()) {
-      // This assumes that access to thread_names has been serialized by the
-      // sink, which may not be true.
-      auto thread_id = thread.get();
-      auto it = thread_names.find(thread_id);
+      // Access to thread_names is serialized by the asynchronous sink's
+      // feeding thread.
+      auto it = thread_names.find(info.thread);
       uint32_t thread_short_id;
       if (it == thread_names.end()) {
         thread_short_id = next_thread_name.fetch_add(1);
-        thread_names[thread_id] = thread_short_id;
+        thread_names[info.thread] = thread_short_id;
       } else {
         thread_short_id = it->second;
       }
@@ -198,21 +244,17 @@ class LoggerSink : public SynchronizedSink {
   }
 
   static bool filter(const boost::log::attribute_value_set& values) {
-    auto severity =
-        values["Severity"].extract<boost::log::trivial::severity_level>();
-
-    int info_level = boost::log::trivial::info;
-
-    if (verbosity_level > info_level) {
-      verbosity_level = info_level;
-    } else if (info_level - verbosity_level > boost::log::trivial::fatal) {
-      verbosity_level = info_level - boost::log::trivial::fatal;
-    }
-
-    return severity >= (boost::log::trivial::info - verbosity_level);
+    auto severity = values[boost::log::trivial::severity];
+    return severity && ShouldLog(severity.get());
   };
 };
 
+typedef sinks::asynchronous_sink<LoggerSink, LockFreeRecordQueue>
+    AsyncLoggerSink;
+
+static std::mutex sink_lock;
+static boost::shared_ptr<AsyncLoggerSink> logger_sink;
+
 void InitializeLogging(uint32_t verbosity) {
   auto idx = base_path.rfind('/');      // Drop the filename
   idx = base_path.rfind('/', idx - 1);  // Drop util
@@ -223,15 +265,55 @@ void InitializeLogging(uint32_t verbosity) {
   SetVerbosity(verbosity);
   core->set_filter(&LoggerSink::filter);
 
-  typedef boost::log::sinks::synchronous_sink<LoggerSink> logger_sink;
-  auto sink = boost::make_shared<logger_sink>();
-  sink->set_formatter(&LoggerSink::format);
-  core->add_sink(sink);
+  const std::lock_guard lock(sink_lock);
+  if (logger_sink) {
+    return;
+  }
+  logger_sink = boost::make_shared<AsyncLoggerSink>();
+  logger_sink->set_formatter(&LoggerSink::format);
+  core->add_sink(logger_sink);
+}
+
+void FlushLogging() {
+  const std::lock_guard lock(sink_lock);
+  if (logger_sink) {
+    logger_sink->flush();
+  }
+}
+
+void ShutdownLogging() {
+  const std::lock_guard lock(sink_lock);
+  if (!logger_sink) {
+    return;
+  }
+
+  boost::log::core::get()->remove_sink(logger_sink);
+  logger_sink->stop();
+  logger_sink->flush();
+  logger_sink.reset();
+}
 
-  boost::log::add_common_attributes();
+void SetVerbosity(uint32_t verbosity) {
+  auto level = std::min<uint32_t>(verbosity, boost::log::trivial::info);
+  detail::min_severity = boost::log::trivial::info - static_cast<int>(level);
+}
+
+namespace detail {
+
+bool IsTagEnabled(std::string_view tag) {
+  if (tag == kLoggingTagGDB) {
+    return enable_gdb_messages;
+  }
+  if (tag == kLoggingTagXBDM || tag == kLoggingTagXBDMNotification) {
+    return enable_xbdm_messages;
+  }
+  if (tag == kLoggingTagDebugger) {
+    return enable_debugger_messages;
+  }
+  return true;
 }
 
-void SetVerbosity(uint32_t verbosity) { verbosity_level = verbosity; }
+}  // namespace detail
 
 void SetGDBTraceEnabled(bool enabled) { enable_gdb_messages = enabled; }
 
@@ -1,40 +1,71 @@
 #ifndef XBDM_GDB_BRIDGE_LOGGING_H
 #define XBDM_GDB_BRIDGE_LOGGING_H
 
+#include <atomic>
 #include <boost/log/expressions/keyword.hpp>
 #include <boost/log/trivial.hpp>
 #include <boost/log/utility/manipulators/add_value.hpp>
 #include <cstdint>
+#include <string>
+#include <string_view>
 #include <thread>
 
 namespace logging {
 
-extern const char kLoggingTagAttribute[];
-extern const char kLoggingFileAttribute[];
-extern const char kLoggingLineAttribute[];
-extern const char kLoggingThreadAttribute[];
+extern const char kLoggingSourceAttribute[];
 
 extern const char kLoggingTagGDB[];
 extern const char kLoggingTagXBDM[];
 extern const char kLoggingTagXBDMNotification[];
 extern const char kLoggingTagDebugger[];
 
-BOOST_LOG_ATTRIBUTE_KEYWORD(tag_attr, kLoggingTagAttribute, std::string)
-BOOST_LOG_ATTRIBUTE_KEYWORD(file_attr, kLoggingFileAttribute, std::string)
-BOOST_LOG_ATTRIBUTE_KEYWORD(line_attr, kLoggingLineAttribute, unsigned int)
-BOOST_LOG_ATTRIBUTE_KEYWORD(thread_attr, kLoggingThreadAttribute,
-                            std::thread::id)
+//! Everything a log record needs beyond its severity and message, captured as
+//! a single attribute to minimize the per-record cost.
+struct RecordSource {
+  const char* file;
+  unsigned int line;
+  std::thread::id thread;
+  std::string tag;
+};
 
-#define LOG(lvl)                                                          \
-  BOOST_LOG_TRIVIAL(lvl) << boost::log::add_value(::logging::file_attr,   \
-                                                  __FILE__)               \
-                         << boost::log::add_value(::logging::line_attr,   \
-                                                  __LINE__)               \
-                         << boost::log::add_value(::logging::thread_attr, \
-                                                  std::this_thread::get_id())
+BOOST_LOG_ATTRIBUTE_KEYWORD(source_attr, kLoggingSourceAttribute, RecordSource)
 
-#define LOG_TAGGED(lvl, tag) \
-  LOG(lvl) << boost::log::add_value(::logging::tag_attr, tag)
+namespace detail {
+extern std::atomic<int> min_severity;
+
+bool IsTagEnabled(std::string_view tag);
+}  // namespace detail
+
+//! Returns true if records with the given severity will be emitted.
+inline bool ShouldLog(boost::log::trivial::severity_level severity) {
+  return severity >= detail::min_severity.load(std::memory_order_relaxed);
+}
+
+//! Returns true if records with the given severity and tag will be emitted.
+inline bool ShouldLog(boost::log::trivial::severity_level severity,
+                      std::string_view tag) {
+  if (!ShouldLog(severity)) {
+    return false;
+  }
+  return severity >= boost::log::trivial::warning || tag.empty() ||
+         detail::IsTagEnabled(tag);
+}
+
+// The enabled check precedes the record so that arguments streamed into a
+// disabled log statement are never evaluated. A loop is used rather than an
+// if/else so that the macro can be used as the body of an unbraced if.
+#define LOG_RECORD_(lvl, tag)                                        \
+  for (bool log_enabled_ =                                           \
+           ::logging::ShouldLog(::boost::log::trivial::lvl, tag);    \
+       log_enabled_; log_enabled_ = false)                           \
+  BOOST_LOG_TRIVIAL(lvl) << ::boost::log::add_value(                 \
+      ::logging::source_attr,                                        \
+      ::logging::RecordSource{__FILE__, __LINE__,                    \
+                              std::this_thread::get_id(), tag})
+
+#define LOG(lvl) LOG_RECORD_(lvl, "")
+
+#define LOG_TAGGED(lvl, tag) LOG_RECORD_(lvl, tag)
 
 #define LOG_GDB(lvl) LOG_TAGGED(lvl, ::logging::kLoggingTagGDB)
 
@@ -42,8 +73,16 @@ BOOST_LOG_ATTRIBUTE_KEYWORD(thread_attr, kLoggingThreadAttribute,
 
 #define LOG_DEBUGGER(lvl) LOG_TAGGED(lvl, ::logging::kLoggingTagDebugger)
 
+//! Starts logging to stdout. Records are formatted and written by a
+//! background thread so that logging does not block the caller.
 void InitializeLogging(uint32_t verbosity);
 
+//! Blocks until all queued records have been written.
+void FlushLogging();
+
+//! Writes any queued records and stops the background logging thread.
+void ShutdownLogging();
+
 void SetVerbosity(uint32_t verbosity);
 void SetGDBTraceEnabled(bool enabled);
 void SetXBDMTraceEnabled(bool enabled);
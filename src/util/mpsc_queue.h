@@ -0,0 +1,73 @@
+#ifndef XBDM_GDB_BRIDGE_SRC_UTIL_MPSC_QUEUE_H_
+#define XBDM_GDB_BRIDGE_SRC_UTIL_MPSC_QUEUE_H_
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+//! Unbounded, lock-free, multiple producer single consumer FIFO queue.
+//!
+//! Producers never block and enqueue with a single atomic exchange; see
+//! Dmitry Vyukov's intrusive MPSC node-based queue. Pop() must only be called
+//! by one thread at a time.
+//!
+//! A producer that has been preempted between publishing and linking its node
+//! hides subsequently pushed elements from the consumer until it resumes, so
+//! Pop() may transiently report an empty queue while other pushes have
+//! completed.
+template <typename T>
+class MPSCQueue {
+ public:
+  MPSCQueue() : head_(&stub_), tail_(&stub_) {}
+  MPSCQueue(const MPSCQueue&) = delete;
+  MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+  ~MPSCQueue() {
+    while (Pop()) {
+    }
+    if (tail_ != &stub_) {
+      delete tail_;
+    }
+  }
+
+  void Push(T value) {
+    auto node = new Node{{nullptr}, std::move(value)};
+    auto prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  std::optional<T> Pop() {
+    auto tail = tail_;
+    auto next = tail->next.load(std::memory_order_acquire);
+    if (!next) {
+      return std::nullopt;
+    }
+
+    // `next` becomes the new stub; its value is moved out but the node is
+    // retained until the following Pop.
+    std::optional<T> ret(std::move(*next->value));
+    next->value.reset();
+    tail_ = next;
+    if (tail != &stub_) {
+      delete tail;
+    }
+    return ret;
+  }
+
+  //! Returns true if no elements are visible to the consumer.
+  [[nodiscard]] bool Empty() const {
+    return !tail_->next.load(std::memory_order_acquire);
+  }
+
+ private:
+  struct Node {
+    std::atomic<Node*> next;
+    std::optional<T> value;
+  };
+
+  Node stub_{{nullptr}, std::nullopt};
+  std::atomic<Node*> head_;
+  Node* tail_;
+};
+
+#endif  // XBDM_GDB_BRIDGE_SRC_UTIL_MPSC_QUEUE_H_
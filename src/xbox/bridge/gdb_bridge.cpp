@@ -9,6 +9,7 @@
 #include <cstdio>
 
 #include "configure.h"
+#include "gdb/gdb_agent_expression.h"
 #include "gdb/gdb_packet.h"
 #include "gdb/gdb_transport.h"
 #include "gdb_registers.h"
@@ -18,6 +19,18 @@
 #include "xbox/debugger/xbdm_debugger.h"
 #include "xbox/xbdm_context.h"
 
+//! Returns the registers collected in the given frame, falling back to just
+//! the address of the tracepoint.
+static std::optional<ThreadContext> TraceFrameRegisters(
+    const TraceFrame& frame) {
+  if (frame.registers) {
+    return frame.registers;
+  }
+  ThreadContext ret;
+  ret.eip = static_cast<int32_t>(frame.address);
+  return ret;
+}
+
 GDBBridge::GDBBridge(std::shared_ptr<XBDMContext> xbdm_context,
                      std::shared_ptr<XBDMDebugger> debugger)
     : xbdm_(std::move(xbdm_context)), debugger_(std::move(debugger)) {}
@@ -31,23 +44,34 @@ bool GDBBridge::AddTransport(std::shared_ptr<GDBTransport> transport) {
   // TODO: Either chain notifications off the debugger or add "go last" flag.
   // Currently the debugger receives the same notifications as the bridge and
   // does some work to update thread states/etc... This class assumes this has
-  // all happened by the time it receives notifications, but it is not enforced
-  // anywhere. The context could be extended to allow a "last" handler or the
-  // debugger could hold a weak_ptr to a notification listener (this class) to
-  // be notified once it has finished processing notifications from the context.
+  // all happened by the time it receives notifications. Sharing the debugger's
+  // ordering key keeps the handlers serialized, but only runs this one last if
+  // the debugger registered first. The debugger could hold a weak_ptr to a
+  // notification listener (this class) to be notified once it has finished
+  // processing notifications from the context.
+  last_stop_event_count_ = debugger_->StopEventCount();
+  selected_trace_frame_.reset();
   xbdm_->UnregisterNotificationHandler(notification_handler_id_);
   notification_handler_id_ = xbdm_->RegisterNotificationHandler(
       [this](const std::shared_ptr<XBDMNotification>& notification,
-             XBDMContext&) { this->OnNotification(notification); });
+             XBDMContext&) { this->OnNotification(notification); },
+      XBDMDebugger::kNotificationOrderingKey);
 
   return true;
 }
 
+GDBBridge::~GDBBridge() { Stop(); }
+
 void GDBBridge::Stop() {
   if (HasGDBClient()) {
     gdb_->Close();
     gdb_.reset();
   }
+
+  // Waits for any notification that is being handled, so the bridge may be
+  // destroyed once this returns.
+  xbdm_->UnregisterNotificationHandler(notification_handler_id_);
+  notification_handler_id_ = 0;
 }
 
 bool GDBBridge::HasGDBClient() const { return gdb_ && gdb_->IsConnected(); }
@@ -338,6 +362,17 @@ void GDBBridge::HandleReadGeneralRegisters(const GDBPacket& packet) {
     return;
   }
 
+  if (selected_trace_frame_) {
+    auto frame = SelectedTraceFrame();
+    if (!frame) {
+      SendError(EBADMSG);
+      return;
+    }
+    gdb_->Send(GDBPacket(
+        SerializeRegisters(TraceFrameRegisters(*frame), std::nullopt)));
+    return;
+  }
+
   if (!thread_id) {
     auto id = debugger_->AnyThreadID();
     thread_id = id ? static_cast<int32_t>(*id) : -1;
@@ -420,7 +455,21 @@ void GDBBridge::HandleReadMemory(const GDBPacket& packet) {
     return;
   }
 
-  auto memory = debugger_->GetMemory(address, length);
+  std::optional<std::vector<uint8_t>> memory;
+  if (selected_trace_frame_) {
+    auto frame = SelectedTraceFrame();
+    if (frame) {
+      memory = frame->ReadMemory(address, length);
+    }
+    // Memory that cannot change is read from the target, as it is not
+    // collected.
+    if (!memory && length && debugger_->ValidateMemoryAccess(address, length) &&
+        !debugger_->ValidateMemoryAccess(address, length, true)) {
+      memory = debugger_->GetMemory(address, length);
+    }
+  } else {
+    memory = debugger_->GetMemory(address, length);
+  }
   if (memory.has_value()) {
     std::vector<uint8_t> data;
     boost::algorithm::hex(memory->begin(), memory->end(), back_inserter(data));
@@ -431,6 +480,11 @@ void GDBBridge::HandleReadMemory(const GDBPacket& packet) {
 }
 
 void GDBBridge::HandleWriteMemory(const GDBPacket& packet) {
+  if (selected_trace_frame_) {
+    SendError(EROFS);
+    return;
+  }
+
   auto place_data_split = packet.FindFirst(':');
   auto address_length_split = packet.FindFirst(',');
 
@@ -490,6 +544,24 @@ void GDBBridge::HandleReadRegister(const GDBPacket& packet) {
     return;
   }
 
+  if (selected_trace_frame_) {
+    auto frame = SelectedTraceFrame();
+    if (!frame) {
+      SendError(EBADMSG);
+      return;
+    }
+    auto value =
+        GetRegister(register_index, TraceFrameRegisters(*frame), std::nullopt);
+    if (!value.has_value()) {
+      SendEmpty();
+      return;
+    }
+    char response[32] = {0};
+    snprintf(response, 31, "%llx", value.value());
+    gdb_->Send(GDBPacket(response));
+    return;
+  }
+
   if (!thread_id) {
     auto id = debugger_->AnyThreadID();
     thread_id = id ? static_cast<int32_t>(*id) : -1;
@@ -524,6 +596,11 @@ void GDBBridge::HandleReadRegister(const GDBPacket& packet) {
 }
 
 void GDBBridge::HandleWriteRegister(const GDBPacket& packet) {
+  if (selected_trace_frame_) {
+    SendError(EROFS);
+    return;
+  }
+
   // P0=10270000
   auto index_value_split = packet.FindFirst('=');
   if (index_value_split == packet.Data().end()) {
@@ -636,6 +713,19 @@ void GDBBridge::HandleReadQuery(const GDBPacket& packet) {
     return;
   }
 
+  if (boost::algorithm::starts_with(query, "TP:")) {
+    HandleQueryTracepointStatus(query.substr(3));
+    return;
+  }
+
+  // Uploading tracepoint definitions, trace state variables, and static
+  // tracepoint markers is not supported, so report empty lists.
+  if (query == "TfP" || query == "TsP" || query == "TfV" || query == "TsV" ||
+      query == "TfSTM" || query == "TsSTM") {
+    gdb_->Send(GDBPacket("l"));
+    return;
+  }
+
   if (query == "C") {
     HandleQueryCurrentThreadID();
     return;
@@ -651,12 +741,66 @@ void GDBBridge::HandleReadQuery(const GDBPacket& packet) {
 }
 
 void GDBBridge::HandleWriteQuery(const GDBPacket& packet) {
-  if (packet.DataString() == "QStartNoAckMode") {
+  std::string query = packet.DataString();
+  if (query == "QStartNoAckMode") {
     gdb_->SetNoAckMode(true);
     SendOK();
     return;
   }
 
+  if (query == "QTinit") {
+    debugger_->ClearTracepoints();
+    selected_trace_frame_.reset();
+    SendOK();
+    return;
+  }
+
+  if (boost::algorithm::starts_with(query, "QTDP:-")) {
+    HandleDefineTracepointActions(query.substr(6));
+    return;
+  }
+
+  if (boost::algorithm::starts_with(query, "QTDP:")) {
+    HandleDefineTracepoint(query.substr(5));
+    return;
+  }
+
+  if (query == "QTStart") {
+    selected_trace_frame_.reset();
+    if (!debugger_->StartTracing()) {
+      SendError(EBUSY);
+      return;
+    }
+    SendOK();
+    return;
+  }
+
+  if (query == "QTStop") {
+    debugger_->StopTracing();
+    SendOK();
+    return;
+  }
+
+  if (boost::algorithm::starts_with(query, "QTFrame:")) {
+    HandleSelectTraceFrame(query.substr(8));
+    return;
+  }
+
+  if (boost::algorithm::starts_with(query, "QTBuffer:")) {
+    HandleTraceBuffer(query.substr(9));
+    return;
+  }
+
+  // Tracepoint source text, notes, and the disconnected tracing and read-only
+  // memory settings do not affect collection.
+  if (boost::algorithm::starts_with(query, "QTDPsrc:") ||
+      boost::algorithm::starts_with(query, "QTNotes:") ||
+      boost::algorithm::starts_with(query, "QTDisconnected:") ||
+      boost::algorithm::starts_with(query, "QTro")) {
+    SendOK();
+    return;
+  }
+
   LOG_GDB(error) << "Unsupported query write packet " << packet.DataString();
   SendEmpty();
 }
@@ -705,6 +849,11 @@ void GDBBridge::HandleExtendedVCommand(const GDBPacket& packet) {
 }
 
 void GDBBridge::HandleWriteMemoryBinary(const GDBPacket& packet) {
+  if (selected_trace_frame_) {
+    SendError(EROFS);
+    return;
+  }
+
   auto place_data_split = packet.FindFirst(':');
   auto address_length_split = packet.FindFirst(',');
 
@@ -778,6 +927,116 @@ static bool ExtractBreakpointCommandParams(
   return true;
 }
 
+//! Wraps an agent expression in an evaluator that stops the thread if the
+//! expression evaluates to a nonzero value.
+static XBDMDebugger::ConditionEvaluator MakeConditionEvaluator(
+    GDBAgentExpression expression) {
+  return [expression = std::move(expression)](
+             const ThreadContext& context, uint32_t,
+             const DebuggerExpressionParser::MemoryReader& memory_reader)
+             -> std::expected<bool, std::string> {
+    std::optional<ThreadContext> registers(context);
+    auto result = expression.Evaluate(
+        [&registers](uint32_t gdb_index) {
+          return GetRegister(gdb_index, registers, std::nullopt);
+        },
+        memory_reader);
+    if (!result.has_value()) {
+      return std::unexpected(result.error());
+    }
+    return *result != 0;
+  };
+}
+
+static TraceAction MakeCollectMemoryAction(int32_t base_register,
+                                           uint32_t offset, uint32_t length) {
+  return [base_register, offset, length](
+             const ThreadContext& context, uint32_t,
+             const DebuggerExpressionParser::MemoryReader& memory_reader,
+             TraceFrame& frame) -> std::expected<void, std::string> {
+    uint32_t address = offset;
+    if (base_register >= 0) {
+      auto value = GetRegister(base_register,
+                               std::optional<ThreadContext>(context),
+                               std::nullopt);
+      if (!value) {
+        return std::unexpected("Register " + std::to_string(base_register) +
+                               " is not available");
+      }
+      address += static_cast<uint32_t>(*value);
+    }
+
+    if (!length) {
+      return {};
+    }
+    auto data = memory_reader(address, length);
+    if (!data) {
+      return std::unexpected(data.error());
+    }
+    frame.AddMemory(address, std::move(*data));
+    return {};
+  };
+}
+
+static TraceAction MakeCollectExpressionAction(GDBAgentExpression expression) {
+  return [expression = std::move(expression)](
+             const ThreadContext& context, uint32_t,
+             const DebuggerExpressionParser::MemoryReader& memory_reader,
+             TraceFrame& frame) -> std::expected<void, std::string> {
+    std::optional<ThreadContext> registers(context);
+    auto result = expression.Evaluate(
+        [&registers](uint32_t gdb_index) {
+          return GetRegister(gdb_index, registers, std::nullopt);
+        },
+        memory_reader,
+        [&memory_reader, &frame](uint32_t address, uint32_t size)
+            -> std::expected<void, std::string> {
+          if (!size) {
+            return {};
+          }
+          auto data = memory_reader(address, size);
+          if (!data) {
+            return std::unexpected(data.error());
+          }
+          frame.AddMemory(address, std::move(*data));
+          return {};
+        });
+    if (!result.has_value()) {
+      return std::unexpected(result.error());
+    }
+    return {};
+  };
+}
+
+//! Compiles the agent expression conditions attached to a Z packet. Returns
+//! false if any condition is malformed.
+static bool ExtractBreakpointConditions(
+    const std::vector<std::vector<uint8_t>>& args,
+    std::vector<XBDMDebugger::ConditionEvaluator>& evaluators) {
+  for (auto& arg : args) {
+    std::string encoded(arg.begin(), arg.end());
+    if (encoded.empty()) {
+      continue;
+    }
+    if (encoded.front() != 'X') {
+      LOG_GDB(warning) << "Ignoring unsupported breakpoint parameter "
+                       << encoded;
+      continue;
+    }
+
+    auto expressions = GDBAgentExpression::ParseList(encoded);
+    if (!expressions) {
+      return false;
+    }
+
+    for (auto& expression : *expressions) {
+      evaluators.emplace_back(MakeConditionEvaluator(std::move(expression)));
+    }
+  }
+
+  return true;
+}
+
 void GDBBridge::HandleRemoveBreakpointType(const GDBPacket& packet) {
   int32_t type;
   uint32_t address;
@@ -797,6 +1056,8 @@ void GDBBridge::HandleRemoveBreakpointType(const GDBPacket& packet) {
                          << std::setfill('0') << address << "with kind "
                          << std::dec << int_arg;
       }
+      debugger_->SetBreakpointConditionEvaluators(
+          XBDMDebugger::BreakpointType::BREAKPOINT, address, {});
       debugger_->RemoveBreakpoint(address);
       SendOK();
       return;
@@ -842,15 +1103,29 @@ void GDBBridge::HandleInsertBreakpointType(const GDBPacket& packet) {
   }
 
   switch (type) {
-    case BP_SOFTWARE:
-      if (int_arg != 1 || !args.empty()) {
+    case BP_SOFTWARE: {
+      if (int_arg != 1) {
         LOG_GDB(warning) << "Partially supported insert swbreak " << std::hex
                          << std::setw(8) << std::setfill('0') << address
                          << "with kind " << std::dec << int_arg;
       }
+
+      // Conditions are evaluated by the debugger so that GDB is only notified
+      // when they are true. Reinserting a breakpoint replaces its conditions.
+      std::vector<XBDMDebugger::ConditionEvaluator> evaluators;
+      if (!ExtractBreakpointConditions(args, evaluators)) {
+        LOG_GDB(error) << "Invalid breakpoint condition "
+                       << packet.DataString();
+        SendError(EBADMSG);
+        return;
+      }
+      debugger_->SetBreakpointConditionEvaluators(
+          XBDMDebugger::BreakpointType::BREAKPOINT, address,
+          std::move(evaluators));
       debugger_->AddBreakpoint(address);
       SendOK();
       return;
+    }
 
     case BP_HARDWARE:
       SendEmpty();
@@ -1019,7 +1294,9 @@ void GDBBridge::HandleQuerySupported(const GDBPacket& packet) {
     boost::split(features, feature_str, boost::is_any_of(delim));
   }
 
-  std::string response = "PacketSize=4096;qXfer:features:read+;";
+  std::string response =
+      "PacketSize=4096;qXfer:features:read+;ConditionalBreakpoints+;"
+      "ConditionalTracepoints+;TracepointSource+;QTBuffer:size+;";
   for (auto& feature : features) {
     if (feature == "multiprocess+") {
       response += "multiprocess-;";
@@ -1171,7 +1448,9 @@ void GDBBridge::HandleQueryThreadExtraInfo(const GDBPacket& packet) {
 }
 
 void GDBBridge::HandleThreadInfoStart() {
-  if (!debugger_->FetchThreads()) {
+  // The thread table is maintained from notifications, so it only needs to be
+  // fetched if it has never been populated.
+  if (debugger_->Threads().empty() && !debugger_->FetchThreads()) {
     SendError(EFAULT);
     return;
   }
@@ -1214,7 +1493,300 @@ void GDBBridge::SendThreadInfoBuffer(bool send_all) {
   gdb_->Send(GDBPacket(send_buffer));
 }
 
-void GDBBridge::HandleQueryTraceStatus() { SendEmpty(); }
+void GDBBridge::HandleQueryTraceStatus() {
+  auto status = debugger_->GetTraceStatus();
+
+  const char* stop_reason = "tnotrun";
+  if (!status.running) {
+    switch (status.stop_reason) {
+      case XBDMDebugger::TraceStopReason::NOT_RUN:
+        break;
+      case XBDMDebugger::TraceStopReason::REQUESTED:
+        stop_reason = "tstop";
+        break;
+      case XBDMDebugger::TraceStopReason::PASS_COUNT:
+        stop_reason = "tpasscount";
+        break;
+      case XBDMDebugger::TraceStopReason::BUFFER_FULL:
+        stop_reason = "tfull";
+        break;
+      case XBDMDebugger::TraceStopReason::TARGET_REBOOTED:
+        // terror:<hex encoded "Target rebooted">
+        stop_reason = "terror:546172676574207265626f6f746564";
+        break;
+    }
+  }
+
+  auto buffer_free = status.buffer_size > status.buffer_used
+                         ? status.buffer_size - status.buffer_used
+                         : 0;
+  char buffer[256] = {0};
+  snprintf(buffer, sizeof(buffer),
+           "T%d;%s:%x;tframes:%zx;tcreated:%zx;tfree:%zx;tsize:%zx;"
+           "circular:0;disconn:0",
+           status.running ? 1 : 0, stop_reason, status.stop_tracepoint,
+           status.frames, status.frames, buffer_free, status.buffer_size);
+  gdb_->Send(GDBPacket(buffer));
+}
+
+void GDBBridge::HandleQueryTracepointStatus(const std::string& args) {
+  // qTP:<number>:<address>
+  uint32_t number;
+  if (!MaybeParseHexInt(number, args)) {
+    LOG_GDB(error) << "Invalid tracepoint status query: " << args;
+    SendError(EBADMSG);
+    return;
+  }
+
+  auto tracepoint = debugger_->GetTracepoint(number);
+  if (!tracepoint) {
+    SendError(ENOENT);
+    return;
+  }
+
+  char buffer[64] = {0};
+  snprintf(buffer, sizeof(buffer), "V%llx:%llx",
+           static_cast<unsigned long long>(tracepoint->hits),
+           static_cast<unsigned long long>(tracepoint->buffer_used));
+  gdb_->Send(GDBPacket(buffer));
+}
+
+void GDBBridge::HandleDefineTracepoint(const std::string& args) {
+  // QTDP:<number>:<address>:<E|D>:<step>:<pass>[:F<len>][:X<len>,<expr>][-]
+  std::string definition = args;
+  if (!definition.empty() && definition.back() == '-') {
+    definition.pop_back();
+  }
+  std::vector<std::string> fields;
+  boost::split(fields, definition, boost::is_any_of(":"));
+
+  XBDMDebugger::Tracepoint tracepoint;
+  uint64_t step_count;
+  if (fields.size() < 5 || !MaybeParseHexInt(tracepoint.number, fields[0]) ||
+      !MaybeParseHexInt(tracepoint.address, fields[1]) ||
+      !MaybeParseHexInt(step_count, fields[3]) ||
+      !MaybeParseHexInt(tracepoint.pass_count, fields[4])) {
+    LOG_GDB(error) << "Invalid tracepoint definition: " << args;
+    SendError(EBADMSG);
+    return;
+  }
+  tracepoint.enabled = fields[2] == "E";
+  if (step_count) {
+    LOG_GDB(warning) << "Ignoring unsupported while-stepping count for "
+                        "tracepoint "
+                     << tracepoint.number;
+  }
+
+  for (auto field = fields.begin() + 5; field != fields.end(); ++field) {
+    if (field->empty()) {
+      continue;
+    }
+    if (field->front() == 'X') {
+      auto expression = GDBAgentExpression::Parse(*field);
+      if (!expression) {
+        LOG_GDB(error) << "Invalid tracepoint condition: " << *field;
+        SendError(EBADMSG);
+        return;
+      }
+      tracepoint.conditions.emplace_back(
+          MakeConditionEvaluator(std::move(*expression)));
+      continue;
+    }
+
+    // Fast and static tracepoints are handled as regular tracepoints.
+    LOG_GDB(warning) << "Ignoring unsupported tracepoint parameter " << *field;
+  }
+
+  debugger_->SetTracepoint(std::move(tracepoint));
+  SendOK();
+}
+
+void GDBBridge::HandleDefineTracepointActions(const std::string& args) {
+  // QTDP:-<number>:<address>:[S]<actions>[-]
+  auto number_end = args.find(':');
+  auto address_end = number_end == std::string::npos
+                         ? std::string::npos
+                         : args.find(':', number_end + 1);
+  uint32_t number;
+  if (address_end == std::string::npos ||
+      !MaybeParseHexInt(number, args.substr(0, number_end))) {
+    LOG_GDB(error) << "Invalid tracepoint actions: " << args;
+    SendError(EBADMSG);
+    return;
+  }
+
+  auto tracepoint = debugger_->GetTracepoint(number);
+  if (!tracepoint) {
+    LOG_GDB(error) << "Actions for unknown tracepoint " << number;
+    SendError(ENOENT);
+    return;
+  }
+
+  std::string actions = args.substr(address_end + 1);
+  if (!actions.empty() && actions.back() == '-') {
+    actions.pop_back();
+  }
+  if (!actions.empty() && actions.front() == 'S') {
+    LOG_GDB(warning) << "Ignoring unsupported while-stepping actions for "
+                        "tracepoint "
+                     << number;
+    SendOK();
+    return;
+  }
+
+  size_t offset = 0;
+  while (offset < actions.size()) {
+    size_t action_start = offset;
+    char type = actions[offset];
+    char* end = nullptr;
+    const char* start = actions.c_str();
+
+    if (type == 'R') {
+      // The register mask is ignored and all registers are collected.
+      strtoull(start + offset + 1, &end, 16);
+      offset = end - start;
+      tracepoint->actions.emplace_back(trace_actions::CollectRegisters());
+    } else if (type == 'M') {
+      // M<base register>,<offset>,<length>, where a base register of -1
+      // indicates an absolute address.
+      auto base_register =
+          static_cast<int32_t>(strtoll(start + offset + 1, &end, 16));
+      if (*end != ',') {
+        break;
+      }
+      auto address = static_cast<uint32_t>(strtoull(end + 1, &end, 16));
+      if (*end != ',') {
+        break;
+      }
+      auto length = static_cast<uint32_t>(strtoull(end + 1, &end, 16));
+      offset = end - start;
+      tracepoint->actions.emplace_back(
+          MakeCollectMemoryAction(base_register, address, length));
+    } else if (type == 'X') {
+      auto expression = GDBAgentExpression::Parse(actions, offset);
+      if (!expression) {
+        break;
+      }
+      tracepoint->actions.emplace_back(
+          MakeCollectExpressionAction(std::move(*expression)));
+    } else {
+      break;
+    }
+
+    tracepoint->action_descriptions.emplace_back(
+        actions.substr(action_start, offset - action_start));
+  }
+
+  if (offset != actions.size()) {
+    LOG_GDB(error) << "Invalid tracepoint action: " << actions.substr(offset);
+    SendError(EBADMSG);
+    return;
+  }
+
+  debugger_->SetTracepoint(std::move(*tracepoint));
+  SendOK();
+}
+
+void GDBBridge::HandleSelectTraceFrame(const std::string& args) {
+  auto status = debugger_->GetTraceStatus();
+
+  // Searches begin after the currently selected frame.
+  size_t first_frame = selected_trace_frame_ ? *selected_trace_frame_ + 1 : 0;
+  std::function<bool(const TraceFrame&)> matches;
+
+  std::vector<std::string> fields;
+  boost::split(fields, args, boost::is_any_of(":"));
+  if (fields.size() == 2 && fields[0] == "pc") {
+    uint32_t pc;
+    if (MaybeParseHexInt(pc, fields[1])) {
+      matches = [pc](const TraceFrame& frame) { return frame.address == pc; };
+    }
+  } else if (fields.size() == 2 && fields[0] == "tdp") {
+    uint32_t number;
+    if (MaybeParseHexInt(number, fields[1])) {
+      matches = [number](const TraceFrame& frame) {
+        return frame.tracepoint == number;
+      };
+    }
+  } else if (fields.size() == 3 &&
+             (fields[0] == "range" || fields[0] == "outside")) {
+    uint32_t start;
+    uint32_t end;
+    if (MaybeParseHexInt(start, fields[1]) &&
+        MaybeParseHexInt(end, fields[2])) {
+      bool inside = fields[0] == "range";
+      matches = [start, end, inside](const TraceFrame& frame) {
+        return (frame.address >= start && frame.address <= end) == inside;
+      };
+    }
+  } else if (fields.size() == 1) {
+    int32_t index;
+    if (MaybeParseHexInt(index, fields[0])) {
+      if (index < 0) {
+        selected_trace_frame_.reset();
+        SendOK();
+        return;
+      }
+      first_frame = index;
+      matches = [](const TraceFrame&) { return true; };
+    }
+  }
+
+  if (!matches) {
+    LOG_GDB(error) << "Invalid trace frame selection: " << args;
+    SendError(EBADMSG);
+    return;
+  }
+
+  for (size_t index = first_frame; index < status.frames; ++index) {
+    auto frame = debugger_->GetTraceFrame(index);
+    if (!frame) {
+      break;
+    }
+    if (!matches(*frame)) {
+      continue;
+    }
+
+    selected_trace_frame_ = index;
+    char buffer[64] = {0};
+    snprintf(buffer, sizeof(buffer), "F%zxT%x", index, frame->tracepoint);
+    gdb_->Send(GDBPacket(buffer));
+    return;
+  }
+
+  selected_trace_frame_.reset();
+  gdb_->Send(GDBPacket("F-1"));
+}
+
+void GDBBridge::HandleTraceBuffer(const std::string& args) {
+  if (args == "circular:0") {
+    SendOK();
+    return;
+  }
+
+  if (boost::algorithm::starts_with(args, "size:")) {
+    int64_t size;
+    if (!MaybeParseHexInt(size, args.substr(5))) {
+      SendError(EBADMSG);
+      return;
+    }
+    debugger_->SetTraceBufferSize(size < 0
+                                      ? XBDMDebugger::kDefaultTraceBufferSize
+                                      : static_cast<size_t>(size));
+    SendOK();
+    return;
+  }
+
+  LOG_GDB(error) << "Unsupported trace buffer setting " << args;
+  SendError(EINVAL);
+}
+
+std::optional<TraceFrame> GDBBridge::SelectedTraceFrame() const {
+  if (!selected_trace_frame_) {
+    return std::nullopt;
+  }
+  return debugger_->GetTraceFrame(*selected_trace_frame_);
+}
 
 void GDBBridge::HandleQueryCurrentThreadID() {
   auto maybe_id = debugger_->AnyThreadID();
@@ -1312,7 +1884,8 @@ void GDBBridge::HandleFeaturesRead(const GDBPacket& packet) {
 void GDBBridge::HandleVContQuery() {
   // c - continue
   // s - step
-  gdb_->Send(GDBPacket("vCont;c;C;s;S"));
+  // r - step while within a range
+  gdb_->Send(GDBPacket("vCont;c;C;s;S;r"));
 }
 
 void GDBBridge::HandleVCont(const std::string& args) {
@@ -1358,14 +1931,13 @@ void GDBBridge::HandleVCont(const std::string& args) {
         continue;
       }
 
-      for (auto& thread : debugger_->Threads()) {
-        if (processed_threads.find(thread->thread_id) !=
-            processed_threads.end()) {
+      for (auto& [id, thread] : debugger_->Threads()) {
+        if (processed_threads.find(id) != processed_threads.end()) {
           continue;
         }
 
-        if (!debugger_->ContinueThread(thread_id)) {
-          LOG_GDB(warning) << "Failed to continue thread " << thread_id << " "
+        if (!debugger_->ContinueThread(id)) {
+          LOG_GDB(warning) << "Failed to continue thread " << id << " "
                            << command;
         }
       }
@@ -1390,6 +1962,31 @@ void GDBBridge::HandleVCont(const std::string& args) {
       continue;
     }
 
+    if (command_code == 'r') {
+      std::vector<std::string> range;
+      boost::split(range, command_params[0].substr(1), boost::is_any_of(","));
+      uint32_t start;
+      uint32_t end;
+      if (range.size() != 2 || !MaybeParseHexInt(start, range[0]) ||
+          !MaybeParseHexInt(end, range[1])) {
+        LOG_GDB(error) << "Failed to parse vCont range " << command;
+        SendError(EBADMSG);
+        continue;
+      }
+
+      if (thread_id > 0) {
+        debugger_->SetActiveThread(thread_id);
+      }
+
+      // Intermediate steps are handled entirely by the debugger so that GDB
+      // only receives a stop packet once the thread has left the range.
+      if (!debugger_->StepRange(start, end)) {
+        SendError(EFAULT);
+        continue;
+      }
+      continue;
+    }
+
     LOG_GDB(error) << "TODO: Implement vCont subcommand " << command;
     SendEmpty();
   }
@@ -1410,6 +2007,13 @@ void GDBBridge::MarkWaitingForStopPacket() {
   }
 }
 
+bool GDBBridge::ConsumeStopEvent() {
+  auto count = debugger_->StopEventCount();
+  bool ret = count != last_stop_event_count_;
+  last_stop_event_count_ = count;
+  return ret;
+}
+
 void GDBBridge::OnNotification(
     const std::shared_ptr<XBDMNotification>& notification) {
   switch (notification->Type()) {
@@ -1492,7 +2096,9 @@ void GDBBridge::OnExecutionStateChanged(
 
 void GDBBridge::OnBreakpoint(
     const std::shared_ptr<NotificationBreakpoint>& msg) {
-  if (!waiting_on_stop_packet_) {
+  // The debugger resumes threads that hit tracepoints or breakpoints whose
+  // conditions are false.
+  if (!ConsumeStopEvent() || !waiting_on_stop_packet_) {
     return;
   }
 
@@ -1501,7 +2107,7 @@ void GDBBridge::OnBreakpoint(
 
 void GDBBridge::OnWatchpoint(
     const std::shared_ptr<NotificationWatchpoint>& msg) {
-  if (!waiting_on_stop_packet_) {
+  if (!ConsumeStopEvent() || !waiting_on_stop_packet_) {
     return;
   }
   SendThreadStopPacket(debugger_->ActiveThread());
@@ -1510,6 +2116,7 @@ void GDBBridge::OnWatchpoint(
 void GDBBridge::OnSingleStep(
     const std::shared_ptr<NotificationSingleStep>& msg) {
   LOG_GDB(warning) << "SingleStep: " << *msg;
+  ConsumeStopEvent();
   if (!waiting_on_stop_packet_) {
     return;
   }
@@ -1518,6 +2125,7 @@ void GDBBridge::OnSingleStep(
 
 void GDBBridge::OnException(const std::shared_ptr<NotificationException>& msg) {
   LOG_GDB(warning) << "Received exception: " << *msg;
+  ConsumeStopEvent();
   if (!waiting_on_stop_packet_) {
     return;
   }
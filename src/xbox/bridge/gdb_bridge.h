@@ -5,6 +5,8 @@
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <optional>
+#include <string>
 #include <vector>
 
 class GDBPacket;
@@ -15,6 +17,7 @@ class NotificationWatchpoint;
 class NotificationSingleStep;
 class NotificationException;
 class Thread;
+struct TraceFrame;
 class XBDMContext;
 class XBDMDebugger;
 class XBDMNotification;
@@ -33,7 +36,9 @@ class GDBBridge {
  public:
   explicit GDBBridge(std::shared_ptr<XBDMContext> xbdm_context,
                      std::shared_ptr<XBDMDebugger> debugger);
+  ~GDBBridge();
 
+  //! Disconnects the GDB client and stops handling notifications.
   void Stop();
 
   bool HandlePacket(const GDBPacket& packet);
@@ -92,6 +97,13 @@ class GDBBridge {
   void HandleThreadInfoContinue();
   void SendThreadInfoBuffer(bool send_all = true);
   void HandleQueryTraceStatus();
+  void HandleQueryTracepointStatus(const std::string& args);
+  void HandleDefineTracepoint(const std::string& args);
+  void HandleDefineTracepointActions(const std::string& args);
+  void HandleSelectTraceFrame(const std::string& args);
+  void HandleTraceBuffer(const std::string& args);
+  //! Returns the trace frame selected by QTFrame, if any.
+  [[nodiscard]] std::optional<TraceFrame> SelectedTraceFrame() const;
   void HandleQueryCurrentThreadID();
   void HandleFeaturesRead(const GDBPacket& packet);
 
@@ -107,6 +119,9 @@ class GDBBridge {
   void OnException(const std::shared_ptr<NotificationException>&);
 
   void MarkWaitingForStopPacket();
+  //! Returns true if the debugger reported a stop since the last call, false
+  //! if it resumed the thread instead (e.g., for a tracepoint).
+  bool ConsumeStopEvent();
 
  private:
   std::shared_ptr<GDBTransport> gdb_;
@@ -121,6 +136,11 @@ class GDBBridge {
 
   bool send_thread_events_{false};
   std::atomic<bool> waiting_on_stop_packet_{false};
+  //! The debugger's StopEventCount as of the last stop notification.
+  uint64_t last_stop_event_count_{0};
+
+  //! The index of the trace frame selected by QTFrame.
+  std::optional<size_t> selected_trace_frame_;
 };
 
 #endif  // XBDM_GDB_BRIDGE_GDB_BRIDGE_H
@@ -5,6 +5,8 @@
 #include <cctype>
 #include <cmath>
 
+#include "symbol_index.h"
+
 Token DebuggerExpressionParser::Peek() const {
   if (pos_ >= tokens_.size()) {
     return {TokenType::END_OF_FILE, ""};
@@ -150,23 +152,35 @@ std::expected<void, std::string> DebuggerExpressionParser::Tokenize(
       continue;
     }
 
-    // Identifier (E.g., tid, AND, OR)
-    if (std::isalpha(c)) {
+    // Quoted symbol name, allowing decorated names such as `?Func@@YAXXZ`
+    if (c == '`') {
+      auto end = expr.find('`', i + 1);
+      if (end == std::string::npos || end == i + 1) {
+        return std::unexpected("Unterminated symbol name at position " +
+                               std::to_string(start));
+      }
+      tokens_.push_back(
+          {TokenType::SYMBOL, expr.substr(i + 1, end - i - 1), 0, start});
+      i = end + 1;
+      continue;
+    }
+
+    // Identifier (E.g., tid, AND, OR) or symbol name
+    if (std::isalpha(c) || c == '_') {
       std::string literal;
-      while (i < expr.length() && std::isalpha(expr[i])) {
+      while (i < expr.length() && (std::isalnum(expr[i]) || expr[i] == '_')) {
         literal += expr[i++];
       }
-      boost::algorithm::to_lower(literal);
-
-      if (literal == "tid") {
-        tokens_.push_back({TokenType::IDENTIFIER, literal, 0, start});
-      } else if (literal == "and") {
-        tokens_.push_back({TokenType::AND, literal, 0, start});
-      } else if (literal == "or") {
-        tokens_.push_back({TokenType::OR, literal, 0, start});
+      auto keyword = boost::algorithm::to_lower_copy(literal);
+
+      if (keyword == "tid") {
+        tokens_.push_back({TokenType::IDENTIFIER, keyword, 0, start});
+      } else if (keyword == "and") {
+        tokens_.push_back({TokenType::AND, keyword, 0, start});
+      } else if (keyword == "or") {
+        tokens_.push_back({TokenType::OR, keyword, 0, start});
       } else {
-        return std::unexpected("Unexpected character at position " +
-                               std::to_string(start));
+        tokens_.push_back({TokenType::SYMBOL, literal, 0, start});
       }
       continue;
     }
@@ -330,6 +344,17 @@ std::expected<uint32_t, std::string> DebuggerExpressionParser::ParsePrefix(
     case TokenType::REGISTER:
       return ResolveRegisterValue(token.literal);
 
+    case TokenType::SYMBOL: {
+      if (!symbols_) {
+        return std::unexpected("Unknown identifier: " + token.literal);
+      }
+      auto address = symbols_->FindAddress(token.literal);
+      if (!address) {
+        return std::unexpected("Unknown symbol: " + token.literal);
+      }
+      return *address;
+    }
+
     case TokenType::LPAREN: {
       auto exp = ParseExpression(Precedence::LOWEST);
       if (!exp) {
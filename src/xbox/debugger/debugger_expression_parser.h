@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <expected>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <string>
 #include <vector>
@@ -11,6 +12,8 @@
 #include "rdcp/types/thread_context.h"
 #include "util/parsing.h"
 
+class SymbolIndex;
+
 enum class Precedence {
   LOWEST = 1,
   LOGICAL_OR,   // ||, OR
@@ -30,6 +33,7 @@ enum class TokenType {
   IDENTIFIER,  // tid
   INT,         // 123, 0x123
   REGISTER,    // $eax
+  SYMBOL,      // _main, `?Func@@YAXXZ`
 
   // Operators
   PLUS,      // +
@@ -81,10 +85,16 @@ class DebuggerExpressionParser : public ExpressionParser {
 
   std::expected<uint32_t, std::string> Parse(const std::string& expr) override;
 
+  //! Sets the index used to resolve symbol names to addresses.
+  void SetSymbolIndex(std::shared_ptr<const SymbolIndex> symbols) {
+    symbols_ = std::move(symbols);
+  }
+
  protected:
   ThreadContext context_;
   std::optional<uint32_t> thread_id_;
   MemoryReader memory_reader_;
+  std::shared_ptr<const SymbolIndex> symbols_;
 
  private:
   std::vector<Token> tokens_;
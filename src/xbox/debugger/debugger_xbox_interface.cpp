@@ -18,6 +18,7 @@ struct ContextAwareExpressionParser : DebuggerExpressionParser {
 
   std::expected<uint32_t, std::string> Parse(const std::string& expr) override {
     if (debugger_) {
+      symbols_ = debugger_->Symbols();
       auto active_thread = debugger_->ActiveThread();
       if (active_thread) {
         auto& context = active_thread->context;
@@ -40,6 +41,7 @@ struct ContextAwareExpressionParser : DebuggerExpressionParser {
 bool DebuggerXBOXInterface::AttachDebugger() {
   if (!xbdm_debugger_) {
     xbdm_debugger_ = std::make_shared<XBDMDebugger>(xbdm_context_);
+    xbdm_debugger_->SetSymbolIndex(symbols_);
     SetExpressionParser(
         std::make_shared<ContextAwareExpressionParser>(xbdm_debugger_));
   }
@@ -58,6 +60,14 @@ void DebuggerXBOXInterface::DetachDebugger() {
   SetExpressionParser(std::make_shared<DebuggerExpressionParser>());
 }
 
+void DebuggerXBOXInterface::SetSymbolIndex(
+    std::shared_ptr<const SymbolIndex> symbols) {
+  symbols_ = std::move(symbols);
+  if (xbdm_debugger_) {
+    xbdm_debugger_->SetSymbolIndex(symbols_);
+  }
+}
+
 void DebuggerXBOXInterface::AttachDebugNotificationHandler() {
   if (debug_notification_handler_id_ > 0) {
     return;
@@ -13,6 +13,7 @@
 class DelegatingServer;
 class RDCPProcessedRequest;
 class SelectThread;
+class SymbolIndex;
 class XBDMContext;
 class XBDMDebugger;
 
@@ -39,8 +40,16 @@ class DebuggerXBOXInterface : public XBOXInterface {
   void AttachDebugNotificationHandler();
   void DetachDebugNotificationHandler();
 
+  //! Sets the symbols used by the debugger. The index is retained across
+  //! debugger attach/detach.
+  void SetSymbolIndex(std::shared_ptr<const SymbolIndex> symbols);
+  [[nodiscard]] std::shared_ptr<const SymbolIndex> Symbols() const {
+    return symbols_;
+  }
+
  protected:
   std::shared_ptr<XBDMDebugger> xbdm_debugger_;
+  std::shared_ptr<const SymbolIndex> symbols_;
 
   int debug_notification_handler_id_{0};
 };
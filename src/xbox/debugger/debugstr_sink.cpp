@@ -0,0 +1,268 @@
+#include "debugstr_sink.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+std::unique_ptr<DebugStrLogFile> DebugStrLogFile::Open(
+    const std::filesystem::path& path, size_t buffer_bytes,
+    uint32_t flush_milliseconds) {
+  FILE* file = fopen(path.c_str(), "ab");
+  if (!file) {
+    return nullptr;
+  }
+
+  return std::unique_ptr<DebugStrLogFile>(
+      new DebugStrLogFile(file, buffer_bytes, flush_milliseconds));
+}
+
+DebugStrLogFile::DebugStrLogFile(FILE* file, size_t buffer_bytes,
+                                 uint32_t flush_milliseconds)
+    : file_(file),
+      buffer_(std::bit_ceil(std::max<size_t>(buffer_bytes, 256))),
+      mask_(buffer_.size() - 1),
+      flush_interval_(std::max<uint32_t>(flush_milliseconds, 1)) {
+  writer_thread_ = std::thread([this]() { WriterThreadMain(); });
+}
+
+DebugStrLogFile::~DebugStrLogFile() {
+  {
+    const std::lock_guard lock(wake_lock_);
+    stopping_ = true;
+  }
+  wake_condition_.notify_all();
+  writer_thread_.join();
+  fclose(file_);
+}
+
+bool DebugStrLogFile::Append(std::string_view line) {
+  auto len = line.size() + 1;
+  auto head = head_.load(std::memory_order_relaxed);
+  auto tail = tail_.load(std::memory_order_acquire);
+  auto used = head - tail;
+  if (buffer_.size() - used < len) {
+    ++dropped_lines_;
+    return false;
+  }
+
+  auto offset = head & mask_;
+  auto first_chunk = std::min(line.size(), buffer_.size() - offset);
+  memcpy(buffer_.data() + offset, line.data(), first_chunk);
+  memcpy(buffer_.data(), line.data() + first_chunk, line.size() - first_chunk);
+  buffer_[(head + line.size()) & mask_] = '\n';
+  head_.store(head + len, std::memory_order_release);
+
+  // Wake the writer early if the ring is filling up rather than waiting for
+  // the next periodic flush.
+  if (used + len > buffer_.size() / 2) {
+    wake_condition_.notify_one();
+  }
+  return true;
+}
+
+void DebugStrLogFile::WriterThreadMain() {
+  std::unique_lock lock(wake_lock_);
+  while (!stopping_) {
+    wake_condition_.wait_for(lock, flush_interval_);
+    lock.unlock();
+    Drain();
+    lock.lock();
+  }
+  lock.unlock();
+  Drain();
+}
+
+void DebugStrLogFile::Drain() {
+  auto head = head_.load(std::memory_order_acquire);
+  auto tail = tail_.load(std::memory_order_relaxed);
+  if (head == tail) {
+    return;
+  }
+
+  while (tail != head) {
+    auto offset = tail & mask_;
+    auto chunk = std::min(head - tail, buffer_.size() - offset);
+    fwrite(buffer_.data() + offset, 1, chunk, file_);
+    tail += chunk;
+  }
+  fflush(file_);
+  tail_.store(tail, std::memory_order_release);
+}
+
+DebugStrSink::DebugStrSink(LineHandler on_line,
+                           SuppressedHandler on_suppressed)
+    : on_line_(std::move(on_line)),
+      on_suppressed_(std::move(on_suppressed)),
+      last_refill_(std::chrono::steady_clock::now()) {
+  summary_thread_ = std::thread([this]() { SummaryThreadMain(); });
+}
+
+DebugStrSink::~DebugStrSink() {
+  {
+    const std::lock_guard lock(lock_);
+    stopping_ = true;
+  }
+  summary_condition_.notify_all();
+  summary_thread_.join();
+}
+
+void DebugStrSink::Write(int thread_id, std::string_view text,
+                         bool is_terminated) {
+  const std::lock_guard lock(lock_);
+
+  auto existing = partial_lines_.find(thread_id);
+  if (existing == partial_lines_.end()) {
+    if (is_terminated) {
+      EmitLine(thread_id, std::string(text));
+      return;
+    }
+    existing = partial_lines_.emplace(thread_id, std::string()).first;
+  }
+
+  existing->second.append(text);
+  if (is_terminated || existing->second.size() > kMaxPartialLineBytes) {
+    EmitLine(thread_id, existing->second);
+    partial_lines_.erase(existing);
+  }
+}
+
+void DebugStrSink::Flush() {
+  const std::lock_guard lock(lock_);
+  for (auto& entry : partial_lines_) {
+    EmitLine(entry.first, entry.second);
+  }
+  partial_lines_.clear();
+  FlushSuppressed();
+}
+
+void DebugStrSink::SetMaxLinesPerSecond(uint32_t max_lines_per_second) {
+  const std::lock_guard lock(lock_);
+  max_lines_per_second_ = max_lines_per_second;
+  display_tokens_ = max_lines_per_second;
+  last_refill_ = std::chrono::steady_clock::now();
+  summary_condition_.notify_all();
+}
+
+uint32_t DebugStrSink::MaxLinesPerSecond() const {
+  const std::lock_guard lock(lock_);
+  return max_lines_per_second_;
+}
+
+bool DebugStrSink::OpenLogFile(const std::filesystem::path& path,
+                               size_t buffer_bytes,
+                               uint32_t flush_milliseconds) {
+  auto log_file = DebugStrLogFile::Open(path, buffer_bytes, flush_milliseconds);
+  if (!log_file) {
+    return false;
+  }
+
+  std::unique_ptr<DebugStrLogFile> previous;
+  {
+    const std::lock_guard lock(lock_);
+    previous = std::move(log_file_);
+    if (previous) {
+      log_dropped_before_reopen_ += previous->DroppedLines();
+    }
+    log_file_ = std::move(log_file);
+  }
+  return true;
+}
+
+void DebugStrSink::CloseLogFile() {
+  std::unique_ptr<DebugStrLogFile> previous;
+  {
+    const std::lock_guard lock(lock_);
+    previous = std::move(log_file_);
+    if (previous) {
+      log_dropped_before_reopen_ += previous->DroppedLines();
+    }
+  }
+}
+
+DebugStrSink::Stats DebugStrSink::GetStats() const {
+  const std::lock_guard lock(lock_);
+  auto ret = stats_;
+  ret.log_dropped_lines = log_dropped_before_reopen_;
+  if (log_file_) {
+    ret.log_dropped_lines += log_file_->DroppedLines();
+  }
+  return ret;
+}
+
+void DebugStrSink::EmitLine(int thread_id, const std::string& line) {
+  ++stats_.lines;
+  if (log_file_ && log_file_->Append(line)) {
+    ++stats_.logged_lines;
+  }
+
+  if (!ConsumeDisplayToken()) {
+    ++stats_.suppressed_lines;
+    if (!pending_suppressed_++) {
+      summary_condition_.notify_all();
+    }
+    return;
+  }
+
+  FlushSuppressed();
+  ++stats_.displayed_lines;
+  if (on_line_) {
+    on_line_(thread_id, line);
+  }
+}
+
+void DebugStrSink::RefillDisplayTokens() {
+  auto now = std::chrono::steady_clock::now();
+  std::chrono::duration<double> elapsed = now - last_refill_;
+  last_refill_ = now;
+  display_tokens_ =
+      std::min(static_cast<double>(max_lines_per_second_),
+               display_tokens_ + elapsed.count() * max_lines_per_second_);
+}
+
+bool DebugStrSink::ConsumeDisplayToken() {
+  if (!max_lines_per_second_) {
+    return true;
+  }
+
+  RefillDisplayTokens();
+  if (display_tokens_ < 1.0) {
+    return false;
+  }
+
+  display_tokens_ -= 1.0;
+  return true;
+}
+
+void DebugStrSink::FlushSuppressed() {
+  if (!pending_suppressed_) {
+    return;
+  }
+
+  auto suppressed = pending_suppressed_;
+  pending_suppressed_ = 0;
+  if (on_suppressed_) {
+    on_suppressed_(suppressed);
+  }
+}
+
+void DebugStrSink::SummaryThreadMain() {
+  std::unique_lock lock(lock_);
+  while (!stopping_) {
+    if (!pending_suppressed_) {
+      summary_condition_.wait(lock);
+      continue;
+    }
+
+    if (max_lines_per_second_) {
+      RefillDisplayTokens();
+      if (display_tokens_ < 1.0) {
+        std::chrono::duration<double> until_refilled(
+            (1.0 - display_tokens_) / max_lines_per_second_);
+        summary_condition_.wait_for(lock, until_refilled);
+        continue;
+      }
+    }
+
+    FlushSuppressed();
+  }
+}
@@ -0,0 +1,151 @@
+#ifndef XBDM_GDB_BRIDGE_SRC_XBOX_DEBUGGER_DEBUGSTR_SINK_H_
+#define XBDM_GDB_BRIDGE_SRC_XBOX_DEBUGGER_DEBUGSTR_SINK_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+//! Records debugstr lines to a file without blocking the caller.
+//!
+//! Lines are copied into a single producer, single consumer byte ring that is
+//! drained to the file by a background thread. Lines that do not fit in the
+//! ring are dropped and counted.
+class DebugStrLogFile {
+ public:
+  //! Returns nullptr if the file cannot be opened.
+  static std::unique_ptr<DebugStrLogFile> Open(
+      const std::filesystem::path& path, size_t buffer_bytes,
+      uint32_t flush_milliseconds);
+
+  //! Writes any buffered lines and closes the file.
+  ~DebugStrLogFile();
+
+  //! Queues `line` followed by a newline. Must only be called from one thread
+  //! at a time.
+  bool Append(std::string_view line);
+
+  [[nodiscard]] uint64_t DroppedLines() const { return dropped_lines_; }
+
+ private:
+  DebugStrLogFile(FILE* file, size_t buffer_bytes,
+                  uint32_t flush_milliseconds);
+
+  void WriterThreadMain();
+  void Drain();
+
+ private:
+  FILE* file_;
+  std::vector<char> buffer_;
+  size_t mask_;
+  std::chrono::milliseconds flush_interval_;
+
+  //! Total bytes ever written by the producer and consumed by the writer.
+  //! Positions in `buffer_` are obtained by masking.
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+  std::atomic<uint64_t> dropped_lines_{0};
+
+  std::mutex wake_lock_;
+  std::condition_variable wake_condition_;
+  bool stopping_{false};
+  std::thread writer_thread_;
+};
+
+//! Coalesces debugstr fragments into complete lines per thread and rate limits
+//! the lines that are displayed, so that a title that logs heavily does not
+//! stall notification handling on the console or log sink.
+//!
+//! Every completed line may also be recorded, unthrottled, to a
+//! DebugStrLogFile.
+class DebugStrSink {
+ public:
+  //! Invoked with each complete line that is to be displayed. Handlers are
+  //! called with the sink's lock held and must not call back into it.
+  typedef std::function<void(int thread_id, const std::string& line)>
+      LineHandler;
+  //! Invoked with the number of lines that were suppressed by the rate limit
+  //! once it allows lines to be displayed again, or on Flush. This may be
+  //! called from the sink's own thread.
+  typedef std::function<void(uint64_t suppressed_lines)> SuppressedHandler;
+
+  static constexpr uint32_t kDefaultMaxLinesPerSecond = 100;
+  static constexpr size_t kDefaultLogBufferBytes = 1024 * 1024;
+  static constexpr uint32_t kDefaultLogFlushMilliseconds = 250;
+
+  //! Partial lines longer than this are emitted as if they were terminated.
+  static constexpr size_t kMaxPartialLineBytes = 16 * 1024;
+
+  struct Stats {
+    uint64_t lines{0};
+    uint64_t displayed_lines{0};
+    uint64_t suppressed_lines{0};
+    uint64_t logged_lines{0};
+    uint64_t log_dropped_lines{0};
+  };
+
+  DebugStrSink(LineHandler on_line, SuppressedHandler on_suppressed);
+  ~DebugStrSink();
+
+  //! Appends a fragment of debug output from the given thread.
+  void Write(int thread_id, std::string_view text, bool is_terminated);
+
+  //! Emits any partial lines and the pending suppression summary.
+  void Flush();
+
+  //! Sets the maximum number of lines displayed per second. 0 disables rate
+  //! limiting.
+  void SetMaxLinesPerSecond(uint32_t max_lines_per_second);
+  [[nodiscard]] uint32_t MaxLinesPerSecond() const;
+
+  //! Records all subsequent lines to the given file, replacing any existing
+  //! log file.
+  bool OpenLogFile(const std::filesystem::path& path,
+                   size_t buffer_bytes = kDefaultLogBufferBytes,
+                   uint32_t flush_milliseconds = kDefaultLogFlushMilliseconds);
+  void CloseLogFile();
+
+  [[nodiscard]] Stats GetStats() const;
+
+ private:
+  void EmitLine(int thread_id, const std::string& line);
+  void RefillDisplayTokens();
+  bool ConsumeDisplayToken();
+  void FlushSuppressed();
+  //! Emits the suppression summary as soon as the rate limit refills, rather
+  //! than waiting for another line to be displayed.
+  void SummaryThreadMain();
+
+ private:
+  LineHandler on_line_;
+  SuppressedHandler on_suppressed_;
+
+  mutable std::mutex lock_;
+  std::map<int, std::string> partial_lines_;
+
+  uint32_t max_lines_per_second_{kDefaultMaxLinesPerSecond};
+  double display_tokens_{kDefaultMaxLinesPerSecond};
+  std::chrono::steady_clock::time_point last_refill_;
+  uint64_t pending_suppressed_{0};
+
+  std::condition_variable summary_condition_;
+  bool stopping_{false};
+  std::thread summary_thread_;
+
+  std::unique_ptr<DebugStrLogFile> log_file_;
+  uint64_t log_dropped_before_reopen_{0};
+
+  Stats stats_;
+};
+
+#endif  // XBDM_GDB_BRIDGE_SRC_XBOX_DEBUGGER_DEBUGSTR_SINK_H_
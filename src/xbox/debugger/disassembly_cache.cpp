@@ -0,0 +1,217 @@
+#include "disassembly_cache.h"
+
+#include <capstone/capstone.h>
+
+#include <algorithm>
+#include <map>
+
+#include "util/logging.h"
+
+//! Maximum number of bytes in an i386 instruction.
+static constexpr uint32_t kMaxInstructionBytes = 15;
+static constexpr uint32_t kPageMask = DisassemblyCache::kPageSize - 1;
+
+struct DisassemblyCache::Impl {
+  struct Page {
+    std::vector<uint8_t> data;
+    //! Instructions that start within this page, keyed by address.
+    std::map<uint32_t, cs_insn> instructions;
+    uint64_t last_used{0};
+  };
+
+  explicit Impl(size_t max_page_count) : max_pages(max_page_count) {}
+
+  void AddPage(uint32_t page_address, uint64_t generation,
+               std::vector<uint8_t> data);
+  Page* GetPage(uint32_t page_address, const PageReader& read_page);
+  //! Decodes instructions starting at `address` until the end of its page,
+  //! returning false if no instruction could be decoded.
+  bool DecodeFrom(uint32_t address, Page& page, const PageReader& read_page);
+  //! Decodes up to `count` instructions (or all if zero) into `page`.
+  void Decode(uint32_t address, const uint8_t* data, size_t size,
+              size_t count, Page& page);
+  void EvictIfNeeded();
+
+  csh handle{0};
+  bool handle_valid{false};
+  size_t max_pages;
+  uint64_t generation{0};
+  uint64_t use_counter{0};
+  std::map<uint32_t, Page> pages;
+};
+
+DisassemblyCache::DisassemblyCache(size_t max_pages)
+    : impl_(std::make_unique<Impl>(std::max<size_t>(max_pages, 2))) {
+  if (cs_open(CS_ARCH_X86, CS_MODE_32, &impl_->handle) != CS_ERR_OK) {
+    LOG_DEBUGGER(error) << "DisassemblyCache: Failed to initialize Capstone";
+    return;
+  }
+  impl_->handle_valid = true;
+}
+
+DisassemblyCache::~DisassemblyCache() {
+  if (impl_->handle_valid) {
+    cs_close(&impl_->handle);
+  }
+}
+
+std::vector<cs_insn> DisassemblyCache::Disassemble(
+    uint32_t address, uint32_t count, const PageReader& read_page) {
+  std::vector<cs_insn> ret;
+  if (!impl_->handle_valid) {
+    return ret;
+  }
+  ret.reserve(count);
+
+  uint32_t current = address;
+  while (ret.size() < count) {
+    auto page = impl_->GetPage(current & ~kPageMask, read_page);
+    if (!page) {
+      break;
+    }
+
+    auto it = page->instructions.find(current);
+    if (it == page->instructions.end()) {
+      if (!impl_->DecodeFrom(current, *page, read_page)) {
+        break;
+      }
+      it = page->instructions.find(current);
+    }
+
+    ret.push_back(it->second);
+    uint64_t next = static_cast<uint64_t>(current) + it->second.size;
+    if (next > 0xFFFFFFFF) {
+      break;
+    }
+    current = static_cast<uint32_t>(next);
+  }
+
+  return ret;
+}
+
+uint64_t DisassemblyCache::Generation() const { return impl_->generation; }
+
+size_t DisassemblyCache::PageCount() const { return impl_->pages.size(); }
+
+bool DisassemblyCache::Contains(uint32_t page_address) const {
+  return impl_->pages.contains(page_address);
+}
+
+void DisassemblyCache::AddPage(uint32_t page_address, uint64_t generation,
+                               std::vector<uint8_t> data) {
+  impl_->AddPage(page_address, generation, std::move(data));
+}
+
+void DisassemblyCache::Invalidate(uint32_t address, uint32_t length) {
+  if (!length) {
+    return;
+  }
+
+  // Instructions that start on the preceding page may extend into the range.
+  uint64_t first = address & ~kPageMask;
+  if (first >= kPageSize) {
+    first -= kPageSize;
+  }
+  uint64_t last = (static_cast<uint64_t>(address) + length - 1) & ~kPageMask;
+  auto& pages = impl_->pages;
+  pages.erase(pages.lower_bound(static_cast<uint32_t>(first)),
+              pages.upper_bound(static_cast<uint32_t>(last)));
+}
+
+void DisassemblyCache::Reset() {
+  impl_->pages.clear();
+  ++impl_->generation;
+}
+
+void DisassemblyCache::Impl::AddPage(uint32_t page_address,
+                                     uint64_t page_generation,
+                                     std::vector<uint8_t> data) {
+  if (page_generation != generation || data.empty() ||
+      data.size() > kPageSize) {
+    return;
+  }
+
+  auto& page = pages[page_address & ~kPageMask];
+  page.data = std::move(data);
+  page.instructions.clear();
+  page.last_used = ++use_counter;
+  EvictIfNeeded();
+}
+
+DisassemblyCache::Impl::Page* DisassemblyCache::Impl::GetPage(
+    uint32_t page_address, const PageReader& read_page) {
+  auto it = pages.find(page_address);
+  if (it == pages.end()) {
+    auto data = read_page(page_address);
+    if (!data || data->empty()) {
+      return nullptr;
+    }
+    AddPage(page_address, generation, std::move(*data));
+    it = pages.find(page_address);
+    if (it == pages.end()) {
+      return nullptr;
+    }
+  }
+
+  it->second.last_used = ++use_counter;
+  return &it->second;
+}
+
+bool DisassemblyCache::Impl::DecodeFrom(uint32_t address, Page& page,
+                                        const PageReader& read_page) {
+  uint32_t page_address = address & ~kPageMask;
+  uint32_t offset = address - page_address;
+  if (offset >= page.data.size()) {
+    return false;
+  }
+
+  Decode(address, page.data.data() + offset, page.data.size() - offset, 0,
+         page);
+  if (page.instructions.contains(address)) {
+    return true;
+  }
+
+  // Decoding fails at the end of a page if an instruction continues onto the
+  // next one, which is only read once such an instruction is reached.
+  uint32_t remaining = kPageSize - offset;
+  if (page.data.size() != kPageSize || remaining >= kMaxInstructionBytes ||
+      !(page_address + kPageSize)) {
+    return false;
+  }
+  auto next = GetPage(page_address + kPageSize, read_page);
+  if (!next) {
+    return false;
+  }
+
+  std::vector<uint8_t> buffer(page.data.begin() + offset, page.data.end());
+  auto spill = std::min<size_t>(next->data.size(), kMaxInstructionBytes);
+  buffer.insert(buffer.end(), next->data.begin(),
+                next->data.begin() + static_cast<ptrdiff_t>(spill));
+  Decode(address, buffer.data(), buffer.size(), 1, page);
+  return page.instructions.contains(address);
+}
+
+void DisassemblyCache::Impl::Decode(uint32_t address, const uint8_t* data,
+                                    size_t size, size_t count, Page& page) {
+  cs_insn* insn;
+  size_t decoded = cs_disasm(handle, data, size, address, count, &insn);
+  for (size_t i = 0; i < decoded; ++i) {
+    cs_insn entry = insn[i];
+    entry.detail = nullptr;
+    page.instructions.emplace(static_cast<uint32_t>(entry.address), entry);
+  }
+  if (decoded) {
+    cs_free(insn, decoded);
+  }
+}
+
+void DisassemblyCache::Impl::EvictIfNeeded() {
+  while (pages.size() > max_pages) {
+    auto oldest = std::min_element(pages.begin(), pages.end(),
+                                   [](const auto& a, const auto& b) {
+                                     return a.second.last_used <
+                                            b.second.last_used;
+                                   });
+    pages.erase(oldest);
+  }
+}
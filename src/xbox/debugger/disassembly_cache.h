@@ -0,0 +1,67 @@
+#ifndef XBDM_GDB_BRIDGE_SRC_XBOX_DEBUGGER_DISASSEMBLY_CACHE_H_
+#define XBDM_GDB_BRIDGE_SRC_XBOX_DEBUGGER_DISASSEMBLY_CACHE_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+// Capstone is kept out of this header so that it is only needed by code that
+// inspects the returned instructions.
+struct cs_insn;
+
+//! Caches target code a page at a time along with the instructions decoded
+//! from it, so that repeatedly disassembling the same code (e.g., around EIP
+//! while stepping) neither reads memory nor runs Capstone again.
+//!
+//! Pages are tagged with the generation in which they were read. `Reset`
+//! starts a new generation, discarding every page and causing any page read
+//! under an earlier generation (such as an outstanding prefetch) to be
+//! ignored when it is added.
+//!
+//! This class is not thread safe.
+class DisassemblyCache {
+ public:
+  static constexpr uint32_t kPageSize = 0x1000;
+  static constexpr size_t kDefaultMaxPages = 64;
+
+  //! Reads the page starting at the given address. The result may be shorter
+  //! than a page if the end of the page is not readable.
+  using PageReader = std::function<std::optional<std::vector<uint8_t>>(
+      uint32_t page_address)>;
+
+  explicit DisassemblyCache(size_t max_pages = kDefaultMaxPages);
+  ~DisassemblyCache();
+  DisassemblyCache(const DisassemblyCache&) = delete;
+  DisassemblyCache& operator=(const DisassemblyCache&) = delete;
+
+  //! Returns up to `count` consecutive instructions starting at `address`,
+  //! reading uncached pages via `read_page`. Fewer instructions are returned
+  //! if memory cannot be read or an invalid instruction is reached. The
+  //! returned instructions do not include Capstone detail information.
+  std::vector<cs_insn> Disassemble(uint32_t address, uint32_t count,
+                                   const PageReader& read_page);
+
+  [[nodiscard]] uint64_t Generation() const;
+  [[nodiscard]] size_t PageCount() const;
+  [[nodiscard]] bool Contains(uint32_t page_address) const;
+
+  //! Adds a page that was read during the given generation.
+  void AddPage(uint32_t page_address, uint64_t generation,
+               std::vector<uint8_t> data);
+
+  //! Discards any cached code that may be affected by a change to the given
+  //! range.
+  void Invalidate(uint32_t address, uint32_t length);
+
+  //! Discards all pages and starts a new generation, e.g., because modules
+  //! were loaded or unloaded.
+  void Reset();
+
+ private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+#endif  // XBDM_GDB_BRIDGE_SRC_XBOX_DEBUGGER_DISASSEMBLY_CACHE_H_
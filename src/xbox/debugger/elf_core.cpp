@@ -0,0 +1,190 @@
+#include "elf_core.h"
+
+#include "rdcp/types/memory_region.h"
+
+static constexpr uint32_t kElfHeaderSize = 52;
+static constexpr uint32_t kProgramHeaderSize = 32;
+static constexpr uint16_t kElfTypeCore = 4;
+static constexpr uint16_t kElfMachine386 = 3;
+static constexpr uint32_t kProgramTypeLoad = 1;
+static constexpr uint32_t kProgramTypeNote = 4;
+static constexpr uint32_t kSegmentFlagExecute = 1;
+static constexpr uint32_t kSegmentFlagWrite = 2;
+static constexpr uint32_t kSegmentFlagRead = 4;
+static constexpr uint32_t kSegmentAlignment = 0x1000;
+
+static constexpr uint32_t kNoteTypePRStatus = 1;
+static constexpr uint32_t kNoteTypeFPRegSet = 2;
+//! sizeof(struct elf_prstatus) on i386 Linux.
+static constexpr uint32_t kPRStatusSize = 144;
+static constexpr uint32_t kPRStatusCurrentSignalOffset = 12;
+static constexpr uint32_t kPRStatusPidOffset = 24;
+static constexpr uint32_t kPRStatusRegistersOffset = 72;
+static constexpr uint32_t kPRStatusFPValidOffset = 140;
+//! sizeof(struct user_i387_struct), which matches the FSAVE layout produced
+//! by ThreadFloatContext::Serialize.
+static constexpr uint32_t kFPRegSetSize = 108;
+static constexpr uint32_t kSIGTRAP = 5;
+
+static void Put16(std::vector<uint8_t>& buffer, uint16_t value) {
+  buffer.push_back(static_cast<uint8_t>(value));
+  buffer.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+static void Put32(std::vector<uint8_t>& buffer, uint32_t value) {
+  for (uint32_t i = 0; i < 32; i += 8) {
+    buffer.push_back(static_cast<uint8_t>(value >> i));
+  }
+}
+
+static void Set32(std::vector<uint8_t>& buffer, size_t offset,
+                  uint32_t value) {
+  for (uint32_t i = 0; i < 4; ++i) {
+    buffer[offset + i] = static_cast<uint8_t>(value >> (i * 8));
+  }
+}
+
+static void AlignTo(std::vector<uint8_t>& buffer, uint32_t alignment) {
+  buffer.resize((buffer.size() + alignment - 1) / alignment * alignment);
+}
+
+static void AppendNote(std::vector<uint8_t>& buffer, uint32_t type,
+                       const std::vector<uint8_t>& desc) {
+  static constexpr char kName[] = "CORE";
+  Put32(buffer, sizeof(kName));
+  Put32(buffer, static_cast<uint32_t>(desc.size()));
+  Put32(buffer, type);
+  buffer.insert(buffer.end(), kName, kName + sizeof(kName));
+  AlignTo(buffer, 4);
+  buffer.insert(buffer.end(), desc.begin(), desc.end());
+  AlignTo(buffer, 4);
+}
+
+static std::vector<uint8_t> BuildPRStatus(const ElfCoreThread& thread) {
+  std::vector<uint8_t> ret(kPRStatusSize);
+  if (thread.stopped) {
+    ret[kPRStatusCurrentSignalOffset] = kSIGTRAP;
+  }
+  Set32(ret, kPRStatusPidOffset, thread.thread_id);
+
+  // Registers are stored in i386 user_regs_struct order. Segment registers
+  // and orig_eax are not available from XBDM and are left as zero.
+  auto set_register = [&ret](uint32_t index,
+                             const std::optional<int32_t>& value) {
+    if (value.has_value()) {
+      Set32(ret, kPRStatusRegistersOffset + index * 4,
+            static_cast<uint32_t>(*value));
+    }
+  };
+  auto& context = thread.context;
+  set_register(0, context.ebx);
+  set_register(1, context.ecx);
+  set_register(2, context.edx);
+  set_register(3, context.esi);
+  set_register(4, context.edi);
+  set_register(5, context.ebp);
+  set_register(6, context.eax);
+  set_register(12, context.eip);
+  set_register(14, context.eflags);
+  set_register(15, context.esp);
+
+  Set32(ret, kPRStatusFPValidOffset, thread.float_context.has_value());
+  return ret;
+}
+
+std::expected<std::vector<uint8_t>, std::string> BuildElfCoreHeader(
+    const std::vector<ElfCoreThread>& threads,
+    const std::vector<ElfCoreSegment>& segments) {
+  // PN_XNUM (0xFFFF) indicates that the real count is stored in a section
+  // header, which is not supported.
+  if (segments.size() + 1 >= 0xFFFF) {
+    return std::unexpected("Too many memory regions for an ELF core file");
+  }
+  auto program_header_count = static_cast<uint16_t>(segments.size() + 1);
+
+  std::vector<uint8_t> notes;
+  for (auto& thread : threads) {
+    AppendNote(notes, kNoteTypePRStatus, BuildPRStatus(thread));
+    if (thread.float_context.has_value()) {
+      auto fpregs = thread.float_context->Serialize();
+      fpregs.resize(kFPRegSetSize);
+      AppendNote(notes, kNoteTypeFPRegSet, fpregs);
+    }
+  }
+
+  uint64_t notes_offset =
+      kElfHeaderSize + kProgramHeaderSize * program_header_count;
+  uint64_t data_offset = (notes_offset + notes.size() + kSegmentAlignment - 1) /
+                         kSegmentAlignment * kSegmentAlignment;
+  uint64_t file_size = data_offset;
+  for (auto& segment : segments) {
+    file_size += segment.size;
+  }
+  if (file_size > 0xFFFFFFFFULL) {
+    return std::unexpected("Memory regions are too large for an ELF32 core");
+  }
+
+  std::vector<uint8_t> ret = {0x7F, 'E', 'L', 'F',
+                              1,  // ELFCLASS32
+                              1,  // ELFDATA2LSB
+                              1,  // EV_CURRENT
+                              0,  // ELFOSABI_NONE
+                              0, 0, 0, 0, 0, 0, 0, 0};
+  Put16(ret, kElfTypeCore);
+  Put16(ret, kElfMachine386);
+  Put32(ret, 1);  // e_version
+  Put32(ret, 0);  // e_entry
+  Put32(ret, kElfHeaderSize);
+  Put32(ret, 0);  // e_shoff
+  Put32(ret, 0);  // e_flags
+  Put16(ret, kElfHeaderSize);
+  Put16(ret, kProgramHeaderSize);
+  Put16(ret, program_header_count);
+  Put16(ret, 0);  // e_shentsize
+  Put16(ret, 0);  // e_shnum
+  Put16(ret, 0);  // e_shstrndx
+
+  Put32(ret, kProgramTypeNote);
+  Put32(ret, static_cast<uint32_t>(notes_offset));
+  Put32(ret, 0);  // p_vaddr
+  Put32(ret, 0);  // p_paddr
+  Put32(ret, static_cast<uint32_t>(notes.size()));
+  Put32(ret, 0);  // p_memsz
+  Put32(ret, 0);  // p_flags
+  Put32(ret, 4);
+
+  auto offset = static_cast<uint32_t>(data_offset);
+  for (auto& segment : segments) {
+    uint32_t flags = kSegmentFlagRead;
+    if (segment.protect &
+        (MemoryRegion::PAGE_READWRITE | MemoryRegion::PAGE_WRITECOPY |
+         MemoryRegion::PAGE_EXECUTE_READWRITE |
+         MemoryRegion::PAGE_EXECUTE_WRITECOPY)) {
+      flags |= kSegmentFlagWrite;
+    }
+    if (segment.protect &
+        (MemoryRegion::PAGE_EXECUTE | MemoryRegion::PAGE_EXECUTE_READ |
+         MemoryRegion::PAGE_EXECUTE_READWRITE |
+         MemoryRegion::PAGE_EXECUTE_WRITECOPY)) {
+      flags |= kSegmentFlagExecute;
+    }
+
+    Put32(ret, kProgramTypeLoad);
+    Put32(ret, offset);
+    Put32(ret, segment.address);
+    Put32(ret, 0);  // p_paddr
+    Put32(ret, segment.size);
+    Put32(ret, segment.size);
+    Put32(ret, flags);
+    // XBDM regions are whole pages, so segments are normally page aligned
+    // within the file as well.
+    Put32(ret, (offset - segment.address) % kSegmentAlignment
+                   ? 1
+                   : kSegmentAlignment);
+    offset += segment.size;
+  }
+
+  ret.insert(ret.end(), notes.begin(), notes.end());
+  ret.resize(data_offset);
+  return ret;
+}
@@ -0,0 +1,38 @@
+#ifndef XBDM_GDB_BRIDGE_SRC_XBOX_DEBUGGER_ELF_CORE_H_
+#define XBDM_GDB_BRIDGE_SRC_XBOX_DEBUGGER_ELF_CORE_H_
+
+#include <cstdint>
+#include <expected>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "rdcp/types/thread_context.h"
+
+//! Thread state recorded in the notes of an ELF core file.
+struct ElfCoreThread {
+  uint32_t thread_id{0};
+  ThreadContext context;
+  std::optional<ThreadFloatContext> float_context;
+  //! True if the thread is stopped, in which case it is reported as having
+  //! received SIGTRAP.
+  bool stopped{false};
+};
+
+//! A block of memory stored in an ELF core file.
+struct ElfCoreSegment {
+  uint32_t address{0};
+  uint32_t size{0};
+  //! The MemoryRegion protection flags for the segment.
+  uint32_t protect{0};
+};
+
+//! Builds the ELF header, program headers and NT_PRSTATUS/NT_FPREGSET notes
+//! for an ELF32 i386 core file. The returned buffer is padded such that the
+//! contents of each segment may be appended directly, in order, with no
+//! further padding.
+std::expected<std::vector<uint8_t>, std::string> BuildElfCoreHeader(
+    const std::vector<ElfCoreThread>& threads,
+    const std::vector<ElfCoreSegment>& segments);
+
+#endif  // XBDM_GDB_BRIDGE_SRC_XBOX_DEBUGGER_ELF_CORE_H_
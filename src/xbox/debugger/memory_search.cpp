@@ -0,0 +1,155 @@
+#include "memory_search.h"
+
+#include <cassert>
+#include <cctype>
+#include <cstring>
+
+//! Returns a score estimating how frequently the given byte appears in typical
+//! memory, used to pick an anchor that produces few false candidates.
+static int AnchorScore(uint8_t value) {
+  switch (value) {
+    case 0x00:
+      return 3;
+    case 0xFF:
+      return 2;
+    case 0xCC:
+    case 0x90:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+MemorySearchPattern::MemorySearchPattern(std::vector<uint8_t> bytes,
+                                         uint32_t alignment)
+    : MemorySearchPattern(bytes, std::vector<uint8_t>(bytes.size(), 0xFF),
+                          alignment) {}
+
+MemorySearchPattern::MemorySearchPattern(std::vector<uint8_t> bytes,
+                                         std::vector<uint8_t> mask,
+                                         uint32_t alignment)
+    : bytes_(std::move(bytes)),
+      mask_(std::move(mask)),
+      alignment_(alignment ? alignment : 1) {
+  assert(!bytes_.empty() && "Empty search pattern");
+  assert(bytes_.size() == mask_.size() && "Mismatched search pattern mask");
+
+  for (size_t i = 0; i < bytes_.size(); ++i) {
+    bytes_[i] &= mask_[i];
+    if (mask_[i] != 0xFF) {
+      continue;
+    }
+    if (!anchor_ || AnchorScore(bytes_[i]) < AnchorScore(bytes_[*anchor_])) {
+      anchor_ = i;
+    }
+  }
+}
+
+std::optional<MemorySearchPattern> MemorySearchPattern::ParseHex(
+    const std::string& text, uint32_t alignment) {
+  std::vector<uint8_t> bytes;
+  std::vector<uint8_t> mask;
+  bool high_nibble = true;
+
+  for (char c : text) {
+    if (isspace(static_cast<unsigned char>(c))) {
+      continue;
+    }
+
+    uint8_t value = 0;
+    uint8_t value_mask = 0x0F;
+    if (c == '?') {
+      value_mask = 0;
+    } else if (isxdigit(static_cast<unsigned char>(c))) {
+      value = static_cast<uint8_t>(isdigit(c) ? c - '0'
+                                              : tolower(c) - 'a' + 10);
+    } else {
+      return std::nullopt;
+    }
+
+    if (high_nibble) {
+      bytes.push_back(value << 4);
+      mask.push_back(value_mask << 4);
+    } else {
+      bytes.back() |= value;
+      mask.back() |= value_mask;
+    }
+    high_nibble = !high_nibble;
+  }
+
+  if (bytes.empty() || !high_nibble) {
+    return std::nullopt;
+  }
+
+  return MemorySearchPattern(std::move(bytes), std::move(mask), alignment);
+}
+
+MemorySearchPattern MemorySearchPattern::FromValue(uint32_t value,
+                                                   uint32_t size) {
+  assert(size >= 1 && size <= 4 && "Invalid value size");
+  std::vector<uint8_t> bytes;
+  for (uint32_t i = 0; i < size; ++i) {
+    bytes.push_back(static_cast<uint8_t>(value >> (i * 8)));
+  }
+  return MemorySearchPattern(std::move(bytes), size);
+}
+
+bool MemorySearchPattern::Matches(const uint8_t* data) const {
+  for (size_t i = 0; i < bytes_.size(); ++i) {
+    if ((data[i] & mask_[i]) != bytes_[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool MemorySearchPattern::Scan(const uint8_t* data, size_t size,
+                               uint32_t base_address,
+                               std::vector<uint32_t>& hits,
+                               size_t max_hits) const {
+  if (size < bytes_.size()) {
+    return true;
+  }
+  size_t last_start = size - bytes_.size();
+
+  auto check = [&](size_t start) {
+    if (!Matches(data + start)) {
+      return true;
+    }
+    hits.push_back(base_address + static_cast<uint32_t>(start));
+    return hits.size() < max_hits;
+  };
+
+  // Aligned value searches visit every aligned position directly, as values
+  // such as 0 would produce a candidate for nearly every byte.
+  if (!anchor_ || (alignment_ > 1 && alignment_ >= bytes_.size())) {
+    size_t start = (alignment_ - base_address % alignment_) % alignment_;
+    for (; start <= last_start; start += alignment_) {
+      if (!check(start)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Otherwise use memchr, which is vectorized by the C library, to skip to
+  // each occurrence of the anchor byte.
+  auto anchor = *anchor_;
+  const uint8_t* cursor = data + anchor;
+  const uint8_t* end = data + last_start + anchor + 1;
+  while (cursor < end) {
+    auto found = static_cast<const uint8_t*>(
+        memchr(cursor, bytes_[anchor], static_cast<size_t>(end - cursor)));
+    if (!found) {
+      break;
+    }
+
+    auto start = static_cast<size_t>(found - data) - anchor;
+    if ((base_address + start) % alignment_ == 0 && !check(start)) {
+      return false;
+    }
+    cursor = found + 1;
+  }
+
+  return true;
+}
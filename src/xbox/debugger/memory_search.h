@@ -0,0 +1,54 @@
+#ifndef XBDM_GDB_BRIDGE_SRC_XBOX_DEBUGGER_MEMORY_SEARCH_H_
+#define XBDM_GDB_BRIDGE_SRC_XBOX_DEBUGGER_MEMORY_SEARCH_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+//! A byte pattern with an optional per-bit mask, used to scan blocks of
+//! target memory.
+class MemorySearchPattern {
+ public:
+  //! Creates a pattern that matches `bytes` exactly.
+  explicit MemorySearchPattern(std::vector<uint8_t> bytes,
+                               uint32_t alignment = 1);
+
+  //! Creates a pattern that only compares the bits that are set in `mask`.
+  MemorySearchPattern(std::vector<uint8_t> bytes, std::vector<uint8_t> mask,
+                      uint32_t alignment = 1);
+
+  //! Parses a sequence of hex bytes, ignoring whitespace. A `?` matches any
+  //! value for that nibble, e.g. "8b 45 ?? 0f" or "8b4?".
+  static std::optional<MemorySearchPattern> ParseHex(const std::string& text,
+                                                     uint32_t alignment = 1);
+
+  //! Creates a pattern matching the little endian representation of the low
+  //! `size` bytes of `value`, aligned to `size` bytes.
+  static MemorySearchPattern FromValue(uint32_t value, uint32_t size);
+
+  [[nodiscard]] size_t Size() const { return bytes_.size(); }
+  [[nodiscard]] uint32_t Alignment() const { return alignment_; }
+  void SetAlignment(uint32_t alignment) {
+    alignment_ = alignment ? alignment : 1;
+  }
+
+  //! Appends the address of each match that lies entirely within `data` to
+  //! `hits`. Returns false if scanning stopped because `hits` reached
+  //! `max_hits` entries.
+  bool Scan(const uint8_t* data, size_t size, uint32_t base_address,
+            std::vector<uint32_t>& hits, size_t max_hits) const;
+
+ private:
+  [[nodiscard]] bool Matches(const uint8_t* data) const;
+
+ private:
+  std::vector<uint8_t> bytes_;
+  std::vector<uint8_t> mask_;
+  uint32_t alignment_;
+  //! The index of the fully specified byte used to find candidate matches
+  //! with memchr, if any.
+  std::optional<size_t> anchor_;
+};
+
+#endif  // XBDM_GDB_BRIDGE_SRC_XBOX_DEBUGGER_MEMORY_SEARCH_H_
@@ -0,0 +1,233 @@
+#include "memory_snapshot.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+
+#include "util/logging.h"
+
+static constexpr char kMagic[4] = {'X', 'B', 'M', 'S'};
+static constexpr uint32_t kVersion = 1;
+static constexpr uint32_t kHeaderSize = 32;
+static constexpr uint32_t kBlockEntrySize = 8;
+static constexpr uint32_t kMaxBlockSize = 0x1000;
+
+static void PutLE(std::vector<uint8_t>& buffer, uint64_t value,
+                  uint32_t size) {
+  for (uint32_t i = 0; i < size; ++i) {
+    buffer.push_back(static_cast<uint8_t>(value >> (i * 8)));
+  }
+}
+
+static uint64_t GetLE(const uint8_t* buffer, uint32_t size) {
+  uint64_t ret = 0;
+  for (uint32_t i = 0; i < size; ++i) {
+    ret |= static_cast<uint64_t>(buffer[i]) << (i * 8);
+  }
+  return ret;
+}
+
+static bool IsValidBlockSize(uint32_t block_size) {
+  return block_size >= 8 && block_size <= kMaxBlockSize &&
+         !(block_size & (block_size - 1));
+}
+
+static uint64_t DataOffset(uint64_t block_count, uint32_t block_size) {
+  uint64_t table_end = kHeaderSize + block_count * kBlockEntrySize;
+  return (table_end + block_size - 1) / block_size * block_size;
+}
+
+//! Appends the given range, merging it with the last range if they are
+//! contiguous.
+static void AppendRange(std::vector<MemorySnapshot::Range>& ranges,
+                        uint32_t address, uint32_t length) {
+  if (!ranges.empty()) {
+    auto& last = ranges.back();
+    if (static_cast<uint64_t>(last.address) + last.length == address) {
+      last.length += length;
+      return;
+    }
+  }
+  ranges.push_back({address, length});
+}
+
+MemorySnapshot::MemorySnapshot(uint32_t block_size) : block_size_(block_size) {
+  assert(IsValidBlockSize(block_size) && "Invalid snapshot block size");
+}
+
+size_t MemorySnapshot::AddBlock(uint32_t address, uint32_t checksum) {
+  assert((blocks_.empty() || blocks_.back().address < address) &&
+         "Snapshot blocks must be added in ascending order");
+  blocks_.push_back({address, checksum});
+  data_.resize(data_.size() + block_size_);
+  return blocks_.size() - 1;
+}
+
+std::optional<size_t> MemorySnapshot::FindBlock(uint32_t address) const {
+  auto it = std::lower_bound(
+      blocks_.begin(), blocks_.end(), address,
+      [](const Block& block, uint32_t value) { return block.address < value; });
+  if (it == blocks_.end() || it->address != address) {
+    return std::nullopt;
+  }
+  return static_cast<size_t>(it - blocks_.begin());
+}
+
+std::optional<std::vector<uint8_t>> MemorySnapshot::ReadMemory(
+    uint32_t address, uint32_t length) const {
+  std::vector<uint8_t> ret;
+  ret.reserve(length);
+
+  uint64_t current = address;
+  uint64_t end = static_cast<uint64_t>(address) + length;
+  while (current < end) {
+    auto block_address = static_cast<uint32_t>(current & ~(block_size_ - 1));
+    auto index = FindBlock(block_address);
+    if (!index.has_value()) {
+      return std::nullopt;
+    }
+
+    auto offset = static_cast<uint32_t>(current - block_address);
+    auto available = std::min<uint64_t>(block_size_ - offset, end - current);
+    auto begin = BlockData(*index) + offset;
+    ret.insert(ret.end(), begin, begin + available);
+    current += available;
+  }
+
+  return ret;
+}
+
+bool MemorySnapshot::Save(const std::string& path) const {
+  std::vector<uint8_t> header;
+  header.insert(header.end(), std::begin(kMagic), std::end(kMagic));
+  PutLE(header, kVersion, 4);
+  PutLE(header, block_size_, 4);
+  PutLE(header, 0, 4);
+  PutLE(header, blocks_.size(), 8);
+  PutLE(header, DataOffset(blocks_.size(), block_size_), 8);
+  assert(header.size() == kHeaderSize);
+
+  for (auto& block : blocks_) {
+    PutLE(header, block.address, 4);
+    PutLE(header, block.checksum, 4);
+  }
+  header.resize(DataOffset(blocks_.size(), block_size_));
+
+  std::ofstream of(path, std::ofstream::binary | std::ofstream::trunc);
+  if (!of) {
+    LOG_DEBUGGER(error) << "Failed to open " << path << " for writing";
+    return false;
+  }
+  of.write(reinterpret_cast<const char*>(header.data()),
+           static_cast<std::streamsize>(header.size()));
+  of.write(reinterpret_cast<const char*>(data_.data()),
+           static_cast<std::streamsize>(data_.size()));
+  if (!of) {
+    LOG_DEBUGGER(error) << "Failed to write snapshot to " << path;
+    return false;
+  }
+  return true;
+}
+
+std::shared_ptr<MemorySnapshot> MemorySnapshot::Load(const std::string& path) {
+  std::ifstream ifs(path, std::ifstream::binary);
+  if (!ifs) {
+    LOG_DEBUGGER(error) << "Failed to open " << path;
+    return nullptr;
+  }
+
+  uint8_t header[kHeaderSize];
+  if (!ifs.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+      memcmp(header, kMagic, sizeof(kMagic)) != 0) {
+    LOG_DEBUGGER(error) << path << " is not a memory snapshot";
+    return nullptr;
+  }
+
+  auto version = static_cast<uint32_t>(GetLE(header + 4, 4));
+  auto block_size = static_cast<uint32_t>(GetLE(header + 8, 4));
+  auto block_count = GetLE(header + 16, 8);
+  auto data_offset = GetLE(header + 24, 8);
+  if (version != kVersion || !IsValidBlockSize(block_size) ||
+      block_count > 0x100000000ULL / block_size ||
+      data_offset != DataOffset(block_count, block_size)) {
+    LOG_DEBUGGER(error) << path << " has an unsupported snapshot header";
+    return nullptr;
+  }
+
+  auto ret = std::make_shared<MemorySnapshot>(block_size);
+  std::vector<uint8_t> table(block_count * kBlockEntrySize);
+  if (!ifs.read(reinterpret_cast<char*>(table.data()),
+                static_cast<std::streamsize>(table.size()))) {
+    LOG_DEBUGGER(error) << "Failed to read block table from " << path;
+    return nullptr;
+  }
+  ret->blocks_.reserve(block_count);
+  for (uint64_t i = 0; i < block_count; ++i) {
+    auto entry = table.data() + i * kBlockEntrySize;
+    auto address = static_cast<uint32_t>(GetLE(entry, 4));
+    if (!ret->blocks_.empty() && ret->blocks_.back().address >= address) {
+      LOG_DEBUGGER(error) << path << " has an unsorted block table";
+      return nullptr;
+    }
+    auto checksum = static_cast<uint32_t>(GetLE(entry + 4, 4));
+    ret->blocks_.push_back({address, checksum});
+  }
+
+  ret->data_.resize(block_count * block_size);
+  ifs.seekg(static_cast<std::streamoff>(data_offset));
+  if (!ifs.read(reinterpret_cast<char*>(ret->data_.data()),
+                static_cast<std::streamsize>(ret->data_.size()))) {
+    LOG_DEBUGGER(error) << "Failed to read block contents from " << path;
+    return nullptr;
+  }
+
+  return ret;
+}
+
+MemorySnapshot::Diff MemorySnapshot::Compare(const MemorySnapshot& before,
+                                             const MemorySnapshot& after) {
+  assert(before.block_size_ == after.block_size_ &&
+         "Snapshots must have the same block size");
+  auto block_size = before.block_size_;
+
+  Diff ret;
+  size_t b = 0;
+  size_t a = 0;
+  while (b < before.blocks_.size() || a < after.blocks_.size()) {
+    if (a == after.blocks_.size() ||
+        (b < before.blocks_.size() &&
+         before.blocks_[b].address < after.blocks_[a].address)) {
+      AppendRange(ret.removed, before.blocks_[b++].address, block_size);
+      continue;
+    }
+    if (b == before.blocks_.size() ||
+        after.blocks_[a].address < before.blocks_[b].address) {
+      AppendRange(ret.added, after.blocks_[a++].address, block_size);
+      continue;
+    }
+
+    if (before.blocks_[b].checksum != after.blocks_[a].checksum) {
+      auto address = after.blocks_[a].address;
+      auto old_data = before.BlockData(b);
+      auto new_data = after.BlockData(a);
+      uint32_t i = 0;
+      while (i < block_size) {
+        if (old_data[i] == new_data[i]) {
+          ++i;
+          continue;
+        }
+        uint32_t run_start = i;
+        while (i < block_size && old_data[i] != new_data[i]) {
+          ++i;
+        }
+        AppendRange(ret.changed, address + run_start, i - run_start);
+        ret.bytes_changed += i - run_start;
+      }
+    }
+    ++a;
+    ++b;
+  }
+
+  return ret;
+}
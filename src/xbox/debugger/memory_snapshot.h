@@ -0,0 +1,82 @@
+#ifndef XBDM_GDB_BRIDGE_SRC_XBOX_DEBUGGER_MEMORY_SNAPSHOT_H_
+#define XBDM_GDB_BRIDGE_SRC_XBOX_DEBUGGER_MEMORY_SNAPSHOT_H_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+//! A copy of target memory, stored as fixed size blocks along with the XBDM
+//! `getsum` checksum of each block so that later snapshots only need to
+//! download blocks whose checksum has changed.
+//!
+//! On disk a snapshot is a fixed size little endian header, followed by the
+//! block table and then the contents of every block. The contents start at a
+//! multiple of the block size so that the file may be mapped directly.
+class MemorySnapshot {
+ public:
+  static constexpr uint32_t kDefaultBlockSize = 0x1000;
+
+  struct Block {
+    uint32_t address;
+    uint32_t checksum;
+  };
+
+  struct Range {
+    uint32_t address;
+    uint32_t length;
+  };
+
+  //! The differences between two snapshots.
+  struct Diff {
+    //! Ranges present in both snapshots whose contents differ.
+    std::vector<Range> changed;
+    //! Ranges only present in the later snapshot.
+    std::vector<Range> added;
+    //! Ranges only present in the earlier snapshot.
+    std::vector<Range> removed;
+    uint64_t bytes_changed{0};
+  };
+
+  //! `block_size` must be a power of two between 8 and the page size.
+  explicit MemorySnapshot(uint32_t block_size = kDefaultBlockSize);
+
+  [[nodiscard]] uint32_t BlockSize() const { return block_size_; }
+  [[nodiscard]] size_t BlockCount() const { return blocks_.size(); }
+  [[nodiscard]] const std::vector<Block>& Blocks() const { return blocks_; }
+  [[nodiscard]] uint64_t DataSize() const { return data_.size(); }
+
+  [[nodiscard]] const uint8_t* BlockData(size_t index) const {
+    return data_.data() + index * block_size_;
+  }
+  [[nodiscard]] uint8_t* BlockData(size_t index) {
+    return data_.data() + index * block_size_;
+  }
+
+  //! Appends a block, which must be above any existing block. The contents
+  //! are zero filled and should be populated via `BlockData`.
+  size_t AddBlock(uint32_t address, uint32_t checksum);
+
+  //! Returns the index of the block starting at the given address.
+  [[nodiscard]] std::optional<size_t> FindBlock(uint32_t address) const;
+
+  //! Returns the given range if every byte in it was captured.
+  [[nodiscard]] std::optional<std::vector<uint8_t>> ReadMemory(
+      uint32_t address, uint32_t length) const;
+
+  bool Save(const std::string& path) const;
+  static std::shared_ptr<MemorySnapshot> Load(const std::string& path);
+
+  //! Compares two snapshots taken with the same block size. Blocks with equal
+  //! checksums are assumed to be unchanged.
+  static Diff Compare(const MemorySnapshot& before,
+                      const MemorySnapshot& after);
+
+ private:
+  uint32_t block_size_;
+  std::vector<Block> blocks_;
+  std::vector<uint8_t> data_;
+};
+
+#endif  // XBDM_GDB_BRIDGE_SRC_XBOX_DEBUGGER_MEMORY_SNAPSHOT_H_
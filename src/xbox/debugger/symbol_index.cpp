@@ -0,0 +1,583 @@
+#include "symbol_index.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "util/logging.h"
+
+static_assert(std::endian::native == std::endian::little,
+              "Symbol cache files are mapped directly and are little endian");
+
+static constexpr char kMagic[4] = {'X', 'B', 'S', 'Y'};
+static constexpr uint32_t kVersion = 1;
+static constexpr uint32_t kHeaderSize = 32;
+static constexpr uint32_t kEntrySize = 16;
+
+static constexpr char kXBEMagic[4] = {'X', 'B', 'E', 'H'};
+static constexpr uint32_t kXBEBaseAddressOffset = 0x104;
+static constexpr uint32_t kXBEHeadersSizeOffset = 0x108;
+static constexpr uint32_t kXBESectionCountOffset = 0x11C;
+static constexpr uint32_t kXBESectionHeadersOffset = 0x120;
+static constexpr uint32_t kXBESectionHeaderSize = 0x38;
+static constexpr uint32_t kXBEMaxHeadersSize = 0x1000000;
+
+static uint32_t Read32(const uint8_t* buffer) {
+  uint32_t ret;
+  memcpy(&ret, buffer, sizeof(ret));
+  return ret;
+}
+
+static void Put32(std::vector<uint8_t>& buffer, uint32_t value) {
+  for (uint32_t i = 0; i < 32; i += 8) {
+    buffer.push_back(static_cast<uint8_t>(value >> i));
+  }
+}
+
+static std::optional<uint32_t> ParseHex(std::string_view token) {
+  if (token.starts_with("0x") || token.starts_with("0X")) {
+    token.remove_prefix(2);
+  }
+  if (token.empty() || token.size() > 16) {
+    return std::nullopt;
+  }
+
+  uint64_t value = 0;
+  for (char c : token) {
+    if (!std::isxdigit(static_cast<unsigned char>(c))) {
+      return std::nullopt;
+    }
+    value = (value << 4) |
+            static_cast<uint64_t>(std::isdigit(c) ? c - '0'
+                                                  : std::tolower(c) - 'a' + 10);
+  }
+  if (value > 0xFFFFFFFF) {
+    return std::nullopt;
+  }
+  return static_cast<uint32_t>(value);
+}
+
+//! Splits off up to `max_tokens` whitespace separated tokens, storing the
+//! remainder of the line (with surrounding whitespace removed) in `rest`.
+static std::vector<std::string_view> Tokenize(std::string_view line,
+                                              size_t max_tokens,
+                                              std::string_view& rest) {
+  static constexpr char kWhitespace[] = " \t\r\n";
+  std::vector<std::string_view> ret;
+  while (ret.size() < max_tokens) {
+    auto start = line.find_first_not_of(kWhitespace);
+    if (start == std::string_view::npos) {
+      line = {};
+      break;
+    }
+    line.remove_prefix(start);
+    auto end = std::min(line.find_first_of(kWhitespace), line.size());
+    ret.push_back(line.substr(0, end));
+    line.remove_prefix(end);
+  }
+
+  auto start = line.find_first_not_of(kWhitespace);
+  if (start == std::string_view::npos) {
+    rest = {};
+  } else {
+    auto end = line.find_last_not_of(kWhitespace);
+    rest = line.substr(start, end - start + 1);
+  }
+  return ret;
+}
+
+std::string SymbolIndex::Match::ToString() const {
+  if (!offset) {
+    return std::string(name);
+  }
+  std::stringstream ret;
+  ret << name << "+0x" << std::hex << offset;
+  return ret.str();
+}
+
+void SymbolIndex::Builder::AddSymbol(uint32_t address, uint32_t size,
+                                     std::string name) {
+  symbols_.push_back({address, size, std::move(name)});
+}
+
+void SymbolIndex::Builder::AddSection(uint32_t address, uint32_t size,
+                                      std::string name) {
+  sections_.push_back({address, size, std::move(name)});
+}
+
+bool SymbolIndex::Builder::LoadMapFile(const std::string& path) {
+  std::ifstream ifs(path);
+  if (!ifs) {
+    LOG_DEBUGGER(error) << "Failed to open " << path;
+    return false;
+  }
+
+  std::string line;
+  bool in_symbols = false;
+  while (std::getline(ifs, line)) {
+    if (!in_symbols) {
+      in_symbols = line.find("Publics by Value") != std::string::npos;
+      continue;
+    }
+
+    // " 0001:00000000       _main         00011000 f   main.obj"
+    std::string_view rest;
+    auto tokens = Tokenize(line, 3, rest);
+    if (tokens.size() != 3 || tokens[0].size() != 13 || tokens[0][4] != ':') {
+      continue;
+    }
+    // Segment 0 holds absolute symbols rather than addresses.
+    auto segment = ParseHex(tokens[0].substr(0, 4));
+    auto address = ParseHex(tokens[2]);
+    if (!segment || !*segment || !address) {
+      continue;
+    }
+    AddSymbol(*address, 0, std::string(tokens[1]));
+  }
+
+  if (!in_symbols) {
+    LOG_DEBUGGER(error) << path << " is not an MSVC linker map file";
+    return false;
+  }
+  return true;
+}
+
+bool SymbolIndex::Builder::LoadSymbolDump(const std::string& path) {
+  std::ifstream ifs(path);
+  if (!ifs) {
+    LOG_DEBUGGER(error) << "Failed to open " << path;
+    return false;
+  }
+  return ParseSymbolDump(ifs);
+}
+
+bool SymbolIndex::Builder::ParseSymbolDump(std::istream& is) {
+  auto is_type = [](std::string_view token) {
+    return token.size() == 1 && std::isalpha(token[0]);
+  };
+
+  std::string line;
+  while (std::getline(is, line)) {
+    std::string_view rest;
+    auto tokens = Tokenize(line, 3, rest);
+    if (tokens.empty()) {
+      continue;
+    }
+    auto address = ParseHex(tokens[0]);
+    if (!address) {
+      continue;
+    }
+
+    uint32_t size = 0;
+    size_t name_index = 1;
+    if (tokens.size() > 2 && !is_type(tokens[1])) {
+      auto parsed_size = ParseHex(tokens[1]);
+      if (parsed_size) {
+        size = *parsed_size;
+        name_index = 2;
+      }
+    }
+    if (name_index < tokens.size() && is_type(tokens[name_index]) &&
+        (name_index + 1 < tokens.size() || !rest.empty())) {
+      ++name_index;
+    }
+
+    // Everything after the name token is part of the name, which allows
+    // demangled names containing whitespace.
+    std::string name;
+    for (size_t i = name_index; i < tokens.size(); ++i) {
+      if (!name.empty()) {
+        name += " ";
+      }
+      name += tokens[i];
+    }
+    if (!rest.empty()) {
+      if (!name.empty()) {
+        name += " ";
+      }
+      name += rest;
+    }
+    if (name.empty()) {
+      continue;
+    }
+    AddSymbol(*address, size, std::move(name));
+  }
+  return true;
+}
+
+bool SymbolIndex::Builder::LoadXBE(const std::string& path) {
+  std::ifstream ifs(path, std::ifstream::binary);
+  if (!ifs) {
+    LOG_DEBUGGER(error) << "Failed to open " << path;
+    return false;
+  }
+
+  std::vector<uint8_t> headers(kXBESectionHeadersOffset + 4);
+  if (!ifs.read(reinterpret_cast<char*>(headers.data()),
+                static_cast<std::streamsize>(headers.size())) ||
+      memcmp(headers.data(), kXBEMagic, sizeof(kXBEMagic)) != 0) {
+    LOG_DEBUGGER(error) << path << " is not an XBE";
+    return false;
+  }
+
+  auto base_address = Read32(headers.data() + kXBEBaseAddressOffset);
+  auto headers_size = Read32(headers.data() + kXBEHeadersSizeOffset);
+  auto section_count = Read32(headers.data() + kXBESectionCountOffset);
+  auto section_headers = Read32(headers.data() + kXBESectionHeadersOffset);
+  if (headers_size < headers.size() || headers_size > kXBEMaxHeadersSize ||
+      section_headers < base_address ||
+      static_cast<uint64_t>(section_headers - base_address) +
+              static_cast<uint64_t>(section_count) * kXBESectionHeaderSize >
+          headers_size) {
+    LOG_DEBUGGER(error) << path << " has an invalid XBE header";
+    return false;
+  }
+
+  auto header_size = headers.size();
+  headers.resize(headers_size);
+  if (!ifs.read(reinterpret_cast<char*>(headers.data() + header_size),
+                static_cast<std::streamsize>(headers_size - header_size))) {
+    LOG_DEBUGGER(error) << "Failed to read XBE headers from " << path;
+    return false;
+  }
+
+  auto header = headers.data() + (section_headers - base_address);
+  for (uint32_t i = 0; i < section_count;
+       ++i, header += kXBESectionHeaderSize) {
+    auto address = Read32(header + 4);
+    auto size = Read32(header + 8);
+    auto name_address = Read32(header + 0x14);
+
+    std::string name;
+    uint32_t name_offset = name_address - base_address;
+    if (name_address >= base_address && name_offset < headers_size) {
+      auto name_begin =
+          reinterpret_cast<const char*>(headers.data()) + name_offset;
+      name.assign(name_begin, strnlen(name_begin, headers_size - name_offset));
+    }
+    if (name.empty()) {
+      name = "section" + std::to_string(i);
+    }
+    AddSection(address, size, std::move(name));
+  }
+
+  return true;
+}
+
+bool SymbolIndex::Builder::Load(const std::string& path) {
+  std::ifstream ifs(path, std::ifstream::binary);
+  if (!ifs) {
+    LOG_DEBUGGER(error) << "Failed to open " << path;
+    return false;
+  }
+
+  char magic[sizeof(kXBEMagic)] = {0};
+  ifs.read(magic, sizeof(magic));
+  if (ifs.gcount() == sizeof(magic) &&
+      !memcmp(magic, kXBEMagic, sizeof(kXBEMagic))) {
+    return LoadXBE(path);
+  }
+
+  ifs.clear();
+  ifs.seekg(0);
+  std::string line;
+  while (std::getline(ifs, line)) {
+    if (line.find("Publics by Value") != std::string::npos) {
+      return LoadMapFile(path);
+    }
+  }
+
+  return LoadSymbolDump(path);
+}
+
+std::shared_ptr<SymbolIndex> SymbolIndex::Builder::Build() const {
+  auto by_address = [](const Entry& a, const Entry& b) {
+    if (a.address != b.address) {
+      return a.address < b.address;
+    }
+    return a.name < b.name;
+  };
+
+  auto symbols = symbols_;
+  std::sort(symbols.begin(), symbols.end(), by_address);
+  symbols.erase(std::unique(symbols.begin(), symbols.end(),
+                            [](const Entry& a, const Entry& b) {
+                              return a.address == b.address &&
+                                     a.name == b.name;
+                            }),
+                symbols.end());
+
+  auto sections = sections_;
+  std::sort(sections.begin(), sections.end(), by_address);
+
+  // Symbols without an explicit size extend to the next symbol, bounded by
+  // the end of the containing section.
+  for (size_t i = 0; i < symbols.size(); ++i) {
+    auto& symbol = symbols[i];
+    if (symbol.size) {
+      continue;
+    }
+
+    uint64_t end = 0;
+    auto next = std::upper_bound(symbols.begin() + static_cast<ptrdiff_t>(i),
+                                 symbols.end(), symbol.address,
+                                 [](uint32_t address, const Entry& entry) {
+                                   return address < entry.address;
+                                 });
+    if (next != symbols.end()) {
+      end = next->address;
+    }
+
+    auto section = std::upper_bound(sections.begin(), sections.end(),
+                                    symbol.address,
+                                    [](uint32_t address, const Entry& entry) {
+                                      return address < entry.address;
+                                    });
+    if (section != sections.begin()) {
+      --section;
+      uint64_t section_end =
+          static_cast<uint64_t>(section->address) + section->size;
+      if (symbol.address < section_end && (!end || section_end < end)) {
+        end = section_end;
+      }
+    }
+
+    if (end > symbol.address) {
+      symbol.size = static_cast<uint32_t>(
+          std::min<uint64_t>(end - symbol.address, 0xFFFFFFFF));
+    }
+  }
+
+  std::vector<uint32_t> name_order(symbols.size());
+  for (uint32_t i = 0; i < name_order.size(); ++i) {
+    name_order[i] = i;
+  }
+  std::stable_sort(name_order.begin(), name_order.end(),
+                   [&symbols](uint32_t a, uint32_t b) {
+                     return symbols[a].name < symbols[b].name;
+                   });
+
+  std::vector<uint8_t> data;
+  std::string strings;
+  auto put_entry = [&data, &strings](const Entry& entry) {
+    Put32(data, entry.address);
+    Put32(data, entry.size);
+    Put32(data, static_cast<uint32_t>(strings.size()));
+    Put32(data, static_cast<uint32_t>(entry.name.size()));
+    strings += entry.name;
+  };
+
+  data.insert(data.end(), std::begin(kMagic), std::end(kMagic));
+  Put32(data, kVersion);
+  Put32(data, static_cast<uint32_t>(symbols.size()));
+  Put32(data, static_cast<uint32_t>(sections.size()));
+  Put32(data, 0);  // Strings size, filled in below.
+  data.resize(kHeaderSize);
+
+  for (auto& symbol : symbols) {
+    put_entry(symbol);
+  }
+  for (auto index : name_order) {
+    Put32(data, index);
+  }
+  for (auto& section : sections) {
+    put_entry(section);
+  }
+  data.insert(data.end(), strings.begin(), strings.end());
+  auto strings_size = static_cast<uint32_t>(strings.size());
+  memcpy(data.data() + 16, &strings_size, sizeof(strings_size));
+
+  std::shared_ptr<SymbolIndex> ret(new SymbolIndex());
+  ret->owned_data_ = std::move(data);
+  bool valid = ret->Attach(ret->owned_data_.data(), ret->owned_data_.size());
+  assert(valid && "Built an invalid symbol index");
+  (void)valid;
+  return ret;
+}
+
+SymbolIndex::~SymbolIndex() {
+  if (mapping_) {
+    munmap(mapping_, mapping_size_);
+  }
+}
+
+std::shared_ptr<SymbolIndex> SymbolIndex::Open(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG_DEBUGGER(error) << "Failed to open " << path;
+    return nullptr;
+  }
+
+  struct stat info {};
+  if (fstat(fd, &info) || info.st_size < kHeaderSize) {
+    close(fd);
+    LOG_DEBUGGER(error) << path << " is not a symbol cache";
+    return nullptr;
+  }
+
+  auto size = static_cast<size_t>(info.st_size);
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    LOG_DEBUGGER(error) << "Failed to map " << path;
+    return nullptr;
+  }
+
+  std::shared_ptr<SymbolIndex> ret(new SymbolIndex());
+  ret->mapping_ = mapping;
+  ret->mapping_size_ = size;
+  if (!ret->Attach(static_cast<const uint8_t*>(mapping), size)) {
+    LOG_DEBUGGER(error) << path << " is not a valid symbol cache";
+    return nullptr;
+  }
+  return ret;
+}
+
+bool SymbolIndex::IsCacheFile(const std::string& path) {
+  std::ifstream ifs(path, std::ifstream::binary);
+  char magic[sizeof(kMagic)] = {0};
+  ifs.read(magic, sizeof(magic));
+  return ifs.gcount() == sizeof(magic) &&
+         !memcmp(magic, kMagic, sizeof(kMagic));
+}
+
+bool SymbolIndex::Save(const std::string& path) const {
+  std::ofstream of(path, std::ofstream::binary | std::ofstream::trunc);
+  if (!of) {
+    LOG_DEBUGGER(error) << "Failed to open " << path << " for writing";
+    return false;
+  }
+  of.write(reinterpret_cast<const char*>(data_),
+           static_cast<std::streamsize>(size_));
+  if (!of) {
+    LOG_DEBUGGER(error) << "Failed to write symbol cache to " << path;
+    return false;
+  }
+  return true;
+}
+
+bool SymbolIndex::Attach(const uint8_t* data, size_t size) {
+  if (size < kHeaderSize || memcmp(data, kMagic, sizeof(kMagic)) != 0 ||
+      Read32(data + 4) != kVersion) {
+    return false;
+  }
+
+  auto symbol_count = Read32(data + 8);
+  auto section_count = Read32(data + 12);
+  auto strings_size = Read32(data + 16);
+  uint64_t symbols_offset = kHeaderSize;
+  uint64_t name_order_offset =
+      symbols_offset + static_cast<uint64_t>(symbol_count) * kEntrySize;
+  uint64_t sections_offset =
+      name_order_offset + static_cast<uint64_t>(symbol_count) * 4;
+  uint64_t strings_offset =
+      sections_offset + static_cast<uint64_t>(section_count) * kEntrySize;
+  if (strings_offset + strings_size != size) {
+    return false;
+  }
+
+  data_ = data;
+  size_ = size;
+  symbol_count_ = symbol_count;
+  section_count_ = section_count;
+  symbols_ = reinterpret_cast<const RawEntry*>(data + symbols_offset);
+  name_order_ = reinterpret_cast<const uint32_t*>(data + name_order_offset);
+  sections_ = reinterpret_cast<const RawEntry*>(data + sections_offset);
+  strings_ = reinterpret_cast<const char*>(data + strings_offset);
+  strings_size_ = strings_size;
+
+  auto valid_name = [strings_size](const RawEntry& entry) {
+    return static_cast<uint64_t>(entry.name_offset) + entry.name_length <=
+           strings_size;
+  };
+  for (uint32_t i = 0; i < symbol_count; ++i) {
+    if (!valid_name(symbols_[i]) || name_order_[i] >= symbol_count) {
+      return false;
+    }
+  }
+  for (uint32_t i = 0; i < section_count; ++i) {
+    if (!valid_name(sections_[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string_view SymbolIndex::Name(const RawEntry& entry) const {
+  return {strings_ + entry.name_offset, entry.name_length};
+}
+
+SymbolIndex::Symbol SymbolIndex::GetSymbol(uint32_t index) const {
+  auto& entry = symbols_[index];
+  return {entry.address, entry.size, Name(entry)};
+}
+
+SymbolIndex::Symbol SymbolIndex::GetSection(uint32_t index) const {
+  auto& entry = sections_[index];
+  return {entry.address, entry.size, Name(entry)};
+}
+
+std::optional<SymbolIndex::Match> SymbolIndex::Lookup(uint32_t address) const {
+  auto find = [this, address](const RawEntry* begin,
+                              const RawEntry* end) -> std::optional<Match> {
+    auto it = std::upper_bound(begin, end, address,
+                               [](uint32_t value, const RawEntry& entry) {
+                                 return value < entry.address;
+                               });
+    if (it == begin) {
+      return std::nullopt;
+    }
+    --it;
+
+    // Prefer the first of several aliases at the same address.
+    while (it != begin && (it - 1)->address == it->address) {
+      --it;
+    }
+    uint32_t offset = address - it->address;
+    if (offset && offset >= it->size) {
+      return std::nullopt;
+    }
+    return Match{Name(*it), offset};
+  };
+
+  auto ret = find(symbols_, symbols_ + symbol_count_);
+  if (ret.has_value()) {
+    return ret;
+  }
+  return find(sections_, sections_ + section_count_);
+}
+
+std::string SymbolIndex::Describe(uint32_t address) const {
+  auto match = Lookup(address);
+  if (!match.has_value()) {
+    return {};
+  }
+  return match->ToString();
+}
+
+std::optional<uint32_t> SymbolIndex::FindExact(std::string_view name) const {
+  auto it = std::lower_bound(name_order_, name_order_ + symbol_count_, name,
+                             [this](uint32_t index, std::string_view value) {
+                               return Name(symbols_[index]) < value;
+                             });
+  if (it == name_order_ + symbol_count_ || Name(symbols_[*it]) != name) {
+    return std::nullopt;
+  }
+  return symbols_[*it].address;
+}
+
+std::optional<uint32_t> SymbolIndex::FindAddress(std::string_view name) const {
+  auto ret = FindExact(name);
+  if (ret.has_value() || name.starts_with('_')) {
+    return ret;
+  }
+  return FindExact("_" + std::string(name));
+}
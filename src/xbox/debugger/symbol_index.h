@@ -0,0 +1,131 @@
+#ifndef XBDM_GDB_BRIDGE_SRC_XBOX_DEBUGGER_SYMBOL_INDEX_H_
+#define XBDM_GDB_BRIDGE_SRC_XBOX_DEBUGGER_SYMBOL_INDEX_H_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//! An immutable, address ordered table of symbols loaded from local files.
+//!
+//! The index is kept in the same flat layout that is written to disk so that
+//! a prebuilt cache file can be memory mapped and used without parsing:
+//! a 32 byte little endian header, the symbol table sorted by address, a table
+//! of symbol indices sorted by name, a table of sections sorted by address and
+//! finally the string table.
+class SymbolIndex {
+ public:
+  struct Symbol {
+    uint32_t address;
+    //! The extent of the symbol. Symbols that were loaded without a size are
+    //! assumed to extend to the next symbol or the end of their section.
+    uint32_t size;
+    std::string_view name;
+  };
+
+  //! The symbol (or section, if no symbol covers the address) containing an
+  //! address.
+  struct Match {
+    std::string_view name;
+    uint32_t offset;
+
+    //! Returns "name" or "name+0x<offset>".
+    [[nodiscard]] std::string ToString() const;
+  };
+
+  //! Accumulates symbols from source files and produces a SymbolIndex.
+  class Builder {
+   public:
+    void AddSymbol(uint32_t address, uint32_t size, std::string name);
+    void AddSection(uint32_t address, uint32_t size, std::string name);
+
+    //! Loads the "Publics by Value" and "Static symbols" tables from an MSVC
+    //! linker map file.
+    bool LoadMapFile(const std::string& path);
+    //! Loads a plain text symbol dump, one symbol per line, in any of the
+    //! forms "<addr> <name>", "<addr> <size> <name>", "<addr> <type> <name>"
+    //! (nm) or "<addr> <size> <type> <name>" (nm -S). Addresses and sizes are
+    //! hexadecimal.
+    bool LoadSymbolDump(const std::string& path);
+    //! Loads the section table from an XBE image.
+    bool LoadXBE(const std::string& path);
+
+    //! Loads a file, selecting the parser based on its contents.
+    bool Load(const std::string& path);
+
+    [[nodiscard]] size_t SymbolCount() const { return symbols_.size(); }
+
+    [[nodiscard]] std::shared_ptr<SymbolIndex> Build() const;
+
+   private:
+    struct Entry {
+      uint32_t address;
+      uint32_t size;
+      std::string name;
+    };
+
+    bool ParseSymbolDump(std::istream& is);
+
+    std::vector<Entry> symbols_;
+    std::vector<Entry> sections_;
+  };
+
+  ~SymbolIndex();
+  SymbolIndex(const SymbolIndex&) = delete;
+  SymbolIndex& operator=(const SymbolIndex&) = delete;
+
+  //! Memory maps a cache file previously written by `Save`.
+  static std::shared_ptr<SymbolIndex> Open(const std::string& path);
+  static bool IsCacheFile(const std::string& path);
+  bool Save(const std::string& path) const;
+
+  [[nodiscard]] uint32_t SymbolCount() const { return symbol_count_; }
+  [[nodiscard]] uint32_t SectionCount() const { return section_count_; }
+  [[nodiscard]] Symbol GetSymbol(uint32_t index) const;
+  [[nodiscard]] Symbol GetSection(uint32_t index) const;
+
+  //! Returns the symbol containing the given address, falling back to the
+  //! containing section.
+  [[nodiscard]] std::optional<Match> Lookup(uint32_t address) const;
+
+  //! Returns "symbol+offset" for the given address, or an empty string if it
+  //! is not covered by any symbol or section.
+  [[nodiscard]] std::string Describe(uint32_t address) const;
+
+  //! Returns the address of the given symbol. If there is no exact match, the
+  //! cdecl decorated name (with a leading underscore) is also tried.
+  [[nodiscard]] std::optional<uint32_t> FindAddress(
+      std::string_view name) const;
+
+ private:
+  struct RawEntry {
+    uint32_t address;
+    uint32_t size;
+    uint32_t name_offset;
+    uint32_t name_length;
+  };
+
+  SymbolIndex() = default;
+
+  bool Attach(const uint8_t* data, size_t size);
+  [[nodiscard]] std::string_view Name(const RawEntry& entry) const;
+  [[nodiscard]] std::optional<uint32_t> FindExact(std::string_view name) const;
+
+  std::vector<uint8_t> owned_data_;
+  void* mapping_{nullptr};
+  size_t mapping_size_{0};
+
+  const uint8_t* data_{nullptr};
+  size_t size_{0};
+  uint32_t symbol_count_{0};
+  uint32_t section_count_{0};
+  const RawEntry* symbols_{nullptr};
+  const uint32_t* name_order_{nullptr};
+  const RawEntry* sections_{nullptr};
+  const char* strings_{nullptr};
+  uint32_t strings_size_{0};
+};
+
+#endif  // XBDM_GDB_BRIDGE_SRC_XBOX_DEBUGGER_SYMBOL_INDEX_H_
@@ -47,7 +47,11 @@ std::ostream& operator<<(std::ostream& os, const Thread& t) {
 bool Thread::FetchInfoSync(XBDMContext& ctx) {
   auto request = std::make_shared<ThreadInfo>(thread_id);
   ctx.SendCommandSync(request);
-  if (!request->IsOK()) {
+  return UpdateInfo(*request);
+}
+
+bool Thread::UpdateInfo(const ThreadInfo& request) {
+  if (!request.IsOK()) {
     suspend_count.reset();
     priority.reset();
     tls_base.reset();
@@ -57,13 +61,13 @@ bool Thread::FetchInfoSync(XBDMContext& ctx) {
     create_timestamp.reset();
     return false;
   }
-  suspend_count = request->suspend_count;
-  priority = request->priority;
-  tls_base = request->tls_base;
-  start = request->start;
-  base = request->base;
-  limit = request->limit;
-  create_timestamp = request->create_timestamp;
+  suspend_count = request.suspend_count;
+  priority = request.priority;
+  tls_base = request.tls_base;
+  start = request.start;
+  base = request.base;
+  limit = request.limit;
+  create_timestamp = request.create_timestamp;
   return true;
 }
 
@@ -112,13 +116,17 @@ bool Thread::PushFloatContextSync(XBDMContext& ctx) {
 bool Thread::FetchStopReasonSync(XBDMContext& ctx) {
   auto request = std::make_shared<IsStopped>(thread_id);
   ctx.SendCommandSync(request);
-  if (!request->IsOK()) {
+  return UpdateStopReason(*request);
+}
+
+bool Thread::UpdateStopReason(const IsStopped& request) {
+  if (!request.IsOK()) {
     last_stop_reason.reset();
     return false;
   }
 
-  stopped = request->stopped;
-  last_stop_reason = request->stop_reason;
+  stopped = request.stopped;
+  last_stop_reason = request.stop_reason;
   return true;
 }
 
@@ -10,6 +10,8 @@
 #include "rdcp/xbdm_stop_reasons.h"
 
 class XBDMContext;
+struct IsStopped;
+struct ThreadInfo;
 
 struct Thread {
   static constexpr uint32_t kTrapFlag = 0x100;
@@ -17,11 +19,15 @@ struct Thread {
   explicit Thread(uint32_t thread_id) : thread_id(thread_id) {}
 
   bool FetchInfoSync(XBDMContext& ctx);
+  //! Updates this thread from a completed ThreadInfo request.
+  bool UpdateInfo(const ThreadInfo& request);
   bool FetchContextSync(XBDMContext& ctx);
   bool PushContextSync(XBDMContext& ctx);
   bool FetchFloatContextSync(XBDMContext& ctx);
   bool PushFloatContextSync(XBDMContext& ctx);
   bool FetchStopReasonSync(XBDMContext& ctx);
+  //! Updates this thread from a completed IsStopped request.
+  bool UpdateStopReason(const IsStopped& request);
 
   bool Halt(XBDMContext& ctx);
   bool Continue(XBDMContext& ctx, bool break_on_exceptions = true);
@@ -30,6 +36,9 @@ struct Thread {
 
   bool StepInstruction(XBDMContext& ctx);
 
+  //! Returns true if thread info has been fetched for this thread.
+  [[nodiscard]] bool HasInfo() const { return create_timestamp.has_value(); }
+
   //! Checks if `address` is within the stack region owned by this thread.
   bool HasStack(uint32_t address) const;
 
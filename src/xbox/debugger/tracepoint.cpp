@@ -0,0 +1,104 @@
+#include "tracepoint.h"
+
+#include <algorithm>
+
+void TraceFrame::AddMemory(uint32_t address, std::vector<uint8_t> data) {
+  if (data.empty()) {
+    return;
+  }
+
+  auto& block = memory[address];
+  if (block.size() < data.size()) {
+    block = std::move(data);
+  }
+}
+
+std::optional<std::vector<uint8_t>> TraceFrame::ReadMemory(
+    uint32_t address, uint32_t length) const {
+  std::vector<uint8_t> ret;
+  ret.reserve(length);
+
+  uint64_t current = address;
+  uint64_t end = static_cast<uint64_t>(address) + length;
+  while (current < end) {
+    // Find the last block starting at or before the current address.
+    auto block = memory.upper_bound(static_cast<uint32_t>(current));
+    if (block == memory.begin()) {
+      return std::nullopt;
+    }
+    --block;
+
+    uint64_t block_end = static_cast<uint64_t>(block->first) +
+                         block->second.size();
+    if (block_end <= current) {
+      return std::nullopt;
+    }
+
+    auto offset = static_cast<size_t>(current - block->first);
+    auto available = static_cast<size_t>(std::min(block_end, end) - current);
+    auto begin = block->second.begin() + static_cast<ptrdiff_t>(offset);
+    ret.insert(ret.end(), begin, begin + static_cast<ptrdiff_t>(available));
+    current += available;
+  }
+
+  return ret;
+}
+
+size_t TraceFrame::Size() const {
+  size_t ret = sizeof(*this);
+  for (auto& [address, data] : memory) {
+    ret += sizeof(address) + data.size();
+  }
+  for (auto& [expression, value] : values) {
+    ret += expression.size() + sizeof(value);
+  }
+  return ret;
+}
+
+namespace trace_actions {
+
+TraceAction CollectRegisters() {
+  return [](const ThreadContext& context, uint32_t,
+            const DebuggerExpressionParser::MemoryReader&,
+            TraceFrame& frame) -> std::expected<void, std::string> {
+    frame.registers = context;
+    return {};
+  };
+}
+
+TraceAction CollectMemory(std::string expression, uint32_t length) {
+  return [expression = std::move(expression), length](
+             const ThreadContext& context, uint32_t thread_id,
+             const DebuggerExpressionParser::MemoryReader& memory_reader,
+             TraceFrame& frame) -> std::expected<void, std::string> {
+    DebuggerExpressionParser parser(context, thread_id, memory_reader);
+    auto address = parser.Parse(expression);
+    if (!address.has_value()) {
+      return std::unexpected(address.error());
+    }
+
+    auto data = memory_reader(*address, length);
+    if (!data.has_value()) {
+      return std::unexpected(data.error());
+    }
+    frame.AddMemory(*address, std::move(*data));
+    return {};
+  };
+}
+
+TraceAction CollectExpression(std::string expression) {
+  return [expression = std::move(expression)](
+             const ThreadContext& context, uint32_t thread_id,
+             const DebuggerExpressionParser::MemoryReader& memory_reader,
+             TraceFrame& frame) -> std::expected<void, std::string> {
+    DebuggerExpressionParser parser(context, thread_id, memory_reader);
+    auto value = parser.Parse(expression);
+    if (!value.has_value()) {
+      return std::unexpected(value.error());
+    }
+    frame.values.emplace_back(expression, *value);
+    return {};
+  };
+}
+
+}  // namespace trace_actions
@@ -0,0 +1,59 @@
+#ifndef XBDM_GDB_BRIDGE_SRC_XBOX_DEBUGGER_TRACEPOINT_H_
+#define XBDM_GDB_BRIDGE_SRC_XBOX_DEBUGGER_TRACEPOINT_H_
+
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "debugger_expression_parser.h"
+#include "rdcp/types/thread_context.h"
+
+//! The data collected by a single tracepoint hit.
+struct TraceFrame {
+  uint32_t tracepoint{0};
+  uint32_t thread_id{0};
+  uint32_t address{0};
+
+  std::optional<ThreadContext> registers;
+  //! Collected memory blocks keyed by their start address.
+  std::map<uint32_t, std::vector<uint8_t>> memory;
+  //! Collected expressions and their values.
+  std::vector<std::pair<std::string, uint32_t>> values;
+
+  void AddMemory(uint32_t address, std::vector<uint8_t> data);
+
+  //! Returns the given range if every byte in it was collected.
+  [[nodiscard]] std::optional<std::vector<uint8_t>> ReadMemory(
+      uint32_t address, uint32_t length) const;
+
+  //! Returns the approximate number of bytes of trace buffer used by this
+  //! frame.
+  [[nodiscard]] size_t Size() const;
+};
+
+//! Collects data into a trace frame for a thread that hit a tracepoint.
+typedef std::function<std::expected<void, std::string>(
+    const ThreadContext& context, uint32_t thread_id,
+    const DebuggerExpressionParser::MemoryReader& memory_reader,
+    TraceFrame& frame)>
+    TraceAction;
+
+namespace trace_actions {
+
+//! Collects the general purpose registers.
+TraceAction CollectRegisters();
+
+//! Collects `length` bytes starting at the address given by `expression`.
+TraceAction CollectMemory(std::string expression, uint32_t length);
+
+//! Collects the value of `expression`.
+TraceAction CollectExpression(std::string expression);
+
+}  // namespace trace_actions
+
+#endif  // XBDM_GDB_BRIDGE_SRC_XBOX_DEBUGGER_TRACEPOINT_H_
@@ -1,5 +1,9 @@
 #include "xbdm_debugger.h"
 
+#include <algorithm>
+#include <cstring>
+#include <deque>
+
 #include <capstone/capstone.h>
 
 #include "debugger_expression_parser.h"
@@ -19,8 +23,22 @@ static constexpr uint32_t kPostBreakAtStartThreadCreateMakeWaitMilliseconds =
 //! likely to have actually been taken.
 static constexpr uint32_t kMaxReasonableFunctionOffset = 1024;
 
+//! The next code page is prefetched when a thread stops within this many bytes
+//! of the end of a cached page. This covers a typical disassembly listing.
+static constexpr uint32_t kCodePrefetchThreshold = 256;
+
 XBDMDebugger::XBDMDebugger(std::shared_ptr<XBDMContext> context)
-    : context_(std::move(context)) {}
+    : context_(std::move(context)),
+      debugstr_sink_(
+          [](int thread_id, const std::string& line) {
+            LOG_DEBUGGER(info) << std::endl
+                               << "DebugStr: thread_id: " << thread_id
+                               << " text: " << line;
+          },
+          [](uint64_t suppressed_lines) {
+            LOG_DEBUGGER(info) << "Suppressed " << suppressed_lines
+                               << " debugstr lines.";
+          }) {}
 
 XBDMDebugger::ScopedResume::ScopedResume(XBDMDebugger& dbg) : debugger(dbg) {
   auto stop_request = std::make_shared<::Stop>();
@@ -90,7 +108,8 @@ bool XBDMDebugger::Attach() {
   context_->UnregisterNotificationHandler(notification_handler_id_);
   notification_handler_id_ = context_->RegisterNotificationHandler(
       [this](const std::shared_ptr<XBDMNotification>& notification,
-             XBDMContext&) { OnNotification(notification); });
+             XBDMContext&) { OnNotification(notification); },
+      kNotificationOrderingKey);
 
   if (!RequestDebugNotifications(address.Port(), context_)) {
     context_->UnregisterNotificationHandler(notification_handler_id_);
@@ -124,6 +143,7 @@ void XBDMDebugger::Shutdown() {
   // TODO: Request a notifyat drop as well.
   context_->UnregisterNotificationHandler(notification_handler_id_);
   notification_handler_id_ = 0;
+  debugstr_sink_.Flush();
 }
 
 bool XBDMDebugger::DebugXBE(const std::string& path, bool wait_forever,
@@ -263,11 +283,16 @@ bool XBDMDebugger::DebugXBE(const std::string& path,
   return true;
 }
 
-std::list<std::shared_ptr<Thread>> XBDMDebugger::Threads() {
+std::map<uint32_t, std::shared_ptr<Thread>> XBDMDebugger::Threads() {
   std::unique_lock lock(threads_lock_);
   return threads_;
 }
 
+uint64_t XBDMDebugger::ThreadsGeneration() const {
+  std::unique_lock lock(threads_lock_);
+  return threads_generation_;
+}
+
 std::vector<uint32_t> XBDMDebugger::GetThreadIDs() {
   std::unique_lock lock(threads_lock_);
   std::vector<uint32_t> ret;
@@ -280,11 +305,11 @@ std::vector<uint32_t> XBDMDebugger::GetThreadIDs() {
     ret.push_back(*active_thread_id_);
   }
 
-  for (auto& thread : threads_) {
-    if (active_thread_id_ && thread->thread_id == *active_thread_id_) {
+  for (auto& [thread_id, thread] : threads_) {
+    if (active_thread_id_ && thread_id == *active_thread_id_) {
       continue;
     }
-    ret.push_back(thread->thread_id);
+    ret.push_back(thread_id);
   }
   return ret;
 }
@@ -315,7 +340,7 @@ std::optional<uint32_t> XBDMDebugger::AnyThreadID() {
     return active_thread_id_;
   }
 
-  return threads_.front()->thread_id;
+  return threads_.begin()->first;
 }
 
 std::shared_ptr<Thread> XBDMDebugger::GetAnyThread() {
@@ -328,17 +353,16 @@ std::shared_ptr<Thread> XBDMDebugger::GetAnyThread() {
 
 std::shared_ptr<Thread> XBDMDebugger::GetThread(uint32_t thread_id) {
   std::lock_guard lock(threads_lock_);
-  for (auto& thread : threads_) {
-    if (thread->thread_id == thread_id) {
-      return thread;
-    }
+  auto it = threads_.find(thread_id);
+  if (it == threads_.end()) {
+    return nullptr;
   }
-  return nullptr;
+  return it->second;
 }
 
 std::shared_ptr<Thread> XBDMDebugger::GetFirstStoppedThread() {
   LOG_DEBUGGER(trace) << "Looking for first stopped thread";
-  std::list<std::shared_ptr<Thread>> threads;
+  std::map<uint32_t, std::shared_ptr<Thread>> threads;
   std::optional<uint32_t> active_thread_id;
   {
     const std::lock_guard lock(threads_lock_);
@@ -350,20 +374,33 @@ std::shared_ptr<Thread> XBDMDebugger::GetFirstStoppedThread() {
     active_thread_id = active_thread_id_;
   }
 
-  // Prefer the active active_thread if it's still stopped.
-  std::shared_ptr<Thread> active_thread = ActiveThread();
-  if (active_thread && active_thread->FetchStopReasonSync(*context_) &&
-      active_thread->stopped) {
-    return active_thread;
+  // Query every thread in a single batch rather than one round trip each.
+  std::vector<std::shared_ptr<RDCPProcessedRequest>> requests;
+  requests.reserve(threads.size());
+  for (auto& [thread_id, thread] : threads) {
+    requests.emplace_back(std::make_shared<IsStopped>(thread_id));
   }
+  context_->SendBatch(requests);
 
-  for (auto& thread : threads) {
-    if (active_thread_id && thread->thread_id == *active_thread_id) {
+  std::shared_ptr<Thread> first_stopped;
+  auto request = requests.begin();
+  for (auto& [thread_id, thread] : threads) {
+    auto& is_stopped = static_cast<const IsStopped&>(**request++);
+    if (!thread->UpdateStopReason(is_stopped) || !thread->stopped) {
       continue;
     }
-    if (thread->FetchStopReasonSync(*context_) && thread->stopped) {
+
+    // Prefer the active thread if it's still stopped.
+    if (active_thread_id && thread_id == *active_thread_id) {
       return thread;
     }
+    if (!first_stopped) {
+      first_stopped = thread;
+    }
+  }
+
+  if (first_stopped) {
+    return first_stopped;
   }
 
   LOG_DEBUGGER(trace) << "No stopped threads";
@@ -372,11 +409,9 @@ std::shared_ptr<Thread> XBDMDebugger::GetFirstStoppedThread() {
 
 bool XBDMDebugger::SetActiveThread(uint32_t thread_id) {
   const std::lock_guard lock(threads_lock_);
-  for (auto& thread : threads_) {
-    if (thread->thread_id == thread_id) {
-      active_thread_id_ = thread_id;
-      return true;
-    }
+  if (threads_.contains(thread_id)) {
+    active_thread_id_ = thread_id;
+    return true;
   }
 
   active_thread_id_ = std::nullopt;
@@ -481,6 +516,10 @@ void XBDMDebugger::OnNotification(
           std::dynamic_pointer_cast<NotificationException>(notification));
       break;
 
+    case NT_RECONNECTED:
+      OnReconnected();
+      break;
+
     case NT_INVALID:
       LOG_DEBUGGER(error) << "XBDMNotif: Received invalid notification type.";
       break;
@@ -497,29 +536,13 @@ void XBDMDebugger::OnVX(const std::shared_ptr<NotificationVX>& msg) {
 
 void XBDMDebugger::OnDebugStr(
     const std::shared_ptr<NotificationDebugStr>& msg) {
-  if (!msg->is_terminated) {
-    auto existing = debugstr_accumulator_.find(msg->thread_id);
-    if (existing != debugstr_accumulator_.end()) {
-      debugstr_accumulator_[msg->thread_id] += msg->text;
-    } else {
-      debugstr_accumulator_[msg->thread_id] = msg->text;
-    }
-    return;
-  }
-
-  auto existing = debugstr_accumulator_.find(msg->thread_id);
-  if (existing != debugstr_accumulator_.end()) {
-    LOG_DEBUGGER(info) << std::endl << existing->second << *msg;
-    debugstr_accumulator_.erase(existing);
-    return;
-  }
-
-  LOG_DEBUGGER(info) << std::endl << *msg;
+  debugstr_sink_.Write(msg->thread_id, msg->text, msg->is_terminated);
 }
 
 void XBDMDebugger::OnModuleLoaded(
     const std::shared_ptr<NotificationModuleLoaded>& msg) {
   LOG_DEBUGGER(info) << "Module loaded";
+  ResetCodeCache();
   std::unique_lock lock(modules_lock_);
   auto mod = std::make_shared<Module>(msg->module);
   modules_[mod->base_address] = mod;
@@ -528,6 +551,7 @@ void XBDMDebugger::OnModuleLoaded(
 
 void XBDMDebugger::OnSectionLoaded(
     const std::shared_ptr<NotificationSectionLoaded>& msg) {
+  ResetCodeCache();
   std::unique_lock lock(sections_lock_);
   auto section = std::make_shared<Section>(msg->section);
   sections_[section->base_address] = section;
@@ -536,6 +560,7 @@ void XBDMDebugger::OnSectionLoaded(
 
 void XBDMDebugger::OnSectionUnloaded(
     const std::shared_ptr<NotificationSectionUnloaded>& msg) {
+  ResetCodeCache();
   std::unique_lock lock(sections_lock_);
   auto& section = msg->section;
   sections_.erase(section.base_address);
@@ -546,30 +571,27 @@ void XBDMDebugger::OnThreadCreated(
     const std::shared_ptr<NotificationThreadCreated>& msg) {
   LOG_DEBUGGER(info) << "Thread created: " << msg->thread_id;
   const std::lock_guard lock(threads_lock_);
-  for (auto& thread : threads_) {
-    if (thread->thread_id == msg->thread_id) {
-      LOG_DEBUGGER(warning)
-          << "Ignoring duplicate thread creation for " << msg->thread_id;
-      return;
-    }
+  if (threads_.contains(msg->thread_id)) {
+    LOG_DEBUGGER(warning) << "Ignoring duplicate thread creation for "
+                          << msg->thread_id;
+    return;
   }
 
-  threads_.push_back(std::make_shared<Thread>(msg->thread_id));
+  // Thread info is fetched lazily, as it is rarely needed for new threads.
+  threads_.emplace(msg->thread_id, std::make_shared<Thread>(msg->thread_id));
+  ++threads_generation_;
 }
 
 void XBDMDebugger::OnThreadTerminated(
     const std::shared_ptr<NotificationThreadTerminated>& msg) {
   LOG_DEBUGGER(info) << "Thread terminated: " << msg->thread_id;
   const std::lock_guard lock(threads_lock_);
-  for (auto it = threads_.begin(); it != threads_.end(); ++it) {
-    auto& thread = *it;
-    if (thread->thread_id == msg->thread_id) {
-      if (active_thread_id_ && thread->thread_id == *active_thread_id_) {
-        active_thread_id_ = std::nullopt;
-      }
-      threads_.erase(it);
-      return;
+  if (threads_.erase(msg->thread_id)) {
+    if (active_thread_id_ && msg->thread_id == *active_thread_id_) {
+      active_thread_id_ = std::nullopt;
     }
+    ++threads_generation_;
+    return;
   }
 
   LOG_DEBUGGER(warning)
@@ -577,6 +599,19 @@ void XBDMDebugger::OnThreadTerminated(
       << msg->thread_id;
 }
 
+void XBDMDebugger::OnReconnected() {
+  if (!is_attached_) {
+    return;
+  }
+
+  // Thread creation and termination notifications may have been missed while
+  // the notification channel was down.
+  LOG_DEBUGGER(info) << "XBDMNotif: Reconnected, refetching threads.";
+  if (!FetchThreads()) {
+    LOG_DEBUGGER(warning) << "Failed to refetch threads after reconnecting.";
+  }
+}
+
 void XBDMDebugger::OnExecutionStateChanged(
     const std::shared_ptr<NotificationExecutionStateChanged>& msg) {
   LOG_DEBUGGER(info) << "XBDMNotif: State changed: " << *msg;
@@ -589,16 +624,58 @@ void XBDMDebugger::OnExecutionStateChanged(
       sections_.clear();
       std::lock_guard lock(breakpoints_lock_);
       breakpoints_.clear();
+      traced_addresses_.clear();
+      tracepoint_only_breakpoints_.clear();
+      suspended_breakpoints_.clear();
+      step_suspended_breakpoints_.clear();
+      step_resumed_ = false;
+
+      // The tracepoint breakpoints are gone, so the experiment cannot
+      // continue. Collected frames are kept.
+      std::lock_guard trace_lock(tracepoints_lock_);
+      if (trace_status_.running) {
+        trace_status_.running = false;
+        trace_status_.stop_reason = TraceStopReason::TARGET_REBOOTED;
+        trace_status_.stop_tracepoint = 0;
+      }
+    }
+  }
+  if (msg->state == ExecutionState::S_REBOOTING) {
+    ResetCodeCache();
+
+    // Threads are refetched in full once the target has restarted.
+    const std::lock_guard lock(threads_lock_);
+    threads_.clear();
+    active_thread_id_ = std::nullopt;
+    ++threads_generation_;
+  }
+  if (msg->state == ExecutionState::S_STARTED) {
+    std::lock_guard lock(breakpoints_lock_);
+    if (!step_suspended_breakpoints_.empty()) {
+      step_resumed_ = true;
     }
   }
   if (state_ == ExecutionState::S_STOPPED) {
-    std::vector<uint32_t> breakpoints_to_restore;
+    // The restore is queued with the lock held so that it is sent before any
+    // later suspension. Breakpoints that are still suspended are left alone,
+    // including those stepped over by a StepInstruction whose resume has not
+    // been seen yet, as this notification may predate the step.
     {
       std::lock_guard lock(breakpoints_lock_);
-      breakpoints_to_restore.assign(breakpoints_.begin(), breakpoints_.end());
-    }
-    if (!breakpoints_to_restore.empty()) {
-      RestoreBreakpoints(breakpoints_to_restore, false);
+      if (step_resumed_) {
+        ReleaseBreakpointSuspensions(std::vector<uint32_t>(
+            step_suspended_breakpoints_.begin(),
+            step_suspended_breakpoints_.end()));
+        step_suspended_breakpoints_.clear();
+        step_resumed_ = false;
+      }
+      std::vector<uint32_t> breakpoints_to_restore;
+      for (uint32_t bp : breakpoints_) {
+        if (!suspended_breakpoints_.contains(bp)) {
+          breakpoints_to_restore.push_back(bp);
+        }
+      }
+      SendBreakpointRestores(breakpoints_to_restore, false);
     }
 
     auto stopped_thread = GetFirstStoppedThread();
@@ -620,6 +697,10 @@ void XBDMDebugger::OnBreakpoint(
     return;
   }
 
+  if (ProcessTracepointHit(thread, msg->address)) {
+    return;
+  }
+
   SetActiveThread(thread->thread_id);
   thread->last_known_address = msg->address;
   // TODO: Set the stop reason from the notification content.
@@ -632,30 +713,13 @@ void XBDMDebugger::OnBreakpoint(
     thread->Resume(*context_);
   }
 
-  auto condition =
-      FindBreakpointCondition(BreakpointType::BREAKPOINT, msg->address);
-
-  if (condition) {
-    thread->FetchContextSync(*context_);
-    if (thread->context.has_value()) {
-      DebuggerExpressionParser parser(*thread->context, thread->thread_id,
-                                      CreateMemoryReader());
-      auto result = parser.Parse(*condition);
-      if (result.has_value()) {
-        if (*result == 0) {
-          LOG_DEBUGGER(info)
-              << "Condition '" << *condition << "' false, continuing.";
-          ContinueThread(thread->thread_id);
-          if (!Go()) {
-            LOG_DEBUGGER(warning) << "Failed to go after ignored breakpoint";
-          }
-          return;
-        }
-      } else {
-        LOG_DEBUGGER(warning) << "Failed to parse condition '" << *condition
-                              << "': '" << result.error() << "'";
-      }
+  if (!ShouldStopForBreakpoint(thread, BreakpointType::BREAKPOINT,
+                               msg->address)) {
+    ContinueThread(thread->thread_id);
+    if (!Go()) {
+      LOG_DEBUGGER(warning) << "Failed to go after ignored breakpoint";
     }
+    return;
   }
 
   PerformAfterStopActions(thread);
@@ -700,31 +764,14 @@ void XBDMDebugger::OnWatchpoint(
       break;
   }
 
-  if (breakpoint_type) {
-    auto condition =
-        FindBreakpointCondition(*breakpoint_type, msg->watched_address);
-    if (condition) {
-      thread->FetchContextSync(*context_);
-      if (thread->context.has_value()) {
-        DebuggerExpressionParser parser(*thread->context, thread->thread_id,
-                                        CreateMemoryReader());
-        auto result = parser.Parse(*condition);
-        if (result.has_value()) {
-          if (*result == 0) {
-            LOG_DEBUGGER(info)
-                << "Condition '" << *condition << "' false, continuing.";
-            ContinueThread(thread->thread_id);
-            if (!Go()) {
-              LOG_DEBUGGER(warning) << "Failed to go after ignored breakpoint";
-            }
-            return;
-          }
-        } else {
-          LOG_DEBUGGER(warning) << "Failed to parse condition '" << *condition
-                                << "': '" << result.error() << "'";
-        }
-      }
+  if (breakpoint_type &&
+      !ShouldStopForBreakpoint(thread, *breakpoint_type,
+                               msg->watched_address)) {
+    ContinueThread(thread->thread_id);
+    if (!Go()) {
+      LOG_DEBUGGER(warning) << "Failed to go after ignored breakpoint";
     }
+    return;
   }
 
   PerformAfterStopActions(thread);
@@ -767,13 +814,97 @@ void XBDMDebugger::OnException(
   PerformAfterStopActions(thread);
 }
 
+bool XBDMDebugger::ShouldStopForBreakpoint(
+    const std::shared_ptr<Thread>& thread, BreakpointType breakpoint_type,
+    uint32_t address) {
+  auto condition = FindBreakpointCondition(breakpoint_type, address);
+  std::vector<ConditionEvaluator> evaluators;
+  {
+    std::lock_guard lock(conditions_lock_);
+    auto entry = breakpoint_condition_evaluators_.find(
+        std::make_pair(breakpoint_type, address));
+    if (entry != breakpoint_condition_evaluators_.end()) {
+      evaluators = entry->second;
+    }
+  }
+
+  if (!condition && evaluators.empty()) {
+    return true;
+  }
+
+  thread->FetchContextSync(*context_);
+  if (!thread->context.has_value()) {
+    return true;
+  }
+
+  auto memory_reader = CreateMemoryReader();
+  if (condition) {
+    DebuggerExpressionParser parser(*thread->context, thread->thread_id,
+                                    memory_reader);
+    parser.SetSymbolIndex(Symbols());
+    auto result = parser.Parse(*condition);
+    if (!result.has_value()) {
+      LOG_DEBUGGER(warning) << "Failed to parse condition '" << *condition
+                            << "': '" << result.error() << "'";
+      return true;
+    }
+    if (*result != 0) {
+      return true;
+    }
+  }
+
+  for (auto& evaluator : evaluators) {
+    auto result = evaluator(*thread->context, thread->thread_id, memory_reader);
+    if (!result.has_value()) {
+      LOG_DEBUGGER(warning) << "Failed to evaluate condition at " << std::hex
+                            << address << std::dec << ": '" << result.error()
+                            << "'";
+      return true;
+    }
+    if (*result) {
+      return true;
+    }
+  }
+
+  if (condition) {
+    LOG_DEBUGGER(info) << "Condition '" << *condition << "' false, continuing.";
+  } else {
+    LOG_DEBUGGER(info) << "Conditions at " << std::hex << address << std::dec
+                       << " false, continuing.";
+  }
+  return false;
+}
+
 void XBDMDebugger::PerformAfterStopActions(
     const std::shared_ptr<Thread>& active_thread) {
+  // The prefetch briefly suspends any breakpoints in the code it reads. Their
+  // restore must be queued before anyone waiting on the stop can resume the
+  // target.
+  if (active_thread->last_known_address.has_value()) {
+    PrefetchCode(*active_thread->last_known_address);
+  }
+
+  {
+    const std::lock_guard lock(state_lock_);
+    ++stop_event_count_;
+    last_stop_thread_id_ = active_thread->thread_id;
+  }
+  state_condition_variable_.notify_all();
+
   if (print_thread_info_on_break_) {
     std::stringstream context_info;
 
     if (active_thread->FetchContextSync(*context_)) {
       context_info << *active_thread->context;
+
+      auto symbols = Symbols();
+      auto& eip = active_thread->context->eip;
+      if (symbols && eip.has_value()) {
+        auto location = symbols->Describe(static_cast<uint32_t>(*eip));
+        if (!location.empty()) {
+          context_info << std::endl << "Location: " << location;
+        }
+      }
     } else {
       context_info << "[Failed to fetch active thread context]";
     }
@@ -1044,12 +1175,52 @@ bool XBDMDebugger::FetchThreads() {
   const std::lock_guard lock(threads_lock_);
   threads_.clear();
   for (auto thread_id : request->threads) {
-    threads_.emplace_back(std::make_shared<Thread>(thread_id));
+    threads_.emplace(thread_id, std::make_shared<Thread>(thread_id));
+  }
+  ++threads_generation_;
+
+  std::vector<std::shared_ptr<Thread>> threads;
+  threads.reserve(threads_.size());
+  for (auto& [thread_id, thread] : threads_) {
+    threads.push_back(thread);
+  }
+  return FetchThreadInfo(threads);
+}
+
+bool XBDMDebugger::FetchMissingThreadInfo() {
+  std::vector<std::shared_ptr<Thread>> threads;
+  {
+    const std::lock_guard lock(threads_lock_);
+    for (auto& [thread_id, thread] : threads_) {
+      if (!thread->HasInfo()) {
+        threads.push_back(thread);
+      }
+    }
   }
+  FetchThreadInfo(threads);
 
-  auto& context = *context_;
-  for (auto& thread : threads_) {
-    if (!thread->FetchInfoSync(context)) {
+  // Failures are ignored, as threads may terminate while their info is being
+  // fetched.
+  return true;
+}
+
+bool XBDMDebugger::FetchThreadInfo(
+    const std::vector<std::shared_ptr<Thread>>& threads) {
+  if (threads.empty()) {
+    return true;
+  }
+
+  std::vector<std::shared_ptr<RDCPProcessedRequest>> info_requests;
+  info_requests.reserve(threads.size());
+  for (auto& thread : threads) {
+    info_requests.emplace_back(std::make_shared<ThreadInfo>(thread->thread_id));
+  }
+  context_->SendBatch(info_requests);
+
+  auto info_request = info_requests.begin();
+  for (auto& thread : threads) {
+    auto& info = static_cast<const ThreadInfo&>(**info_request++);
+    if (!thread->UpdateInfo(info)) {
       LOG_DEBUGGER(error) << "Failed to fetch info for thread "
                           << thread->thread_id;
     }
@@ -1067,6 +1238,7 @@ bool XBDMDebugger::FetchModules() {
     return false;
   }
 
+  ResetCodeCache();
   const std::lock_guard lock(modules_lock_);
   modules_.clear();
   {
@@ -1149,7 +1321,9 @@ bool XBDMDebugger::RestartAndReconnect(uint32_t reboot_flags) {
     context_->SendCommandSync(request);
     // No need to check for success or failure.
 
-    context_->CloseActiveConnections();
+    // The XBOX drops its notification streams as it reboots and may already
+    // have reopened them, so only the control connection is closed here.
+    context_->CloseControlConnection();
   }
 
   // Then wait for the notification connection to be reestablished. A real
@@ -1203,6 +1377,19 @@ ExecutionState XBDMDebugger::CurrentKnownState() {
   return state_;
 }
 
+uint64_t XBDMDebugger::StopEventCount() const {
+  std::unique_lock lock(state_lock_);
+  return stop_event_count_;
+}
+
+bool XBDMDebugger::WaitForStopEvent(uint64_t last_count,
+                                    uint32_t max_wait_milliseconds) {
+  std::unique_lock lock(state_lock_);
+  return state_condition_variable_.wait_for(
+      lock, std::chrono::milliseconds(max_wait_milliseconds),
+      [this, last_count] { return stop_event_count_ > last_count; });
+}
+
 bool XBDMDebugger::StepInstruction() {
   auto thread = ActiveThread();
   if (!thread) {
@@ -1250,7 +1437,22 @@ bool XBDMDebugger::StepInstruction() {
     return false;
   }
 
+  // The breakpoints stay suspended until the target stops after the step.
+  {
+    std::lock_guard lock(breakpoints_lock_);
+    step_suspended_breakpoints_.insert(breakpoints.begin(), breakpoints.end());
+  }
+
   if (!Go()) {
+    std::lock_guard lock(breakpoints_lock_);
+    // A reboot while the step was being resumed may already have cleared the
+    // set.
+    for (uint32_t bp : breakpoints) {
+      auto it = step_suspended_breakpoints_.find(bp);
+      if (it != step_suspended_breakpoints_.end()) {
+        step_suspended_breakpoints_.erase(it);
+      }
+    }
     return false;
   }
 
@@ -1275,16 +1477,188 @@ bool XBDMDebugger::StepFunction() {
   return Go() && ret;
 }
 
+bool XBDMDebugger::StepRange(uint32_t start, uint32_t end,
+                             uint32_t max_wait_milliseconds) {
+  static constexpr uint32_t kMaxRangeBytes = 4096;
+  static constexpr uint32_t kMaxRangeSteps = 4096;
+
+  auto thread = ActiveThread();
+  if (!thread) {
+    LOG_DEBUGGER(error) << "StepRange called with no active thread.";
+    return false;
+  }
+
+  if (!thread->FetchContextSync(*context_) ||
+      !thread->context->eip.has_value()) {
+    LOG_DEBUGGER(error) << "StepRange: Failed to fetch EIP of active thread.";
+    return false;
+  }
+  uint32_t eip = thread->context->eip.value();
+  if (eip < start || eip >= end) {
+    // A range that does not contain EIP steps a single instruction.
+    return StepInstructionSync(thread, max_wait_milliseconds);
+  }
+
+  // The range is read once so that calls may be identified without fetching
+  // memory on every step.
+  auto code = GetMemory(start, std::min(end - start, kMaxRangeBytes));
+
+  csh handle;
+  if (cs_open(CS_ARCH_X86, CS_MODE_32, &handle) != CS_ERR_OK) {
+    LOG_DEBUGGER(error) << "StepRange: Failed to initialize Capstone";
+    return false;
+  }
+  std::shared_ptr<void> cs_cleanup(nullptr, [&](void*) { cs_close(&handle); });
+
+  auto find_return_address = [&](uint32_t address) {
+    std::optional<uint32_t> ret;
+    if (!code || address - start >= code->size()) {
+      return ret;
+    }
+
+    uint32_t offset = address - start;
+    cs_insn* insn;
+    size_t count = cs_disasm(handle, code->data() + offset,
+                             code->size() - offset, address, 1, &insn);
+    if (count > 0) {
+      if (insn[0].id == X86_INS_CALL) {
+        ret = address + insn[0].size;
+      }
+      cs_free(insn, count);
+    }
+    return ret;
+  };
+
+  for (uint32_t step = 0; step < kMaxRangeSteps; ++step) {
+    auto return_address = find_return_address(eip);
+
+    if (!StepInstructionSync(thread, max_wait_milliseconds)) {
+      return false;
+    }
+    if (!StoppedForSingleStep(thread)) {
+      return true;
+    }
+    eip = thread->last_known_address.value_or(0);
+
+    if (return_address && eip != *return_address) {
+      // Stepped into a callee. Any breakpoint at its entry is reported as
+      // though it had been hit.
+      if (!GetActiveBreakpointsInRange(eip, 1).empty()) {
+        return true;
+      }
+
+      if (!thread->FetchContextSync(*context_) ||
+          !thread->context->esp.has_value()) {
+        LOG_DEBUGGER(error) << "StepRange: Failed to fetch ESP in callee.";
+        return false;
+      }
+      uint32_t callee_esp = thread->context->esp.value();
+
+      bool temporary = GetActiveBreakpointsInRange(*return_address, 1).empty();
+      if (temporary && !AddBreakpoint(*return_address)) {
+        LOG_DEBUGGER(error) << "StepRange: Failed to set breakpoint at return "
+                            << "address " << std::hex << *return_address;
+        return false;
+      }
+
+      bool ok = true;
+      bool returned = false;
+      while (true) {
+        auto last_count = StopEventCount();
+        ok = ContinueThread(thread->thread_id) && Go() &&
+             WaitForStopEvent(last_count, max_wait_milliseconds);
+        if (!ok || thread->last_known_address != return_address) {
+          break;
+        }
+
+        ok = thread->FetchContextSync(*context_) &&
+             thread->context->esp.has_value();
+        if (!ok) {
+          break;
+        }
+        // A recursive call hits the return address in a deeper frame, so the
+        // breakpoint must be stepped over before continuing.
+        if (thread->context->esp.value() > callee_esp) {
+          returned = true;
+          break;
+        }
+        ok = StepInstructionSync(thread, max_wait_milliseconds) &&
+             StoppedForSingleStep(thread);
+        if (!ok) {
+          break;
+        }
+      }
+
+      if (temporary && !RemoveBreakpoint(*return_address)) {
+        LOG_DEBUGGER(warning) << "StepRange: Failed to remove breakpoint at "
+                              << std::hex << *return_address;
+      }
+      if (!ok) {
+        return false;
+      }
+      if (!returned) {
+        return true;
+      }
+      eip = *return_address;
+    }
+
+    if (eip < start || eip >= end) {
+      return true;
+    }
+  }
+
+  LOG_DEBUGGER(warning) << "StepRange: Gave up after " << kMaxRangeSteps
+                        << " steps.";
+  return true;
+}
+
+bool XBDMDebugger::StepInstructionSync(const std::shared_ptr<Thread>& thread,
+                                       uint32_t max_wait_milliseconds) {
+  // The active thread may have been changed by an intervening stop.
+  SetActiveThread(thread->thread_id);
+
+  auto last_count = StopEventCount();
+  if (!StepInstruction()) {
+    return false;
+  }
+  if (!WaitForStopEvent(last_count, max_wait_milliseconds)) {
+    LOG_DEBUGGER(error) << "Timed out waiting for step of thread "
+                        << thread->thread_id;
+    return false;
+  }
+  return true;
+}
+
+bool XBDMDebugger::StoppedForSingleStep(const std::shared_ptr<Thread>& thread) {
+  {
+    std::unique_lock lock(state_lock_);
+    if (last_stop_thread_id_ != thread->thread_id) {
+      return false;
+    }
+  }
+  return thread->last_stop_reason &&
+         thread->last_stop_reason->type == SRT_SINGLE_STEP;
+}
+
 bool XBDMDebugger::ContinueAll(bool no_break_on_exception) {
-  std::list<std::shared_ptr<Thread>> threads = Threads();
-  bool ret = true;
-  for (auto& thread : threads) {
-    if (!thread->Continue(*context_, no_break_on_exception)) {
-      LOG_DEBUGGER(error) << "Failed to continue thread " << thread->thread_id;
-      ret = false;
+  auto threads = Threads();
+  std::vector<std::shared_ptr<RDCPProcessedRequest>> requests;
+  requests.reserve(threads.size());
+  for (auto& [thread_id, thread] : threads) {
+    requests.emplace_back(std::make_shared<::Continue>(thread_id));
+  }
+
+  if (context_->SendBatch(requests)) {
+    return true;
+  }
+
+  auto request = requests.begin();
+  for (auto& [thread_id, thread] : threads) {
+    if (!(*request++)->IsOK()) {
+      LOG_DEBUGGER(error) << "Failed to continue thread " << thread_id;
     }
   }
-  return ret;
+  return false;
 }
 
 bool XBDMDebugger::ContinueThread(uint32_t thread_id,
@@ -1303,7 +1677,7 @@ bool XBDMDebugger::ContinueThread(uint32_t thread_id,
 }
 
 bool XBDMDebugger::HaltAll(uint32_t optimistic_max_wait) {
-  std::list<std::shared_ptr<Thread>> threads = Threads();
+  auto threads = Threads();
   if (threads.empty()) {
     LOG_DEBUGGER(warning) << "HaltAll called with no threads.";
     return true;
@@ -1328,7 +1702,7 @@ bool XBDMDebugger::HaltAll(uint32_t optimistic_max_wait) {
   auto active_thread = GetFirstStoppedThread();
   if (!active_thread) {
     LOG_DEBUGGER(warning) << "No threads stopped after HaltAll";
-    active_thread = threads.front();
+    active_thread = threads.begin()->second;
   }
   SetActiveThread(active_thread->thread_id);
 
@@ -1375,6 +1749,33 @@ DebuggerExpressionParser::MemoryReader XBDMDebugger::CreateMemoryReader() {
   };
 }
 
+void XBDMDebugger::SetSymbolIndex(std::shared_ptr<const SymbolIndex> symbols) {
+  const std::lock_guard lock(symbols_lock_);
+  symbols_ = std::move(symbols);
+}
+
+std::shared_ptr<const SymbolIndex> XBDMDebugger::Symbols() const {
+  const std::lock_guard lock(symbols_lock_);
+  return symbols_;
+}
+
+std::vector<std::shared_ptr<MemoryRegion>> XBDMDebugger::GetReadableRegions(
+    uint32_t start, uint64_t end) {
+  std::vector<std::shared_ptr<MemoryRegion>> ret;
+  std::lock_guard lock(memory_regions_lock_);
+  for (auto& region : memory_regions_) {
+    if (region->protect &
+        (MemoryRegion::PAGE_NOACCESS | MemoryRegion::PAGE_GUARD)) {
+      continue;
+    }
+    uint64_t region_end = static_cast<uint64_t>(region->start) + region->size;
+    if (region_end > start && region->start < end) {
+      ret.push_back(region);
+    }
+  }
+  return ret;
+}
+
 std::vector<uint32_t> XBDMDebugger::GetActiveBreakpointsInRange(
     uint32_t address, uint32_t length) {
   std::vector<uint32_t> overlaps;
@@ -1390,37 +1791,94 @@ std::vector<uint32_t> XBDMDebugger::GetActiveBreakpointsInRange(
 
 void XBDMDebugger::SuspendBreakpoints(
     const std::vector<uint32_t>& breakpoints) {
+  if (breakpoints.empty()) {
+    return;
+  }
+  {
+    std::lock_guard lock(breakpoints_lock_);
+    for (uint32_t bp : breakpoints) {
+      ++suspended_breakpoints_[bp];
+    }
+  }
+
+  std::vector<std::shared_ptr<RDCPProcessedRequest>> requests;
+  requests.reserve(breakpoints.size());
   for (uint32_t bp : breakpoints) {
-    auto request = std::make_shared<BreakAddress>(bp, true);
-    context_->SendCommandSync(request);
-    if (!request->IsOK()) {
+    requests.emplace_back(std::make_shared<BreakAddress>(bp, true));
+  }
+  if (context_->SendBatch(requests)) {
+    return;
+  }
+
+  for (size_t i = 0; i < requests.size(); ++i) {
+    if (!requests[i]->IsOK()) {
       LOG_DEBUGGER(error) << "Failed to remove transparent breakpoint at "
-                          << std::hex << bp;
+                          << std::hex << breakpoints[i];
     }
   }
 }
 
 void XBDMDebugger::RestoreBreakpoints(const std::vector<uint32_t>& breakpoints,
                                       bool wait) {
-  for (uint32_t bp : breakpoints) {
-    auto restore_request = std::make_shared<BreakAddress>(bp, false);
-    if (wait) {
-      context_->SendCommandSync(restore_request);
-      if (!restore_request->IsOK()) {
-        LOG_DEBUGGER(error)
-            << "Failed to restore transparent breakpoint at " << std::hex << bp;
-      }
-    } else {
-      context_->SendCommand(restore_request);
-    }
+  std::vector<uint32_t> restorable;
+  {
+    std::lock_guard lock(breakpoints_lock_);
+    restorable = ReleaseBreakpointSuspensions(breakpoints);
   }
+  SendBreakpointRestores(restorable, wait);
 }
 
-std::optional<std::vector<uint8_t>> XBDMDebugger::GetMemory(uint32_t address,
-                                                            uint32_t length,
-                                                            bool validate) {
-  if (validate && !ValidateMemoryAccess(address, length)) {
-    return std::nullopt;
+std::vector<uint32_t> XBDMDebugger::ReleaseBreakpointSuspensions(
+    const std::vector<uint32_t>& breakpoints) {
+  std::vector<uint32_t> ret;
+  for (uint32_t bp : breakpoints) {
+    auto it = suspended_breakpoints_.find(bp);
+    if (it == suspended_breakpoints_.end()) {
+      // Suspensions are discarded when the target reboots.
+      continue;
+    }
+    if (!--it->second) {
+      suspended_breakpoints_.erase(it);
+      ret.push_back(bp);
+    }
+  }
+  return ret;
+}
+
+void XBDMDebugger::SendBreakpointRestores(
+    const std::vector<uint32_t>& breakpoints, bool wait) {
+  if (breakpoints.empty()) {
+    return;
+  }
+  if (!wait) {
+    for (uint32_t bp : breakpoints) {
+      context_->SendCommand(std::make_shared<BreakAddress>(bp, false));
+    }
+    return;
+  }
+
+  std::vector<std::shared_ptr<RDCPProcessedRequest>> requests;
+  requests.reserve(breakpoints.size());
+  for (uint32_t bp : breakpoints) {
+    requests.emplace_back(std::make_shared<BreakAddress>(bp, false));
+  }
+  if (context_->SendBatch(requests)) {
+    return;
+  }
+
+  for (size_t i = 0; i < requests.size(); ++i) {
+    if (!requests[i]->IsOK()) {
+      LOG_DEBUGGER(error) << "Failed to restore transparent breakpoint at "
+                          << std::hex << breakpoints[i];
+    }
+  }
+}
+
+std::optional<std::vector<uint8_t>> XBDMDebugger::GetMemory(uint32_t address,
+                                                            uint32_t length,
+                                                            bool validate) {
+  if (validate && !ValidateMemoryAccess(address, length)) {
+    return std::nullopt;
   }
 
   std::vector<uint32_t> overlaps = GetActiveBreakpointsInRange(address, length);
@@ -1440,6 +1898,115 @@ std::optional<std::vector<uint8_t>> XBDMDebugger::GetMemory(uint32_t address,
   return request->data;
 }
 
+std::vector<cs_insn> XBDMDebugger::Disassemble(uint32_t address,
+                                               uint32_t count) {
+  const std::lock_guard lock(code_cache_lock_);
+  return code_cache_.Disassemble(
+      address, count,
+      [this](uint32_t page_address) { return ReadCodePage(page_address); });
+}
+
+void XBDMDebugger::InvalidateCode(uint32_t address, uint32_t length) {
+  if (!length) {
+    return;
+  }
+
+  const std::lock_guard lock(code_cache_lock_);
+  code_cache_.Invalidate(address, length);
+
+  uint64_t end = static_cast<uint64_t>(address) + length;
+  std::erase_if(code_prefetches_, [address, end](const auto& entry) {
+    uint64_t page_end =
+        static_cast<uint64_t>(entry.first) + DisassemblyCache::kPageSize;
+    return entry.first < end && page_end > address;
+  });
+}
+
+void XBDMDebugger::ResetCodeCache() {
+  const std::lock_guard lock(code_cache_lock_);
+  code_cache_.Reset();
+  code_prefetches_.clear();
+}
+
+uint32_t XBDMDebugger::GetReadableCodeLength(uint32_t page_address) {
+  std::lock_guard lock(memory_regions_lock_);
+  if (memory_regions_.empty()) {
+    return DisassemblyCache::kPageSize;
+  }
+
+  // Regions are sorted by address, so adjacent regions extend the readable
+  // range in order.
+  uint64_t readable_end = page_address;
+  for (auto& region : memory_regions_) {
+    if (region->protect &
+        (MemoryRegion::PAGE_NOACCESS | MemoryRegion::PAGE_GUARD)) {
+      continue;
+    }
+    uint64_t region_end = static_cast<uint64_t>(region->start) + region->size;
+    if (region->start <= readable_end && region_end > readable_end) {
+      readable_end = region_end;
+    }
+  }
+
+  return static_cast<uint32_t>(
+      std::min<uint64_t>(readable_end - page_address,
+                         DisassemblyCache::kPageSize));
+}
+
+std::optional<std::vector<uint8_t>> XBDMDebugger::ReadCodePage(
+    uint32_t page_address) {
+  auto prefetch = code_prefetches_.find(page_address);
+  if (prefetch != code_prefetches_.end()) {
+    auto [generation, request] = prefetch->second;
+    code_prefetches_.erase(prefetch);
+
+    request->WaitUntilCompleted();
+    if (request->IsOK() && generation == code_cache_.Generation() &&
+        !request->data.empty()) {
+      return request->data;
+    }
+  }
+
+  auto length = GetReadableCodeLength(page_address);
+  if (!length) {
+    return std::nullopt;
+  }
+  return GetMemory(page_address, length, false);
+}
+
+void XBDMDebugger::PrefetchCode(uint32_t address) {
+  uint32_t page_address = address & ~(DisassemblyCache::kPageSize - 1);
+  uint32_t next_page = page_address + DisassemblyCache::kPageSize;
+  if (!next_page || next_page - address > kCodePrefetchThreshold) {
+    return;
+  }
+
+  // Only code that is already being disassembled is worth prefetching.
+  const std::lock_guard lock(code_cache_lock_);
+  if (!code_cache_.Contains(page_address) || code_cache_.Contains(next_page) ||
+      code_prefetches_.contains(next_page)) {
+    return;
+  }
+
+  auto length = GetReadableCodeLength(next_page);
+  if (!length) {
+    return;
+  }
+
+  std::vector<uint32_t> overlaps =
+      GetActiveBreakpointsInRange(next_page, length);
+  SuspendBreakpoints(overlaps);
+
+  auto request = std::make_shared<GetMemBinary>(next_page, length);
+  context_->SendCommand(request);
+
+  // Requests are processed in order, so the breakpoints are not restored
+  // until the read has completed.
+  RestoreBreakpoints(overlaps, false);
+
+  code_prefetches_[next_page] = {code_cache_.Generation(), request};
+}
+
 std::optional<uint32_t> XBDMDebugger::GetDWORD(uint32_t address) {
   auto raw = GetMemory(address, 4);
   if (!raw.has_value()) {
@@ -1449,6 +2016,376 @@ std::optional<uint32_t> XBDMDebugger::GetDWORD(uint32_t address) {
   return *reinterpret_cast<uint32_t*>(raw->data());
 }
 
+XBDMDebugger::MemorySearchResult XBDMDebugger::SearchMemory(
+    const MemorySearchPattern& pattern, uint32_t start, uint64_t end,
+    size_t max_hits) {
+  MemorySearchResult result;
+  if (!max_hits || start >= end) {
+    return result;
+  }
+  if (!FetchMemoryMap()) {
+    return result;
+  }
+
+  auto regions = GetReadableRegions(start, end);
+
+  // Adjacent regions are scanned as a single span so that matches crossing
+  // region boundaries are found.
+  std::vector<std::pair<uint64_t, uint64_t>> spans;
+  for (auto& region : regions) {
+    uint64_t span_start = std::max<uint64_t>(region->start, start);
+    uint64_t span_end = std::min<uint64_t>(
+        static_cast<uint64_t>(region->start) + region->size, end);
+    if (!spans.empty() && spans.back().second == span_start) {
+      spans.back().second = span_end;
+    } else {
+      spans.emplace_back(span_start, span_end);
+    }
+  }
+  result.regions_scanned = regions.size();
+
+  struct ChunkRead {
+    uint64_t address;
+    std::shared_ptr<GetMemBinary> request;
+  };
+
+  std::vector<uint32_t> addresses;
+  for (auto& [span_start, span_end] : spans) {
+    auto breakpoints = GetActiveBreakpointsInRange(
+        static_cast<uint32_t>(span_start),
+        static_cast<uint32_t>(span_end - span_start));
+    SuspendBreakpoints(breakpoints);
+
+    uint64_t next_address = span_start;
+    auto request_next_chunk = [&]() -> std::optional<ChunkRead> {
+      if (next_address >= span_end) {
+        return std::nullopt;
+      }
+      auto length = static_cast<uint32_t>(
+          std::min<uint64_t>(kMemorySearchChunkSize, span_end - next_address));
+      ChunkRead read{next_address, std::make_shared<GetMemBinary>(
+                                       static_cast<uint32_t>(next_address),
+                                       length)};
+      context_->SendCommand(read.request);
+      next_address += length;
+      return read;
+    };
+
+    // Holds the tail of the previous chunk followed by the current one, so
+    // that matches crossing chunk boundaries are found.
+    std::vector<uint8_t> buffer;
+    uint64_t buffer_address = span_start;
+
+    auto pending = request_next_chunk();
+    while (pending && !result.truncated) {
+      auto current = std::move(*pending);
+      current.request->WaitUntilCompleted();
+      pending = request_next_chunk();
+
+      if (!current.request->IsOK()) {
+        LOG_DEBUGGER(warning) << "Failed to read memory at " << std::hex
+                              << current.address << std::dec
+                              << " during search";
+        ++result.failed_reads;
+        buffer.clear();
+        continue;
+      }
+
+      auto& data = current.request->data;
+      if (buffer.empty() || buffer_address + buffer.size() != current.address) {
+        buffer.clear();
+        buffer_address = current.address;
+      }
+      buffer.insert(buffer.end(), data.begin(), data.end());
+      result.bytes_scanned += data.size();
+
+      if (!pattern.Scan(buffer.data(), buffer.size(),
+                        static_cast<uint32_t>(buffer_address), addresses,
+                        max_hits)) {
+        result.truncated = true;
+      }
+
+      auto keep = std::min(buffer.size(), pattern.Size() - 1);
+      buffer.erase(buffer.begin(),
+                   buffer.end() - static_cast<ptrdiff_t>(keep));
+      buffer_address = current.address + data.size() - keep;
+    }
+
+    if (pending) {
+      pending->request->WaitUntilCompleted();
+    }
+    RestoreBreakpoints(breakpoints);
+
+    if (result.truncated) {
+      break;
+    }
+  }
+
+  for (auto address : addresses) {
+    auto region = std::find_if(regions.begin(), regions.end(),
+                               [address](const auto& region) {
+                                 return region->Contains(address);
+                               });
+    result.hits.push_back(
+        {address, region == regions.end() ? nullptr : *region});
+  }
+
+  return result;
+}
+
+XBDMDebugger::MemorySnapshotResult XBDMDebugger::CaptureMemorySnapshot(
+    const std::shared_ptr<MemorySnapshot>& baseline, uint32_t block_size) {
+  MemorySnapshotResult result;
+  if (baseline) {
+    block_size = baseline->BlockSize();
+  }
+  if (!FetchMemoryMap()) {
+    return result;
+  }
+
+  // XBDM allocates memory in whole pages, so regions that are not block
+  // aligned are not expected in practice.
+  auto regions = GetReadableRegions(0, 0x100000000ULL);
+  std::erase_if(regions, [block_size](const auto& region) {
+    if (!(region->start % block_size) && !(region->size % block_size)) {
+      return false;
+    }
+    LOG_DEBUGGER(warning) << "Skipping unaligned region at " << std::hex
+                          << region->start << " in snapshot";
+    return true;
+  });
+
+  std::vector<uint32_t> breakpoints;
+  for (auto& region : regions) {
+    auto overlaps = GetActiveBreakpointsInRange(region->start, region->size);
+    breakpoints.insert(breakpoints.end(), overlaps.begin(), overlaps.end());
+  }
+  SuspendBreakpoints(breakpoints);
+
+  // Request every checksum up front so that the target can process them
+  // while earlier responses are being handled.
+  std::vector<std::shared_ptr<GetChecksum>> checksum_requests;
+  for (auto& region : regions) {
+    auto request =
+        std::make_shared<GetChecksum>(region->start, region->size, block_size);
+    context_->SendCommand(request);
+    checksum_requests.push_back(request);
+  }
+
+  struct BlockRead {
+    size_t first_block;
+    uint32_t block_count;
+    std::shared_ptr<GetMemBinary> request;
+  };
+  std::vector<BlockRead> reads;
+
+  auto snapshot = std::make_shared<MemorySnapshot>(block_size);
+  std::optional<size_t> run_start;
+  uint32_t run_length = 0;
+  auto flush_run = [&]() {
+    if (!run_length) {
+      return;
+    }
+    auto address = snapshot->Blocks()[*run_start].address;
+    auto request =
+        std::make_shared<GetMemBinary>(address, run_length * block_size);
+    context_->SendCommand(request);
+    reads.push_back({*run_start, run_length, request});
+    run_start.reset();
+    run_length = 0;
+  };
+
+  for (size_t i = 0; i < regions.size(); ++i) {
+    auto& region = regions[i];
+    auto& request = checksum_requests[i];
+    request->WaitUntilCompleted();
+    if (!request->IsOK() ||
+        request->checksums.size() != region->size / block_size) {
+      LOG_DEBUGGER(warning) << "Failed to fetch checksums for region at "
+                            << std::hex << region->start;
+      ++result.failed_reads;
+      continue;
+    }
+
+    for (size_t j = 0; j < request->checksums.size(); ++j) {
+      auto address = region->start + static_cast<uint32_t>(j) * block_size;
+      auto checksum = request->checksums[j];
+      auto index = snapshot->AddBlock(address, checksum);
+
+      if (baseline) {
+        auto baseline_index = baseline->FindBlock(address);
+        if (baseline_index.has_value() &&
+            baseline->Blocks()[*baseline_index].checksum == checksum) {
+          memcpy(snapshot->BlockData(index),
+                 baseline->BlockData(*baseline_index), block_size);
+          ++result.blocks_reused;
+          flush_run();
+          continue;
+        }
+      }
+
+      if (!run_length) {
+        run_start = index;
+      }
+      ++run_length;
+      if (run_length * block_size >= kMemorySnapshotReadSize) {
+        flush_run();
+      }
+    }
+    flush_run();
+  }
+
+  std::vector<bool> failed_blocks(snapshot->BlockCount(), false);
+  bool any_failed = false;
+  for (auto& read : reads) {
+    read.request->WaitUntilCompleted();
+    auto& data = read.request->data;
+    if (!read.request->IsOK() || data.size() != read.block_count * block_size) {
+      LOG_DEBUGGER(warning)
+          << "Failed to read memory at " << std::hex
+          << snapshot->Blocks()[read.first_block].address << " for snapshot";
+      ++result.failed_reads;
+      any_failed = true;
+      std::fill_n(failed_blocks.begin() +
+                      static_cast<ptrdiff_t>(read.first_block),
+                  read.block_count, true);
+      continue;
+    }
+
+    memcpy(snapshot->BlockData(read.first_block), data.data(), data.size());
+    result.blocks_downloaded += read.block_count;
+  }
+
+  RestoreBreakpoints(breakpoints);
+
+  if (any_failed) {
+    auto complete = std::make_shared<MemorySnapshot>(block_size);
+    for (size_t i = 0; i < snapshot->BlockCount(); ++i) {
+      if (failed_blocks[i]) {
+        continue;
+      }
+      auto& block = snapshot->Blocks()[i];
+      auto index = complete->AddBlock(block.address, block.checksum);
+      memcpy(complete->BlockData(index), snapshot->BlockData(i), block_size);
+    }
+    snapshot = complete;
+  }
+
+  result.snapshot = snapshot;
+  return result;
+}
+
+std::expected<XBDMDebugger::CoreDumpResult, std::string>
+XBDMDebugger::WriteCoreDump(std::ostream& out) {
+  CoreDumpResult result;
+
+  std::vector<ElfCoreThread> threads;
+  for (auto& [thread_id, thread] : Threads()) {
+    if (!thread->FetchContextSync(*context_)) {
+      LOG_DEBUGGER(warning) << "Failed to fetch context for thread "
+                            << thread->thread_id << " for core dump";
+      continue;
+    }
+    ElfCoreThread entry{thread->thread_id, *thread->context, std::nullopt,
+                        thread->stopped};
+    if (thread->FetchFloatContextSync(*context_)) {
+      entry.float_context = thread->float_context;
+    }
+    threads.push_back(entry);
+  }
+  result.threads = threads.size();
+
+  if (!FetchMemoryMap()) {
+    return std::unexpected("Failed to fetch memory map");
+  }
+  auto regions = GetReadableRegions(0, 0x100000000ULL);
+  result.regions = regions.size();
+
+  std::vector<ElfCoreSegment> segments;
+  std::vector<uint32_t> breakpoints;
+  for (auto& region : regions) {
+    segments.push_back({region->start, region->size, region->protect});
+    auto overlaps = GetActiveBreakpointsInRange(region->start, region->size);
+    breakpoints.insert(breakpoints.end(), overlaps.begin(), overlaps.end());
+  }
+
+  auto header = BuildElfCoreHeader(threads, segments);
+  if (!header.has_value()) {
+    return std::unexpected(header.error());
+  }
+  out.write(reinterpret_cast<const char*>(header->data()),
+            static_cast<std::streamsize>(header->size()));
+  result.bytes_written += header->size();
+
+  SuspendBreakpoints(breakpoints);
+
+  // Chunks are written in order, with up to kCoreDumpReadsInFlight requests
+  // outstanding so that the connection is kept busy while writing.
+  struct ChunkRead {
+    uint32_t address;
+    std::shared_ptr<GetMemBinary> request;
+  };
+  std::deque<ChunkRead> in_flight;
+  auto region = regions.begin();
+  uint64_t next_address = regions.empty() ? 0 : (*region)->start;
+  auto request_next_chunk = [&]() {
+    while (region != regions.end() &&
+           next_address >= static_cast<uint64_t>((*region)->start) +
+                               (*region)->size) {
+      if (++region != regions.end()) {
+        next_address = (*region)->start;
+      }
+    }
+    if (region == regions.end()) {
+      return false;
+    }
+
+    auto length = static_cast<uint32_t>(std::min<uint64_t>(
+        kCoreDumpChunkSize,
+        static_cast<uint64_t>((*region)->start) + (*region)->size -
+            next_address));
+    ChunkRead read{static_cast<uint32_t>(next_address),
+                   std::make_shared<GetMemBinary>(
+                       static_cast<uint32_t>(next_address), length)};
+    context_->SendCommand(read.request);
+    in_flight.push_back(read);
+    next_address += length;
+    return true;
+  };
+
+  while (in_flight.size() < kCoreDumpReadsInFlight && request_next_chunk()) {
+  }
+
+  while (!in_flight.empty() && out) {
+    auto read = in_flight.front();
+    in_flight.pop_front();
+    auto& request = read.request;
+    request->WaitUntilCompleted();
+    request_next_chunk();
+
+    auto& data = request->data;
+    if (!request->IsOK() || data.size() != request->length) {
+      LOG_DEBUGGER(warning) << "Failed to read memory at " << std::hex
+                            << read.address << " for core dump";
+      ++result.failed_reads;
+      data.assign(request->length, 0);
+    }
+    out.write(reinterpret_cast<const char*>(data.data()),
+              static_cast<std::streamsize>(data.size()));
+    result.bytes_written += data.size();
+  }
+
+  for (auto& read : in_flight) {
+    read.request->WaitUntilCompleted();
+  }
+  RestoreBreakpoints(breakpoints);
+
+  if (!out) {
+    return std::unexpected("Failed to write core dump");
+  }
+  return result;
+}
+
 bool XBDMDebugger::SetMemory(uint32_t address,
                              const std::vector<uint8_t>& data) {
   if (!ValidateMemoryAccess(address, data.size(), true)) {
@@ -1457,6 +2394,7 @@ bool XBDMDebugger::SetMemory(uint32_t address,
 
   auto request = std::make_shared<SetMem>(address, data);
   context_->SendCommandSync(request);
+  InvalidateCode(address, data.size());
   return request->IsOK();
 }
 
@@ -1479,6 +2417,19 @@ void XBDMDebugger::RemoveBreakpointCondition(BreakpointType breakpoint_type,
   breakpoint_conditions_.erase(std::make_pair(breakpoint_type, address));
 }
 
+void XBDMDebugger::SetBreakpointConditionEvaluators(
+    BreakpointType breakpoint_type, uint32_t address,
+    std::vector<ConditionEvaluator> evaluators) {
+  std::lock_guard lock(conditions_lock_);
+  auto key = std::make_pair(breakpoint_type, address);
+
+  if (evaluators.empty()) {
+    breakpoint_condition_evaluators_.erase(key);
+  } else {
+    breakpoint_condition_evaluators_[key] = std::move(evaluators);
+  }
+}
+
 std::optional<std::string> XBDMDebugger::FindBreakpointCondition(
     BreakpointType breakpoint_type, uint32_t address) const {
   std::lock_guard lock(conditions_lock_);
@@ -1492,7 +2443,16 @@ std::optional<std::string> XBDMDebugger::FindBreakpointCondition(
 }
 
 bool XBDMDebugger::AddBreakpoint(uint32_t address) {
+  // Code reads hold code_cache_lock_ while taking breakpoints_lock_, so the
+  // cache must be invalidated first.
+  InvalidateCode(address, 1);
   std::lock_guard lock(breakpoints_lock_);
+  // The breakpoint is already set on behalf of a tracepoint, so just take
+  // ownership of it.
+  if (tracepoint_only_breakpoints_.erase(address)) {
+    return true;
+  }
+
   auto request = std::make_shared<BreakAddress>(address);
   context_->SendCommandSync(request);
   if (request->IsOK()) {
@@ -1515,7 +2475,15 @@ bool XBDMDebugger::AddWriteWatch(uint32_t address, uint32_t length) {
 }
 
 bool XBDMDebugger::RemoveBreakpoint(uint32_t address) {
+  InvalidateCode(address, 1);
   std::lock_guard lock(breakpoints_lock_);
+  // Leave the breakpoint in place for an armed tracepoint, to be removed when
+  // tracing stops.
+  if (traced_addresses_.contains(address)) {
+    tracepoint_only_breakpoints_.insert(address);
+    return true;
+  }
+
   auto request = std::make_shared<BreakAddress>(address, true);
   context_->SendCommandSync(request);
   if (request->IsOK()) {
@@ -1573,3 +2541,274 @@ std::shared_ptr<Module> XBDMDebugger::GetModule(
   }
   return nullptr;
 }
+
+void XBDMDebugger::SetTracepoint(Tracepoint tracepoint) {
+  std::lock_guard lock(tracepoints_lock_);
+  auto number = tracepoint.number;
+  tracepoints_[number] = std::move(tracepoint);
+}
+
+std::optional<XBDMDebugger::Tracepoint> XBDMDebugger::GetTracepoint(
+    uint32_t number) {
+  std::lock_guard lock(tracepoints_lock_);
+  auto entry = tracepoints_.find(number);
+  if (entry == tracepoints_.end()) {
+    return std::nullopt;
+  }
+  return entry->second;
+}
+
+std::vector<XBDMDebugger::Tracepoint> XBDMDebugger::Tracepoints() {
+  std::lock_guard lock(tracepoints_lock_);
+  std::vector<Tracepoint> ret;
+  ret.reserve(tracepoints_.size());
+  for (auto& [number, tracepoint] : tracepoints_) {
+    ret.push_back(tracepoint);
+  }
+  return ret;
+}
+
+uint32_t XBDMDebugger::NextTracepointNumber() {
+  std::lock_guard lock(tracepoints_lock_);
+  if (tracepoints_.empty()) {
+    return 1;
+  }
+  return tracepoints_.rbegin()->first + 1;
+}
+
+bool XBDMDebugger::RemoveTracepoint(uint32_t number) {
+  std::lock_guard lock(tracepoints_lock_);
+  return tracepoints_.erase(number) != 0;
+}
+
+void XBDMDebugger::ClearTracepoints() {
+  StopTracing();
+
+  std::lock_guard lock(tracepoints_lock_);
+  tracepoints_.clear();
+  trace_frames_.clear();
+  trace_status_.frames = 0;
+  trace_status_.buffer_used = 0;
+  trace_status_.stop_reason = TraceStopReason::NOT_RUN;
+}
+
+bool XBDMDebugger::StartTracing() {
+  std::set<uint32_t> addresses;
+  {
+    std::lock_guard lock(tracepoints_lock_);
+    if (trace_status_.running) {
+      return false;
+    }
+
+    trace_frames_.clear();
+    trace_status_.frames = 0;
+    trace_status_.buffer_used = 0;
+    trace_status_.stop_tracepoint = 0;
+    for (auto& [number, tracepoint] : tracepoints_) {
+      tracepoint.hits = 0;
+      tracepoint.frames = 0;
+      tracepoint.buffer_used = 0;
+      tracepoint.total_overhead_us = 0;
+      tracepoint.max_overhead_us = 0;
+      if (tracepoint.enabled) {
+        addresses.insert(tracepoint.address);
+      }
+    }
+    trace_status_.running = true;
+  }
+
+  bool ret = true;
+  std::lock_guard lock(breakpoints_lock_);
+  for (auto address : addresses) {
+    traced_addresses_.insert(address);
+    if (breakpoints_.contains(address)) {
+      continue;
+    }
+
+    auto request = std::make_shared<BreakAddress>(address);
+    context_->SendCommandSync(request);
+    if (!request->IsOK()) {
+      LOG_DEBUGGER(error) << "Failed to set tracepoint breakpoint at "
+                          << std::hex << address << std::dec;
+      ret = false;
+      continue;
+    }
+    breakpoints_.insert(address);
+    tracepoint_only_breakpoints_.insert(address);
+  }
+
+  return ret;
+}
+
+void XBDMDebugger::StopTracing() {
+  StopTracing(TraceStopReason::REQUESTED, 0);
+}
+
+void XBDMDebugger::StopTracing(TraceStopReason reason, uint32_t tracepoint) {
+  {
+    std::lock_guard lock(tracepoints_lock_);
+    if (!trace_status_.running) {
+      return;
+    }
+    trace_status_.running = false;
+    trace_status_.stop_reason = reason;
+    trace_status_.stop_tracepoint = tracepoint;
+  }
+
+  DisarmTracepoints();
+}
+
+void XBDMDebugger::DisarmTracepoints() {
+  std::lock_guard lock(breakpoints_lock_);
+  for (auto address : tracepoint_only_breakpoints_) {
+    auto request = std::make_shared<BreakAddress>(address, true);
+    context_->SendCommandSync(request);
+    if (!request->IsOK()) {
+      LOG_DEBUGGER(error) << "Failed to remove tracepoint breakpoint at "
+                          << std::hex << address << std::dec;
+    }
+    breakpoints_.erase(address);
+  }
+  tracepoint_only_breakpoints_.clear();
+  traced_addresses_.clear();
+}
+
+XBDMDebugger::TraceStatus XBDMDebugger::GetTraceStatus() {
+  std::lock_guard lock(tracepoints_lock_);
+  return trace_status_;
+}
+
+std::optional<TraceFrame> XBDMDebugger::GetTraceFrame(size_t index) {
+  std::lock_guard lock(tracepoints_lock_);
+  if (index >= trace_frames_.size()) {
+    return std::nullopt;
+  }
+  return trace_frames_[index];
+}
+
+void XBDMDebugger::SetTraceBufferSize(size_t bytes) {
+  std::lock_guard lock(tracepoints_lock_);
+  trace_status_.buffer_size = bytes;
+}
+
+bool XBDMDebugger::ProcessTracepointHit(const std::shared_ptr<Thread>& thread,
+                                        uint32_t address) {
+  Timer timer;
+
+  std::vector<Tracepoint> hit_tracepoints;
+  {
+    std::lock_guard lock(tracepoints_lock_);
+    if (!trace_status_.running) {
+      return false;
+    }
+    for (auto& [number, tracepoint] : tracepoints_) {
+      if (tracepoint.enabled && tracepoint.address == address) {
+        hit_tracepoints.push_back(tracepoint);
+      }
+    }
+  }
+  if (hit_tracepoints.empty()) {
+    return false;
+  }
+
+  bool has_user_breakpoint;
+  {
+    std::lock_guard lock(breakpoints_lock_);
+    has_user_breakpoint = breakpoints_.contains(address) &&
+                          !tracepoint_only_breakpoints_.contains(address);
+  }
+
+  std::vector<TraceFrame> frames;
+  if (thread->FetchContextSync(*context_) && thread->context.has_value()) {
+    auto memory_reader = CreateMemoryReader();
+    for (auto& tracepoint : hit_tracepoints) {
+      bool collect = tracepoint.conditions.empty();
+      for (auto& condition : tracepoint.conditions) {
+        auto result =
+            condition(*thread->context, thread->thread_id, memory_reader);
+        if (!result.has_value() || *result) {
+          collect = true;
+          break;
+        }
+      }
+      if (!collect) {
+        continue;
+      }
+
+      TraceFrame frame{tracepoint.number, thread->thread_id, address};
+      for (auto& action : tracepoint.actions) {
+        auto result =
+            action(*thread->context, thread->thread_id, memory_reader, frame);
+        if (!result.has_value()) {
+          LOG_DEBUGGER(warning)
+              << "Tracepoint " << tracepoint.number
+              << " failed to collect data: '" << result.error() << "'";
+        }
+      }
+      frames.push_back(std::move(frame));
+    }
+  } else {
+    LOG_DEBUGGER(warning) << "Failed to fetch context for tracepoint hit at "
+                          << std::hex << address << std::dec;
+  }
+
+  if (!has_user_breakpoint) {
+    ContinueThread(thread->thread_id);
+    if (!Go()) {
+      LOG_DEBUGGER(warning) << "Failed to go after tracepoint hit";
+    }
+  }
+
+  auto overhead = static_cast<uint64_t>(timer.MicrosecondsElapsed());
+  std::optional<std::pair<TraceStopReason, uint32_t>> stop_reason;
+  {
+    std::lock_guard lock(tracepoints_lock_);
+    for (auto& hit : hit_tracepoints) {
+      auto entry = tracepoints_.find(hit.number);
+      if (entry == tracepoints_.end()) {
+        continue;
+      }
+      auto& tracepoint = entry->second;
+      ++tracepoint.hits;
+      tracepoint.total_overhead_us += overhead;
+      tracepoint.max_overhead_us =
+          std::max(tracepoint.max_overhead_us, overhead);
+    }
+
+    for (auto& frame : frames) {
+      if (!trace_status_.running || stop_reason) {
+        break;
+      }
+
+      auto size = frame.Size();
+      if (trace_status_.buffer_used + size > trace_status_.buffer_size) {
+        stop_reason = std::make_pair(TraceStopReason::BUFFER_FULL, 0);
+        break;
+      }
+
+      auto entry = tracepoints_.find(frame.tracepoint);
+      if (entry != tracepoints_.end()) {
+        auto& tracepoint = entry->second;
+        ++tracepoint.frames;
+        tracepoint.buffer_used += size;
+        if (tracepoint.pass_count &&
+            tracepoint.frames >= tracepoint.pass_count) {
+          stop_reason = std::make_pair(TraceStopReason::PASS_COUNT,
+                                       tracepoint.number);
+        }
+      }
+
+      trace_status_.buffer_used += size;
+      trace_frames_.push_back(std::move(frame));
+      trace_status_.frames = trace_frames_.size();
+    }
+  }
+
+  if (stop_reason) {
+    LOG_DEBUGGER(info) << "Tracing stopped after tracepoint hit at "
+                       << std::hex << address << std::dec;
+    StopTracing(stop_reason->first, stop_reason->second);
+  }
+
+  return !has_user_breakpoint;
+}
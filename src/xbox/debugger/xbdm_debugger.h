@@ -1,7 +1,10 @@
 #ifndef XBDM_GDB_BRIDGE_SRC_XBOX_DEBUGGER_DEBUGGER_H_
 #define XBDM_GDB_BRIDGE_SRC_XBOX_DEBUGGER_DEBUGGER_H_
 
+#include <atomic>
 #include <condition_variable>
+#include <expected>
+#include <functional>
 #include <list>
 #include <map>
 #include <memory>
@@ -11,12 +14,19 @@
 #include <string>
 
 #include "debugger_expression_parser.h"
+#include "debugstr_sink.h"
+#include "disassembly_cache.h"
+#include "elf_core.h"
+#include "memory_search.h"
+#include "memory_snapshot.h"
 #include "rdcp/types/execution_state.h"
 #include "rdcp/types/memory_region.h"
 #include "rdcp/types/module.h"
 #include "rdcp/types/section.h"
 #include "rdcp/xbdm_requests.h"
+#include "symbol_index.h"
 #include "thread.h"
+#include "tracepoint.h"
 
 class XBDMContext;
 class XBDMNotification;
@@ -37,6 +47,23 @@ class XBDMDebugger {
  public:
   static constexpr uint32_t kDefaultHaltAllMaxWaitMilliseconds = 250;
   static constexpr uint32_t kAttachSafeStateMaxWaitMilliseconds = 250;
+  static constexpr uint32_t kDefaultStepMaxWaitMilliseconds = 1000;
+  static constexpr size_t kDefaultTraceBufferSize = 4 * 1024 * 1024;
+  //! The number of bytes requested by each read made by SearchMemory.
+  static constexpr uint32_t kMemorySearchChunkSize = 1024 * 1024;
+  static constexpr size_t kDefaultMemorySearchMaxHits = 1000;
+  //! The maximum number of bytes requested by each read made by
+  //! CaptureMemorySnapshot.
+  static constexpr uint32_t kMemorySnapshotReadSize = 1024 * 1024;
+  //! The size of each read made by WriteCoreDump and the maximum number of
+  //! reads that may be outstanding at once.
+  static constexpr uint32_t kCoreDumpChunkSize = 1024 * 1024;
+  static constexpr uint32_t kCoreDumpReadsInFlight = 4;
+
+  //! Notification ordering key used by the debugger. Handlers that rely on the
+  //! debugger's view of thread and module state should share it so that they
+  //! never run concurrently with the debugger's own handler.
+  static constexpr const char kNotificationOrderingKey[] = "debugger";
 
   enum class BreakpointType {
     BREAKPOINT,
@@ -53,6 +80,90 @@ class XBDMDebugger {
                                  // created.
   };
 
+  //! Evaluates a compiled condition against the context of a thread that has
+  //! hit a breakpoint, returning true if the thread should stop.
+  typedef std::function<std::expected<bool, std::string>(
+      const ThreadContext& context, uint32_t thread_id,
+      const DebuggerExpressionParser::MemoryReader& memory_reader)>
+      ConditionEvaluator;
+
+  //! A breakpoint that records a TraceFrame and immediately resumes the thread
+  //! rather than stopping it.
+  struct Tracepoint {
+    uint32_t number{0};
+    uint32_t address{0};
+    bool enabled{true};
+    //! Tracing stops once this many frames have been collected for this
+    //! tracepoint. 0 means unlimited.
+    uint64_t pass_count{0};
+    //! If non-empty, a frame is only collected if any condition is true.
+    std::vector<ConditionEvaluator> conditions;
+    std::vector<TraceAction> actions;
+    std::vector<std::string> action_descriptions;
+
+    //! Statistics for the current or most recent tracing run.
+    uint64_t hits{0};
+    uint64_t frames{0};
+    //! Bytes of trace buffer used by this tracepoint's frames.
+    uint64_t buffer_used{0};
+    //! Time spent handling hits, from processing the notification until the
+    //! thread was resumed.
+    uint64_t total_overhead_us{0};
+    uint64_t max_overhead_us{0};
+  };
+
+  enum class TraceStopReason {
+    NOT_RUN,
+    REQUESTED,
+    PASS_COUNT,
+    BUFFER_FULL,
+    TARGET_REBOOTED,
+  };
+
+  struct TraceStatus {
+    bool running{false};
+    TraceStopReason stop_reason{TraceStopReason::NOT_RUN};
+    //! The tracepoint that stopped tracing due to its pass count.
+    uint32_t stop_tracepoint{0};
+    size_t frames{0};
+    size_t buffer_size{kDefaultTraceBufferSize};
+    size_t buffer_used{0};
+  };
+
+  struct MemorySearchResult {
+    struct Hit {
+      uint32_t address;
+      //! The region containing the start of the match.
+      std::shared_ptr<MemoryRegion> region;
+    };
+
+    std::vector<Hit> hits;
+    //! True if the search stopped early because the maximum number of hits
+    //! was found.
+    bool truncated{false};
+    uint32_t regions_scanned{0};
+    uint64_t bytes_scanned{0};
+    uint32_t failed_reads{0};
+  };
+
+  struct MemorySnapshotResult {
+    std::shared_ptr<MemorySnapshot> snapshot;
+    uint32_t blocks_downloaded{0};
+    //! The number of blocks copied from the baseline snapshot because their
+    //! checksums were unchanged.
+    uint32_t blocks_reused{0};
+    uint32_t failed_reads{0};
+  };
+
+  struct CoreDumpResult {
+    uint32_t threads{0};
+    uint32_t regions{0};
+    uint64_t bytes_written{0};
+    //! The number of chunks that could not be read, which are written as
+    //! zeroes.
+    uint32_t failed_reads{0};
+  };
+
   struct BacktraceFrame {
     uint32_t address;
     bool is_indirect_call;
@@ -90,7 +201,11 @@ class XBDMDebugger {
       bool wait_forever = false,
       LaunchMode launch_mode = LaunchMode::BREAK_AT_APPLICATION_START);
 
-  [[nodiscard]] std::list<std::shared_ptr<Thread>> Threads();
+  //! Returns the known threads keyed by thread ID.
+  [[nodiscard]] std::map<uint32_t, std::shared_ptr<Thread>> Threads();
+  //! Returns a counter that is incremented whenever threads are added to or
+  //! removed from the thread table.
+  [[nodiscard]] uint64_t ThreadsGeneration() const;
   [[nodiscard]] std::map<uint32_t, std::shared_ptr<Module>> Modules();
   //! Returns the module map keyed by their start and end virtual memory
   //! addresses.
@@ -128,7 +243,13 @@ class XBDMDebugger {
   [[nodiscard]] bool Stop() const;
   [[nodiscard]] bool Go() const;
 
+  //! Replaces the thread table with the current thread list from the target
+  //! and fetches info for every thread. The table is otherwise kept up to date
+  //! by thread creation and termination notifications, so this is only needed
+  //! after attaching or rebooting.
   bool FetchThreads();
+  //! Fetches info for any known threads that have not yet been populated.
+  bool FetchMissingThreadInfo();
   bool FetchModules();
   bool FetchSections(const std::string& module_name);
   bool FetchMemoryMap();
@@ -139,6 +260,14 @@ class XBDMDebugger {
   bool StepInstruction();
   bool StepFunction();
 
+  //! Single steps the active thread until its EIP leaves [start, end), running
+  //! to the return address of any call made from within the range rather than
+  //! stepping through the callee. Returns early if the thread stops for any
+  //! other reason. Returns false if stepping failed or timed out.
+  bool StepRange(
+      uint32_t start, uint32_t end,
+      uint32_t max_wait_milliseconds = kDefaultStepMaxWaitMilliseconds);
+
   /**
    * Fetches memory from the remote.
    * @param address - The address to start fetching from.
@@ -152,12 +281,48 @@ class XBDMDebugger {
                                                 uint32_t length,
                                                 bool validate = true);
   std::optional<uint32_t> GetDWORD(uint32_t address);
+
+  //! Searches the readable memory regions overlapping [start, end) for the
+  //! given pattern, returning at most `max_hits` matches. The memory map is
+  //! refreshed and regions are streamed in kMemorySearchChunkSize reads, each
+  //! of which is requested before the previous one is scanned.
+  MemorySearchResult SearchMemory(
+      const MemorySearchPattern& pattern, uint32_t start = 0,
+      uint64_t end = 0x100000000ULL,
+      size_t max_hits = kDefaultMemorySearchMaxHits);
+
+  //! Captures every readable memory region. The XBDM checksum of each block is
+  //! fetched first and, if a baseline snapshot is given, only the blocks whose
+  //! checksum differs from the baseline are downloaded. Blocks that cannot be
+  //! read are omitted from the snapshot.
+  MemorySnapshotResult CaptureMemorySnapshot(
+      const std::shared_ptr<MemorySnapshot>& baseline = nullptr,
+      uint32_t block_size = MemorySnapshot::kDefaultBlockSize);
+
+  //! Writes an ELF32 core file containing a PT_LOAD segment for each readable
+  //! memory region and the register state of each thread. Memory is streamed
+  //! to `out` as it is read, with at most kCoreDumpReadsInFlight chunks held
+  //! in memory. The target should be stopped to obtain a consistent image.
+  std::expected<CoreDumpResult, std::string> WriteCoreDump(std::ostream& out);
+
   bool SetMemory(uint32_t address, const std::vector<uint8_t>& data);
 
+  //! Disassembles up to `count` instructions starting at `address`. Code is
+  //! read a page at a time and cached along with the decoded instructions
+  //! until it is modified through this debugger or modules change.
+  std::vector<cs_insn> Disassemble(uint32_t address, uint32_t count);
+
+  //! Discards cached code overlapping the given range. This must be called if
+  //! target memory is modified other than via SetMemory.
+  void InvalidateCode(uint32_t address, uint32_t length);
+
   void SetDisplayExpandedBreakpointOutput(bool enable) {
     print_thread_info_on_break_ = enable;
   };
 
+  //! Buffers and rate limits debugstr output from the target.
+  [[nodiscard]] DebugStrSink& DebugStrOutput() { return debugstr_sink_; }
+
   void SetBreakpointCondition(BreakpointType breakpoint_type, uint32_t address,
                               const std::string& condition);
   void RemoveBreakpointCondition(BreakpointType breakpoint_type,
@@ -165,6 +330,12 @@ class XBDMDebugger {
   std::optional<std::string> FindBreakpointCondition(
       BreakpointType breakpoint_type, uint32_t address) const;
 
+  //! Replaces the compiled conditions attached to the given breakpoint. The
+  //! thread stops if any of them is true. An empty list removes them.
+  void SetBreakpointConditionEvaluators(
+      BreakpointType breakpoint_type, uint32_t address,
+      std::vector<ConditionEvaluator> evaluators);
+
   bool AddBreakpoint(uint32_t address);
   bool AddReadWatch(uint32_t address, uint32_t length);
   bool AddWriteWatch(uint32_t address, uint32_t length);
@@ -191,14 +362,72 @@ class XBDMDebugger {
 
   ExecutionState CurrentKnownState();
 
+  //! Returns the number of stops (breakpoints, watchpoints, single steps and
+  //! exceptions) that have been processed.
+  [[nodiscard]] uint64_t StopEventCount() const;
+
+  //! Waits up to max_wait_milliseconds for a stop to be processed after the
+  //! given StopEventCount.
+  bool WaitForStopEvent(uint64_t last_count, uint32_t max_wait_milliseconds);
+
   DebuggerExpressionParser::MemoryReader CreateMemoryReader();
 
+  //! Sets the index used to resolve symbols in breakpoint conditions and to
+  //! describe stop locations.
+  void SetSymbolIndex(std::shared_ptr<const SymbolIndex> symbols);
+  [[nodiscard]] std::shared_ptr<const SymbolIndex> Symbols() const;
+
+  //! Adds or replaces the tracepoint with the same number. Changes take effect
+  //! the next time tracing is started.
+  void SetTracepoint(Tracepoint tracepoint);
+  [[nodiscard]] std::optional<Tracepoint> GetTracepoint(uint32_t number);
+  [[nodiscard]] std::vector<Tracepoint> Tracepoints();
+  [[nodiscard]] uint32_t NextTracepointNumber();
+  bool RemoveTracepoint(uint32_t number);
+  //! Stops tracing, removes all tracepoints, and discards collected frames.
+  void ClearTracepoints();
+
+  //! Discards any previously collected frames and arms all enabled
+  //! tracepoints.
+  bool StartTracing();
+  void StopTracing();
+  [[nodiscard]] TraceStatus GetTraceStatus();
+  [[nodiscard]] std::optional<TraceFrame> GetTraceFrame(size_t index);
+  //! Sets the maximum number of bytes of frames that may be collected before
+  //! tracing is stopped.
+  void SetTraceBufferSize(size_t bytes);
+
  private:
+  //! Returns the cached memory regions overlapping [start, end) that may be
+  //! read.
+  std::vector<std::shared_ptr<MemoryRegion>> GetReadableRegions(uint32_t start,
+                                                                uint64_t end);
+  bool FetchThreadInfo(const std::vector<std::shared_ptr<Thread>>& threads);
   std::vector<uint32_t> GetActiveBreakpointsInRange(uint32_t address,
                                                     uint32_t length);
   void SuspendBreakpoints(const std::vector<uint32_t>& breakpoints);
   void RestoreBreakpoints(const std::vector<uint32_t>& breakpoints,
                           bool wait = true);
+  //! Releases one suspension of each of the given breakpoints, returning those
+  //! that are no longer suspended. Must be called with breakpoints_lock_ held.
+  std::vector<uint32_t> ReleaseBreakpointSuspensions(
+      const std::vector<uint32_t>& breakpoints);
+  //! Sends the commands to set the given breakpoints on the target.
+  void SendBreakpointRestores(const std::vector<uint32_t>& breakpoints,
+                              bool wait);
+
+  //! Returns the number of bytes from the start of the given code page that
+  //! may be read according to the memory map.
+  uint32_t GetReadableCodeLength(uint32_t page_address);
+  //! Reads a page for the disassembly cache, preferring a pending prefetch.
+  //! Must be called with code_cache_lock_ held.
+  std::optional<std::vector<uint8_t>> ReadCodePage(uint32_t page_address);
+  //! Starts reading the page following `address` if `address` is near the
+  //! end of a cached page, so that disassembly after the next step does not
+  //! have to wait for it.
+  void PrefetchCode(uint32_t address);
+  //! Discards all cached code, e.g., because modules were loaded or unloaded.
+  void ResetCodeCache();
 
   [[nodiscard]] bool BreakAtStart() const;
   bool SetDebugger(bool enabled);
@@ -213,6 +442,7 @@ class XBDMDebugger {
   void OnSectionUnloaded(const std::shared_ptr<NotificationSectionUnloaded>&);
   void OnThreadCreated(const std::shared_ptr<NotificationThreadCreated>&);
   void OnThreadTerminated(const std::shared_ptr<NotificationThreadTerminated>&);
+  void OnReconnected();
   void OnExecutionStateChanged(
       const std::shared_ptr<NotificationExecutionStateChanged>&);
   void OnBreakpoint(const std::shared_ptr<NotificationBreakpoint>&);
@@ -225,20 +455,47 @@ class XBDMDebugger {
    */
   void PerformAfterStopActions(const std::shared_ptr<Thread>& active_thread);
 
+  //! Steps the given thread and waits for the next stop, which may be for an
+  //! unrelated reason. Returns false on failure or timeout.
+  bool StepInstructionSync(const std::shared_ptr<Thread>& thread,
+                           uint32_t max_wait_milliseconds);
+
+  //! Returns true if the last stop was the given thread completing a step.
+  [[nodiscard]] bool StoppedForSingleStep(
+      const std::shared_ptr<Thread>& thread);
+
+  //! Evaluates any conditions attached to the given breakpoint, returning
+  //! false if the thread should be continued without reporting the stop.
+  bool ShouldStopForBreakpoint(const std::shared_ptr<Thread>& thread,
+                               BreakpointType breakpoint_type,
+                               uint32_t address);
+
+  //! Collects frames for any running tracepoints at the given address,
+  //! resuming the thread if no user breakpoint is also set there. Returns true
+  //! if the thread was resumed.
+  bool ProcessTracepointHit(const std::shared_ptr<Thread>& thread,
+                            uint32_t address);
+  void StopTracing(TraceStopReason reason, uint32_t tracepoint);
+  //! Removes the breakpoints that were only set to support tracepoints.
+  void DisarmTracepoints();
+
   bool BreakOnNextThreadCreate();
 
  private:
-  bool is_attached_{false};
+  std::atomic<bool> is_attached_{false};
   std::shared_ptr<XBDMContext> context_;
 
   mutable std::mutex state_lock_;
   std::condition_variable state_condition_variable_;
   ExecutionState state_{S_INVALID};
+  uint64_t stop_event_count_{0};
+  std::optional<uint32_t> last_stop_thread_id_;
 
   std::optional<uint32_t> active_thread_id_;
 
   mutable std::recursive_mutex threads_lock_;
-  std::list<std::shared_ptr<Thread>> threads_;
+  std::map<uint32_t, std::shared_ptr<Thread>> threads_;
+  uint64_t threads_generation_{0};
 
   mutable std::recursive_mutex modules_lock_;
   //! Map of base virtual address to Module.
@@ -251,15 +508,52 @@ class XBDMDebugger {
   mutable std::recursive_mutex memory_regions_lock_;
   std::list<std::shared_ptr<MemoryRegion>> memory_regions_;
 
-  std::map<int, std::string> debugstr_accumulator_;
+  DebugStrSink debugstr_sink_;
 
   mutable std::recursive_mutex conditions_lock_;
   // Maps <BreakpointType, Address> to strings defining IF conditions.
   std::map<std::pair<BreakpointType, uint32_t>, std::string>
       breakpoint_conditions_;
+  // Maps <BreakpointType, Address> to compiled conditions, such as those
+  // provided by GDB.
+  std::map<std::pair<BreakpointType, uint32_t>,
+           std::vector<ConditionEvaluator>>
+      breakpoint_condition_evaluators_;
 
   mutable std::mutex breakpoints_lock_;
   std::set<uint32_t> breakpoints_;
+  //! Addresses of the tracepoints that are armed while tracing.
+  std::set<uint32_t> traced_addresses_;
+  //! Breakpoints in `breakpoints_` that were set on behalf of tracepoints and
+  //! should be removed when tracing stops.
+  std::set<uint32_t> tracepoint_only_breakpoints_;
+  //! Breakpoints that have been temporarily removed from the target, e.g., to
+  //! read memory, with the number of outstanding suspensions of each. These
+  //! are not restored when the target stops.
+  std::map<uint32_t, uint32_t> suspended_breakpoints_;
+  //! Suspended breakpoints that are left removed until the target stops after
+  //! a StepInstruction.
+  std::multiset<uint32_t> step_suspended_breakpoints_;
+  //! Whether the target has been observed resuming for that step.
+  bool step_resumed_{false};
+
+  mutable std::mutex tracepoints_lock_;
+  std::map<uint32_t, Tracepoint> tracepoints_;
+  std::vector<TraceFrame> trace_frames_;
+  TraceStatus trace_status_;
+
+  mutable std::mutex symbols_lock_;
+  std::shared_ptr<const SymbolIndex> symbols_;
+
+  struct CodePrefetch {
+    uint64_t generation;
+    std::shared_ptr<GetMemBinary> request;
+  };
+
+  mutable std::mutex code_cache_lock_;
+  DisassemblyCache code_cache_;
+  //! Outstanding reads of code pages, keyed by page address.
+  std::map<uint32_t, CodePrefetch> code_prefetches_;
 
   bool target_not_debuggable_{false};
   int notification_handler_id_{0};
@@ -1,23 +1,56 @@
 #include "xbdm_context.h"
 
+#include <algorithm>
 #include <boost/asio/dispatch.hpp>
+#include <boost/asio/post.hpp>
+#include <chrono>
+#include <latch>
 #include <utility>
 
 #include "net/delegating_server.h"
 #include "net/select_thread.h"
+#include "notification/xbdm_notification.h"
 #include "notification/xbdm_notification_transport.h"
 #include "rdcp/rdcp_processed_request.h"
+#include "rdcp/session_capture.h"
 #include "rdcp/xbdm_transport.h"
 #include "util/logging.h"
 #include "util/timer.h"
 
+namespace {
+
+//! Abandons requests that are dropped by an executor without being sent, so
+//! that their completion handlers are always invoked.
+class PendingRequests {
+ public:
+  explicit PendingRequests(
+      std::vector<std::shared_ptr<RDCPProcessedRequest>> requests)
+      : requests_(std::move(requests)) {}
+  PendingRequests(PendingRequests&&) = default;
+  PendingRequests(const PendingRequests&) = delete;
+  ~PendingRequests() {
+    for (auto& request : requests_) {
+      request->Abandon();
+    }
+  }
+
+  std::vector<std::shared_ptr<RDCPProcessedRequest>> Release() {
+    return std::move(requests_);
+  }
+
+ private:
+  std::vector<std::shared_ptr<RDCPProcessedRequest>> requests_;
+};
+
+}  // namespace
+
 XBDMContext::XBDMContext(std::string name, IPAddress xbox_address,
                          std::shared_ptr<SelectThread> select_thread)
     : name_(std::move(name)),
       xbox_address_(std::move(xbox_address)),
       select_thread_(std::move(select_thread)) {
-  xbdm_transport_ = std::make_shared<XBDMTransport>(logging::kLoggingTagXBDM);
-  select_thread_->AddConnection(xbdm_transport_);
+  control_channel_ = std::make_shared<Channel>(logging::kLoggingTagXBDM);
+  control_channel_->executor = std::make_shared<boost::asio::thread_pool>(1);
 
   notification_server_ = std::make_shared<DelegatingServer>(
       name_ + "__xbdm_notification_server",
@@ -26,34 +59,37 @@ XBDMContext::XBDMContext(std::string name, IPAddress xbox_address,
       });
   select_thread_->AddConnection(notification_server_);
 
-  xbdm_control_executor_ = std::make_shared<boost::asio::thread_pool>(1);
-  notification_executor_ = std::make_shared<boost::asio::thread_pool>(1);
+  notification_executor_ = std::make_shared<boost::asio::thread_pool>(
+      kNotificationDispatchThreads);
+  notification_handler_groups_ =
+      std::make_shared<const NotificationHandlerGroups>();
 }
 
 void XBDMContext::Shutdown() {
-  for (const auto& it : dedicated_transports_) {
-    it.second->Close();
-  }
-  dedicated_transports_.clear();
-
-  if (xbdm_transport_) {
-    xbdm_transport_->Close();
-    xbdm_transport_.reset();
+  std::map<std::string, std::shared_ptr<Channel>> dedicated_channels;
+  {
+    const std::lock_guard lock(dedicated_channels_lock_);
+    dedicated_channels.swap(dedicated_channels_);
   }
-  if (xbdm_control_executor_) {
-    xbdm_control_executor_->stop();
-    xbdm_control_executor_->join();
-    xbdm_control_executor_.reset();
+  for (auto& it : dedicated_channels) {
+    CloseChannel(*it.second);
   }
+
+  CloseChannel(*control_channel_);
+  StopCapture();
   if (notification_server_) {
     notification_server_->Close();
     notification_server_.reset();
   }
-  if (notification_executor_) {
-    notification_executor_->stop();
-    notification_executor_->join();
-    notification_executor_.reset();
+  // The executor is kept alive because the notification handler strands refer
+  // to it. Work posted after it is stopped is discarded.
+  notification_executor_->stop();
+  notification_executor_->join();
+  {
+    const std::lock_guard lock(notification_delivery_lock_);
+    notification_executor_stopped_ = true;
   }
+  notification_delivery_done_.notify_all();
 }
 
 bool XBDMContext::StartNotificationListener(const IPAddress& address) {
@@ -84,7 +120,8 @@ void XBDMContext::OnNotificationChannelConnected(int sock, IPAddress& address) {
   // reproduce this would require queueing the handling of `modload`
   // notifications, and it seems like an immediate reconnect here causes no
   // issues.
-  if (!xbdm_transport_ || !xbdm_transport_->CanProcessCommands()) {
+  auto control_transport = GetTransport(*control_channel_);
+  if (!control_transport || !control_transport->CanProcessCommands()) {
     LOG_XBDM(trace) << "Reconnecting XBDM transport due to notification.";
     Reconnect();
   }
@@ -94,8 +131,20 @@ void XBDMContext::OnNotificationChannelConnected(int sock, IPAddress& address) {
       [this](std::shared_ptr<XBDMNotification> notification) {
         this->OnNotificationReceived(std::move(notification));
       });
+  transport->SetCapture(GetCapture());
+
+  bool reconnected;
+  {
+    const std::lock_guard lock(notification_transports_lock_);
+    reconnected = std::exchange(notification_channel_connected_, true);
+    notification_transports_.insert(transport);
+  }
 
-  notification_transports_.insert(transport);
+  // Notifications sent while the previous channel was down were lost, so
+  // handlers are told before anything is read from the new channel.
+  if (reconnected) {
+    DispatchNotification(std::make_shared<NotificationReconnected>());
+  }
 
   select_thread_->AddConnection(transport, [this, transport]() {
     const std::lock_guard lock(notification_transports_lock_);
@@ -106,20 +155,21 @@ void XBDMContext::OnNotificationChannelConnected(int sock, IPAddress& address) {
 void XBDMContext::OnNotificationReceived(
     std::shared_ptr<XBDMNotification> notification) {
   assert(notification_executor_);
-  boost::asio::dispatch(*notification_executor_,
-                        [this, notification]() mutable {
-                          this->DispatchNotification(notification);
-                        });
+  DispatchNotification(notification);
 }
 
 void XBDMContext::CloseActiveConnections() {
-  if (xbdm_transport_) {
-    xbdm_transport_->Close();
-  }
-
+  CloseControlConnection();
   ResetNotificationConnections();
 }
 
+void XBDMContext::CloseControlConnection() {
+  auto transport = GetTransport(*control_channel_);
+  if (transport) {
+    transport->Close();
+  }
+}
+
 void XBDMContext::ResetNotificationConnections() {
   const std::lock_guard lock(notification_transports_lock_);
   for (auto& transport : notification_transports_) {
@@ -128,18 +178,95 @@ void XBDMContext::ResetNotificationConnections() {
 }
 
 bool XBDMContext::Reconnect() {
-  if (xbdm_transport_) {
-    xbdm_transport_->Close();
+  return ReconnectChannel(control_channel_, nullptr);
+}
+
+void XBDMContext::SetReconnectPolicy(const ReconnectPolicy& policy) {
+  const std::lock_guard lock(connection_lock_);
+  reconnect_policy_ = policy;
+}
+
+XBDMContext::ConnectionMetrics XBDMContext::GetConnectionMetrics() const {
+  const std::lock_guard lock(connection_lock_);
+  return connection_metrics_;
+}
+
+std::map<std::string, TransportMetrics::Snapshot>
+XBDMContext::GetTransportMetrics() {
+  std::map<std::string, TransportMetrics::Snapshot> ret;
+  ret[control_channel_->name] = control_channel_->metrics->GetSnapshot();
+
+  const std::lock_guard lock(dedicated_channels_lock_);
+  for (const auto& [handler, channel] : dedicated_channels_) {
+    ret[channel->name] = channel->metrics->GetSnapshot();
+  }
+  return ret;
+}
+
+void XBDMContext::ResetTransportMetrics() {
+  control_channel_->metrics->Reset();
+
+  const std::lock_guard lock(dedicated_channels_lock_);
+  for (const auto& [handler, channel] : dedicated_channels_) {
+    channel->metrics->Reset();
+  }
+}
+
+bool XBDMContext::StartCapture(const std::filesystem::path& path) {
+  auto writer = SessionCaptureWriter::Create(path);
+  if (!writer) {
+    return false;
+  }
+
+  {
+    const std::lock_guard lock(connection_lock_);
+    capture_ = writer;
+  }
+  ApplyCapture(writer);
+  return true;
+}
+
+void XBDMContext::StopCapture() {
+  {
+    const std::lock_guard lock(connection_lock_);
+    capture_.reset();
+  }
+  ApplyCapture(nullptr);
+}
+
+std::shared_ptr<SessionCaptureWriter> XBDMContext::GetCapture() const {
+  const std::lock_guard lock(connection_lock_);
+  return capture_;
+}
+
+void XBDMContext::ApplyCapture(
+    const std::shared_ptr<SessionCaptureWriter>& writer) {
+  // Transports created concurrently pick up the writer from `capture_`, so
+  // attaching it twice is harmless.
+  auto apply_to_channel = [&writer](Channel& channel) {
+    auto transport = GetTransport(channel);
+    if (transport) {
+      transport->SetCapture(writer);
+    }
+  };
+
+  apply_to_channel(*control_channel_);
+  {
+    const std::lock_guard lock(dedicated_channels_lock_);
+    for (const auto& [handler, channel] : dedicated_channels_) {
+      apply_to_channel(*channel);
+    }
   }
 
-  xbdm_transport_ = std::make_shared<XBDMTransport>(logging::kLoggingTagXBDM);
-  select_thread_->AddConnection(xbdm_transport_);
-  return xbdm_transport_->Connect(xbox_address_);
+  const std::lock_guard lock(notification_transports_lock_);
+  for (const auto& transport : notification_transports_) {
+    transport->SetCapture(writer);
+  }
 }
 
 std::shared_ptr<RDCPProcessedRequest> XBDMContext::SendCommandSync(
     const std::shared_ptr<RDCPProcessedRequest>& command) {
-  if (!xbdm_transport_) {
+  if (!GetExecutor(*control_channel_)) {
     return nullptr;
   }
 
@@ -150,28 +277,23 @@ std::shared_ptr<RDCPProcessedRequest> XBDMContext::SendCommandSync(
 
 std::future<std::shared_ptr<RDCPProcessedRequest>> XBDMContext::SendCommand(
     const std::shared_ptr<RDCPProcessedRequest>& command) {
-  return SendCommand(command, xbdm_transport_);
-}
-
-std::shared_ptr<RDCPProcessedRequest> XBDMContext::SendCommandSync(
-    std::shared_ptr<RDCPProcessedRequest> command,
-    const std::shared_ptr<XBDMTransport>& transport) {
-  auto future = SendCommand(command, transport);
-  future.get();
-  return command;
+  auto promise =
+      std::make_shared<std::promise<std::shared_ptr<RDCPProcessedRequest>>>();
+  auto future = promise->get_future();
+  SendCommandAsync(command,
+                   [promise, command]() { promise->set_value(command); });
+  return future;
 }
 
 std::future<std::shared_ptr<RDCPProcessedRequest>> XBDMContext::SendCommand(
     const std::shared_ptr<RDCPProcessedRequest>& command,
     const std::string& dedicated_handler) {
-  auto it = dedicated_transports_.find(dedicated_handler);
-  if (it == dedicated_transports_.end()) {
-    assert(CreateDedicatedChannel(dedicated_handler));
-    it = dedicated_transports_.find(dedicated_handler);
-    assert(it != dedicated_transports_.end());
-  }
-
-  return SendCommand(command, it->second);
+  auto promise =
+      std::make_shared<std::promise<std::shared_ptr<RDCPProcessedRequest>>>();
+  auto future = promise->get_future();
+  SendCommandAsync(command, dedicated_handler,
+                   [promise, command]() { promise->set_value(command); });
+  return future;
 }
 
 std::shared_ptr<RDCPProcessedRequest> XBDMContext::SendCommandSync(
@@ -182,126 +304,536 @@ std::shared_ptr<RDCPProcessedRequest> XBDMContext::SendCommandSync(
   return command;
 }
 
-std::future<std::shared_ptr<RDCPProcessedRequest>> XBDMContext::SendCommand(
+void XBDMContext::SendCommandAsync(
     const std::shared_ptr<RDCPProcessedRequest>& command,
-    const std::shared_ptr<XBDMTransport>& transport) {
-  assert(xbdm_control_executor_ && "SendCommand called before Start.");
-  assert(transport && "transport must not be null");
-  std::promise<std::shared_ptr<RDCPProcessedRequest>> promise;
-  auto future = promise.get_future();
+    std::function<void()> on_complete) {
+  SendCommandAsync(command, control_channel_, std::move(on_complete));
+}
+
+void XBDMContext::SendCommandAsync(
+    const std::shared_ptr<RDCPProcessedRequest>& command,
+    const std::string& dedicated_handler, std::function<void()> on_complete) {
+  auto channel = GetDedicatedChannel(dedicated_handler);
+  if (!channel) {
+    LOG_XBDM(error) << "Failed to create dedicated channel for "
+                    << dedicated_handler;
+    command->SetCompletionHandler(std::move(on_complete));
+    command->Fail(StatusCode::ERR_NOT_CONNECTED);
+    return;
+  }
+
+  SendCommandAsync(command, channel, std::move(on_complete));
+}
+
+void XBDMContext::SendCommandAsync(
+    const std::shared_ptr<RDCPProcessedRequest>& command,
+    const std::shared_ptr<Channel>& channel,
+    std::function<void()> on_complete) {
+  command->SetCompletionHandler(std::move(on_complete));
+
+  auto executor = GetExecutor(*channel);
+  if (!executor) {
+    command->Fail(StatusCode::ERR_NOT_CONNECTED);
+    return;
+  }
 
+  // The executor only establishes the connection and queues the request on
+  // the transport; it does not wait for the response.
   boost::asio::dispatch(
-      *xbdm_control_executor_,
-      [this, promise = std::move(promise), command, transport]() mutable {
-        this->ExecuteXBDMPromise(promise, command, transport);
+      *executor, [this, pending = PendingRequests({command}), channel,
+                  dispatched_at = std::chrono::steady_clock::now()]() mutable {
+        channel->metrics->RecordExecutorWait(std::chrono::steady_clock::now() -
+                                             dispatched_at);
+        this->ExecuteXBDMRequest(pending.Release().front(), channel);
       });
-  return future;
+}
+
+bool XBDMContext::SendBatch(
+    const std::vector<std::shared_ptr<RDCPProcessedRequest>>& requests,
+    BatchTiming* timing) {
+  return SendBatch(requests, control_channel_, timing);
+}
+
+bool XBDMContext::SendBatch(
+    const std::vector<std::shared_ptr<RDCPProcessedRequest>>& requests,
+    const std::string& dedicated_handler, BatchTiming* timing) {
+  auto channel = GetDedicatedChannel(dedicated_handler);
+  if (!channel) {
+    LOG_XBDM(error) << "Failed to create dedicated channel for "
+                    << dedicated_handler;
+    for (auto& request : requests) {
+      request->SetCompletionHandler(nullptr);
+      request->Fail(StatusCode::ERR_NOT_CONNECTED);
+    }
+    return false;
+  }
+
+  return SendBatch(requests, channel, timing);
+}
+
+bool XBDMContext::SendBatch(
+    const std::vector<std::shared_ptr<RDCPProcessedRequest>>& requests,
+    const std::shared_ptr<Channel>& channel, BatchTiming* timing) {
+  if (requests.empty()) {
+    return true;
+  }
+
+  auto executor = GetExecutor(*channel);
+  if (!executor) {
+    for (auto& request : requests) {
+      request->SetCompletionHandler(nullptr);
+      request->Fail(StatusCode::ERR_NOT_CONNECTED);
+    }
+    return false;
+  }
+
+  Timer timer;
+  std::vector<double> completion_milliseconds(requests.size());
+  std::latch pending(static_cast<std::ptrdiff_t>(requests.size()));
+  for (size_t i = 0; i < requests.size(); ++i) {
+    requests[i]->SetCompletionHandler(
+        [&timer, &completion_milliseconds, &pending, i]() {
+          completion_milliseconds[i] = timer.FractionalMillisecondsElapsed();
+          pending.count_down();
+        });
+  }
+
+  boost::asio::dispatch(
+      *executor, [this, pending = PendingRequests(requests), channel,
+                  dispatched_at = std::chrono::steady_clock::now()]() mutable {
+        channel->metrics->RecordExecutorWait(std::chrono::steady_clock::now() -
+                                             dispatched_at);
+        this->ExecuteXBDMBatch(pending.Release(), channel);
+      });
+  // If the channel is closed while waiting, the batch is abandoned when the
+  // last reference to the executor is released.
+  executor.reset();
+  pending.wait();
+
+  auto total_milliseconds = timer.FractionalMillisecondsElapsed();
+  LOG_XBDM(trace) << "Batch of " << requests.size() << " requests completed in "
+                  << total_milliseconds << " ms, first response after "
+                  << completion_milliseconds.front() << " ms";
+  if (timing) {
+    timing->completion_milliseconds = std::move(completion_milliseconds);
+    timing->total_milliseconds = total_milliseconds;
+  }
+
+  return std::all_of(requests.begin(), requests.end(),
+                     [](const auto& request) { return request->IsOK(); });
 }
 
 bool XBDMContext::CreateDedicatedChannel(const std::string& command_handler) {
-  if (dedicated_transports_.find(command_handler) !=
-      dedicated_transports_.end()) {
+  const std::lock_guard lock(dedicated_channels_lock_);
+  if (dedicated_channels_.find(command_handler) != dedicated_channels_.end()) {
     return false;
   }
 
   std::string tag = logging::kLoggingTagXBDM;
   tag += "_";
   tag += command_handler;
-  auto transport = std::make_shared<XBDMTransport>(tag);
-  select_thread_->AddConnection(transport);
+  auto channel = std::make_shared<Channel>(tag);
+  channel->executor = std::make_shared<boost::asio::thread_pool>(1);
 
-  if (!transport->Connect(xbox_address_)) {
+  if (!ReconnectChannel(channel, nullptr)) {
+    CloseChannel(*channel);
     return false;
   }
 
-  dedicated_transports_[command_handler] = transport;
+  dedicated_channels_[command_handler] = channel;
   return true;
 }
 
 void XBDMContext::DestroyDedicatedChannel(const std::string& command_handler) {
-  auto it = dedicated_transports_.find(command_handler);
-  if (it == dedicated_transports_.end()) {
+  std::shared_ptr<Channel> channel;
+  {
+    const std::lock_guard lock(dedicated_channels_lock_);
+    auto it = dedicated_channels_.find(command_handler);
+    if (it == dedicated_channels_.end()) {
+      return;
+    }
+    channel = it->second;
+    dedicated_channels_.erase(it);
+  }
+
+  CloseChannel(*channel);
+}
+
+std::shared_ptr<XBDMTransport> XBDMContext::GetTransport(Channel& channel) {
+  const std::lock_guard lock(channel.transport_lock);
+  return channel.transport;
+}
+
+std::shared_ptr<boost::asio::thread_pool> XBDMContext::GetExecutor(
+    Channel& channel) {
+  const std::lock_guard lock(channel.executor_lock);
+  return channel.executor;
+}
+
+void XBDMContext::CloseChannel(Channel& channel) {
+  // The executor is stopped first so that nothing is queued on the transport
+  // after it is closed. Closing the transport abandons any requests that were
+  // queued on it and destroying the executor abandons any that never reached
+  // it.
+  std::shared_ptr<boost::asio::thread_pool> executor;
+  {
+    const std::lock_guard lock(channel.executor_lock);
+    executor.swap(channel.executor);
+  }
+  if (executor) {
+    executor->stop();
+    executor->join();
+  }
+
+  std::shared_ptr<XBDMTransport> transport;
+  {
+    const std::lock_guard lock(channel.transport_lock);
+    transport.swap(channel.transport);
+  }
+  if (transport) {
+    transport->SetStateChangedHandler(nullptr);
+    transport->Close();
+    transport->AbandonUnsentRequests();
+  }
+  executor.reset();
+}
+
+bool XBDMContext::ReconnectChannel(
+    const std::shared_ptr<Channel>& channel,
+    const std::shared_ptr<XBDMTransport>& expected) {
+  std::shared_ptr<XBDMTransport> transport;
+  {
+    const std::lock_guard lock(channel->transport_lock);
+    if (expected && channel->transport != expected) {
+      return channel->transport && channel->transport->IsConnected();
+    }
+
+    transport = std::make_shared<XBDMTransport>(channel->name);
+    transport->SetHoldUnsentRequests(true);
+    transport->SetMetrics(channel->metrics);
+    transport->SetCapture(GetCapture());
+    transport->SetStateChangedHandler(
+        [this, weak_channel = std::weak_ptr<Channel>(channel)](
+            XBDMTransport& changed) {
+          this->OnTransportStateChanged(weak_channel, changed);
+        });
+
+    auto previous = std::exchange(channel->transport, transport);
+    if (previous) {
+      previous->SetStateChangedHandler(nullptr);
+      previous->Close();
+      transport->TakeUnsentRequests(*previous);
+
+      const std::lock_guard metrics_lock(connection_lock_);
+      ++connection_metrics_.reconnects;
+    }
+  }
+
+  select_thread_->AddConnection(transport);
+  if (!transport->Connect(xbox_address_)) {
+    const std::lock_guard lock(connection_lock_);
+    ++connection_metrics_.failed_connects;
+    return false;
+  }
+
+  return true;
+}
+
+void XBDMContext::OnTransportStateChanged(
+    const std::weak_ptr<Channel>& weak_channel, XBDMTransport& transport) {
+  // This may be invoked from the SelectThread while the transport's socket is
+  // locked, so it must not touch the channel's transport.
+  auto state = transport.State();
+  if (state == XBDMTransport::ConnectionState::CONNECTED) {
+    auto connect_milliseconds = transport.LastConnectMilliseconds();
+    const std::lock_guard lock(connection_lock_);
+    ++connection_metrics_.connections;
+    connection_metrics_.last_connect_milliseconds = connect_milliseconds;
+    connection_metrics_.max_connect_milliseconds = std::max(
+        connection_metrics_.max_connect_milliseconds, connect_milliseconds);
+    connection_metrics_.total_connect_milliseconds += connect_milliseconds;
+    return;
+  }
+
+  if (state != XBDMTransport::ConnectionState::DISCONNECTED ||
+      !transport.HasUnsentRequests()) {
+    return;
+  }
+
+  auto channel = weak_channel.lock();
+  if (!channel) {
+    return;
+  }
+  auto executor = GetExecutor(*channel);
+  if (!executor) {
     return;
   }
 
-  it->second->Close();
-  dedicated_transports_.erase(it);
+  // Requests were waiting to be written when the connection dropped, so
+  // reconnect on their behalf rather than waiting for the next command.
+  boost::asio::post(*executor, [this, weak_channel]() {
+    auto channel = weak_channel.lock();
+    if (!channel) {
+      return;
+    }
+    auto current = GetTransport(*channel);
+    if (!current || current->CanProcessCommands() ||
+        !current->HasUnsentRequests()) {
+      return;
+    }
+
+    LOG_XBDM(trace) << channel->name
+                    << " disconnected with pending requests, reconnecting.";
+    XBDMConnect(channel);
+  });
+}
+
+std::shared_ptr<XBDMContext::Channel> XBDMContext::GetDedicatedChannel(
+    const std::string& command_handler) {
+  const std::lock_guard lock(dedicated_channels_lock_);
+  auto it = dedicated_channels_.find(command_handler);
+  if (it == dedicated_channels_.end()) {
+    if (!CreateDedicatedChannel(command_handler)) {
+      return nullptr;
+    }
+    it = dedicated_channels_.find(command_handler);
+  }
+
+  return it->second;
 }
 
-void XBDMContext::ExecuteXBDMPromise(
-    std::promise<std::shared_ptr<RDCPProcessedRequest>>& promise,
+void XBDMContext::ExecuteXBDMRequest(
     const std::shared_ptr<RDCPProcessedRequest>& request,
-    const std::shared_ptr<XBDMTransport>& transport) {
-  assert(transport && "Invalid transport during ExecuteXBDMPromise");
-  if (!XBDMConnect(transport)) {
-    request->status = StatusCode::ERR_NOT_CONNECTED;
-  } else {
-    LOG_XBDM(trace) << "Send " << *request;
+    const std::shared_ptr<Channel>& channel) {
+  auto transport = XBDMConnect(channel);
+  if (!transport) {
+    request->Fail(StatusCode::ERR_NOT_CONNECTED);
+    return;
+  }
+
+  LOG_XBDM(trace) << "Send " << *request;
+  {
+    // The transport may have been replaced by another thread, in which case
+    // the request is queued on its replacement.
+    const std::lock_guard lock(channel->transport_lock);
+    transport = channel->transport;
     transport->Send(request);
-    request->WaitUntilCompleted();
   }
 
-  promise.set_value(request);
+  // If the connection dropped before the request could be written, it is held
+  // by the transport and must be moved to a new connection.
+  if (!transport->CanProcessCommands()) {
+    XBDMConnect(channel);
+  }
 }
 
-bool XBDMContext::XBDMConnect(const std::shared_ptr<XBDMTransport>& transport,
-                              int max_wait_millis) {
-  assert(transport && "Invalid transport during XBDMConnect");
-  if (transport->CanProcessCommands()) {
-    return true;
+void XBDMContext::ExecuteXBDMBatch(
+    const std::vector<std::shared_ptr<RDCPProcessedRequest>>& requests,
+    const std::shared_ptr<Channel>& channel) {
+  auto transport = XBDMConnect(channel);
+  if (!transport) {
+    for (auto& request : requests) {
+      request->Fail(StatusCode::ERR_NOT_CONNECTED);
+    }
+    return;
   }
 
-  if (transport->IsShutdown()) {
-    Reconnect();
+  LOG_XBDM(trace) << "Send batch of " << requests.size() << " requests";
+  {
+    const std::lock_guard lock(channel->transport_lock);
+    transport = channel->transport;
+    transport->SendPipelined(
+        std::vector<std::shared_ptr<RDCPRequest>>(requests.begin(),
+                                                  requests.end()));
   }
 
-  if (!transport->IsConnected() && !transport->Connect(xbox_address_)) {
-    return false;
+  if (!transport->CanProcessCommands()) {
+    XBDMConnect(channel);
+  }
+}
+
+std::shared_ptr<XBDMTransport> XBDMContext::XBDMConnect(
+    const std::shared_ptr<Channel>& channel) {
+  ReconnectPolicy policy;
+  {
+    const std::lock_guard lock(connection_lock_);
+    policy = reconnect_policy_;
   }
 
-  static constexpr int busywait_millis = 5;
-  while (max_wait_millis > 0) {
-    if (transport->CanProcessCommands()) {
-      return true;
+  auto backoff_milliseconds = policy.initial_backoff_milliseconds;
+  for (int attempt = 0; attempt <= policy.max_retries; ++attempt) {
+    auto transport = GetTransport(*channel);
+    if (transport && transport->CanProcessCommands()) {
+      return transport;
     }
 
-    WaitMilliseconds(busywait_millis);
-    max_wait_millis -= busywait_millis;
-  }
+    if (attempt) {
+      LOG_XBDM(warning) << channel->name << " not connected, retrying in "
+                        << backoff_milliseconds << " ms";
+      WaitMilliseconds(backoff_milliseconds);
+      backoff_milliseconds = std::min(backoff_milliseconds * 2,
+                                      policy.max_backoff_milliseconds);
+    }
 
-  LOG_XBDM(warning) << "Timeout waiting for command processing to become "
-                       "available. Attempting to reconnect...";
+    // A transport that has opened its socket is left to finish its handshake
+    // on the first attempt.
+    if (attempt || !transport || !transport->IsConnected()) {
+      if (!ReconnectChannel(channel, transport)) {
+        continue;
+      }
+      transport = GetTransport(*channel);
+    }
 
-  transport->Connect(xbox_address_);
+    if (transport->WaitUntilConnected(policy.connect_timeout_milliseconds)) {
+      return transport;
+    }
 
-  return false;
+    const std::lock_guard lock(connection_lock_);
+    ++connection_metrics_.failed_connects;
+  }
+
+  LOG_XBDM(error) << channel->name << " failed to connect after "
+                  << policy.max_retries + 1 << " attempts.";
+  auto transport = GetTransport(*channel);
+  if (transport) {
+    transport->AbandonUnsentRequests();
+  }
+  return nullptr;
 }
+
 int XBDMContext::RegisterNotificationHandler(
-    XBDMContext::NotificationHandler handler) {
+    XBDMContext::NotificationHandler handler, const std::string& ordering_key) {
   const std::lock_guard lock(notification_handler_lock_);
   int id = next_notification_handler_id_++;
-  notification_handlers_[id] = std::move(handler);
+
+  auto groups = std::make_shared<NotificationHandlerGroups>(
+      *notification_handler_groups_.load());
+  auto it = std::find_if(groups->begin(), groups->end(),
+                         [&ordering_key](const auto& group) {
+                           return group->ordering_key == ordering_key;
+                         });
+  std::shared_ptr<NotificationHandlerGroup> group;
+  if (it == groups->end()) {
+    group = std::make_shared<NotificationHandlerGroup>(NotificationHandlerGroup{
+        ordering_key,
+        boost::asio::make_strand(notification_executor_->get_executor()),
+        std::make_shared<NotificationQueue>(),
+        {}});
+    groups->push_back(group);
+  } else {
+    // Copies of a group share its strand and notification queue, so ordering
+    // is preserved across the replacement.
+    group = std::make_shared<NotificationHandlerGroup>(**it);
+    *it = group;
+  }
+  group->handlers.emplace_back(id, std::move(handler));
+
+  notification_handler_groups_ = std::move(groups);
   return id;
 }
+
 void XBDMContext::UnregisterNotificationHandler(int id) {
   if (id <= 0) {
     return;
   }
 
-  const std::lock_guard lock(notification_handler_lock_);
-  notification_handlers_.erase(id);
+  std::shared_ptr<const NotificationHandlerGroup> removed_from;
+  {
+    const std::lock_guard lock(notification_handler_lock_);
+    auto groups = std::make_shared<NotificationHandlerGroups>();
+    for (const auto& group : *notification_handler_groups_.load()) {
+      auto it =
+          std::find_if(group->handlers.begin(), group->handlers.end(),
+                       [id](const auto& entry) { return entry.first == id; });
+      if (it == group->handlers.end()) {
+        groups->push_back(group);
+        continue;
+      }
+
+      removed_from = group;
+      if (group->handlers.size() > 1) {
+        auto updated = std::make_shared<NotificationHandlerGroup>(*group);
+        updated->handlers.erase(updated->handlers.begin() +
+                                (it - group->handlers.begin()));
+        groups->push_back(updated);
+      }
+    }
+
+    notification_handler_groups_ = std::move(groups);
+  }
+
+  // Wait for the handler to return from any notification it is processing so
+  // that its owner may be destroyed as soon as this returns. Notifications
+  // taken for delivery after this point look the handlers up once the
+  // handler has been removed, so only those already started are waited for.
+  if (!removed_from || removed_from->strand.running_in_this_thread()) {
+    return;
+  }
+  auto& queue = *removed_from->queue;
+  std::unique_lock lock(notification_delivery_lock_);
+  auto started = queue.started;
+  // Work posted after Shutdown is discarded rather than run.
+  notification_delivery_done_.wait(lock, [this, &queue, started]() {
+    return queue.finished >= started || notification_executor_stopped_;
+  });
 }
 
 void XBDMContext::DispatchNotification(
     const std::shared_ptr<XBDMNotification>& notification) {
-  std::map<int, NotificationHandler> handlers;
-
-  {
-    const std::lock_guard lock(notification_handler_lock_);
-    handlers = notification_handlers_;
+  // Notifications arrive on the SelectThread, so queueing them for each group
+  // here preserves the order in which they were received. A delivery task is
+  // only posted to the group's strand if one is not already pending.
+  auto groups = notification_handler_groups_.load();
+  for (const auto& group : *groups) {
+    bool schedule;
+    {
+      const std::lock_guard lock(notification_delivery_lock_);
+      group->queue->pending.push_back(notification);
+      schedule = !std::exchange(group->queue->scheduled, true);
+    }
+    if (schedule) {
+      boost::asio::post(group->strand, [this, queue = group->queue]() {
+        DeliverQueuedNotifications(*queue);
+      });
+    }
   }
+}
+
+void XBDMContext::DeliverQueuedNotifications(NotificationQueue& queue) {
+  while (true) {
+    {
+      const std::lock_guard lock(notification_delivery_lock_);
+      if (queue.pending.empty()) {
+        queue.scheduled = false;
+        return;
+      }
+      std::swap(queue.delivering, queue.pending);
+      queue.started += queue.delivering.size();
+    }
 
-  for (auto& handler : handlers) {
-    handler.second(notification, *this);
+    for (const auto& notification : queue.delivering) {
+      // The handlers are looked up when the notification is delivered rather
+      // than when it is queued, so that a handler that has been unregistered
+      // in the meantime is not invoked.
+      auto current_groups = notification_handler_groups_.load();
+      auto current = std::find_if(
+          current_groups->begin(), current_groups->end(),
+          [&queue](const auto& candidate) {
+            return candidate->queue.get() == &queue;
+          });
+      if (current == current_groups->end()) {
+        continue;
+      }
+      for (const auto& entry : (*current)->handlers) {
+        entry.second(notification, *this);
+      }
+    }
+
+    {
+      const std::lock_guard lock(notification_delivery_lock_);
+      queue.finished += queue.delivering.size();
+    }
+    queue.delivering.clear();
+    notification_delivery_done_.notify_all();
   }
 }
@@ -1,7 +1,14 @@
 #ifndef XBDM_GDB_BRIDGE_XBDM_CONTEXT_H
 #define XBDM_GDB_BRIDGE_XBDM_CONTEXT_H
 
+#include <algorithm>
+#include <atomic>
+#include <boost/asio/strand.hpp>
 #include <boost/asio/thread_pool.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
 #include <future>
 #include <list>
 #include <map>
@@ -9,12 +16,15 @@
 #include <mutex>
 #include <string>
 #include <unordered_set>
+#include <vector>
 
 #include "net/ip_address.h"
+#include "rdcp/transport_metrics.h"
 
 class DelegatingServer;
 class RDCPProcessedRequest;
 class SelectThread;
+class SessionCaptureWriter;
 class XBDMNotification;
 class XBDMNotificationTransport;
 class XBDMTransport;
@@ -25,6 +35,58 @@ class XBDMContext {
                              XBDMContext&)>
       NotificationHandler;
 
+  //! The ordering key used by handlers that do not specify one.
+  static constexpr const char kDefaultNotificationOrderingKey[] = "";
+
+  //! The number of threads on which notification handlers are invoked.
+  static constexpr int kNotificationDispatchThreads = 4;
+
+  //! Timing information for a batch of requests sent via SendBatch.
+  struct BatchTiming {
+    //! Milliseconds from the batch being queued until each request completed.
+    std::vector<double> completion_milliseconds;
+    //! Milliseconds from the batch being queued until the final response.
+    double total_milliseconds{0};
+
+    //! Estimates the time saved relative to sending the requests one at a
+    //! time, assuming that each would have taken as long as the first.
+    [[nodiscard]] double EstimatedSavingsMilliseconds() const {
+      if (completion_milliseconds.empty()) {
+        return 0;
+      }
+      auto serial = completion_milliseconds.front() *
+                    static_cast<double>(completion_milliseconds.size());
+      return std::max(0.0, serial - total_milliseconds);
+    }
+  };
+
+  //! Controls how a dropped or unresponsive XBDM connection is re-established
+  //! before a command is sent.
+  struct ReconnectPolicy {
+    //! The number of additional connection attempts made before a command
+    //! fails with ERR_NOT_CONNECTED.
+    int max_retries{3};
+    //! The delay before the first retry. Doubled after each failed attempt.
+    int initial_backoff_milliseconds{50};
+    int max_backoff_milliseconds{2000};
+    //! How long to wait for XBDM to accept a connection.
+    int connect_timeout_milliseconds{5000};
+  };
+
+  //! Connection statistics across the control and dedicated channels.
+  struct ConnectionMetrics {
+    //! The number of connections accepted by XBDM.
+    uint64_t connections{0};
+    //! The number of times a channel replaced its transport.
+    uint64_t reconnects{0};
+    //! The number of connection attempts that were refused or timed out.
+    uint64_t failed_connects{0};
+    //! Time from opening a socket until XBDM sent its connection banner.
+    double last_connect_milliseconds{0};
+    double max_connect_milliseconds{0};
+    double total_connect_milliseconds{0};
+  };
+
  public:
   XBDMContext(std::string name, IPAddress xbox_address,
               std::shared_ptr<SelectThread> select_thread);
@@ -36,17 +98,55 @@ class XBDMContext {
   //! notification streams from the Xbox.
   void CloseActiveConnections();
 
+  //! Closes the XBDM transport socket, leaving notification streams open.
+  void CloseControlConnection();
+
   //! Hard closes any outstanding notification streams.
   void ResetNotificationConnections();
 
-  //! Drops the XBDM transport socket and immediately reconnects.
+  //! Drops the XBDM transport socket and immediately reconnects. Requests that
+  //! have not yet been sent are held and sent on the new connection.
   bool Reconnect();
 
+  void SetReconnectPolicy(const ReconnectPolicy& policy);
+  [[nodiscard]] ConnectionMetrics GetConnectionMetrics() const;
+
+  //! Returns per-command request statistics for the control channel and each
+  //! dedicated channel, keyed by channel name.
+  std::map<std::string, TransportMetrics::Snapshot> GetTransportMetrics();
+  void ResetTransportMetrics();
+
+  //! Records all traffic on the control, dedicated and notification channels
+  //! to the given file, replacing any capture in progress. The capture may be
+  //! served back by a SessionReplayServer.
+  bool StartCapture(const std::filesystem::path& path);
+  //! Stops recording and closes the capture file.
+  void StopCapture();
+  //! Returns the writer for the capture in progress, if any.
+  [[nodiscard]] std::shared_ptr<SessionCaptureWriter> GetCapture() const;
+
   bool StartNotificationListener(const IPAddress& address);
   bool GetNotificationServerAddress(IPAddress& address) const;
 
-  int RegisterNotificationHandler(NotificationHandler);
-  void UnregisterNotificationHandler(int);
+  //! Registers a handler that is invoked for every notification received from
+  //! XBDM and returns an ID that may be passed to
+  //! UnregisterNotificationHandler.
+  //!
+  //! Handlers sharing an `ordering_key` are invoked serially, in registration
+  //! order, and see notifications in the order they were received. Handlers
+  //! with different keys may run concurrently, so a slow handler only delays
+  //! those that share its key.
+  //!
+  //! A NotificationReconnected is delivered whenever XBDM establishes another
+  //! notification channel, ahead of any notification received on it.
+  int RegisterNotificationHandler(
+      NotificationHandler handler,
+      const std::string& ordering_key = kDefaultNotificationOrderingKey);
+
+  //! Unregisters a notification handler. Once this returns the handler is not
+  //! running and will not be invoked again, unless this is called from the
+  //! handler itself or another handler sharing its ordering key.
+  void UnregisterNotificationHandler(int id);
 
   std::future<std::shared_ptr<RDCPProcessedRequest>> SendCommand(
       const std::shared_ptr<RDCPProcessedRequest>& command);
@@ -59,36 +159,141 @@ class XBDMContext {
       const std::shared_ptr<RDCPProcessedRequest>& command,
       const std::string& dedicated_handler);
 
+  //! Sends the given command without blocking the calling thread.
+  //!
+  //! `on_complete` is invoked exactly once, from the SelectThread when the
+  //! response has been processed or from an executor thread if the command
+  //! could not be sent. It must not block.
+  void SendCommandAsync(const std::shared_ptr<RDCPProcessedRequest>& command,
+                        std::function<void()> on_complete);
+  void SendCommandAsync(const std::shared_ptr<RDCPProcessedRequest>& command,
+                        const std::string& dedicated_handler,
+                        std::function<void()> on_complete);
+
+  //! Writes all of the given requests to the XBDM transport back to back and
+  //! blocks until every one of them has completed. Requests are completed in
+  //! order and each carries its own status.
+  //!
+  //! Returns true if every request completed with an OK status.
+  bool SendBatch(
+      const std::vector<std::shared_ptr<RDCPProcessedRequest>>& requests,
+      BatchTiming* timing = nullptr);
+  bool SendBatch(
+      const std::vector<std::shared_ptr<RDCPProcessedRequest>>& requests,
+      const std::string& dedicated_handler, BatchTiming* timing = nullptr);
+
   bool CreateDedicatedChannel(const std::string& command_handler);
   void DestroyDedicatedChannel(const std::string& command_handler);
 
  private:
-  std::future<std::shared_ptr<RDCPProcessedRequest>> SendCommand(
-      const std::shared_ptr<RDCPProcessedRequest>& command,
-      const std::shared_ptr<XBDMTransport>& transport);
-  std::shared_ptr<RDCPProcessedRequest> SendCommandSync(
-      std::shared_ptr<RDCPProcessedRequest> command,
-      const std::shared_ptr<XBDMTransport>& transport);
+  //! A connection to XBDM and the executor that serializes the dispatch of
+  //! commands to it. The transport is replaced each time the channel
+  //! reconnects.
+  struct Channel {
+    explicit Channel(std::string name) : name(std::move(name)) {}
+
+    //! The name given to each of the channel's transports.
+    const std::string name;
+
+    //! Guards `transport`. Held while the transport is being replaced.
+    std::recursive_mutex transport_lock;
+    std::shared_ptr<XBDMTransport> transport;
+
+    //! Guards `executor`. Never held while work is dispatched.
+    std::mutex executor_lock;
+    std::shared_ptr<boost::asio::thread_pool> executor;
+
+    //! Shared by each of the channel's transports.
+    const std::shared_ptr<TransportMetrics> metrics{
+        std::make_shared<TransportMetrics>()};
+  };
+
+  static std::shared_ptr<XBDMTransport> GetTransport(Channel& channel);
+  static std::shared_ptr<boost::asio::thread_pool> GetExecutor(
+      Channel& channel);
+
+  void SendCommandAsync(const std::shared_ptr<RDCPProcessedRequest>& command,
+                        const std::shared_ptr<Channel>& channel,
+                        std::function<void()> on_complete);
+
+  bool SendBatch(
+      const std::vector<std::shared_ptr<RDCPProcessedRequest>>& requests,
+      const std::shared_ptr<Channel>& channel, BatchTiming* timing);
+
+  //! Stops the channel's executor and closes its transport, abandoning any
+  //! outstanding requests.
+  static void CloseChannel(Channel& channel);
+
+  //! Replaces the channel's transport with a new connection, moving over any
+  //! requests that have not yet been sent.
+  //!
+  //! If `expected` is set and the channel's transport has already been
+  //! replaced by another thread, the channel is left untouched.
+  bool ReconnectChannel(const std::shared_ptr<Channel>& channel,
+                        const std::shared_ptr<XBDMTransport>& expected);
+
+  void OnTransportStateChanged(const std::weak_ptr<Channel>& weak_channel,
+                               XBDMTransport& transport);
+
+  //! Returns the channel for the given handler, creating it if necessary.
+  std::shared_ptr<Channel> GetDedicatedChannel(
+      const std::string& command_handler);
 
   void OnNotificationChannelConnected(int sock, IPAddress& address);
   void OnNotificationReceived(std::shared_ptr<XBDMNotification> notification);
 
-  void ExecuteXBDMPromise(
-      std::promise<std::shared_ptr<RDCPProcessedRequest>>& promise,
-      const std::shared_ptr<RDCPProcessedRequest>& request,
-      const std::shared_ptr<XBDMTransport>& transport);
-  bool XBDMConnect(const std::shared_ptr<XBDMTransport>& transport,
-                   int max_wait_millis = 5000);
+  void ExecuteXBDMRequest(const std::shared_ptr<RDCPProcessedRequest>& request,
+                          const std::shared_ptr<Channel>& channel);
+  void ExecuteXBDMBatch(
+      const std::vector<std::shared_ptr<RDCPProcessedRequest>>& requests,
+      const std::shared_ptr<Channel>& channel);
+
+  //! Returns the channel's transport once XBDM is ready to process commands,
+  //! reconnecting according to the ReconnectPolicy as necessary. Returns
+  //! nullptr and abandons any held requests if a connection cannot be made.
+  std::shared_ptr<XBDMTransport> XBDMConnect(
+      const std::shared_ptr<Channel>& channel);
+
+  //! Notifications awaiting delivery to a handler group, shared by every
+  //! version of the group. Guarded by `notification_delivery_lock_`.
+  struct NotificationQueue {
+    std::vector<std::shared_ptr<XBDMNotification>> pending;
+    //! The batch being delivered, which is swapped with `pending` so that
+    //! both buffers are reused. Only accessed on the group's strand.
+    std::vector<std::shared_ptr<XBDMNotification>> delivering;
+    //! Whether a task to deliver `pending` has been posted to the strand.
+    bool scheduled{false};
+    //! The number of notifications taken for delivery and fully delivered.
+    uint64_t started{0};
+    uint64_t finished{0};
+  };
+
+  //! Handlers sharing an ordering key, which are invoked in sequence on the
+  //! group's strand. Groups are immutable once published.
+  struct NotificationHandlerGroup {
+    std::string ordering_key;
+    boost::asio::strand<boost::asio::thread_pool::executor_type> strand;
+    std::shared_ptr<NotificationQueue> queue;
+    std::vector<std::pair<int, NotificationHandler>> handlers;
+  };
+  typedef std::vector<std::shared_ptr<const NotificationHandlerGroup>>
+      NotificationHandlerGroups;
 
   void DispatchNotification(
       const std::shared_ptr<XBDMNotification>& notification);
+  //! Invokes the current handlers of the group owning `queue` for each
+  //! pending notification. Runs on the group's strand.
+  void DeliverQueuedNotifications(NotificationQueue& queue);
+
+  //! Attaches `writer` to every existing transport.
+  void ApplyCapture(const std::shared_ptr<SessionCaptureWriter>& writer);
 
  private:
   std::string name_;
   IPAddress xbox_address_;
 
   std::shared_ptr<SelectThread> select_thread_;
-  std::shared_ptr<XBDMTransport> xbdm_transport_;
+  std::shared_ptr<Channel> control_channel_;
   std::shared_ptr<DelegatingServer> notification_server_;
 
   //! Set of XBDMNotificationTransport instances managing notification streams
@@ -96,16 +301,37 @@ class XBDMContext {
   std::unordered_set<std::shared_ptr<XBDMNotificationTransport>>
       notification_transports_;
   std::recursive_mutex notification_transports_lock_;
+  //! Whether any notification channel has been established, guarded by
+  //! `notification_transports_lock_`.
+  bool notification_channel_connected_{false};
 
-  //! Map of command processor name to dedicated transport channel.
-  std::map<std::string, std::shared_ptr<XBDMTransport>> dedicated_transports_;
+  //! Map of command processor name to dedicated transport channel. Each
+  //! channel has its own executor so that a slow command on one channel does
+  //! not block commands sent to the others.
+  std::map<std::string, std::shared_ptr<Channel>> dedicated_channels_;
+  std::recursive_mutex dedicated_channels_lock_;
+
+  mutable std::mutex connection_lock_;
+  ReconnectPolicy reconnect_policy_;
+  ConnectionMetrics connection_metrics_;
+  std::shared_ptr<SessionCaptureWriter> capture_;
 
-  std::shared_ptr<boost::asio::thread_pool> xbdm_control_executor_;
   std::shared_ptr<boost::asio::thread_pool> notification_executor_;
+  //! Set once the notification executor has been joined and will no longer
+  //! invoke handlers.
+  std::atomic<bool> notification_executor_stopped_{false};
+
+  //! Guards every NotificationQueue. `notification_delivery_done_` is
+  //! signalled when a batch has been delivered or the executor stops.
+  std::mutex notification_delivery_lock_;
+  std::condition_variable notification_delivery_done_;
 
-  std::recursive_mutex notification_handler_lock_;
+  //! Serializes changes to `notification_handler_groups_`, which is replaced
+  //! rather than modified so that dispatch may read it without locking.
+  std::mutex notification_handler_lock_;
   int next_notification_handler_id_{1};
-  std::map<int, NotificationHandler> notification_handlers_;
+  std::atomic<std::shared_ptr<const NotificationHandlerGroups>>
+      notification_handler_groups_;
 };
 
 #endif  // XBDM_GDB_BRIDGE_XBDM_CONTEXT_H
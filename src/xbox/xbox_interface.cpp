@@ -77,3 +77,18 @@ std::future<std::shared_ptr<RDCPProcessedRequest>> XBOXInterface::SendCommand(
   assert(xbdm_context_);
   return xbdm_context_->SendCommand(command, dedicated_handler);
 }
+
+void XBOXInterface::SendCommandAsync(
+    const std::shared_ptr<RDCPProcessedRequest>& command,
+    std::function<void()> on_complete) {
+  assert(xbdm_context_);
+  xbdm_context_->SendCommandAsync(command, std::move(on_complete));
+}
+
+void XBOXInterface::SendCommandAsync(
+    const std::shared_ptr<RDCPProcessedRequest>& command,
+    const std::string& dedicated_handler, std::function<void()> on_complete) {
+  assert(xbdm_context_);
+  xbdm_context_->SendCommandAsync(command, dedicated_handler,
+                                  std::move(on_complete));
+}
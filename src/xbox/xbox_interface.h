@@ -1,6 +1,7 @@
 #ifndef XBDM_GDB_BRIDGE_SRC_XBOX_XBOX_INTERFACE_H_
 #define XBDM_GDB_BRIDGE_SRC_XBOX_XBOX_INTERFACE_H_
 
+#include <functional>
 #include <future>
 #include <memory>
 #include <string>
@@ -48,6 +49,14 @@ class XBOXInterface {
       const std::shared_ptr<RDCPProcessedRequest>& command,
       const std::string& dedicated_handler);
 
+  //! Sends the given command without blocking. See
+  //! XBDMContext::SendCommandAsync.
+  void SendCommandAsync(const std::shared_ptr<RDCPProcessedRequest>& command,
+                        std::function<void()> on_complete);
+  void SendCommandAsync(const std::shared_ptr<RDCPProcessedRequest>& command,
+                        const std::string& dedicated_handler,
+                        std::function<void()> on_complete);
+
   [[nodiscard]] std::shared_ptr<ExpressionParser> GetExpressionParser() const {
     return expression_parser_;
   }
@@ -0,0 +1,207 @@
+#include <boost/test/unit_test.hpp>
+#include <map>
+
+#include "gdb/gdb_agent_expression.h"
+
+namespace {
+
+std::expected<int64_t, std::string> Run(
+    const std::vector<uint8_t>& bytecode,
+    const std::map<uint32_t, uint64_t>& registers = {},
+    const std::map<uint32_t, uint8_t>& memory = {}) {
+  GDBAgentExpression expression(bytecode);
+  return expression.Evaluate(
+      [&registers](uint32_t index) -> std::optional<uint64_t> {
+        auto it = registers.find(index);
+        if (it == registers.end()) {
+          return std::nullopt;
+        }
+        return it->second;
+      },
+      [&memory](uint32_t address, uint32_t size)
+          -> std::expected<std::vector<uint8_t>, std::string> {
+        std::vector<uint8_t> ret;
+        for (uint32_t i = 0; i < size; ++i) {
+          auto it = memory.find(address + i);
+          if (it == memory.end()) {
+            return std::unexpected("Unmapped");
+          }
+          ret.push_back(it->second);
+        }
+        return ret;
+      });
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(gdb_agent_expression_suite)
+
+BOOST_AUTO_TEST_CASE(parse_rejects_malformed_input) {
+  BOOST_TEST(!GDBAgentExpression::Parse(""));
+  BOOST_TEST(!GDBAgentExpression::Parse("X"));
+  BOOST_TEST(!GDBAgentExpression::Parse("X2,27"));
+  BOOST_TEST(!GDBAgentExpression::Parse("X1,zz"));
+  BOOST_TEST(!GDBAgentExpression::Parse("cmds:0,X1,27"));
+}
+
+BOOST_AUTO_TEST_CASE(parse_decodes_bytecode) {
+  auto expression = GDBAgentExpression::Parse("X3,22ff27");
+  BOOST_REQUIRE(expression);
+  std::vector<uint8_t> expected = {0x22, 0xFF, 0x27};
+  BOOST_TEST(expression->Bytecode() == expected,
+             boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(parse_list_splits_concatenated_expressions) {
+  auto expressions = GDBAgentExpression::ParseList("X2,2201X1,27");
+  BOOST_REQUIRE(expressions);
+  BOOST_REQUIRE(expressions->size() == 2);
+  BOOST_TEST((*expressions)[0].Bytecode().size() == 2);
+  BOOST_TEST((*expressions)[1].Bytecode().size() == 1);
+
+  BOOST_TEST(!GDBAgentExpression::ParseList("X2,2201X1,"));
+}
+
+BOOST_AUTO_TEST_CASE(register_equality) {
+  // $ecx == 3, as generated by GDB for `break foo if $ecx == 3`.
+  std::vector<uint8_t> bytecode = {0x26, 0x00, 0x01, 0x22, 0x03, 0x13, 0x27};
+
+  auto result = Run(bytecode, {{1, 3}});
+  BOOST_REQUIRE(result.has_value());
+  BOOST_TEST(*result == 1);
+
+  result = Run(bytecode, {{1, 4}});
+  BOOST_REQUIRE(result.has_value());
+  BOOST_TEST(*result == 0);
+}
+
+BOOST_AUTO_TEST_CASE(memory_reference_is_little_endian) {
+  // *(int32_t*)0x1000 < 0
+  std::vector<uint8_t> bytecode = {0x23, 0x10, 0x00, 0x19, 0x16,
+                                   0x20, 0x22, 0x00, 0x14, 0x27};
+  auto result = Run(bytecode, {},
+                    {{0x1000, 0xFE}, {0x1001, 0xFF}, {0x1002, 0xFF},
+                     {0x1003, 0xFF}});
+  BOOST_REQUIRE(result.has_value());
+  BOOST_TEST(*result == 1);
+
+  bytecode = {0x23, 0x10, 0x00, 0x18, 0x27};
+  result = Run(bytecode, {}, {{0x1000, 0x34}, {0x1001, 0x12}});
+  BOOST_REQUIRE(result.has_value());
+  BOOST_TEST(*result == 0x1234);
+}
+
+BOOST_AUTO_TEST_CASE(memory_errors_are_reported) {
+  std::vector<uint8_t> bytecode = {0x23, 0x20, 0x00, 0x17, 0x27};
+  auto result = Run(bytecode);
+  BOOST_REQUIRE(!result.has_value());
+  BOOST_TEST(result.error() == "Unmapped");
+}
+
+BOOST_AUTO_TEST_CASE(conditional_jump) {
+  // (reg0 ? 10 : 20), laid out as GDB emits `?:`.
+  std::vector<uint8_t> bytecode = {0x26, 0x00, 0x00,  // 0: reg 0
+                                   0x20, 0x00, 0x0B,  // 3: if_goto 11
+                                   0x22, 0x14,        // 6: const8 20
+                                   0x21, 0x00, 0x0D,  // 8: goto 13
+                                   0x22, 0x0A,        // 11: const8 10
+                                   0x27};             // 13: end
+  auto result = Run(bytecode, {{0, 1}});
+  BOOST_REQUIRE(result.has_value());
+  BOOST_TEST(*result == 10);
+
+  result = Run(bytecode, {{0, 0}});
+  BOOST_REQUIRE(result.has_value());
+  BOOST_TEST(*result == 20);
+}
+
+BOOST_AUTO_TEST_CASE(stack_manipulation) {
+  // 1 2 3 rot => 3 1 2, then 1 - 2.
+  std::vector<uint8_t> bytecode = {0x22, 0x01, 0x22, 0x02, 0x22,
+                                   0x03, 0x33, 0x03, 0x27};
+  auto result = Run(bytecode);
+  BOOST_REQUIRE(result.has_value());
+  BOOST_TEST(*result == -1);
+
+  // 1 2 swap => 2 1, then 2 - 1.
+  bytecode = {0x22, 0x01, 0x22, 0x02, 0x2B, 0x03, 0x27};
+  result = Run(bytecode);
+  BOOST_REQUIRE(result.has_value());
+  BOOST_TEST(*result == 1);
+
+  // pick 1 copies the item below the top.
+  bytecode = {0x22, 0x05, 0x22, 0x07, 0x32, 0x01, 0x27};
+  result = Run(bytecode);
+  BOOST_REQUIRE(result.has_value());
+  BOOST_TEST(*result == 5);
+}
+
+BOOST_AUTO_TEST_CASE(out_of_range_shifts) {
+  // const8 0xFF; ext 8 => -1, used as the shift count.
+  std::vector<uint8_t> bytecode = {0x22, 0x08, 0x22, 0xFF,
+                                   0x16, 0x08, 0x09, 0x27};
+  auto result = Run(bytecode);
+  BOOST_REQUIRE(result.has_value());
+  BOOST_TEST(*result == 0);
+
+  // -16 >> -1 (signed) fills with the sign bit.
+  bytecode = {0x22, 0xF0, 0x16, 0x08, 0x22, 0xFF, 0x16, 0x08, 0x0A, 0x27};
+  result = Run(bytecode);
+  BOOST_REQUIRE(result.has_value());
+  BOOST_TEST(*result == -1);
+
+  bytecode[8] = 0x0B;
+  result = Run(bytecode);
+  BOOST_REQUIRE(result.has_value());
+  BOOST_TEST(*result == 0);
+}
+
+BOOST_AUTO_TEST_CASE(invalid_programs_fail) {
+  // Stack underflow.
+  BOOST_TEST(!Run({0x02, 0x27}).has_value());
+  // Missing end.
+  BOOST_TEST(!Run({0x22, 0x01}).has_value());
+  // Division by zero.
+  BOOST_TEST(!Run({0x22, 0x01, 0x22, 0x00, 0x05, 0x27}).has_value());
+  // Unknown register.
+  BOOST_TEST(!Run({0x26, 0x00, 0x09, 0x27}).has_value());
+  // Infinite loop.
+  BOOST_TEST(!Run({0x21, 0x00, 0x00}).has_value());
+  // Floating point.
+  BOOST_TEST(!Run({0x01, 0x27}).has_value());
+}
+
+BOOST_AUTO_TEST_CASE(trace_opcodes_collect_memory) {
+  std::map<uint32_t, uint8_t> memory = {
+      {0x1000, 'h'}, {0x1001, 'i'}, {0x1002, 0}, {0x1003, 'x'}};
+  std::vector<std::pair<uint32_t, uint32_t>> collected;
+
+  // *(int16_t*)0x1000 via trace_quick, then the string at 0x1000 via tracenz.
+  std::vector<uint8_t> bytecode = {0x23, 0x10, 0x00, 0x0D, 0x02, 0x29,
+                                   0x23, 0x10, 0x00, 0x22, 0x04, 0x2F,
+                                   0x22, 0x00, 0x27};
+  GDBAgentExpression expression(bytecode);
+  auto result = expression.Evaluate(
+      nullptr,
+      [&memory](uint32_t address, uint32_t size)
+          -> std::expected<std::vector<uint8_t>, std::string> {
+        std::vector<uint8_t> ret;
+        for (uint32_t i = 0; i < size; ++i) {
+          ret.push_back(memory[address + i]);
+        }
+        return ret;
+      },
+      [&collected](uint32_t address,
+                   uint32_t size) -> std::expected<void, std::string> {
+        collected.emplace_back(address, size);
+        return {};
+      });
+  BOOST_REQUIRE(result.has_value());
+  BOOST_REQUIRE(collected.size() == 2);
+  BOOST_TEST(collected[0].first == 0x1000);
+  BOOST_TEST(collected[0].second == 2);
+  BOOST_TEST(collected[1].first == 0x1000);
+  BOOST_TEST(collected[1].second == 3);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,118 @@
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "notification/xbdm_notification.h"
+
+static std::shared_ptr<XBDMNotification> Parse(const std::string& message) {
+  return ParseXBDMNotification(message.c_str(),
+                               static_cast<long>(message.size()));
+}
+
+template <typename T>
+static std::shared_ptr<T> ParseAs(const std::string& message) {
+  auto ret = std::dynamic_pointer_cast<T>(Parse(message));
+  BOOST_REQUIRE(ret);
+  return ret;
+}
+
+BOOST_AUTO_TEST_SUITE(parse_notification)
+
+BOOST_AUTO_TEST_CASE(builtin_prefixes_dispatch_to_types) {
+  BOOST_TEST(Parse("vx!message")->Type() == NT_VX);
+  BOOST_TEST(Parse("debugstr thread=1 string=a")->Type() == NT_DEBUGSTR);
+  BOOST_TEST(Parse("modload name=\"a.xbe\"")->Type() == NT_MODULE_LOADED);
+  BOOST_TEST(Parse("sectload name=\".text\"")->Type() == NT_SECTION_LOADED);
+  BOOST_TEST(Parse("sectunload name=\".text\"")->Type() ==
+             NT_SECTION_UNLOADED);
+  BOOST_TEST(Parse("create thread=1 start=0x10")->Type() == NT_THREAD_CREATED);
+  BOOST_TEST(Parse("terminate thread=1")->Type() == NT_THREAD_TERMINATED);
+  BOOST_TEST(Parse("execution stopped")->Type() == NT_EXECUTION_STATE_CHANGED);
+  BOOST_TEST(Parse("break addr=0x10 thread=1")->Type() == NT_BREAKPOINT);
+  BOOST_TEST(Parse("data read addr=0x10 thread=1")->Type() == NT_WATCHPOINT);
+  BOOST_TEST(Parse("singlestep addr=0x10 thread=1")->Type() == NT_SINGLE_STEP);
+  BOOST_TEST(Parse("exception code=0x1 thread=1")->Type() == NT_EXCEPTION);
+}
+
+BOOST_AUTO_TEST_CASE(unknown_prefix_is_rejected) {
+  BOOST_TEST(!Parse(""));
+  BOOST_TEST(!Parse("debugstrthread=1"));
+  BOOST_TEST(!Parse("unknown!data"));
+  BOOST_TEST(!Parse("no delimiter"));
+}
+
+BOOST_AUTO_TEST_CASE(custom_prefix_is_matched_without_terminator) {
+  BOOST_REQUIRE(RegisterXBDMNotificationConstructor(
+      "test", MakeXBDMNotificationConstructor<NotificationVX>()));
+
+  // The buffer is deliberately not null terminated after the message.
+  const char buffer[] = "test!payload!trailing";
+  auto notification =
+      std::dynamic_pointer_cast<NotificationVX>(ParseXBDMNotification(
+          buffer, static_cast<long>(strlen("test!payload"))));
+  BOOST_REQUIRE(notification);
+  BOOST_TEST(notification->message == "payload");
+
+  BOOST_TEST(UnregisterXBDMNotificationConstructor("test"));
+  BOOST_TEST(!Parse("test!payload"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(debugstr)
+
+BOOST_AUTO_TEST_CASE(terminators_are_parsed) {
+  auto lf = ParseAs<NotificationDebugStr>("debugstr thread=4 lf string=Text");
+  BOOST_TEST(lf->thread_id == 4);
+  BOOST_TEST(lf->text == "Text");
+  BOOST_TEST(lf->termination == "\n");
+  BOOST_TEST(lf->is_terminated);
+
+  auto cr = ParseAs<NotificationDebugStr>("debugstr thread=5 cr string=Text");
+  BOOST_TEST(cr->termination == "\r");
+
+  auto crlf =
+      ParseAs<NotificationDebugStr>("debugstr thread=6 crlf string=Text");
+  BOOST_TEST(crlf->thread_id == 6);
+  BOOST_TEST(crlf->termination == "\r\n");
+  BOOST_TEST(crlf->text == "Text");
+}
+
+BOOST_AUTO_TEST_CASE(unterminated_fragment) {
+  auto fragment =
+      ParseAs<NotificationDebugStr>("debugstr thread=12 string=Partial ");
+  BOOST_TEST(fragment->thread_id == 12);
+  BOOST_TEST(fragment->text == "Partial ");
+  BOOST_TEST(fragment->termination.empty());
+  BOOST_TEST(!fragment->is_terminated);
+}
+
+BOOST_AUTO_TEST_CASE(text_may_contain_keywords) {
+  auto notification = ParseAs<NotificationDebugStr>(
+      "debugstr thread=1 lf string=string= thread=2 crlf");
+  BOOST_TEST(notification->thread_id == 1);
+  BOOST_TEST(notification->text == "string= thread=2 crlf");
+  BOOST_TEST(notification->termination == "\n");
+}
+
+BOOST_AUTO_TEST_CASE(empty_text) {
+  auto notification =
+      ParseAs<NotificationDebugStr>("debugstr thread=1 lf string=");
+  BOOST_TEST(notification->text.empty());
+  BOOST_TEST(notification->is_terminated);
+}
+
+BOOST_AUTO_TEST_CASE(malformed_input_is_reported_as_invalid_thread) {
+  for (const auto* message :
+       {"debugstr thread= lf string=x", "debugstr thread=1lf string=x",
+        "debugstr thread=1 lf text=x", "debugstr string=x",
+        "debugstr thread=99999999999 lf string=x"}) {
+    auto notification = ParseAs<NotificationDebugStr>(message);
+    BOOST_TEST(notification->thread_id == -1, message);
+    BOOST_TEST(notification->text.empty());
+    BOOST_TEST(notification->is_terminated);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -171,3 +171,42 @@ BOOST_AUTO_TEST_CASE(multi_maps) {
 }
 
 BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(completion_handler_suite)
+
+BOOST_AUTO_TEST_CASE(complete_invokes_handler_once) {
+  RDCPProcessedRequest request("test");
+  int calls = 0;
+  request.SetCompletionHandler([&calls]() { ++calls; });
+
+  request.Complete(std::make_shared<RDCPResponse>(OK, "done"));
+
+  BOOST_TEST(calls == 1);
+  BOOST_TEST(request.IsCompleted());
+  BOOST_TEST(request.status == OK);
+  BOOST_TEST(request.WaitUntilCompleted(0));
+}
+
+BOOST_AUTO_TEST_CASE(abandon_invokes_handler) {
+  RDCPProcessedRequest request("test");
+  StatusCode status_in_handler = INVALID;
+  request.SetCompletionHandler(
+      [&]() { status_in_handler = request.status; });
+
+  request.Abandon();
+
+  BOOST_TEST(status_in_handler == ERR_ABANDONED);
+}
+
+BOOST_AUTO_TEST_CASE(set_completion_handler_resets_completion) {
+  RDCPProcessedRequest request("test");
+  request.Fail(ERR_NOT_CONNECTED);
+  BOOST_TEST(request.IsCompleted());
+
+  request.SetCompletionHandler(nullptr);
+
+  BOOST_TEST(!request.IsCompleted());
+  BOOST_TEST(!request.WaitUntilCompleted(0));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,136 @@
+#include <boost/test/unit_test.hpp>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "rdcp/session_capture.h"
+
+using session_capture::Record;
+using session_capture::RecordType;
+using session_capture::StreamKind;
+
+namespace {
+
+std::filesystem::path TempCapturePath(const char* name) {
+  auto path = std::filesystem::temp_directory_path() / name;
+  std::filesystem::remove(path);
+  return path;
+}
+
+std::string Payload(const Record& record) {
+  return {record.data.begin(), record.data.end()};
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(session_capture_suite)
+
+BOOST_AUTO_TEST_CASE(records_round_trip) {
+  auto path = TempCapturePath("xbdm_gdb_bridge_capture_round_trip.cap");
+  std::string large(100000, 'x');
+  {
+    auto writer = SessionCaptureWriter::Create(path);
+    BOOST_REQUIRE(writer);
+    auto control = writer->OpenStream(StreamKind::CONTROL, "XBDM");
+    auto notification =
+        writer->OpenStream(StreamKind::NOTIFICATION, "XBDMNotif");
+    BOOST_TEST(control != notification);
+
+    writer->Record(control, RecordType::REQUEST, "threads\r\n", 9);
+    writer->Record(notification, RecordType::NOTIFICATION, "hello\r\n", 7);
+    writer->Record(control, RecordType::RESPONSE, large.data(), large.size());
+    writer->Record(control, RecordType::STREAM_CLOSED, nullptr, 0);
+  }
+
+  std::vector<Record> records;
+  BOOST_REQUIRE(session_capture::ReadCapture(path, records));
+  BOOST_REQUIRE(records.size() == 6);
+
+  BOOST_TEST((records[0].type == RecordType::STREAM_OPENED));
+  BOOST_TEST(records[0].data.front() ==
+             static_cast<uint8_t>(StreamKind::CONTROL));
+  BOOST_TEST(Payload(records[0]).substr(1) == "XBDM");
+  BOOST_TEST(Payload(records[1]).substr(1) == "XBDMNotif");
+
+  BOOST_TEST((records[2].type == RecordType::REQUEST));
+  BOOST_TEST(records[2].stream_id == records[0].stream_id);
+  BOOST_TEST(Payload(records[2]) == "threads\r\n");
+  BOOST_TEST(records[3].stream_id == records[1].stream_id);
+  BOOST_TEST(Payload(records[3]) == "hello\r\n");
+  BOOST_TEST(Payload(records[4]) == large);
+  BOOST_TEST((records[5].type == RecordType::STREAM_CLOSED));
+  BOOST_TEST(records[5].data.empty());
+
+  for (size_t i = 1; i < records.size(); ++i) {
+    BOOST_TEST(records[i].timestamp_us >= records[i - 1].timestamp_us);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(truncated_record_is_ignored) {
+  auto path = TempCapturePath("xbdm_gdb_bridge_capture_truncated.cap");
+  {
+    auto writer = SessionCaptureWriter::Create(path);
+    BOOST_REQUIRE(writer);
+    auto stream = writer->OpenStream(StreamKind::CONTROL, "XBDM");
+    writer->Record(stream, RecordType::REQUEST, "go\r\n", 4);
+  }
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+
+  std::vector<Record> records;
+  BOOST_REQUIRE(session_capture::ReadCapture(path, records));
+  BOOST_TEST(records.size() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(record_longer_than_file_is_ignored) {
+  auto path = TempCapturePath("xbdm_gdb_bridge_capture_oversized.cap");
+  {
+    auto writer = SessionCaptureWriter::Create(path);
+    BOOST_REQUIRE(writer);
+    auto stream = writer->OpenStream(StreamKind::CONTROL, "XBDM");
+    writer->Record(stream, RecordType::REQUEST, "go\r\n", 4);
+  }
+  {
+    // type, stream ID and delta followed by a length of 2^62.
+    std::ofstream out(path, std::ios::binary | std::ios::app);
+    out << '\x02' << '\x00' << '\x00'
+        << "\x80\x80\x80\x80\x80\x80\x80\x80\x40" << "data";
+  }
+
+  std::vector<Record> records;
+  BOOST_REQUIRE(session_capture::ReadCapture(path, records));
+  BOOST_TEST(records.size() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(rejects_non_capture) {
+  auto path = TempCapturePath("xbdm_gdb_bridge_capture_invalid.cap");
+  std::ofstream(path) << "not a capture";
+
+  std::vector<Record> records;
+  BOOST_TEST(!session_capture::ReadCapture(path, records));
+}
+
+BOOST_AUTO_TEST_CASE(stream_records_only_while_attached) {
+  auto path = TempCapturePath("xbdm_gdb_bridge_capture_stream.cap");
+  {
+    SessionCaptureStream stream(StreamKind::CONTROL);
+    stream.Record(RecordType::REQUEST, "ignored\r\n", 9);
+
+    auto writer = SessionCaptureWriter::Create(path);
+    BOOST_REQUIRE(writer);
+    stream.SetWriter(writer, "XBDM");
+    stream.SetWriter(writer, "XBDM");
+    stream.Record(RecordType::REQUEST, "go\r\n", 4);
+    stream.Close();
+    stream.Record(RecordType::REQUEST, "ignored\r\n", 9);
+  }
+
+  std::vector<Record> records;
+  BOOST_REQUIRE(session_capture::ReadCapture(path, records));
+  BOOST_REQUIRE(records.size() == 3);
+  BOOST_TEST((records[0].type == RecordType::STREAM_OPENED));
+  BOOST_TEST(Payload(records[1]) == "go\r\n");
+  BOOST_TEST((records[2].type == RecordType::STREAM_CLOSED));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,154 @@
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <sstream>
+#include <string>
+
+#include "rdcp/transport_metrics.h"
+
+using namespace std::chrono_literals;
+
+BOOST_AUTO_TEST_SUITE(latency_histogram_suite)
+
+BOOST_AUTO_TEST_CASE(empty_histogram) {
+  LatencyHistogram histogram;
+  BOOST_TEST(histogram.Count() == 0);
+  BOOST_TEST(histogram.MinMicroseconds() == 0);
+  BOOST_TEST(histogram.ValueAtPercentile(50) == 0);
+  BOOST_TEST(histogram.MeanMicroseconds() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(small_values_are_exact) {
+  LatencyHistogram histogram;
+  for (uint64_t i = 0; i < LatencyHistogram::kSubBucketCount; ++i) {
+    histogram.Record(i);
+  }
+
+  BOOST_TEST(histogram.ValueAtPercentile(0) == 0);
+  BOOST_TEST(histogram.ValueAtPercentile(50) == 7);
+  BOOST_TEST(histogram.ValueAtPercentile(100) ==
+             LatencyHistogram::kSubBucketCount - 1);
+}
+
+BOOST_AUTO_TEST_CASE(large_values_have_bounded_error) {
+  for (uint64_t value : {17ULL, 1000ULL, 123456ULL, 987654321ULL}) {
+    LatencyHistogram histogram;
+    histogram.Record(value);
+    histogram.Record(value * 2);
+
+    auto reported = histogram.ValueAtPercentile(50);
+    BOOST_TEST(reported >= value);
+    BOOST_TEST(reported - value <= value / LatencyHistogram::kSubBucketCount);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(percentiles_and_summary) {
+  LatencyHistogram histogram;
+  for (uint64_t i = 1; i <= 100; ++i) {
+    histogram.Record(i * 1000);
+  }
+
+  BOOST_TEST(histogram.Count() == 100);
+  BOOST_TEST(histogram.MinMicroseconds() == 1000);
+  BOOST_TEST(histogram.MaxMicroseconds() == 100000);
+  BOOST_TEST(histogram.MeanMicroseconds() == 50500.0);
+  BOOST_TEST(histogram.ValueAtPercentile(100) == 100000);
+
+  auto p90 = histogram.ValueAtPercentile(90);
+  BOOST_TEST(p90 >= 90000);
+  BOOST_TEST(p90 <= 90000 + 90000 / LatencyHistogram::kSubBucketCount);
+
+  BOOST_TEST(histogram.CountAtOrBelow(0) == 0);
+  BOOST_TEST(histogram.CountAtOrBelow(UINT64_MAX) == 100);
+}
+
+BOOST_AUTO_TEST_CASE(count_at_or_below_interpolates_within_bucket) {
+  LatencyHistogram histogram;
+  histogram.Record(10);
+  // Values 1024 to 1087 share a single bucket.
+  for (uint64_t i = 1024; i < 1088; ++i) {
+    histogram.Record(i);
+  }
+  histogram.Record(2000);
+
+  BOOST_TEST(histogram.CountAtOrBelow(9) == 0);
+  BOOST_TEST(histogram.CountAtOrBelow(10) == 1);
+  BOOST_TEST(histogram.CountAtOrBelow(1023) == 1);
+  BOOST_TEST(histogram.CountAtOrBelow(1055) == 33);
+  BOOST_TEST(histogram.CountAtOrBelow(1087) == 65);
+  BOOST_TEST(histogram.CountAtOrBelow(1999) == 65);
+  BOOST_TEST(histogram.CountAtOrBelow(2000) == 66);
+}
+
+BOOST_AUTO_TEST_CASE(record_duration_and_merge) {
+  LatencyHistogram a;
+  LatencyHistogram b;
+  a.Record(std::chrono::steady_clock::duration(2ms));
+  b.Record(std::chrono::steady_clock::duration(5ms));
+  a.Merge(b);
+
+  BOOST_TEST(a.Count() == 2);
+  BOOST_TEST(a.MinMicroseconds() == 2000);
+  BOOST_TEST(a.MaxMicroseconds() == 5000);
+  BOOST_TEST(a.SumMicroseconds() == 7000);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(transport_metrics_suite)
+
+BOOST_AUTO_TEST_CASE(records_per_command) {
+  TransportMetrics metrics;
+  metrics.RecordQueueDepth(3);
+  metrics.RecordQueueDepth(1);
+  metrics.RecordCompletion("getmem2", 20, 100, 2ms);
+  metrics.RecordCompletion("getmem2", 20, 300, 4ms);
+  metrics.RecordCompletion("threads", 9, 50, 1ms);
+
+  auto snapshot = metrics.GetSnapshot();
+  BOOST_TEST(snapshot.queue_depth == 1);
+  BOOST_TEST(snapshot.max_queue_depth == 3);
+  BOOST_REQUIRE(snapshot.commands.size() == 2);
+
+  const auto& getmem = snapshot.commands.at("getmem2");
+  BOOST_TEST(getmem.count == 2);
+  BOOST_TEST(getmem.bytes_sent == 40);
+  BOOST_TEST(getmem.bytes_received == 400);
+  BOOST_TEST(getmem.round_trip.SumMicroseconds() == 6000);
+
+  metrics.Reset();
+  snapshot = metrics.GetSnapshot();
+  BOOST_TEST(snapshot.commands.empty());
+  BOOST_TEST(snapshot.queue_depth == 1);
+  BOOST_TEST(snapshot.max_queue_depth == 1);
+}
+
+BOOST_AUTO_TEST_CASE(prometheus_export) {
+  TransportMetrics metrics;
+  metrics.RecordCompletion("getmem2", 20, 100, 2ms);
+  metrics.RecordExecutorWait(50us);
+
+  std::map<std::string, TransportMetrics::Snapshot> snapshots;
+  snapshots["XBDM"] = metrics.GetSnapshot();
+
+  std::stringstream out;
+  WritePrometheusMetrics(out, snapshots);
+  auto text = out.str();
+
+  BOOST_TEST(text.find("# TYPE xbdm_command_requests_total counter") !=
+             std::string::npos);
+  BOOST_TEST(text.find("xbdm_command_requests_total{transport=\"XBDM\","
+                       "command=\"getmem2\"} 1\n") != std::string::npos);
+  BOOST_TEST(text.find("xbdm_command_round_trip_seconds_bucket{transport="
+                       "\"XBDM\",command=\"getmem2\",le=\"0.001\"} 0\n") !=
+             std::string::npos);
+  BOOST_TEST(text.find("xbdm_command_round_trip_seconds_bucket{transport="
+                       "\"XBDM\",command=\"getmem2\",le=\"0.0025\"} 1\n") !=
+             std::string::npos);
+  BOOST_TEST(text.find("xbdm_command_round_trip_seconds_count{transport="
+                       "\"XBDM\",command=\"getmem2\"} 1\n") !=
+             std::string::npos);
+  BOOST_TEST(text.find("xbdm_executor_wait_seconds_bucket{transport="
+                       "\"XBDM\",le=\"0.0001\"} 1\n") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
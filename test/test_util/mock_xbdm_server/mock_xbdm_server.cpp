@@ -380,6 +380,7 @@ bool MockXBDMServer::ProcessCommand(ClientTransport& client,
   HANDLE("debugger", Debugger)
   HANDLE("getcontext", GetContext)
   HANDLE("getmem2", GetMem2)
+  HANDLE("getsum", GetSum)
   HANDLE("go", Go)
   HANDLE("isstopped", IsStopped)
   HANDLE("modsections", ModSections)
@@ -788,6 +789,46 @@ bool MockXBDMServer::HandleGetMem2(ClientTransport& client,
   return true;
 }
 
+bool MockXBDMServer::HandleGetSum(ClientTransport& client,
+                                  const std::string& parameters) {
+  RDCPMapResponse params(parameters);
+
+  auto address = params.GetOptionalDWORD("addr");
+  auto length = params.GetOptionalDWORD("length");
+  auto block_size = params.GetOptionalDWORD("blocksize");
+  if (!address.has_value() || !length.has_value() ||
+      !block_size.has_value() || !block_size.value()) {
+    SendResponse(client, ERR_UNEXPECTED, "Missing parameters");
+    return true;
+  }
+
+  std::vector<uint8_t> data;
+  {
+    std::lock_guard lock(state_mutex_);
+    state_.ReadVirtualMemory(data, address.value(), length.value());
+  }
+  data.resize(length.value());
+
+  // The algorithm used by XBDM is not replicated, any function of the block
+  // contents is sufficient to detect changes. This uses FNV-1a.
+  std::vector<uint8_t> response;
+  auto blocks = static_cast<uint32_t>(length.value()) /
+                static_cast<uint32_t>(block_size.value());
+  for (uint32_t i = 0; i < blocks; ++i) {
+    uint32_t checksum = 0x811C9DC5;
+    auto begin = data.begin() + i * block_size.value();
+    std::for_each(begin, begin + block_size.value(), [&checksum](uint8_t b) {
+      checksum = (checksum ^ b) * 0x01000193;
+    });
+    for (int shift = 0; shift < 32; shift += 8) {
+      response.push_back(static_cast<uint8_t>(checksum >> shift));
+    }
+  }
+
+  SendBinaryResponse(client, response);
+  return true;
+}
+
 bool MockXBDMServer::HandleSetMem(ClientTransport& client,
                                   const std::string& parameters) {
   LOG_SERVER(trace) << "SetMem with parameters: " << parameters;
@@ -1098,6 +1139,25 @@ void MockXBDMServer::RemoveThread(uint32_t thread_id) {
   }
 }
 
+void MockXBDMServer::NotifyThreadCreated(uint32_t thread_id) {
+  SimulatedThread thread;
+  {
+    std::lock_guard lock(state_mutex_);
+    auto it = state_.threads.find(thread_id);
+    if (it == state_.threads.end()) {
+      return;
+    }
+    thread = it->second;
+  }
+  PostThreadCreateNotification(thread);
+}
+
+void MockXBDMServer::NotifyThreadTerminated(uint32_t thread_id) {
+  std::stringstream notification;
+  notification << "terminate thread=" << thread_id << "\r\n";
+  PostNotification(notification.str());
+}
+
 void MockXBDMServer::SetThreadRegister(uint32_t thread_id,
                                        const std::string& reg_name,
                                        uint32_t value) {
@@ -1295,6 +1355,11 @@ void MockXBDMServer::PerformReboot() {
   });
 }
 
+void MockXBDMServer::SimulateNotificationChannelDrop() {
+  SendNotificationAndClose("");
+  task_queue_->PostDelayed(1ms, [this]() { ReconnectNotificationChannels(); });
+}
+
 void MockXBDMServer::SimulateBootToDashboard() {
   std::lock_guard lock(state_mutex_);
   auto& info = state_.load_on_boot_info;
@@ -1466,6 +1531,26 @@ bool MockXBDMServer::SimulateExecutionBreakpoint(uint32_t address,
   return true;
 }
 
+bool MockXBDMServer::SimulateSingleStep(uint32_t address, uint32_t thread_id) {
+  std::lock_guard lock(state_mutex_);
+  auto entry = state_.threads.find(thread_id);
+  if (entry == state_.threads.end()) {
+    return false;
+  }
+
+  auto& thread = entry->second;
+  thread.eip = address;
+  thread.stopped = true;
+  thread.stop_reason = "singlestep";
+  SetExecutionState(S_STOPPED);
+
+  std::stringstream notification;
+  notification << "singlestep addr=0x" << std::hex << address
+               << " thread=" << std::dec << thread.id << " stop\r\n";
+  PostNotification(notification.str());
+  return true;
+}
+
 bool MockXBDMServer::SimulateReadWatchpoint(uint32_t address,
                                             uint32_t thread_id, bool stop) {
   return PostWatchpointNotification("read", address, thread_id, stop);
@@ -75,6 +75,10 @@ class MockXBDMServer {
                      uint32_t base = 0xd0000000, uint32_t start = 0x00060000,
                      uint32_t limit = 0);
   void RemoveThread(uint32_t thread_id);
+  //! Sends a thread creation notification for an existing thread.
+  void NotifyThreadCreated(uint32_t thread_id);
+  //! Sends a thread termination notification.
+  void NotifyThreadTerminated(uint32_t thread_id);
   void SetThreadRegister(uint32_t thread_id, const std::string& reg_name,
                          uint32_t value);
   void SuspendThread(uint32_t thread_id);
@@ -231,6 +235,14 @@ class MockXBDMServer {
    */
   bool SimulateExecutionBreakpoint(uint32_t address, uint32_t thread_id = 0);
 
+  /**
+   * Posts notifications simulating the given thread stopping at `address`
+   * after executing a single instruction with the trap flag set.
+   *
+   * @return true if the notifications were posted
+   */
+  bool SimulateSingleStep(uint32_t address, uint32_t thread_id);
+
   /**
    * Posts notifications simulating a watchpoint being hit within the given
    * thread due to a memory address being read.
@@ -272,6 +284,12 @@ class MockXBDMServer {
 
   void SimulateReboot() { PerformReboot(); }
 
+  /**
+   * Drops every notification channel without notice and then reopens it,
+   * discarding any notifications posted in between.
+   */
+  void SimulateNotificationChannelDrop();
+
  private:
   bool ProcessCommand(ClientTransport& client, const std::string& command,
                       const std::string& params);
@@ -282,6 +300,7 @@ class MockXBDMServer {
   bool HandleDebugger(ClientTransport& client, const std::string& parameters);
   bool HandleGetContext(ClientTransport& client, const std::string& parameters);
   bool HandleGetMem2(ClientTransport& client, const std::string& parameters);
+  bool HandleGetSum(ClientTransport& client, const std::string& parameters);
   bool HandleSetMem(ClientTransport& client, const std::string& parameters);
   bool HandleGo(ClientTransport& client, const std::string& parameters);
   bool HandleStop(ClientTransport& client, const std::string& parameters);
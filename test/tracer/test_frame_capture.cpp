@@ -1,4 +1,5 @@
 #include <boost/test/unit_test.hpp>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <vector>
@@ -201,6 +202,104 @@ BOOST_AUTO_TEST_CASE(test_process_aux_partial_packet) {
   BOOST_TEST(buffer.empty());
 }
 
+static std::vector<uint8_t> MakeTexturePacket(
+    uint32_t stage, const std::vector<uint8_t>& pixels) {
+  TextureHeader texture = {0};
+  texture.stage = stage;
+  texture.len = pixels.size();
+  // LU_IMAGE_A8R8G8B8, 2x2.
+  texture.format = 0x12 << 8;
+  texture.width = 2;
+  texture.height = 2;
+  texture.depth = 1;
+  texture.pitch = 8;
+
+  std::vector<uint8_t> ret(sizeof(texture));
+  memcpy(ret.data(), &texture, sizeof(texture));
+  ret.insert(ret.end(), pixels.begin(), pixels.end());
+  return ret;
+}
+
+static uint32_t CountFiles(const std::filesystem::path& path,
+                           const std::string& extension) {
+  uint32_t ret = 0;
+  for (const auto& entry : std::filesystem::directory_iterator(path)) {
+    if (entry.path().extension() == extension) {
+      ++ret;
+    }
+  }
+  return ret;
+}
+
+BOOST_AUTO_TEST_CASE(test_duplicate_textures_are_stored_once) {
+  std::vector<uint8_t> pixels(16, 0x7F);
+  for (uint32_t i = 0; i < 2; ++i) {
+    auto data = MakeTexturePacket(i, pixels);
+    AuxDataHeader header = {0};
+    header.packet_index = 10 + i;
+    header.data_type = ADT_TEXTURE;
+    header.len = data.size();
+    AddAuxPacket(header, data);
+  }
+
+  ProcessAux();
+
+  BOOST_TEST(GetAuxBuffer().empty());
+  BOOST_TEST(CountFiles(artifact_path / "textures", ".bin") == 1);
+  BOOST_TEST(CountFiles(artifact_path, ".txt") == 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_distinct_textures_are_stored_separately) {
+  for (uint32_t i = 0; i < 2; ++i) {
+    auto data = MakeTexturePacket(0, std::vector<uint8_t>(16, i));
+    AuxDataHeader header = {0};
+    header.packet_index = 10 + i;
+    header.data_type = ADT_TEXTURE;
+    header.len = data.size();
+    AddAuxPacket(header, data);
+  }
+
+  ProcessAux();
+
+  BOOST_TEST(GetAuxBuffer().empty());
+  BOOST_TEST(CountFiles(artifact_path / "textures", ".bin") == 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_texture_image_format_is_configurable) {
+  capture.SetImageOutputFormat(ImageOutputFormat::RAW);
+
+  auto data = MakeTexturePacket(0, std::vector<uint8_t>(16, 0x11));
+  AuxDataHeader header = {0};
+  header.data_type = ADT_TEXTURE;
+  header.len = data.size();
+  AddAuxPacket(header, data);
+
+  ProcessAux();
+
+  BOOST_TEST(CountFiles(artifact_path / "textures", ".raw") == 1);
+  BOOST_TEST(CountFiles(artifact_path / "textures", ".json") == 1);
+  BOOST_TEST(CountFiles(artifact_path / "textures", ".png") == 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_duplicate_texture_is_stored_in_new_image_format) {
+  auto data = MakeTexturePacket(0, std::vector<uint8_t>(16, 0x22));
+  AuxDataHeader header = {0};
+  header.data_type = ADT_TEXTURE;
+  header.len = data.size();
+  AddAuxPacket(header, data);
+  ProcessAux();
+
+  capture.SetImageOutputFormat(ImageOutputFormat::RAW);
+  header.packet_index = 1;
+  AddAuxPacket(header, data);
+  ProcessAux();
+
+  auto store_path = artifact_path / "textures";
+  BOOST_TEST(CountFiles(store_path, ".bin") == 1);
+  BOOST_TEST(CountFiles(store_path, ".png") == 1);
+  BOOST_TEST(CountFiles(store_path, ".raw") == 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace NTRCTracer
@@ -0,0 +1,88 @@
+#include <boost/test/unit_test.hpp>
+#include <vector>
+
+#include "tracer/image_util.h"
+
+BOOST_AUTO_TEST_SUITE(image_util_suite)
+
+BOOST_AUTO_TEST_CASE(test_parse_image_output_format) {
+  ImageOutputFormat format;
+  BOOST_TEST(ParseImageOutputFormat("fastpng", format));
+  BOOST_TEST((format == ImageOutputFormat::PNG_FAST));
+  BOOST_TEST(ParseImageOutputFormat("qoi", format));
+  BOOST_TEST((format == ImageOutputFormat::QOI));
+  BOOST_TEST(!ParseImageOutputFormat("jpeg", format));
+}
+
+BOOST_AUTO_TEST_CASE(test_qoi_falls_back_for_grey_images) {
+  BOOST_TEST(GetImageExtension(ImageOutputFormat::QOI, 4, 8) == "qoi");
+  BOOST_TEST(GetImageExtension(ImageOutputFormat::QOI, 1, 8) == "png");
+  BOOST_TEST(GetImageExtension(ImageOutputFormat::RAW, 1, 16) == "raw");
+}
+
+BOOST_AUTO_TEST_CASE(test_raw_output_is_unmodified) {
+  const std::vector<uint8_t> pixels = {1, 2, 3, 4, 5, 6};
+  std::vector<uint8_t> encoded;
+  BOOST_TEST(!EncodeImage(encoded, pixels.data(), 2, 1, 3, 8,
+                          ImageOutputFormat::RAW));
+  BOOST_TEST(encoded == pixels);
+}
+
+BOOST_AUTO_TEST_CASE(test_qoi_round_trip_rgba) {
+  const uint32_t width = 37;
+  const uint32_t height = 11;
+  std::vector<uint8_t> pixels(width * height * 4);
+  for (uint32_t i = 0; i < pixels.size(); ++i) {
+    // Mix runs, small deltas, and large jumps to exercise each op.
+    auto pixel = i / 4;
+    if (pixel % 13 < 5) {
+      pixels[i] = 0x40;
+    } else if (pixel % 13 < 9) {
+      pixels[i] = static_cast<uint8_t>(pixel + (i % 4));
+    } else {
+      pixels[i] = static_cast<uint8_t>(i * 97);
+    }
+  }
+
+  std::vector<uint8_t> encoded;
+  EncodeQOI(encoded, pixels.data(), width, height, 4);
+
+  std::vector<uint8_t> decoded;
+  uint32_t decoded_width;
+  uint32_t decoded_height;
+  uint32_t decoded_channels;
+  BOOST_REQUIRE(DecodeQOI(encoded, decoded, decoded_width, decoded_height,
+                          decoded_channels));
+  BOOST_TEST(decoded_width == width);
+  BOOST_TEST(decoded_height == height);
+  BOOST_TEST(decoded_channels == 4);
+  BOOST_TEST(decoded == pixels);
+}
+
+BOOST_AUTO_TEST_CASE(test_qoi_round_trip_rgb_solid) {
+  std::vector<uint8_t> pixels(64 * 64 * 3, 0x80);
+
+  std::vector<uint8_t> encoded;
+  EncodeQOI(encoded, pixels.data(), 64, 64, 3);
+  // A solid image should collapse to a handful of run ops.
+  BOOST_TEST(encoded.size() < 128);
+
+  std::vector<uint8_t> decoded;
+  uint32_t width;
+  uint32_t height;
+  uint32_t channels;
+  BOOST_REQUIRE(DecodeQOI(encoded, decoded, width, height, channels));
+  BOOST_TEST(channels == 3);
+  BOOST_TEST(decoded == pixels);
+}
+
+BOOST_AUTO_TEST_CASE(test_qoi_decode_rejects_invalid_data) {
+  std::vector<uint8_t> decoded;
+  uint32_t width;
+  uint32_t height;
+  uint32_t channels;
+  std::vector<uint8_t> garbage(32, 0xFF);
+  BOOST_TEST(!DecodeQOI(garbage, decoded, width, height, channels));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
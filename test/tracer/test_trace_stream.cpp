@@ -0,0 +1,160 @@
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#include "tracer/trace_stream.h"
+#include "tracer/tracer_xbox_shared.h"
+
+namespace NTRCTracer {
+
+class TraceStreamTestFixture {
+ public:
+  TraceStreamTestFixture() {
+    char temp_dir_template[] = "/tmp/trace_stream_test_XXXXXX";
+    temp_path = mkdtemp(temp_dir_template);
+  }
+
+  ~TraceStreamTestFixture() {
+    if (reader >= 0) {
+      close(reader);
+    }
+    if (listener >= 0) {
+      close(listener);
+    }
+    std::filesystem::remove_all(temp_path);
+  }
+
+  std::filesystem::path ListenOnSocket() {
+    auto path = temp_path / "stream.sock";
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    BOOST_REQUIRE(listener >= 0);
+    BOOST_REQUIRE(
+        !bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)));
+    BOOST_REQUIRE(!listen(listener, 1));
+    return path;
+  }
+
+  void Accept() {
+    reader = accept(listener, nullptr, nullptr);
+    BOOST_REQUIRE(reader >= 0);
+  }
+
+  std::vector<uint8_t> ReadAll() {
+    std::vector<uint8_t> ret;
+    uint8_t buffer[512];
+    while (true) {
+      auto bytes_read = read(reader, buffer, sizeof(buffer));
+      if (bytes_read <= 0) {
+        break;
+      }
+      ret.insert(ret.end(), buffer, buffer + bytes_read);
+    }
+    return ret;
+  }
+
+  std::filesystem::path temp_path;
+  int listener{-1};
+  int reader{-1};
+};
+
+BOOST_FIXTURE_TEST_SUITE(trace_stream_suite, TraceStreamTestFixture)
+
+BOOST_AUTO_TEST_CASE(test_open_invalid_target_fails) {
+  BOOST_TEST(!TraceStream::Open(temp_path / "does_not_exist"));
+  BOOST_TEST(!TraceStream::Open(temp_path));
+}
+
+BOOST_AUTO_TEST_CASE(test_socket_receives_framed_records) {
+  auto path = ListenOnSocket();
+  auto stream = TraceStream::Open(path);
+  BOOST_REQUIRE(stream);
+  Accept();
+
+  PushBufferCommandTraceInfo packet = {0};
+  packet.packet_index = 12;
+  const uint32_t params[] = {0xAABBCCDD, 0x11223344};
+  stream->WritePGRAPHCommand(packet, params, 2);
+
+  AuxDataHeader aux = {0};
+  aux.packet_index = 12;
+  aux.data_type = ADT_TEXTURE;
+  stream->WriteAuxHeader(aux);
+
+  stream->Close();
+  BOOST_TEST(stream->frames_written() == 2);
+  BOOST_TEST(stream->frames_dropped() == 0);
+
+  auto data = ReadAll();
+  auto expected_size = 2 * sizeof(TraceStreamFrameHeader) + sizeof(packet) +
+                       sizeof(params) + sizeof(aux);
+  BOOST_REQUIRE(data.size() == expected_size);
+
+  TraceStreamFrameHeader header;
+  memcpy(&header, data.data(), sizeof(header));
+  BOOST_TEST(header.magic == kTraceStreamMagic);
+  BOOST_TEST(header.type == TSFT_PGRAPH_COMMAND);
+  BOOST_TEST(header.sequence == 0);
+  BOOST_TEST(header.len == sizeof(packet) + sizeof(params));
+
+  uint32_t streamed_params[2];
+  memcpy(streamed_params, data.data() + sizeof(header) + sizeof(packet),
+         sizeof(streamed_params));
+  BOOST_TEST(streamed_params[0] == params[0]);
+  BOOST_TEST(streamed_params[1] == params[1]);
+
+  memcpy(&header, data.data() + sizeof(header) + header.len, sizeof(header));
+  BOOST_TEST(header.magic == kTraceStreamMagic);
+  BOOST_TEST(header.type == TSFT_AUX_HEADER);
+  BOOST_TEST(header.sequence == 1);
+  BOOST_TEST(header.len == sizeof(aux));
+}
+
+BOOST_AUTO_TEST_CASE(test_named_pipe_receives_records) {
+  auto path = temp_path / "stream.fifo";
+  BOOST_REQUIRE(!mkfifo(path.c_str(), 0600));
+  reader = open(path.c_str(), O_RDONLY | O_NONBLOCK);
+  BOOST_REQUIRE(reader >= 0);
+
+  auto stream = TraceStream::Open(path);
+  BOOST_REQUIRE(stream);
+
+  AuxDataHeader aux = {0};
+  stream->WriteAuxHeader(aux);
+  stream->Close();
+
+  fcntl(reader, F_SETFL, fcntl(reader, F_GETFL) & ~O_NONBLOCK);
+  auto data = ReadAll();
+  BOOST_TEST(data.size() == sizeof(TraceStreamFrameHeader) + sizeof(aux));
+}
+
+BOOST_AUTO_TEST_CASE(test_frames_exceeding_buffer_are_dropped) {
+  auto path = ListenOnSocket();
+  auto stream = TraceStream::Open(path, sizeof(TraceStreamFrameHeader));
+  BOOST_REQUIRE(stream);
+  Accept();
+
+  AuxDataHeader aux = {0};
+  stream->WriteAuxHeader(aux);
+  stream->Close();
+
+  BOOST_TEST(stream->frames_written() == 0);
+  BOOST_TEST(stream->frames_dropped() == 1);
+  BOOST_TEST(stream->bytes_dropped() ==
+             sizeof(TraceStreamFrameHeader) + sizeof(aux));
+  BOOST_TEST(ReadAll().empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace NTRCTracer
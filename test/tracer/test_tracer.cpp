@@ -0,0 +1,274 @@
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "configure_test.h"
+#include "ntrc_dyndxt.h"
+#include "test_util/mock_xbdm_server/mock_server_debugger_interface_fixture.h"
+#include "test_util/mock_xbdm_server/mock_xbdm_server.h"
+#include "tracer/tracer.h"
+#include "tracer/tracer_xbox_shared.h"
+#include "xbox/xbox_interface.h"
+
+using namespace xbdm_gdb_bridge;
+using namespace xbdm_gdb_bridge::testing;
+
+#define TRACER_TEST_CASE(__name) \
+  BOOST_AUTO_TEST_CASE(__name, *boost::unit_test::timeout(TEST_TIMEOUT_SECONDS))
+
+namespace NTRCTracer {
+
+class TracerTestFixture : public XBDMDebuggerInterfaceFixture {
+ public:
+  //! Data served by the mock server in response to one of the read commands.
+  struct MockStream {
+    std::deque<std::vector<uint8_t>> chunks;
+    ClientTransport* withheld_request{nullptr};
+    uint32_t requests{0};
+  };
+
+  TracerTestFixture() {
+    char temp_dir_template[] = "/tmp/tracer_test_XXXXXX";
+    artifact_path = mkdtemp(temp_dir_template);
+    tracer.in_progress_frame_.Setup(artifact_path);
+
+    server->SetCommandHandler(
+        NTRC_HANDLER_NAME "!read_pgraph",
+        [this](ClientTransport& client, const std::string&) {
+          return Serve(pgraph, aux, client);
+        });
+    server->SetCommandHandler(
+        NTRC_HANDLER_NAME "!read_aux",
+        [this](ClientTransport& client, const std::string&) {
+          return Serve(aux, pgraph, client);
+        });
+  }
+
+  ~TracerTestFixture() override {
+    tracer.in_progress_frame_.Close();
+    std::filesystem::remove_all(artifact_path);
+  }
+
+  //! Splits `data` into `chunk_size` pieces to be returned by consecutive
+  //! reads of the given stream.
+  void Enqueue(MockStream& stream, const std::vector<uint8_t>& data,
+               size_t chunk_size) {
+    const std::lock_guard lock(server_lock);
+    for (size_t offset = 0; offset < data.size(); offset += chunk_size) {
+      auto end = std::min(data.size(), offset + chunk_size);
+      stream.chunks.emplace_back(data.begin() + offset, data.begin() + end);
+    }
+  }
+
+  //! Responds to a read of `stream`. The first read of either stream is held
+  //! until the other stream is read, so a test will time out unless both
+  //! streams are fetched concurrently.
+  bool Serve(MockStream& stream, MockStream& other, ClientTransport& client) {
+    const std::lock_guard lock(server_lock);
+    ++stream.requests;
+    if (hold_responses) {
+      stream.withheld_request = &client;
+      return true;
+    }
+
+    if (!other_stream_read) {
+      if (!other.withheld_request) {
+        stream.withheld_request = &client;
+        return true;
+      }
+      other_stream_read = true;
+      SendNextChunk(other, *other.withheld_request);
+      other.withheld_request = nullptr;
+    }
+
+    SendNextChunk(stream, client);
+    return true;
+  }
+
+  //! Sends the next chunk of `stream` as a size prefixed binary response.
+  void SendNextChunk(MockStream& stream, ClientTransport& client) {
+    if (stream.chunks.empty()) {
+      server->SendResponse(client, ERR_DATA_NOT_AVAILABLE);
+      return;
+    }
+
+    auto& chunk = stream.chunks.front();
+    auto size = static_cast<uint32_t>(chunk.size());
+    std::vector<uint8_t> response(sizeof(size));
+    memcpy(response.data(), &size, sizeof(size));
+    response.insert(response.end(), chunk.begin(), chunk.end());
+    stream.chunks.pop_front();
+    server->SendBinaryResponse(client, response);
+  }
+
+  //! Sends any responses held because `hold_responses` was set.
+  void ReleaseWithheld() {
+    const std::lock_guard lock(server_lock);
+    hold_responses = false;
+    other_stream_read = true;
+    for (auto stream : {&pgraph, &aux}) {
+      if (stream->withheld_request) {
+        SendNextChunk(*stream, *stream->withheld_request);
+        stream->withheld_request = nullptr;
+      }
+    }
+  }
+
+  bool HasWithheld(const MockStream& stream) {
+    const std::lock_guard lock(server_lock);
+    return stream.withheld_request != nullptr;
+  }
+
+  uint32_t Requests(const MockStream& stream) {
+    const std::lock_guard lock(server_lock);
+    return stream.requests;
+  }
+
+  void SignalDataAvailable() {
+    tracer.pgraph_data_available_ = true;
+    tracer.aux_data_available_ = true;
+    tracer.NotifyFetchThreads();
+  }
+
+  void CompleteRequest() {
+    tracer.request_processed_ = true;
+    tracer.NotifyFetchThreads();
+  }
+
+  void ReportState(int state) {
+    tracer.OnNewState(state, *interface->Context());
+  }
+
+  void FetchTraceData() { tracer.FetchTraceData(*interface); }
+
+  [[nodiscard]] bool RequestFailed() const { return tracer.request_failed_; }
+
+  const std::list<PushBufferCommandTraceInfo>& PGRAPHCommands() const {
+    return tracer.in_progress_frame_.pgraph_commands;
+  }
+
+  std::filesystem::path artifact_path;
+  Tracer tracer;
+
+  std::mutex server_lock;
+  MockStream pgraph;
+  MockStream aux;
+  bool other_stream_read{false};
+  bool hold_responses{false};
+};
+
+static std::vector<uint8_t> BuildPGRAPHPackets(uint32_t count) {
+  std::vector<uint8_t> ret;
+  for (uint32_t i = 0; i < count; ++i) {
+    PushBufferCommandTraceInfo packet;
+    memset(&packet, 0, sizeof(packet));
+    packet.valid = 1;
+    packet.packet_index = i;
+    packet.graphics_class = 0x97;
+    packet.command.valid = 1;
+    packet.command.method = 0x1800 + i * 4;
+    packet.command.parameter_count = 1;
+    packet.data.data_state = PBCPDS_SMALL_BUFFER;
+    packet.data.data.buffer[0] = i;
+
+    auto start = reinterpret_cast<const uint8_t*>(&packet);
+    ret.insert(ret.end(), start, start + sizeof(packet));
+  }
+  return ret;
+}
+
+static std::vector<uint8_t> BuildAuxPackets(uint32_t count,
+                                            uint32_t data_len) {
+  std::vector<uint8_t> ret;
+  for (uint32_t i = 0; i < count; ++i) {
+    AuxDataHeader header;
+    memset(&header, 0, sizeof(header));
+    header.packet_index = i;
+    header.data_type = ADT_PGRAPH_DUMP;
+    header.len = data_len;
+
+    auto start = reinterpret_cast<const uint8_t*>(&header);
+    ret.insert(ret.end(), start, start + sizeof(header));
+    ret.insert(ret.end(), data_len, static_cast<uint8_t>(i));
+  }
+  return ret;
+}
+
+static std::vector<uint8_t> ReadFile(const std::filesystem::path& path) {
+  std::ifstream is(path, std::ios_base::binary);
+  return {std::istreambuf_iterator<char>(is),
+          std::istreambuf_iterator<char>()};
+}
+
+BOOST_FIXTURE_TEST_SUITE(tracer_fetch_suite, TracerTestFixture)
+
+TRACER_TEST_CASE(test_streams_are_fetched_concurrently_in_order) {
+  static constexpr uint32_t kPGRAPHPackets = 8;
+  static constexpr uint32_t kAuxPackets = 4;
+  static constexpr uint32_t kAuxDataLen = 24;
+
+  // Odd chunk sizes split packets across reads so that any reordering within a
+  // stream corrupts the reassembled packets.
+  Enqueue(pgraph, BuildPGRAPHPackets(kPGRAPHPackets), 19);
+  Enqueue(aux, BuildAuxPackets(kAuxPackets, kAuxDataLen), 13);
+
+  std::thread fetch_thread([this]() { FetchTraceData(); });
+  SignalDataAvailable();
+  CompleteRequest();
+  fetch_thread.join();
+
+  BOOST_TEST(!RequestFailed());
+
+  const auto& commands = PGRAPHCommands();
+  BOOST_REQUIRE(commands.size() == kPGRAPHPackets);
+  uint32_t expected_index = 0;
+  for (const auto& packet : commands) {
+    BOOST_TEST(packet.packet_index == expected_index);
+    BOOST_TEST(packet.command.method == 0x1800 + expected_index * 4);
+    BOOST_TEST(packet.data.data.buffer[0] == expected_index);
+    ++expected_index;
+  }
+
+  for (uint32_t i = 0; i < kAuxPackets; ++i) {
+    char filename[64];
+    snprintf(filename, sizeof(filename), "%010u_0_PGRAPH.bin", i);
+    auto content = ReadFile(artifact_path / filename);
+    BOOST_TEST(content == std::vector<uint8_t>(kAuxDataLen, i),
+               boost::test_tools::per_element());
+  }
+}
+
+TRACER_TEST_CASE(test_shutdown_during_fetch_stops_fetching) {
+  Enqueue(pgraph, BuildPGRAPHPackets(4), 19);
+  {
+    const std::lock_guard lock(server_lock);
+    hold_responses = true;
+  }
+
+  std::thread fetch_thread([this]() { FetchTraceData(); });
+  SignalDataAvailable();
+
+  while (!HasWithheld(pgraph) || !HasWithheld(aux)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  // The tracer shuts down before the in flight read completes.
+  ReportState(STATE_SHUTDOWN);
+  ReleaseWithheld();
+  fetch_thread.join();
+
+  BOOST_TEST(RequestFailed());
+  BOOST_TEST(Requests(pgraph) == 1);
+  BOOST_TEST(Requests(aux) == 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace NTRCTracer
@@ -0,0 +1,62 @@
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <vector>
+
+#include "tracer/unswizzle.h"
+extern "C" {
+#include "swizzle.h"
+}
+
+static std::vector<uint8_t> MakePattern(uint32_t size) {
+  std::vector<uint8_t> ret(size);
+  for (uint32_t i = 0; i < size; ++i) {
+    ret[i] = static_cast<uint8_t>((i * 31) ^ (i >> 8));
+  }
+  return ret;
+}
+
+static void CheckMatchesReference(uint32_t width, uint32_t height,
+                                  uint32_t bytes_per_pixel) {
+  auto pitch = width * bytes_per_pixel;
+  auto src = MakePattern(pitch * height);
+
+  std::vector<uint8_t> expected(src.size());
+  unswizzle_rect(src.data(), width, height, expected.data(), pitch,
+                 bytes_per_pixel);
+
+  std::vector<uint8_t> actual(src.size());
+  UnswizzleRect(src.data(), width, height, actual.data(), pitch,
+                bytes_per_pixel);
+
+  BOOST_TEST(actual == expected);
+}
+
+BOOST_AUTO_TEST_SUITE(unswizzle_suite)
+
+BOOST_AUTO_TEST_CASE(test_small_images_match_reference) {
+  CheckMatchesReference(1, 1, 4);
+  CheckMatchesReference(8, 32, 1);
+  CheckMatchesReference(32, 8, 2);
+  CheckMatchesReference(64, 64, 3);
+  CheckMatchesReference(16, 16, 4);
+}
+
+BOOST_AUTO_TEST_CASE(test_large_images_match_reference) {
+  CheckMatchesReference(512, 512, 4);
+  CheckMatchesReference(1024, 256, 2);
+  CheckMatchesReference(256, 1024, 4);
+}
+
+BOOST_AUTO_TEST_CASE(test_cached_tables_are_reused) {
+  // Repeated calls hit the table cache and must produce identical output.
+  CheckMatchesReference(512, 512, 4);
+  CheckMatchesReference(512, 512, 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_scratch_buffer_is_reused) {
+  auto first = GetUnswizzleScratchBuffer(128);
+  auto second = GetUnswizzleScratchBuffer(64);
+  BOOST_TEST(first == second);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,32 @@
+#include <boost/test/unit_test.hpp>
+#include <string>
+#include <vector>
+
+#include "util/hash.h"
+
+BOOST_AUTO_TEST_SUITE(hash_suite)
+
+BOOST_AUTO_TEST_CASE(xxhash64_empty) {
+  BOOST_TEST(XXHash64("", 0) == 0xEF46DB3751D8E999ULL);
+}
+
+BOOST_AUTO_TEST_CASE(xxhash64_short_input) {
+  BOOST_TEST(XXHash64("abc", 3) == 0x44BC2CF5AD770999ULL);
+}
+
+BOOST_AUTO_TEST_CASE(xxhash64_multiple_stripes) {
+  std::string input = "Nobody inspects the spammish repetition";
+  BOOST_TEST(XXHash64(input.data(), input.size()) == 0xFBCEA83C8A378BF1ULL);
+}
+
+BOOST_AUTO_TEST_CASE(xxhash64_seed_changes_result) {
+  std::vector<uint8_t> input(256, 0xAA);
+  BOOST_TEST(XXHash64(input.data(), input.size(), 0) !=
+             XXHash64(input.data(), input.size(), 1));
+}
+
+BOOST_AUTO_TEST_CASE(hash_to_string_is_zero_padded) {
+  BOOST_TEST(HashToString(0x1234) == "0000000000001234");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
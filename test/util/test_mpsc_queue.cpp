@@ -0,0 +1,77 @@
+#include <boost/test/unit_test.hpp>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "util/mpsc_queue.h"
+
+BOOST_AUTO_TEST_SUITE(mpsc_queue_suite)
+
+BOOST_AUTO_TEST_CASE(empty_queue_pops_nothing) {
+  MPSCQueue<int> queue;
+  BOOST_TEST(queue.Empty());
+  BOOST_TEST(!queue.Pop().has_value());
+}
+
+BOOST_AUTO_TEST_CASE(single_producer_is_fifo) {
+  MPSCQueue<int> queue;
+  for (int i = 0; i < 10; ++i) {
+    queue.Push(i);
+  }
+
+  BOOST_TEST(!queue.Empty());
+  for (int i = 0; i < 10; ++i) {
+    auto value = queue.Pop();
+    BOOST_REQUIRE(value.has_value());
+    BOOST_TEST(*value == i);
+  }
+  BOOST_TEST(queue.Empty());
+}
+
+BOOST_AUTO_TEST_CASE(destruction_releases_pending_elements) {
+  auto tracked = std::make_shared<int>(0);
+  {
+    MPSCQueue<std::shared_ptr<int>> queue;
+    queue.Push(tracked);
+    queue.Push(tracked);
+    queue.Pop();
+    BOOST_TEST(tracked.use_count() == 2);
+  }
+  BOOST_TEST(tracked.use_count() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(multiple_producers_preserve_per_producer_order) {
+  constexpr int kProducers = 4;
+  constexpr int kItemsPerProducer = 10000;
+  MPSCQueue<std::pair<int, int>> queue;
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&queue, p]() {
+      for (int i = 0; i < kItemsPerProducer; ++i) {
+        queue.Push({p, i});
+      }
+    });
+  }
+
+  std::vector<int> next_expected(kProducers, 0);
+  int received = 0;
+  while (received < kProducers * kItemsPerProducer) {
+    auto item = queue.Pop();
+    if (!item) {
+      std::this_thread::yield();
+      continue;
+    }
+    BOOST_REQUIRE_EQUAL(item->second, next_expected[item->first]);
+    ++next_expected[item->first];
+    ++received;
+  }
+
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  BOOST_TEST(queue.Empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
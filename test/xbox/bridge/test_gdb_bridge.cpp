@@ -0,0 +1,158 @@
+#include <sys/socket.h>
+
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "configure_test.h"
+#include "gdb/gdb_packet.h"
+#include "gdb/gdb_transport.h"
+#include "net/select_thread.h"
+#include "test_util/mock_xbdm_server/mock_xbdm_server.h"
+#include "xbox/bridge/gdb_bridge.h"
+#include "xbox/debugger/xbdm_debugger.h"
+#include "xbox/debugger/xbdm_debugger_fixture.h"
+#include "xbox/xbdm_context.h"
+
+using namespace xbdm_gdb_bridge;
+using namespace xbdm_gdb_bridge::testing;
+
+#define BRIDGE_TEST_CASE(__name) \
+  BOOST_AUTO_TEST_CASE(__name, *boost::unit_test::timeout(TEST_TIMEOUT_SECONDS))
+
+namespace {
+
+//! Runs a GDBBridge against the mock XBDM server, with a GDB client connected
+//! over a socket pair.
+struct GDBBridgeFixture : XBDMDebuggerFixture {
+  ~GDBBridgeFixture() {
+    if (bridge) {
+      bridge->Stop();
+      bridge.reset();
+    }
+    if (client_) {
+      client_->Close();
+    }
+  }
+
+  //! Attaches the debugger and connects a GDB client to a new bridge.
+  void ConnectBridge() {
+    Connect();
+
+    int sockets[2];
+    BOOST_REQUIRE(!socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+    auto transport = std::make_shared<GDBTransport>(
+        "GDBBridge", sockets[0], IPAddress(),
+        [](const std::shared_ptr<GDBPacket>&) {});
+    client_ = std::make_shared<GDBTransport>(
+        "GDBClient", sockets[1], IPAddress(),
+        [this](const std::shared_ptr<GDBPacket>& packet) {
+          const std::lock_guard lock(packets_lock_);
+          packets_.push_back(packet->DataString());
+          packets_condition_.notify_all();
+        });
+    select_thread_->AddConnection(transport);
+    select_thread_->AddConnection(client_);
+
+    // The bridge must be registered for notifications after the debugger.
+    bridge = std::make_shared<GDBBridge>(context_, debugger);
+    BOOST_REQUIRE(bridge->AddTransport(transport));
+  }
+
+  //! Discards any packets sent by the bridge and then sends it `data`.
+  void SendPacket(const std::string& data) {
+    {
+      const std::lock_guard lock(packets_lock_);
+      packets_.clear();
+    }
+    bridge->HandlePacket(GDBPacket(data));
+  }
+
+  //! Returns the next packet sent to the GDB client.
+  std::optional<std::string> NextPacket(uint32_t max_wait_milliseconds = 5000) {
+    std::unique_lock lock(packets_lock_);
+    if (!packets_condition_.wait_for(
+            lock, std::chrono::milliseconds(max_wait_milliseconds),
+            [this]() { return !packets_.empty(); })) {
+      return std::nullopt;
+    }
+    auto ret = packets_.front();
+    packets_.pop_front();
+    return ret;
+  }
+
+  std::shared_ptr<GDBBridge> bridge;
+
+ private:
+  std::shared_ptr<GDBTransport> client_;
+  std::mutex packets_lock_;
+  std::condition_variable packets_condition_;
+  std::deque<std::string> packets_;
+};
+
+std::string ThreadSuffix(uint32_t thread_id) {
+  char buffer[16];
+  snprintf(buffer, sizeof(buffer), ":%x", thread_id);
+  return buffer;
+}
+
+}  // namespace
+
+// ============================================================================
+// VContRangeTests
+// ============================================================================
+
+BOOST_FIXTURE_TEST_SUITE(VContRangeTests, GDBBridgeFixture)
+
+BRIDGE_TEST_CASE(MalformedRangeIsRejected) {
+  Bootup();
+  uint32_t tid = server->AddThread("test_thread", 0x10000);
+  ConnectBridge();
+  ScriptExecution();
+
+  auto thread = ThreadSuffix(tid);
+  for (const auto& range : {"", "10000", "zz,10008", "10000,", "1,2,3"}) {
+    SendPacket(std::string("vCont;r") + range + thread);
+    BOOST_TEST_INFO("range '" << range << "'");
+    BOOST_TEST(NextPacket().value_or("") == "E4a");
+  }
+}
+
+BRIDGE_TEST_CASE(RangeStepReportsStopAfterLeavingRange) {
+  Bootup();
+  server->AddRegion(0x10000, std::vector<uint8_t>(0x20, 0x90));
+  uint32_t tid = server->AddThread("test_thread", 0x10004);
+  ConnectBridge();
+  BOOST_REQUIRE(debugger->FetchThreads());
+
+  auto last_count = debugger->StopEventCount();
+  server->SimulateExecutionBreakpoint(0x10004, tid);
+  BOOST_REQUIRE(debugger->WaitForStopEvent(last_count, 5000));
+  ScriptExecution();
+  QueueSingleStep(tid, 0x10005);
+  QueueSingleStep(tid, 0x10006);
+  QueueSingleStep(tid, 0x10007);
+
+  SendPacket("vCont;r10004,10007" + ThreadSuffix(tid));
+
+  // GDB only sees the stop once the thread has left the range.
+  char expected[32];
+  snprintf(expected, sizeof(expected), "T05thread:%x;", tid);
+  auto packet = NextPacket();
+  BOOST_REQUIRE(packet.has_value());
+  BOOST_TEST(packet->starts_with(expected));
+  BOOST_TEST(GoCount() >= 3);
+
+  auto thread = debugger->GetThread(tid);
+  BOOST_REQUIRE(thread);
+  BOOST_TEST(thread->last_known_address.value_or(0) == 0x10007);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
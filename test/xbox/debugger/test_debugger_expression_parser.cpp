@@ -4,6 +4,7 @@
 #include <string>
 
 #include "xbox/debugger/debugger_expression_parser.h"
+#include "xbox/debugger/symbol_index.h"
 
 static std::expected<uint32_t, std::string> evaluate(const std::string& expr,
                                                      const ThreadContext& ctx) {
@@ -545,6 +546,39 @@ BOOST_AUTO_TEST_CASE(test_tid_not_available) {
 
 BOOST_AUTO_TEST_SUITE_END()
 
+BOOST_AUTO_TEST_SUITE(SymbolTests)
+
+BOOST_AUTO_TEST_CASE(test_symbol_resolution) {
+  SymbolIndex::Builder builder;
+  builder.AddSymbol(0x11000, 0, "_main");
+  builder.AddSymbol(0x12000, 0, "?Update@Game@@QAEXXZ");
+
+  ThreadContext ctx;
+  DebuggerExpressionParser parser(ctx);
+  parser.SetSymbolIndex(builder.Build());
+
+  auto result = parser.Parse("main + 0x10");
+  BOOST_REQUIRE(result.has_value());
+  BOOST_CHECK_EQUAL(result.value(), 0x11010);
+
+  result = parser.Parse("`?Update@Game@@QAEXXZ` == 0x12000");
+  BOOST_REQUIRE(result.has_value());
+  BOOST_CHECK_EQUAL(result.value(), 1);
+
+  result = parser.Parse("missing");
+  BOOST_REQUIRE(!result.has_value());
+  BOOST_CHECK(result.error().find("Unknown symbol") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(test_symbol_without_index) {
+  ThreadContext ctx;
+  auto result = evaluate("_main", ctx);
+  BOOST_REQUIRE(!result.has_value());
+  BOOST_CHECK(result.error().find("Unknown identifier") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
 static std::expected<std::vector<uint8_t>, std::string> MockMemoryReader(
     uint32_t address, uint32_t size) {
   if (address == 0x123) {
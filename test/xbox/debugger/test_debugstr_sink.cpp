@@ -0,0 +1,177 @@
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "xbox/debugger/debugstr_sink.h"
+
+namespace {
+
+struct DebugStrSinkFixture {
+  DebugStrSinkFixture()
+      : sink(
+            [this](int thread_id, const std::string& line) {
+              lines.emplace_back(thread_id, line);
+            },
+            [this](uint64_t count) { suppressed.push_back(count); }) {}
+
+  std::vector<std::pair<int, std::string>> lines;
+  std::vector<uint64_t> suppressed;
+  DebugStrSink sink;
+};
+
+std::filesystem::path TempLogPath(const char* name) {
+  auto path = std::filesystem::temp_directory_path() / name;
+  std::filesystem::remove(path);
+  return path;
+}
+
+std::vector<std::string> ReadLines(const std::filesystem::path& path) {
+  std::vector<std::string> ret;
+  std::ifstream in(path);
+  std::string line;
+  while (std::getline(in, line)) {
+    ret.push_back(line);
+  }
+  return ret;
+}
+
+}  // namespace
+
+BOOST_FIXTURE_TEST_SUITE(DebugStrSinkTests, DebugStrSinkFixture)
+
+BOOST_AUTO_TEST_CASE(fragments_are_coalesced_per_thread) {
+  sink.Write(1, "Hello ", false);
+  sink.Write(2, "Other ", false);
+  sink.Write(1, "World", true);
+  sink.Write(2, "thread", true);
+  sink.Write(3, "Whole line", true);
+
+  BOOST_REQUIRE_EQUAL(lines.size(), 3);
+  BOOST_TEST(lines[0].first == 1);
+  BOOST_TEST(lines[0].second == "Hello World");
+  BOOST_TEST(lines[1].first == 2);
+  BOOST_TEST(lines[1].second == "Other thread");
+  BOOST_TEST(lines[2].first == 3);
+  BOOST_TEST(lines[2].second == "Whole line");
+}
+
+BOOST_AUTO_TEST_CASE(flush_emits_partial_lines) {
+  sink.Write(7, "Unterminated", false);
+  BOOST_TEST(lines.empty());
+
+  sink.Flush();
+
+  BOOST_REQUIRE_EQUAL(lines.size(), 1);
+  BOOST_TEST(lines[0].second == "Unterminated");
+}
+
+BOOST_AUTO_TEST_CASE(rate_limit_suppresses_and_summarizes) {
+  sink.SetMaxLinesPerSecond(5);
+  for (int i = 0; i < 20; ++i) {
+    sink.Write(1, std::to_string(i), true);
+  }
+
+  BOOST_TEST(lines.size() == 5);
+  BOOST_TEST(suppressed.empty());
+
+  sink.Flush();
+  BOOST_REQUIRE_EQUAL(suppressed.size(), 1);
+  BOOST_TEST(suppressed[0] == 15);
+
+  auto stats = sink.GetStats();
+  BOOST_TEST(stats.lines == 20);
+  BOOST_TEST(stats.displayed_lines == 5);
+  BOOST_TEST(stats.suppressed_lines == 15);
+}
+
+BOOST_AUTO_TEST_CASE(summary_is_emitted_when_rate_limit_refills) {
+  std::mutex summary_lock;
+  std::condition_variable summary_condition;
+  std::vector<uint64_t> summaries;
+  DebugStrSink throttled(nullptr, [&](uint64_t count) {
+    {
+      const std::lock_guard lock(summary_lock);
+      summaries.push_back(count);
+    }
+    summary_condition.notify_all();
+  });
+
+  throttled.SetMaxLinesPerSecond(20);
+  for (int i = 0; i < 30; ++i) {
+    throttled.Write(1, std::to_string(i), true);
+  }
+
+  auto suppressed = throttled.GetStats().suppressed_lines;
+  BOOST_REQUIRE(suppressed > 0);
+
+  // No further lines are written, so only the refill can emit the summary.
+  std::unique_lock lock(summary_lock);
+  BOOST_TEST(summary_condition.wait_for(
+      lock, std::chrono::seconds(1), [&]() {
+        return std::accumulate(summaries.begin(), summaries.end(),
+                               uint64_t{0}) == suppressed;
+      }));
+}
+
+BOOST_AUTO_TEST_CASE(zero_rate_disables_limit) {
+  sink.SetMaxLinesPerSecond(0);
+  for (int i = 0; i < 500; ++i) {
+    sink.Write(1, "line", true);
+  }
+
+  BOOST_TEST(lines.size() == 500);
+  BOOST_TEST(sink.GetStats().suppressed_lines == 0);
+}
+
+BOOST_AUTO_TEST_CASE(log_file_records_suppressed_lines) {
+  auto path = TempLogPath("test_debugstr_sink_all.log");
+  sink.SetMaxLinesPerSecond(1);
+  BOOST_REQUIRE(sink.OpenLogFile(path));
+
+  for (int i = 0; i < 50; ++i) {
+    sink.Write(i % 3, "Line " + std::to_string(i), true);
+  }
+  sink.CloseLogFile();
+
+  auto logged = ReadLines(path);
+  BOOST_REQUIRE_EQUAL(logged.size(), 50);
+  for (int i = 0; i < 50; ++i) {
+    BOOST_TEST(logged[i] == "Line " + std::to_string(i));
+  }
+  BOOST_TEST(lines.size() == 1);
+
+  auto stats = sink.GetStats();
+  BOOST_TEST(stats.logged_lines == 50);
+  BOOST_TEST(stats.log_dropped_lines == 0);
+  std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(log_file_drops_lines_when_buffer_is_full) {
+  auto path = TempLogPath("test_debugstr_sink_drop.log");
+  BOOST_REQUIRE(sink.OpenLogFile(path, 256, 60 * 1000));
+
+  sink.Write(1, "Short", true);
+  sink.Write(1, std::string(1024, 'x'), true);
+  sink.Write(1, "After", true);
+  sink.CloseLogFile();
+
+  auto stats = sink.GetStats();
+  BOOST_TEST(stats.log_dropped_lines == 1);
+  BOOST_TEST(stats.logged_lines == 2);
+
+  auto logged = ReadLines(path);
+  BOOST_REQUIRE_EQUAL(logged.size(), 2);
+  BOOST_TEST(logged[0] == "Short");
+  BOOST_TEST(logged[1] == "After");
+  BOOST_TEST(lines.size() == 3);
+  std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
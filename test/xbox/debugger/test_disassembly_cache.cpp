@@ -0,0 +1,166 @@
+#include <boost/test/unit_test.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <capstone/capstone.h>
+
+#include "xbox/debugger/disassembly_cache.h"
+
+namespace {
+
+constexpr uint32_t kPage = DisassemblyCache::kPageSize;
+
+//! Simulated target memory that records which pages are read.
+struct FakeCode {
+  std::map<uint32_t, std::vector<uint8_t>> pages;
+  std::vector<uint32_t> reads;
+
+  DisassemblyCache::PageReader Reader() {
+    return [this](uint32_t page_address)
+               -> std::optional<std::vector<uint8_t>> {
+      reads.push_back(page_address);
+      auto it = pages.find(page_address);
+      if (it == pages.end()) {
+        return std::nullopt;
+      }
+      return it->second;
+    };
+  }
+};
+
+std::vector<std::string> Mnemonics(const std::vector<cs_insn>& instructions) {
+  std::vector<std::string> ret;
+  for (auto& insn : instructions) {
+    ret.emplace_back(insn.mnemonic);
+  }
+  return ret;
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(DisassemblyCacheTests)
+
+BOOST_AUTO_TEST_CASE(repeated_disassembly_reads_once) {
+  FakeCode code;
+  code.pages[0x10000] = std::vector<uint8_t>(kPage, 0x90);
+  code.pages[0x10000][4] = 0xC3;
+  DisassemblyCache cache;
+
+  auto first = cache.Disassemble(0x10000, 5, code.Reader());
+  auto second = cache.Disassemble(0x10002, 3, code.Reader());
+
+  BOOST_TEST(Mnemonics(first) ==
+                 std::vector<std::string>({"nop", "nop", "nop", "nop", "ret"}),
+             boost::test_tools::per_element());
+  BOOST_REQUIRE_EQUAL(second.size(), 3);
+  BOOST_TEST(second[0].address == 0x10002);
+  BOOST_TEST(std::string(second[2].mnemonic) == "ret");
+  BOOST_TEST(code.reads == std::vector<uint32_t>({0x10000}),
+             boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(instruction_crossing_page_boundary) {
+  FakeCode code;
+  // mov eax, 0x12345678 split across the boundary.
+  code.pages[0x10000] = std::vector<uint8_t>(kPage, 0x90);
+  code.pages[0x10000][kPage - 2] = 0xB8;
+  code.pages[0x10000][kPage - 1] = 0x78;
+  code.pages[0x11000] = {0x56, 0x34, 0x12, 0xC3};
+  DisassemblyCache cache;
+
+  auto instructions = cache.Disassemble(0x10FFE, 2, code.Reader());
+
+  BOOST_REQUIRE_EQUAL(instructions.size(), 2);
+  BOOST_TEST(instructions[0].size == 5);
+  BOOST_TEST(std::string(instructions[0].op_str) == "eax, 0x12345678");
+  BOOST_TEST(instructions[1].address == 0x11003);
+  BOOST_TEST(std::string(instructions[1].mnemonic) == "ret");
+  BOOST_TEST(code.reads == std::vector<uint32_t>({0x10000, 0x11000}),
+             boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(partial_page_stops_at_end_of_data) {
+  FakeCode code;
+  code.pages[0x10000] = std::vector<uint8_t>(8, 0x90);
+  DisassemblyCache cache;
+
+  auto instructions = cache.Disassemble(0x10000, 16, code.Reader());
+
+  BOOST_TEST(instructions.size() == 8);
+  BOOST_TEST(code.reads == std::vector<uint32_t>({0x10000}),
+             boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(unreadable_memory_returns_nothing) {
+  FakeCode code;
+  DisassemblyCache cache;
+
+  BOOST_TEST(cache.Disassemble(0x10000, 4, code.Reader()).empty());
+  BOOST_TEST(cache.PageCount() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(invalidate_rereads_affected_pages) {
+  FakeCode code;
+  code.pages[0x10000] = std::vector<uint8_t>(kPage, 0x90);
+  code.pages[0x11000] = std::vector<uint8_t>(kPage, 0x90);
+  DisassemblyCache cache;
+  cache.Disassemble(0x10000, 1, code.Reader());
+  cache.Disassemble(0x11000, 1, code.Reader());
+  BOOST_REQUIRE(cache.Contains(0x10000));
+  BOOST_REQUIRE(cache.Contains(0x11000));
+
+  // An instruction starting on the preceding page may overlap the change.
+  code.pages[0x11000][0] = 0xC3;
+  cache.Invalidate(0x11000, 1);
+  BOOST_TEST(!cache.Contains(0x10000));
+  BOOST_TEST(!cache.Contains(0x11000));
+
+  code.reads.clear();
+  auto instructions = cache.Disassemble(0x11000, 1, code.Reader());
+  BOOST_REQUIRE_EQUAL(instructions.size(), 1);
+  BOOST_TEST(std::string(instructions[0].mnemonic) == "ret");
+  BOOST_TEST(code.reads == std::vector<uint32_t>({0x11000}),
+             boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(reset_discards_pages_from_previous_generation) {
+  FakeCode code;
+  code.pages[0x10000] = std::vector<uint8_t>(kPage, 0x90);
+  DisassemblyCache cache;
+  cache.Disassemble(0x10000, 1, code.Reader());
+  auto stale_generation = cache.Generation();
+
+  cache.Reset();
+  BOOST_TEST(cache.PageCount() == 0);
+  BOOST_TEST(cache.Generation() != stale_generation);
+
+  cache.AddPage(0x20000, stale_generation, std::vector<uint8_t>(kPage, 0xCC));
+  BOOST_TEST(!cache.Contains(0x20000));
+
+  cache.AddPage(0x20000, cache.Generation(), std::vector<uint8_t>(16, 0xCC));
+  code.reads.clear();
+  auto instructions = cache.Disassemble(0x20000, 1, code.Reader());
+  BOOST_REQUIRE_EQUAL(instructions.size(), 1);
+  BOOST_TEST(std::string(instructions[0].mnemonic) == "int3");
+  BOOST_TEST(code.reads.empty());
+}
+
+BOOST_AUTO_TEST_CASE(least_recently_used_page_is_evicted) {
+  FakeCode code;
+  for (uint32_t page = 0x10000; page < 0x14000; page += kPage) {
+    code.pages[page] = std::vector<uint8_t>(16, 0x90);
+  }
+  DisassemblyCache cache(2);
+  cache.Disassemble(0x10000, 1, code.Reader());
+  cache.Disassemble(0x11000, 1, code.Reader());
+  cache.Disassemble(0x10000, 1, code.Reader());
+  cache.Disassemble(0x12000, 1, code.Reader());
+
+  BOOST_TEST(cache.PageCount() == 2);
+  BOOST_TEST(cache.Contains(0x10000));
+  BOOST_TEST(!cache.Contains(0x11000));
+  BOOST_TEST(cache.Contains(0x12000));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
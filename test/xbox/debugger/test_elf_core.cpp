@@ -0,0 +1,91 @@
+#include <boost/test/unit_test.hpp>
+#include <vector>
+
+#include "rdcp/types/memory_region.h"
+#include "xbox/debugger/elf_core.h"
+
+namespace {
+
+uint32_t Read32(const std::vector<uint8_t>& buffer, size_t offset) {
+  return buffer[offset] | buffer[offset + 1] << 8 | buffer[offset + 2] << 16 |
+         buffer[offset + 3] << 24;
+}
+
+uint16_t Read16(const std::vector<uint8_t>& buffer, size_t offset) {
+  return buffer[offset] | buffer[offset + 1] << 8;
+}
+
+constexpr size_t kProgramHeaders = 52;
+
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(ElfCoreTests)
+
+BOOST_AUTO_TEST_CASE(header_describes_segments) {
+  std::vector<ElfCoreSegment> segments = {
+      {0x10000, 0x2000, MemoryRegion::PAGE_READWRITE},
+      {0x20000, 0x1000, MemoryRegion::PAGE_EXECUTE_READ},
+  };
+  auto header = BuildElfCoreHeader({}, segments);
+  BOOST_REQUIRE(header.has_value());
+
+  BOOST_TEST(Read32(*header, 0) == 0x464C457F);
+  BOOST_TEST((*header)[4] == 1);
+  BOOST_TEST(Read16(*header, 16) == 4);
+  BOOST_TEST(Read16(*header, 18) == 3);
+  BOOST_TEST(Read16(*header, 44) == 3);
+  BOOST_TEST(header->size() == 0x1000);
+
+  auto first = kProgramHeaders + 32;
+  BOOST_TEST(Read32(*header, first) == 1);
+  BOOST_TEST(Read32(*header, first + 4) == 0x1000);
+  BOOST_TEST(Read32(*header, first + 8) == 0x10000);
+  BOOST_TEST(Read32(*header, first + 16) == 0x2000);
+  BOOST_TEST(Read32(*header, first + 24) == 6);
+
+  auto second = first + 32;
+  BOOST_TEST(Read32(*header, second + 4) == 0x3000);
+  BOOST_TEST(Read32(*header, second + 8) == 0x20000);
+  BOOST_TEST(Read32(*header, second + 24) == 5);
+}
+
+BOOST_AUTO_TEST_CASE(notes_contain_thread_registers) {
+  ElfCoreThread thread;
+  thread.thread_id = 28;
+  thread.context.eip = 0x12345;
+  thread.context.esp = 0xD0001000;
+  thread.context.eax = 7;
+  thread.stopped = true;
+  ElfCoreThread with_float;
+  with_float.thread_id = 29;
+  with_float.float_context = ThreadFloatContext{};
+
+  auto header = BuildElfCoreHeader({thread, with_float}, {});
+  BOOST_REQUIRE(header.has_value());
+
+  BOOST_TEST(Read32(*header, kProgramHeaders) == 4);
+  auto notes = Read32(*header, kProgramHeaders + 4);
+  // PRSTATUS, PRSTATUS, FPREGSET, each with a 12 byte header and 8 byte name.
+  BOOST_TEST(Read32(*header, kProgramHeaders + 16) ==
+             (20 + 144) * 2 + 20 + 108);
+
+  BOOST_TEST(Read32(*header, notes) == 5);
+  BOOST_TEST(Read32(*header, notes + 4) == 144);
+  BOOST_TEST(Read32(*header, notes + 8) == 1);
+  auto prstatus = notes + 20;
+  BOOST_TEST((*header)[prstatus + 12] == 5);
+  BOOST_TEST(Read32(*header, prstatus + 24) == 28);
+  BOOST_TEST(Read32(*header, prstatus + 72 + 6 * 4) == 7);
+  BOOST_TEST(Read32(*header, prstatus + 72 + 12 * 4) == 0x12345);
+  BOOST_TEST(Read32(*header, prstatus + 72 + 15 * 4) == 0xD0001000);
+  BOOST_TEST(Read32(*header, prstatus + 140) == 0);
+
+  auto second = prstatus + 144;
+  BOOST_TEST(Read32(*header, second + 20 + 24) == 29);
+  BOOST_TEST(Read32(*header, second + 20 + 140) == 1);
+  auto fpregset = second + 20 + 144;
+  BOOST_TEST(Read32(*header, fpregset + 4) == 108);
+  BOOST_TEST(Read32(*header, fpregset + 8) == 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -8,7 +8,7 @@ struct GlobalTestFixture {
     logging::InitializeLogging(boost::log::trivial::severity_level::info);
   }
 
-  ~GlobalTestFixture() {}
+  ~GlobalTestFixture() { logging::ShutdownLogging(); }
 };
 
 BOOST_GLOBAL_FIXTURE(GlobalTestFixture);
@@ -0,0 +1,81 @@
+#include <boost/test/unit_test.hpp>
+#include <vector>
+
+#include "xbox/debugger/memory_search.h"
+
+namespace {
+
+std::vector<uint32_t> Scan(const MemorySearchPattern& pattern,
+                           const std::vector<uint8_t>& data,
+                           uint32_t base_address = 0x1000,
+                           size_t max_hits = 100) {
+  std::vector<uint32_t> hits;
+  pattern.Scan(data.data(), data.size(), base_address, hits, max_hits);
+  return hits;
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(MemorySearchTests)
+
+BOOST_AUTO_TEST_CASE(parse_hex_rejects_malformed_input) {
+  BOOST_TEST(!MemorySearchPattern::ParseHex("").has_value());
+  BOOST_TEST(!MemorySearchPattern::ParseHex("abc").has_value());
+  BOOST_TEST(!MemorySearchPattern::ParseHex("zz").has_value());
+  BOOST_TEST(MemorySearchPattern::ParseHex("de ad ?? ef").has_value());
+}
+
+BOOST_AUTO_TEST_CASE(exact_pattern) {
+  std::vector<uint8_t> data = {0x00, 0xDE, 0xAD, 0xDE, 0xAD, 0xBE, 0xEF};
+  auto pattern = MemorySearchPattern::ParseHex("deadbeef");
+  BOOST_REQUIRE(pattern.has_value());
+
+  auto hits = Scan(*pattern, data);
+  BOOST_TEST(hits == std::vector<uint32_t>({0x1003}),
+             boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(wildcards) {
+  std::vector<uint8_t> data = {0x8B, 0x45, 0x10, 0x0F, 0x8B, 0x4C, 0x20, 0x0F};
+  auto pattern = MemorySearchPattern::ParseHex("8b 4? ?? 0f");
+  BOOST_REQUIRE(pattern.has_value());
+
+  auto hits = Scan(*pattern, data);
+  BOOST_TEST(hits == std::vector<uint32_t>({0x1000, 0x1004}),
+             boost::test_tools::per_element());
+
+  // Fully wildcarded patterns match everywhere.
+  pattern = MemorySearchPattern::ParseHex("????");
+  BOOST_REQUIRE(pattern.has_value());
+  BOOST_TEST(Scan(*pattern, data).size() == 7);
+}
+
+BOOST_AUTO_TEST_CASE(aligned_value) {
+  std::vector<uint8_t> data = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                               0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+  auto pattern = MemorySearchPattern::FromValue(0, 4);
+
+  auto hits = Scan(pattern, data);
+  BOOST_TEST(hits == std::vector<uint32_t>({0x1000, 0x1004, 0x1008}),
+             boost::test_tools::per_element());
+
+  // Alignment is relative to the address rather than the buffer.
+  hits = Scan(pattern, data, 0x1002);
+  BOOST_TEST(hits == std::vector<uint32_t>({0x1004, 0x1008}),
+             boost::test_tools::per_element());
+
+  data = {0x78, 0x56, 0x34, 0x12, 0x00, 0x78, 0x56, 0x34, 0x12};
+  hits = Scan(MemorySearchPattern::FromValue(0x12345678, 4), data);
+  BOOST_TEST(hits == std::vector<uint32_t>({0x1000}),
+             boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(max_hits_stops_scan) {
+  std::vector<uint8_t> data(16, 0xAA);
+  MemorySearchPattern pattern({0xAA});
+  std::vector<uint32_t> hits;
+  BOOST_TEST(!pattern.Scan(data.data(), data.size(), 0, hits, 3));
+  BOOST_TEST(hits.size() == 3);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
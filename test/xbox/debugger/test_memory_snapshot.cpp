@@ -0,0 +1,104 @@
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "xbox/debugger/memory_snapshot.h"
+
+namespace {
+
+void AddBlock(MemorySnapshot& snapshot, uint32_t address, uint32_t checksum,
+              uint8_t fill) {
+  auto index = snapshot.AddBlock(address, checksum);
+  memset(snapshot.BlockData(index), fill, snapshot.BlockSize());
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(MemorySnapshotTests)
+
+BOOST_AUTO_TEST_CASE(read_memory_spans_blocks) {
+  MemorySnapshot snapshot(16);
+  AddBlock(snapshot, 0x1000, 1, 0xAA);
+  AddBlock(snapshot, 0x1010, 2, 0xBB);
+  AddBlock(snapshot, 0x1030, 3, 0xCC);
+
+  auto data = snapshot.ReadMemory(0x100E, 4);
+  BOOST_REQUIRE(data.has_value());
+  BOOST_TEST(*data == std::vector<uint8_t>({0xAA, 0xAA, 0xBB, 0xBB}),
+             boost::test_tools::per_element());
+
+  BOOST_TEST(!snapshot.ReadMemory(0x101E, 4).has_value());
+  BOOST_TEST(!snapshot.FindBlock(0x1020).has_value());
+  BOOST_TEST(snapshot.FindBlock(0x1030).value() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(save_and_load_round_trip) {
+  MemorySnapshot snapshot(16);
+  AddBlock(snapshot, 0x1000, 0x11111111, 0xAA);
+  AddBlock(snapshot, 0x2000, 0x22222222, 0xBB);
+
+  auto path = std::filesystem::temp_directory_path() /
+              "xbdm_gdb_bridge_test_snapshot.bin";
+  BOOST_REQUIRE(snapshot.Save(path.string()));
+  auto file_size = std::filesystem::file_size(path);
+  auto loaded = MemorySnapshot::Load(path.string());
+  std::filesystem::remove(path);
+
+  // Block contents start at a multiple of the block size.
+  BOOST_TEST(file_size == 48 + 2 * 16);
+  BOOST_REQUIRE(loaded);
+  BOOST_TEST(loaded->BlockSize() == 16);
+  BOOST_REQUIRE(loaded->BlockCount() == 2);
+  BOOST_TEST(loaded->Blocks()[1].address == 0x2000);
+  BOOST_TEST(loaded->Blocks()[1].checksum == 0x22222222);
+  BOOST_TEST(loaded->BlockData(1)[15] == 0xBB);
+}
+
+BOOST_AUTO_TEST_CASE(load_rejects_invalid_file) {
+  auto path = std::filesystem::temp_directory_path() /
+              "xbdm_gdb_bridge_test_invalid_snapshot.bin";
+  {
+    std::ofstream of(path, std::ofstream::binary | std::ofstream::trunc);
+    of << "not a snapshot, but long enough to contain a header";
+  }
+  auto loaded = MemorySnapshot::Load(path.string());
+  std::filesystem::remove(path);
+
+  BOOST_TEST(!loaded);
+}
+
+BOOST_AUTO_TEST_CASE(compare_reports_changed_added_and_removed) {
+  MemorySnapshot before(16);
+  AddBlock(before, 0x1000, 1, 0x00);
+  AddBlock(before, 0x1010, 2, 0x00);
+  AddBlock(before, 0x1020, 3, 0x00);
+  AddBlock(before, 0x1030, 4, 0x00);
+
+  MemorySnapshot after(16);
+  AddBlock(after, 0x1000, 1, 0x00);
+  auto index = after.AddBlock(0x1010, 5);
+  after.BlockData(index)[2] = 0x01;
+  after.BlockData(index)[15] = 0x01;
+  index = after.AddBlock(0x1020, 6);
+  after.BlockData(index)[0] = 0x01;
+  AddBlock(after, 0x2000, 7, 0x00);
+
+  auto diff = MemorySnapshot::Compare(before, after);
+  BOOST_REQUIRE(diff.changed.size() == 2);
+  BOOST_TEST(diff.changed[0].address == 0x1012);
+  BOOST_TEST(diff.changed[0].length == 1);
+  // Changes that are contiguous across blocks are merged.
+  BOOST_TEST(diff.changed[1].address == 0x101F);
+  BOOST_TEST(diff.changed[1].length == 2);
+  BOOST_TEST(diff.bytes_changed == 3);
+
+  BOOST_REQUIRE(diff.added.size() == 1);
+  BOOST_TEST(diff.added[0].address == 0x2000);
+  BOOST_REQUIRE(diff.removed.size() == 1);
+  BOOST_TEST(diff.removed[0].address == 0x1030);
+  BOOST_TEST(diff.removed[0].length == 16);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
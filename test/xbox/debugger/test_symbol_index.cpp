@@ -0,0 +1,154 @@
+#include <boost/test/unit_test.hpp>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "xbox/debugger/symbol_index.h"
+
+namespace {
+
+std::filesystem::path WriteFile(const std::string& name,
+                                const std::string& contents) {
+  auto path = std::filesystem::temp_directory_path() / name;
+  std::ofstream of(path, std::ofstream::binary | std::ofstream::trunc);
+  of << contents;
+  return path;
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(SymbolIndexTests)
+
+BOOST_AUTO_TEST_CASE(lookup_uses_implied_sizes_and_sections) {
+  SymbolIndex::Builder builder;
+  builder.AddSection(0x11000, 0x2000, ".text");
+  builder.AddSymbol(0x11100, 0, "_second");
+  builder.AddSymbol(0x11000, 0, "_first");
+  builder.AddSymbol(0x20000, 0x10, "_data");
+  auto index = builder.Build();
+
+  BOOST_TEST(index->Describe(0x11000) == "_first");
+  BOOST_TEST(index->Describe(0x110FF) == "_first+0xff");
+  BOOST_TEST(index->Describe(0x11100) == "_second");
+  // Unsized symbols end at the end of their section.
+  BOOST_TEST(index->Describe(0x12FFF) == "_second+0x1eff");
+  BOOST_TEST(index->Describe(0x13000).empty());
+  BOOST_TEST(index->Describe(0x2000F) == "_data+0xf");
+  BOOST_TEST(index->Describe(0x20010).empty());
+  BOOST_TEST(index->Describe(0x10000).empty());
+}
+
+BOOST_AUTO_TEST_CASE(lookup_falls_back_to_sections) {
+  SymbolIndex::Builder builder;
+  builder.AddSection(0x11000, 0x1000, ".text");
+  builder.AddSection(0x12000, 0x1000, ".data");
+  builder.AddSymbol(0x12100, 0x10, "_value");
+  auto index = builder.Build();
+
+  BOOST_TEST(index->Describe(0x11010) == ".text+0x10");
+  BOOST_TEST(index->Describe(0x12004) == ".data+0x4");
+  BOOST_TEST(index->Describe(0x12104) == "_value+0x4");
+}
+
+BOOST_AUTO_TEST_CASE(find_address_by_name) {
+  SymbolIndex::Builder builder;
+  builder.AddSymbol(0x11000, 0, "_main");
+  builder.AddSymbol(0x12000, 0, "main_loop");
+  auto index = builder.Build();
+
+  BOOST_TEST(index->FindAddress("_main").value() == 0x11000);
+  BOOST_TEST(index->FindAddress("main").value() == 0x11000);
+  BOOST_TEST(index->FindAddress("main_loop").value() == 0x12000);
+  BOOST_TEST(!index->FindAddress("missing").has_value());
+}
+
+BOOST_AUTO_TEST_CASE(cache_round_trip) {
+  SymbolIndex::Builder builder;
+  builder.AddSection(0x11000, 0x1000, ".text");
+  builder.AddSymbol(0x11000, 0, "_main");
+  builder.AddSymbol(0x11800, 0x20, "_helper");
+  auto index = builder.Build();
+
+  auto path = std::filesystem::temp_directory_path() /
+              "xbdm_gdb_bridge_test_symbols.cache";
+  BOOST_REQUIRE(index->Save(path.string()));
+  BOOST_TEST(SymbolIndex::IsCacheFile(path.string()));
+  auto loaded = SymbolIndex::Open(path.string());
+  std::filesystem::remove(path);
+
+  BOOST_REQUIRE(loaded);
+  BOOST_TEST(loaded->SymbolCount() == 2);
+  BOOST_TEST(loaded->SectionCount() == 1);
+  BOOST_TEST(loaded->Describe(0x11810) == "_helper+0x10");
+  BOOST_TEST(loaded->Describe(0x11010) == "_main+0x10");
+  BOOST_TEST(loaded->FindAddress("helper").value() == 0x11800);
+}
+
+BOOST_AUTO_TEST_CASE(open_rejects_invalid_file) {
+  auto path = WriteFile("xbdm_gdb_bridge_test_invalid_symbols.cache",
+                        "XBSY but not a valid symbol cache file");
+  auto loaded = SymbolIndex::Open(path.string());
+  std::filesystem::remove(path);
+
+  BOOST_TEST(!loaded);
+}
+
+BOOST_AUTO_TEST_CASE(load_msvc_map_file) {
+  auto path = WriteFile(
+      "xbdm_gdb_bridge_test_symbols.map",
+      " default\n"
+      "\n"
+      " Preferred load address is 00010000\n"
+      "\n"
+      "  Address         Publics by Value              Rva+Base       "
+      "Lib:Object\n"
+      "\n"
+      " 0000:00000000       ___safe_se_handler_count   00000000     "
+      "<absolute>\n"
+      " 0001:00000000       _main                      00011000 f   main.obj\n"
+      " 0001:00000040       ?Update@Game@@QAEXXZ       00011040 f   "
+      "game.obj\n"
+      "\n"
+      " entry point at        0001:00000000\n"
+      "\n"
+      " Static symbols\n"
+      "\n"
+      " 0001:00000080       _helper                    00011080 f   "
+      "main.obj\n");
+  SymbolIndex::Builder builder;
+  BOOST_REQUIRE(builder.Load(path.string()));
+  std::filesystem::remove(path);
+
+  BOOST_TEST(builder.SymbolCount() == 3);
+  auto index = builder.Build();
+  BOOST_TEST(index->FindAddress("?Update@Game@@QAEXXZ").value() == 0x11040);
+  BOOST_TEST(index->Describe(0x11044) == "?Update@Game@@QAEXXZ+0x4");
+  // Without a section to bound it, the last symbol only covers its address.
+  BOOST_TEST(index->Describe(0x11080) == "_helper");
+  BOOST_TEST(index->Describe(0x11084).empty());
+  BOOST_TEST(!index->FindAddress("___safe_se_handler_count").has_value());
+}
+
+BOOST_AUTO_TEST_CASE(load_symbol_dump) {
+  auto path = WriteFile("xbdm_gdb_bridge_test_symbols.txt",
+                        "00011000 T _main\n"
+                        "00011100 00000020 t _helper\n"
+                        "         U _external\n"
+                        "0x00012000 g_counter\n"
+                        "00013000 00000008 g_table\n"
+                        "00014000 T Game::Update(int, float)\n");
+  SymbolIndex::Builder builder;
+  BOOST_REQUIRE(builder.Load(path.string()));
+  std::filesystem::remove(path);
+
+  auto index = builder.Build();
+  BOOST_TEST(index->SymbolCount() == 5);
+  BOOST_TEST(index->Describe(0x11110) == "_helper+0x10");
+  BOOST_TEST(index->Describe(0x11120).empty());
+  BOOST_TEST(index->FindAddress("g_counter").value() == 0x12000);
+  BOOST_TEST(index->Describe(0x13004) == "g_table+0x4");
+  BOOST_TEST(index->FindAddress("Game::Update(int, float)").value() ==
+             0x14000);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
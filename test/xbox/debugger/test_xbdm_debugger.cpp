@@ -1,6 +1,13 @@
+#include <algorithm>
+#include <atomic>
 #include <boost/test/unit_test.hpp>
 #include <chrono>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <capstone/capstone.h>
 
 #include "configure_test.h"
 #include "net/select_thread.h"
@@ -163,6 +170,129 @@ DEBUGGER_TEST_CASE(ConditionsAreIsolatedByAddressAndType) {
 
 BOOST_AUTO_TEST_SUITE_END()
 
+// ============================================================================
+// ThreadTableTests
+// ============================================================================
+
+BOOST_FIXTURE_TEST_SUITE(ThreadTableTests, XBDMDebuggerFixture)
+
+DEBUGGER_TEST_CASE(NotificationsUpdateThreadTableWithoutRefetching) {
+  Bootup();
+  Connect();
+  server->AwaitQuiescence();
+
+  int threads_requests = 0;
+  server->SetAfterCommandHandler(
+      "threads", [&threads_requests](const std::string&) {
+        ++threads_requests;
+      });
+
+  auto generation = debugger->ThreadsGeneration();
+  auto initial_count = debugger->Threads().size();
+
+  uint32_t thread_id = server->AddThread("new_thread");
+  server->NotifyThreadCreated(thread_id);
+  server->AwaitQuiescence();
+
+  auto thread = debugger->GetThread(thread_id);
+  BOOST_REQUIRE(thread);
+  BOOST_TEST(debugger->Threads().size() == initial_count + 1);
+  BOOST_TEST(debugger->ThreadsGeneration() > generation);
+  BOOST_TEST(!thread->HasInfo());
+
+  BOOST_REQUIRE(debugger->FetchMissingThreadInfo());
+  BOOST_TEST(thread->HasInfo());
+
+  generation = debugger->ThreadsGeneration();
+  server->RemoveThread(thread_id);
+  server->NotifyThreadTerminated(thread_id);
+  server->AwaitQuiescence();
+
+  BOOST_TEST(!debugger->GetThread(thread_id));
+  BOOST_TEST(debugger->Threads().size() == initial_count);
+  BOOST_TEST(debugger->ThreadsGeneration() > generation);
+  BOOST_TEST(threads_requests == 0);
+}
+
+DEBUGGER_TEST_CASE(NotificationChannelReconnectRefetchesThreads) {
+  Bootup();
+  uint32_t lost_thread_id = server->AddThread("lost_thread");
+  Connect();
+  server->AwaitQuiescence();
+  BOOST_REQUIRE(debugger->GetThread(lost_thread_id));
+  auto generation = debugger->ThreadsGeneration();
+
+  // Neither change is reported, as if both happened while the notification
+  // channel was down.
+  server->RemoveThread(lost_thread_id);
+  uint32_t missed_thread_id = server->AddThread("missed_thread");
+  server->SimulateNotificationChannelDrop();
+
+  BOOST_REQUIRE(AwaitCondition([this, missed_thread_id]() {
+    return debugger->GetThread(missed_thread_id) != nullptr;
+  }));
+  BOOST_TEST(!debugger->GetThread(lost_thread_id));
+  BOOST_TEST(debugger->ThreadsGeneration() > generation);
+}
+
+DEBUGGER_TEST_CASE(ContinueAllContinuesEveryThread) {
+  Bootup();
+  server->AddThread("thread_a");
+  server->AddThread("thread_b");
+  Connect();
+  server->AwaitQuiescence();
+
+  auto thread_count = debugger->Threads().size();
+  BOOST_REQUIRE(thread_count >= 3);
+
+  // Responses are withheld until every thread's request has been received,
+  // which only succeeds if the requests are sent as one batch.
+  std::vector<std::string> received;
+  server->SetCommandHandler(
+      "continue", [&](ClientTransport& client, const std::string& params) {
+        received.push_back(params);
+        if (received.size() == thread_count) {
+          for (size_t i = 0; i < thread_count; ++i) {
+            server->SendResponse(client, OK);
+          }
+        }
+        return true;
+      });
+
+  BOOST_TEST(debugger->ContinueAll());
+  BOOST_TEST(received.size() == thread_count);
+}
+
+DEBUGGER_TEST_CASE(ContinueAllReportsSingleFailure) {
+  Bootup();
+  server->AddThread("thread_a");
+  server->AddThread("thread_b");
+  Connect();
+  server->AwaitQuiescence();
+
+  auto thread_count = debugger->Threads().size();
+  BOOST_REQUIRE(thread_count >= 3);
+
+  // Only the second request fails, which must not prevent the others from
+  // being sent.
+  std::vector<std::string> received;
+  server->SetCommandHandler(
+      "continue", [&](ClientTransport& client, const std::string& params) {
+        received.push_back(params);
+        if (received.size() == thread_count) {
+          for (size_t i = 0; i < thread_count; ++i) {
+            server->SendResponse(client, i == 1 ? ERR_NO_SUCH_THREAD : OK);
+          }
+        }
+        return true;
+      });
+
+  BOOST_TEST(!debugger->ContinueAll());
+  BOOST_TEST(received.size() == thread_count);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
 // ============================================================================
 // GuessBackTraceTests
 // ============================================================================
@@ -583,3 +713,523 @@ DEBUGGER_TEST_CASE(GuessBackTraceCorrectlyResolvesMidChainConflicts) {
 }
 
 BOOST_AUTO_TEST_SUITE_END()
+
+// ============================================================================
+// StopEventTests
+// ============================================================================
+
+BOOST_FIXTURE_TEST_SUITE(StopEventTests, XBDMDebuggerFixture)
+
+DEBUGGER_TEST_CASE(BreakpointAdvancesStopEventCount) {
+  Bootup();
+  uint32_t tid = server->AddThread("test_thread");
+  Connect();
+  BOOST_REQUIRE(debugger->FetchThreads());
+
+  auto last_count = debugger->StopEventCount();
+  BOOST_TEST(!debugger->WaitForStopEvent(last_count, 10));
+
+  server->SimulateExecutionBreakpoint(0x1000, tid);
+  BOOST_REQUIRE(debugger->WaitForStopEvent(last_count, 5000));
+  BOOST_TEST(debugger->StopEventCount() == last_count + 1);
+
+  auto thread = debugger->GetThread(tid);
+  BOOST_REQUIRE(thread);
+  BOOST_TEST((thread->last_known_address == 0x1000));
+}
+
+DEBUGGER_TEST_CASE(FalseConditionEvaluatorContinuesWithoutStopEvent) {
+  Bootup();
+  uint32_t tid = server->AddThread("test_thread");
+  server->SetThreadRegister(tid, "ecx", 4);
+  Connect();
+  BOOST_REQUIRE(debugger->FetchThreads());
+
+  std::vector<uint32_t> seen_ecx;
+  std::vector<XBDMDebugger::ConditionEvaluator> evaluators;
+  evaluators.emplace_back(
+      [&seen_ecx](const ThreadContext& context, uint32_t,
+                  const DebuggerExpressionParser::MemoryReader&)
+          -> std::expected<bool, std::string> {
+        seen_ecx.push_back(context.ecx.value_or(0));
+        return context.ecx == 3;
+      });
+  debugger->SetBreakpointConditionEvaluators(
+      XBDMDebugger::BreakpointType::BREAKPOINT, 0x2000, std::move(evaluators));
+  BOOST_REQUIRE(debugger->AddBreakpoint(0x2000));
+
+  std::atomic<bool> continued{false};
+  server->SetAfterCommandHandler("continue",
+                                 [&](const std::string&) { continued = true; });
+
+  auto last_count = debugger->StopEventCount();
+  server->SimulateExecutionBreakpoint(0x2000, tid);
+  BOOST_REQUIRE(AwaitCondition([&continued]() { return continued.load(); }));
+
+  BOOST_TEST(seen_ecx == std::vector<uint32_t>({4}),
+             boost::test_tools::per_element());
+  BOOST_TEST(debugger->StopEventCount() == last_count);
+
+  server->SetThreadRegister(tid, "ecx", 3);
+  server->SimulateExecutionBreakpoint(0x2000, tid);
+  BOOST_TEST(debugger->WaitForStopEvent(last_count, 5000));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+// ============================================================================
+// TracepointTests
+// ============================================================================
+
+BOOST_FIXTURE_TEST_SUITE(TracepointTests, XBDMDebuggerFixture)
+
+DEBUGGER_TEST_CASE(TracepointHitCollectsFrameAndContinues) {
+  Bootup();
+  uint32_t tid = server->AddThread("test_thread");
+  server->SetThreadRegister(tid, "esp", 0x10000);
+  server->AddRegion(0x10000, std::vector<uint8_t>{0xDE, 0xAD, 0xBE, 0xEF});
+  Connect();
+  BOOST_REQUIRE(debugger->FetchThreads());
+
+  XBDMDebugger::Tracepoint tracepoint;
+  tracepoint.number = debugger->NextTracepointNumber();
+  tracepoint.address = 0x2000;
+  tracepoint.pass_count = 2;
+  tracepoint.actions.emplace_back(trace_actions::CollectRegisters());
+  tracepoint.actions.emplace_back(trace_actions::CollectMemory("$esp", 4));
+  debugger->SetTracepoint(tracepoint);
+  BOOST_REQUIRE(debugger->StartTracing());
+  BOOST_TEST(server->HasBreakpoint(0x2000));
+
+  std::atomic<bool> continued{false};
+  server->SetAfterCommandHandler("continue",
+                                 [&](const std::string&) { continued = true; });
+
+  auto last_count = debugger->StopEventCount();
+  server->SimulateExecutionBreakpoint(0x2000, tid);
+  BOOST_REQUIRE(AwaitCondition([&continued]() { return continued.load(); }));
+  // The frame is recorded after the thread is resumed.
+  BOOST_REQUIRE(AwaitCondition(
+      [this]() { return debugger->GetTraceStatus().frames != 0; }));
+  BOOST_TEST(debugger->StopEventCount() == last_count);
+
+  auto frame = debugger->GetTraceFrame(0);
+  BOOST_REQUIRE(frame.has_value());
+  BOOST_TEST(frame->tracepoint == tracepoint.number);
+  BOOST_TEST(frame->thread_id == tid);
+  BOOST_TEST(frame->address == 0x2000);
+  BOOST_REQUIRE(frame->registers.has_value());
+  BOOST_TEST(frame->registers->esp.value_or(0) == 0x10000);
+  auto memory = frame->ReadMemory(0x10001, 2);
+  BOOST_REQUIRE(memory.has_value());
+  BOOST_TEST(*memory == std::vector<uint8_t>({0xAD, 0xBE}),
+             boost::test_tools::per_element());
+  BOOST_TEST(!frame->ReadMemory(0x10002, 4).has_value());
+
+  server->SimulateExecutionBreakpoint(0x2000, tid);
+  BOOST_REQUIRE(AwaitCondition(
+      [this]() { return !debugger->GetTraceStatus().running; }));
+  AwaitQuiescence();
+
+  auto status = debugger->GetTraceStatus();
+  BOOST_TEST((status.stop_reason == XBDMDebugger::TraceStopReason::PASS_COUNT));
+  BOOST_TEST(status.stop_tracepoint == tracepoint.number);
+  BOOST_TEST(status.frames == 2);
+  BOOST_TEST(!server->HasBreakpoint(0x2000));
+
+  auto stats = debugger->GetTracepoint(tracepoint.number);
+  BOOST_REQUIRE(stats.has_value());
+  BOOST_TEST(stats->hits == 2);
+  BOOST_TEST(stats->frames == 2);
+  BOOST_TEST(stats->max_overhead_us >= stats->total_overhead_us / 2);
+}
+
+DEBUGGER_TEST_CASE(RebootStopsTracing) {
+  Bootup();
+  Connect();
+
+  XBDMDebugger::Tracepoint tracepoint;
+  tracepoint.number = debugger->NextTracepointNumber();
+  tracepoint.address = 0x2000;
+  debugger->SetTracepoint(tracepoint);
+  BOOST_REQUIRE(debugger->StartTracing());
+  BOOST_REQUIRE(debugger->GetTraceStatus().running);
+
+  RebootSync();
+  AwaitQuiescence();
+
+  auto status = debugger->GetTraceStatus();
+  BOOST_TEST(!status.running);
+  BOOST_TEST(
+      (status.stop_reason == XBDMDebugger::TraceStopReason::TARGET_REBOOTED));
+}
+
+DEBUGGER_TEST_CASE(TracepointAtUserBreakpointStops) {
+  Bootup();
+  uint32_t tid = server->AddThread("test_thread");
+  Connect();
+  BOOST_REQUIRE(debugger->FetchThreads());
+  BOOST_REQUIRE(debugger->AddBreakpoint(0x2000));
+
+  XBDMDebugger::Tracepoint tracepoint;
+  tracepoint.number = debugger->NextTracepointNumber();
+  tracepoint.address = 0x2000;
+  debugger->SetTracepoint(tracepoint);
+  BOOST_REQUIRE(debugger->StartTracing());
+
+  auto last_count = debugger->StopEventCount();
+  server->SimulateExecutionBreakpoint(0x2000, tid);
+  BOOST_TEST(debugger->WaitForStopEvent(last_count, 5000));
+  BOOST_TEST(debugger->GetTraceStatus().frames == 1);
+
+  debugger->StopTracing();
+  BOOST_TEST(server->HasBreakpoint(0x2000));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+// ============================================================================
+// MemoryScanTests
+// ============================================================================
+
+BOOST_FIXTURE_TEST_SUITE(MemoryScanTests, XBDMDebuggerFixture)
+
+DEBUGGER_TEST_CASE(SearchFindsMatchesAcrossRegions) {
+  Bootup();
+  server->AddRegion(0x10000, std::vector<uint8_t>{0x00, 0x11, 0xDE, 0xAD});
+  server->AddRegion(0x10004, std::vector<uint8_t>{0xBE, 0xEF, 0xDE, 0xAD});
+  server->AddRegion(0x20000, std::vector<uint8_t>{0xBE, 0xEF, 0xDE, 0xAD});
+  Connect();
+
+  auto pattern = MemorySearchPattern::ParseHex("dead beef");
+  BOOST_REQUIRE(pattern.has_value());
+  auto result = debugger->SearchMemory(*pattern);
+
+  BOOST_TEST(result.regions_scanned == 3);
+  BOOST_TEST(result.bytes_scanned == 12);
+  BOOST_TEST(!result.truncated);
+  BOOST_REQUIRE(result.hits.size() == 1);
+  BOOST_TEST(result.hits[0].address == 0x10002);
+  BOOST_REQUIRE(result.hits[0].region);
+  BOOST_TEST(result.hits[0].region->start == 0x10000);
+
+  result = debugger->SearchMemory(MemorySearchPattern::FromValue(0xADDE, 2),
+                                  0x10004, 0x20004);
+  BOOST_TEST(result.bytes_scanned == 8);
+  BOOST_REQUIRE(result.hits.size() == 2);
+  BOOST_TEST(result.hits[0].address == 0x10006);
+  BOOST_TEST(result.hits[1].address == 0x20002);
+
+  result = debugger->SearchMemory(MemorySearchPattern::FromValue(0xADDE, 2),
+                                  0, 0x100000000ULL, 1);
+  BOOST_TEST(result.truncated);
+  BOOST_TEST(result.hits.size() == 1);
+}
+
+DEBUGGER_TEST_CASE(SnapshotOnlyDownloadsChangedBlocks) {
+  Bootup();
+  server->AddRegion(0x10000, std::vector<uint8_t>(32, 0xAA));
+  server->AddRegion(0x20000, std::vector<uint8_t>(16, 0xBB));
+  Connect();
+
+  auto first = debugger->CaptureMemorySnapshot(nullptr, 16);
+  BOOST_REQUIRE(first.snapshot);
+  BOOST_TEST(first.snapshot->BlockCount() == 3);
+  BOOST_TEST(first.blocks_downloaded == 3);
+  BOOST_TEST(first.blocks_reused == 0);
+  BOOST_TEST(first.snapshot->BlockData(2)[0] == 0xBB);
+
+  std::vector<uint8_t> modified(32, 0xAA);
+  modified[0x14] = 0x01;
+  modified[0x15] = 0x02;
+  server->RemoveRegion(0x10000);
+  server->AddRegion(0x10000, modified);
+  auto second = debugger->CaptureMemorySnapshot(first.snapshot);
+  BOOST_REQUIRE(second.snapshot);
+  BOOST_TEST(second.snapshot->BlockSize() == 16);
+  BOOST_TEST(second.blocks_downloaded == 1);
+  BOOST_TEST(second.blocks_reused == 2);
+  BOOST_TEST(second.failed_reads == 0);
+
+  auto diff = MemorySnapshot::Compare(*first.snapshot, *second.snapshot);
+  BOOST_REQUIRE(diff.changed.size() == 1);
+  BOOST_TEST(diff.changed[0].address == 0x10014);
+  BOOST_TEST(diff.changed[0].length == 2);
+  BOOST_TEST(diff.added.empty());
+  BOOST_TEST(diff.removed.empty());
+}
+
+DEBUGGER_TEST_CASE(CoreDumpContainsRegionsAndThreads) {
+  Bootup();
+  std::vector<uint8_t> data(0x1800);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<uint8_t>(i * 7);
+  }
+  server->AddRegion(0x10000, data);
+  uint32_t thread_id = server->AddThread("test_thread");
+  server->SetThreadRegister(thread_id, "eip", 0x10010);
+  Connect();
+
+  std::stringstream out;
+  auto result = debugger->WriteCoreDump(out);
+  BOOST_REQUIRE(result.has_value());
+  BOOST_TEST(result->threads == debugger->Threads().size());
+  BOOST_TEST(result->failed_reads == 0);
+
+  auto core = out.str();
+  BOOST_TEST(core.size() == result->bytes_written);
+  auto read32 = [&core](size_t offset) {
+    uint32_t value;
+    memcpy(&value, core.data() + offset, sizeof(value));
+    return value;
+  };
+
+  std::optional<uint32_t> segment_offset;
+  uint32_t program_headers = *reinterpret_cast<const uint16_t*>(&core[44]);
+  BOOST_TEST(program_headers == result->regions + 1);
+  for (uint32_t i = 0; i < program_headers; ++i) {
+    auto header = 52 + i * 32;
+    if (read32(header) == 1 && read32(header + 8) == 0x10000) {
+      BOOST_TEST(read32(header + 16) == data.size());
+      segment_offset = read32(header + 4);
+    }
+  }
+  BOOST_REQUIRE(segment_offset.has_value());
+  BOOST_REQUIRE(*segment_offset + data.size() <= core.size());
+  BOOST_TEST(memcmp(core.data() + *segment_offset, data.data(),
+                    data.size()) == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+// ============================================================================
+// DisassemblyTests
+// ============================================================================
+
+BOOST_FIXTURE_TEST_SUITE(DisassemblyTests, XBDMDebuggerFixture)
+
+DEBUGGER_TEST_CASE(DisassemblyIsCachedUntilMemoryIsSet) {
+  Bootup();
+  server->AddRegion(0x10000, std::vector<uint8_t>(0x2000, 0x90),
+                    ::MemoryRegion::PAGE_EXECUTE_READWRITE);
+  Connect();
+
+  std::vector<std::string> reads;
+  server->SetAfterCommandHandler(
+      "getmem2", [&](const std::string& params) { reads.push_back(params); });
+
+  BOOST_TEST(debugger->Disassemble(0x10000, 4).size() == 4);
+  BOOST_TEST(debugger->Disassemble(0x10002, 4).size() == 4);
+  BOOST_TEST(reads.size() == 1);
+
+  BOOST_REQUIRE(debugger->SetMemory(0x10001, {0xC3}));
+  auto instructions = debugger->Disassemble(0x10000, 2);
+  BOOST_REQUIRE(instructions.size() == 2);
+  BOOST_TEST(std::string(instructions[1].mnemonic) == "ret");
+  BOOST_TEST(reads.size() == 2);
+}
+
+DEBUGGER_TEST_CASE(StopNearEndOfPagePrefetchesNextPage) {
+  Bootup();
+  server->AddRegion(0x10000, std::vector<uint8_t>(0x3000, 0x90));
+  uint32_t tid = server->AddThread("test_thread");
+  Connect();
+  BOOST_REQUIRE(debugger->FetchThreads());
+
+  BOOST_REQUIRE(!debugger->Disassemble(0x11F00, 1).empty());
+
+  std::vector<std::string> reads;
+  server->SetAfterCommandHandler(
+      "getmem2", [&](const std::string& params) { reads.push_back(params); });
+
+  auto last_count = debugger->StopEventCount();
+  server->SimulateExecutionBreakpoint(0x11FF0, tid);
+  BOOST_REQUIRE(debugger->WaitForStopEvent(last_count, 5000));
+  AwaitQuiescence();
+  BOOST_REQUIRE(reads.size() == 1);
+  BOOST_TEST(reads[0].find("ADDR=0x00012000") != std::string::npos);
+
+  BOOST_TEST(debugger->Disassemble(0x11FF0, 32).size() == 32);
+  BOOST_TEST(reads.size() == 1);
+}
+
+DEBUGGER_TEST_CASE(PrefetchRestoresBreakpointsBeforeStopIsReported) {
+  Bootup();
+  server->AddRegion(0x10000, std::vector<uint8_t>(0x3000, 0x90));
+  uint32_t tid = server->AddThread("test_thread");
+  Connect();
+  BOOST_REQUIRE(debugger->FetchThreads());
+  BOOST_REQUIRE(debugger->AddBreakpoint(0x12010));
+  BOOST_REQUIRE(!debugger->Disassemble(0x11F00, 1).empty());
+  AwaitQuiescence();
+
+  std::mutex commands_lock;
+  std::vector<std::string> commands;
+  for (const auto& command : {"break", "go"}) {
+    server->SetAfterCommandHandler(
+        command, [&, command](const std::string& params) {
+          const std::lock_guard lock(commands_lock);
+          commands.push_back(std::string(command) + " " + params);
+        });
+  }
+
+  // Resuming as soon as the stop is reported must not race the restore of
+  // the breakpoint suspended for the prefetch.
+  auto last_count = debugger->StopEventCount();
+  server->SimulateExecutionBreakpoint(0x11FF0, tid);
+  BOOST_REQUIRE(debugger->WaitForStopEvent(last_count, 5000));
+  BOOST_REQUIRE(debugger->Go());
+  AwaitQuiescence();
+
+  const std::lock_guard lock(commands_lock);
+  auto suspend = std::find_if(commands.begin(), commands.end(), [](auto& c) {
+    return c.starts_with("break") && c.find("clear") != std::string::npos;
+  });
+  BOOST_REQUIRE(suspend != commands.end());
+  auto restore = std::find_if(suspend, commands.end(), [](auto& c) {
+    return c.starts_with("break") && c.find("clear") == std::string::npos;
+  });
+  auto go = std::find_if(commands.begin(), commands.end(),
+                         [](auto& c) { return c.starts_with("go"); });
+  BOOST_REQUIRE(go != commands.end());
+  BOOST_TEST((restore < go));
+  BOOST_TEST(server->HasBreakpoint(0x12010));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+// ============================================================================
+// StepRangeTests
+// ============================================================================
+
+namespace {
+
+struct StepRangeFixture : XBDMDebuggerFixture {
+  //! The range contains a call to kCallee followed by nops.
+  static constexpr uint32_t kRangeStart = 0x10000;
+  static constexpr uint32_t kReturnAddress = 0x10005;
+  static constexpr uint32_t kRangeEnd = 0x10006;
+  static constexpr uint32_t kCallee = 0x20000;
+  static constexpr uint32_t kCallerESP = 0x8000;
+  static constexpr uint32_t kCalleeESP = kCallerESP - 4;
+
+  //! Boots the target with a thread stopped at `address` and scripts its
+  //! execution.
+  void StartStoppedAt(uint32_t address) {
+    Bootup();
+    std::vector<uint8_t> code(0x20, 0x90);
+    DefineCall(code, kRangeStart, kReturnAddress, kCallee);
+    server->AddRegion(kRangeStart, code);
+    server->AddRegion(kCallee, std::vector<uint8_t>(0x20, 0x90));
+    tid = server->AddThread("test_thread", address);
+    server->SetThreadRegister(tid, "esp", kCallerESP);
+    Connect();
+    BOOST_REQUIRE(debugger->FetchThreads());
+
+    auto last_count = debugger->StopEventCount();
+    server->SimulateExecutionBreakpoint(address, tid);
+    BOOST_REQUIRE(debugger->WaitForStopEvent(last_count, 5000));
+    BOOST_REQUIRE(debugger->SetActiveThread(tid));
+    ScriptExecution();
+  }
+
+  uint32_t LastAddress() const {
+    auto thread = debugger->GetThread(tid);
+    return thread ? thread->last_known_address.value_or(0) : 0;
+  }
+
+  uint32_t tid{0};
+};
+
+}  // namespace
+
+BOOST_FIXTURE_TEST_SUITE(StepRangeTests, StepRangeFixture)
+
+DEBUGGER_TEST_CASE(StepRangeOutsideRangeStepsOnce) {
+  StartStoppedAt(kRangeEnd);
+  QueueSingleStep(tid, kRangeEnd + 1);
+
+  BOOST_TEST(debugger->StepRange(kRangeStart, kRangeEnd));
+  BOOST_TEST(GoCount() == 1);
+  BOOST_TEST(LastAddress() == kRangeEnd + 1);
+}
+
+DEBUGGER_TEST_CASE(StepRangeStepsUntilLeavingRange) {
+  StartStoppedAt(kReturnAddress);
+  QueueSingleStep(tid, kReturnAddress + 1);
+  QueueSingleStep(tid, kReturnAddress + 2);
+  QueueSingleStep(tid, kReturnAddress + 3);
+
+  BOOST_TEST(debugger->StepRange(kReturnAddress, kReturnAddress + 3));
+  BOOST_TEST(GoCount() == 3);
+  BOOST_TEST(LastAddress() == kReturnAddress + 3);
+}
+
+DEBUGGER_TEST_CASE(StepRangeRunsToReturnAddressOfCall) {
+  StartStoppedAt(kRangeStart);
+  std::atomic<bool> return_breakpoint_set{false};
+  QueueSingleStep(tid, kCallee, kCalleeESP);
+  OnGo([&]() {
+    return_breakpoint_set = server->HasBreakpoint(kReturnAddress);
+    server->SetThreadRegister(tid, "esp", kCallerESP);
+    server->SetThreadRegister(tid, "eip", kReturnAddress);
+    server->SimulateExecutionBreakpoint(kReturnAddress, tid);
+  });
+  QueueSingleStep(tid, kRangeEnd);
+
+  BOOST_TEST(debugger->StepRange(kRangeStart, kRangeEnd));
+  BOOST_TEST(GoCount() == 3);
+  BOOST_TEST(return_breakpoint_set);
+  BOOST_TEST(LastAddress() == kRangeEnd);
+
+  // The temporary breakpoint is removed once the call returns.
+  AwaitQuiescence();
+  BOOST_TEST(!server->HasBreakpoint(kReturnAddress));
+}
+
+DEBUGGER_TEST_CASE(StepRangeIgnoresReturnAddressInRecursiveCall) {
+  StartStoppedAt(kRangeStart);
+  QueueSingleStep(tid, kCallee, kCalleeESP);
+  // A recursive call reaches the return address in a deeper frame first.
+  QueueBreakpoint(tid, kReturnAddress, kCalleeESP - 0x10);
+  QueueSingleStep(tid, kRangeEnd, kCalleeESP - 0x10);
+  QueueBreakpoint(tid, kReturnAddress, kCallerESP);
+  QueueSingleStep(tid, kRangeEnd, kCallerESP);
+
+  BOOST_TEST(debugger->StepRange(kRangeStart, kRangeEnd));
+  BOOST_TEST(GoCount() == 5);
+  BOOST_TEST(LastAddress() == kRangeEnd);
+
+  AwaitQuiescence();
+  BOOST_TEST(!server->HasBreakpoint(kReturnAddress));
+}
+
+DEBUGGER_TEST_CASE(StepRangeStopsAtBreakpointInCallee) {
+  StartStoppedAt(kRangeStart);
+  BOOST_REQUIRE(debugger->AddBreakpoint(kCallee + 0x10));
+  QueueSingleStep(tid, kCallee, kCalleeESP);
+  QueueBreakpoint(tid, kCallee + 0x10, kCalleeESP - 4);
+
+  BOOST_TEST(debugger->StepRange(kRangeStart, kRangeEnd));
+  BOOST_TEST(GoCount() == 2);
+  BOOST_TEST(LastAddress() == kCallee + 0x10);
+
+  AwaitQuiescence();
+  BOOST_TEST(!server->HasBreakpoint(kReturnAddress));
+  BOOST_TEST(server->HasBreakpoint(kCallee + 0x10));
+}
+
+DEBUGGER_TEST_CASE(StepRangeStopsAtBreakpointOnCalleeEntry) {
+  StartStoppedAt(kRangeStart);
+  BOOST_REQUIRE(debugger->AddBreakpoint(kCallee));
+  QueueSingleStep(tid, kCallee, kCalleeESP);
+
+  BOOST_TEST(debugger->StepRange(kRangeStart, kRangeEnd));
+  BOOST_TEST(GoCount() == 1);
+  BOOST_TEST(LastAddress() == kCallee);
+
+  AwaitQuiescence();
+  BOOST_TEST(!server->HasBreakpoint(kReturnAddress));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -83,6 +83,48 @@ DEBUGGER_TEST_CASE(GetMemoryRemovesAndRestoresBreakpoints) {
   BOOST_CHECK(found_restore);
 }
 
+DEBUGGER_TEST_CASE(GetMemorySuspendsBreakpointsInOneBatch) {
+  static constexpr size_t kBreakpointCount = 3;
+  Bootup();
+  Connect();
+
+  server->AddRegion(0x1000, std::vector<uint8_t>(0x10, 0x90));
+  for (uint32_t i = 0; i < kBreakpointCount; ++i) {
+    BOOST_REQUIRE(debugger->AddBreakpoint(0x1000 + i * 4));
+  }
+  AwaitQuiescence();
+
+  // Responses are withheld until every breakpoint's request has been
+  // received, which only succeeds if the requests are sent as one batch.
+  std::vector<std::vector<std::string>> batches;
+  std::vector<std::string> pending;
+  server->SetCommandHandler(
+      "break", [&](ClientTransport& client, const std::string& params) {
+        pending.push_back(params);
+        if (pending.size() == kBreakpointCount) {
+          for (size_t i = 0; i < kBreakpointCount; ++i) {
+            server->SendResponse(client, OK);
+          }
+          batches.push_back(std::move(pending));
+          pending.clear();
+        }
+        return true;
+      });
+
+  auto memory = debugger->GetMemory(0x1000, 0x10);
+  BOOST_REQUIRE(memory.has_value());
+  AwaitQuiescence();
+
+  BOOST_TEST(pending.empty());
+  BOOST_REQUIRE(batches.size() == 2);
+  auto is_clear = [](const std::string& params) {
+    return boost::algorithm::to_lower_copy(params).find("clear") !=
+           std::string::npos;
+  };
+  BOOST_TEST(std::all_of(batches[0].begin(), batches[0].end(), is_clear));
+  BOOST_TEST(std::none_of(batches[1].begin(), batches[1].end(), is_clear));
+}
+
 DEBUGGER_TEST_CASE(RebootClearsBreakpoints) {
   Bootup();
   Connect();
@@ -151,6 +193,43 @@ DEBUGGER_TEST_CASE(StepOverBreakpointTemporarilyClearsIt) {
       "Breakpoint must be restored after S_STOPPED notification");
 }
 
+DEBUGGER_TEST_CASE(StopBeforeStepResumesDoesNotRestoreBreakpoint) {
+  MockCommands(server.get());
+  // Leave the target stopped so that the step's resume is not reported.
+  server->SetCommandHandler(
+      "go", [server = server.get()](ClientTransport& client,
+                                    const std::string&) {
+        server->SendResponse(client, StatusCode::OK);
+        return true;
+      });
+
+  Bootup();
+  Connect();
+
+  const uint32_t kAddress = 0x80001000;
+  uint32_t thread_id = server->AddThread("Thread1", kAddress);
+
+  BOOST_REQUIRE(debugger->FetchThreads());
+  BOOST_REQUIRE(debugger->SetActiveThread(thread_id));
+  BOOST_REQUIRE(debugger->AddBreakpoint(kAddress));
+  BOOST_REQUIRE(debugger->Stop());
+  BOOST_REQUIRE(debugger->StepInstruction());
+  BOOST_REQUIRE(!server->HasBreakpoint(kAddress));
+
+  // A stop that is reported before the step resumes the target must not
+  // re-arm the breakpoint being stepped over.
+  server->SetExecutionState(ExecutionState::S_PENDING);
+  server->SetExecutionState(ExecutionState::S_STOPPED);
+  BOOST_REQUIRE(debugger->WaitForState(ExecutionState::S_STOPPED, 5000));
+  AwaitQuiescence();
+  BOOST_CHECK(!server->HasBreakpoint(kAddress));
+
+  server->SetExecutionState(ExecutionState::S_STARTED);
+  server->SetExecutionState(ExecutionState::S_STOPPED);
+  BOOST_CHECK(
+      AwaitCondition([&]() { return server->HasBreakpoint(kAddress); }));
+}
+
 DEBUGGER_TEST_CASE(StepOverNonBreakpointDoesNotClear) {
   MockCommands(server.get());
 
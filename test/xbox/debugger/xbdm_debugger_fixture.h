@@ -2,8 +2,14 @@
 #define XBDM_DEBUGGER_FIXTURE_H
 
 #include <boost/test/unit_test.hpp>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
 
 #include "configure_test.h"
 #include "net/select_thread.h"
@@ -28,7 +34,7 @@ struct XBDMDebuggerFixture {
                                              select_thread_);
     select_thread_->Start();
 
-    debugger = std::make_unique<XBDMDebugger>(context_);
+    debugger = std::make_shared<XBDMDebugger>(context_);
   }
 
   ~XBDMDebuggerFixture() {
@@ -77,8 +83,87 @@ struct XBDMDebuggerFixture {
         [this, state]() { return server->GetExecutionState() == state; });
   }
 
+  //! Polls until `predicate` returns true. Used for work done by notification
+  //! handlers, which AwaitQuiescence does not wait for.
+  static bool AwaitCondition(const std::function<bool()>& predicate,
+                             uint32_t max_wait_milliseconds = 5000) {
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(max_wait_milliseconds);
+    while (!predicate()) {
+      if (std::chrono::steady_clock::now() >= deadline) {
+        return false;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+  }
+
+  //! Mocks the commands used to single step and makes each subsequent "go"
+  //! perform the next action queued via OnGo, e.g., simulating a single step
+  //! or a breakpoint.
+  void ScriptExecution() {
+    auto mock = server.get();
+    mock->SetCommandHandler(
+        "stop", [mock](ClientTransport& client, const std::string&) {
+          mock->SendResponse(client, StatusCode::OK);
+          mock->SetExecutionState(S_STOPPED);
+          return true;
+        });
+    mock->SetCommandHandler(
+        "setcontext", [mock](ClientTransport& client, const std::string&) {
+          mock->SendResponse(client, StatusCode::OK);
+          return true;
+        });
+    mock->SetAfterCommandHandler("go", [this](const std::string&) {
+      std::function<void()> action;
+      {
+        const std::lock_guard lock(go_actions_lock_);
+        ++go_count_;
+        if (go_actions_.empty()) {
+          return;
+        }
+        action = std::move(go_actions_.front());
+        go_actions_.pop_front();
+      }
+      action();
+    });
+  }
+
+  void OnGo(std::function<void()> action) {
+    const std::lock_guard lock(go_actions_lock_);
+    go_actions_.push_back(std::move(action));
+  }
+
+  //! Queues a single step of the given thread to `address`.
+  void QueueSingleStep(uint32_t thread_id, uint32_t address,
+                       std::optional<uint32_t> esp = std::nullopt) {
+    OnGo([this, thread_id, address, esp]() {
+      if (esp) {
+        server->SetThreadRegister(thread_id, "esp", *esp);
+      }
+      server->SimulateSingleStep(address, thread_id);
+    });
+  }
+
+  //! Queues the given thread running to a breakpoint at `address`.
+  void QueueBreakpoint(uint32_t thread_id, uint32_t address,
+                       std::optional<uint32_t> esp = std::nullopt) {
+    OnGo([this, thread_id, address, esp]() {
+      if (esp) {
+        server->SetThreadRegister(thread_id, "esp", *esp);
+      }
+      server->SetThreadRegister(thread_id, "eip", address);
+      server->SimulateExecutionBreakpoint(address, thread_id);
+    });
+  }
+
+  uint32_t GoCount() {
+    const std::lock_guard lock(go_actions_lock_);
+    return go_count_;
+  }
+
   std::unique_ptr<MockXBDMServer> server;
-  std::unique_ptr<XBDMDebugger> debugger;
+  std::shared_ptr<XBDMDebugger> debugger;
   uint16_t port = 0;
 
   std::shared_ptr<XBDMContext> context_;
@@ -87,6 +172,10 @@ struct XBDMDebuggerFixture {
  private:
   std::mutex execution_state_mutex_;
   std::condition_variable execution_state_condition_variable_;
+
+  std::mutex go_actions_lock_;
+  std::deque<std::function<void()>> go_actions_;
+  uint32_t go_count_{0};
 };
 
 #endif  // XBDM_DEBUGGER_FIXTURE_H
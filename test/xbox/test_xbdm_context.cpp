@@ -0,0 +1,666 @@
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "configure_test.h"
+#include "net/select_thread.h"
+#include "notification/xbdm_notification.h"
+#include "rdcp/rdcp_processed_request.h"
+#include "rdcp/session_capture.h"
+#include "rdcp/session_replay_server.h"
+#include "rdcp/xbdm_requests.h"
+#include "test_util/mock_xbdm_server/mock_xbdm_server.h"
+#include "xbox/xbdm_context.h"
+
+using namespace xbdm_gdb_bridge;
+using namespace xbdm_gdb_bridge::testing;
+using namespace std::chrono_literals;
+
+struct XBDMContextTestFixture {
+  XBDMContextTestFixture() {
+    server = std::make_unique<MockXBDMServer>(TEST_MOCK_XBDM_PORT);
+    BOOST_REQUIRE(server->Start());
+
+    select_thread_ = std::make_shared<SelectThread>("ST_XBDMContextTest");
+    context_ = std::make_shared<XBDMContext>("Client", server->GetAddress(),
+                                             select_thread_);
+    select_thread_->Start();
+    BOOST_REQUIRE(context_->Reconnect());
+  }
+
+  ~XBDMContextTestFixture() {
+    JoinResponders();
+    if (context_) {
+      context_->Shutdown();
+    }
+    server->Stop();
+    select_thread_->Stop();
+  }
+
+  //! Registers a handler for `command` that responds OK after `delay` without
+  //! blocking the mock server's select loop.
+  void SetDelayedOKHandler(const std::string& command,
+                           std::chrono::milliseconds delay) {
+    server->SetCommandHandler(
+        command, [this, delay](ClientTransport& client, const std::string&) {
+          const std::lock_guard lock(responders_lock_);
+          responders_.emplace_back([this, &client, delay]() {
+            std::this_thread::sleep_for(delay);
+            server->SendResponse(client, OK);
+          });
+          return true;
+        });
+  }
+
+  void JoinResponders() {
+    std::vector<std::thread> responders;
+    {
+      const std::lock_guard lock(responders_lock_);
+      responders.swap(responders_);
+    }
+    for (auto& responder : responders) {
+      responder.join();
+    }
+  }
+
+  std::unique_ptr<MockXBDMServer> server;
+  std::shared_ptr<XBDMContext> context_;
+  std::shared_ptr<SelectThread> select_thread_;
+
+  std::mutex responders_lock_;
+  std::vector<std::thread> responders_;
+};
+
+#define XBDM_CONTEXT_TEST_CASE(__name) \
+  BOOST_AUTO_TEST_CASE(__name, *boost::unit_test::timeout(TEST_TIMEOUT_SECONDS))
+
+BOOST_FIXTURE_TEST_SUITE(XBDMContextTests, XBDMContextTestFixture)
+
+XBDM_CONTEXT_TEST_CASE(DedicatedChannelsExecuteConcurrently) {
+  static constexpr auto kDelay = 500ms;
+  SetDelayedOKHandler("slowcmd", kDelay);
+
+  BOOST_REQUIRE(context_->CreateDedicatedChannel("first"));
+  BOOST_REQUIRE(context_->CreateDedicatedChannel("second"));
+
+  auto first = std::make_shared<RDCPProcessedRequest>("slowcmd");
+  auto second = std::make_shared<RDCPProcessedRequest>("slowcmd");
+
+  auto start = std::chrono::steady_clock::now();
+  auto first_future = context_->SendCommand(first, "first");
+  auto second_future = context_->SendCommand(second, "second");
+  first_future.get();
+  second_future.get();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  BOOST_TEST(first->status == OK);
+  BOOST_TEST(second->status == OK);
+  BOOST_TEST(elapsed < 2 * kDelay);
+}
+
+XBDM_CONTEXT_TEST_CASE(DedicatedChannelDoesNotBlockControlChannel) {
+  static constexpr auto kDelay = 500ms;
+  SetDelayedOKHandler("slowcmd", kDelay);
+  SetDelayedOKHandler("fastcmd", 0ms);
+
+  auto slow = std::make_shared<RDCPProcessedRequest>("slowcmd");
+  auto fast = std::make_shared<RDCPProcessedRequest>("fastcmd");
+
+  auto slow_future = context_->SendCommand(slow, "dedicated");
+  auto start = std::chrono::steady_clock::now();
+  context_->SendCommandSync(fast);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  BOOST_TEST(fast->status == OK);
+  BOOST_TEST(elapsed < kDelay);
+
+  slow_future.get();
+  BOOST_TEST(slow->status == OK);
+}
+
+XBDM_CONTEXT_TEST_CASE(DestroyedDedicatedChannelIsRecreatedOnDemand) {
+  SetDelayedOKHandler("fastcmd", 0ms);
+  BOOST_REQUIRE(context_->CreateDedicatedChannel("dedicated"));
+  BOOST_TEST(!context_->CreateDedicatedChannel("dedicated"));
+
+  context_->DestroyDedicatedChannel("dedicated");
+
+  auto request = std::make_shared<RDCPProcessedRequest>("fastcmd");
+  context_->SendCommandSync(request, "dedicated");
+  BOOST_TEST(request->status == OK);
+}
+
+XBDM_CONTEXT_TEST_CASE(AsyncCommandsCompleteWithoutBlocking) {
+  static constexpr int kNumRequests = 64;
+  server->SetCommandHandler(
+      "fastcmd", [this](ClientTransport& client, const std::string&) {
+        server->SendResponse(client, OK);
+        return true;
+      });
+
+  std::mutex completion_lock;
+  std::condition_variable completion_condition;
+  int completed = 0;
+
+  std::vector<std::shared_ptr<RDCPProcessedRequest>> requests;
+  for (int i = 0; i < kNumRequests; ++i) {
+    auto request = std::make_shared<RDCPProcessedRequest>("fastcmd");
+    requests.push_back(request);
+    context_->SendCommandAsync(request, [&]() {
+      const std::lock_guard lock(completion_lock);
+      ++completed;
+      completion_condition.notify_all();
+    });
+  }
+
+  std::unique_lock lock(completion_lock);
+  BOOST_REQUIRE(completion_condition.wait_for(
+      lock, 5s, [&]() { return completed == kNumRequests; }));
+  for (const auto& request : requests) {
+    BOOST_TEST(request->status == OK);
+  }
+}
+
+XBDM_CONTEXT_TEST_CASE(AsyncCommandOnShutdownIsAbandoned) {
+  SetDelayedOKHandler("slowcmd", 500ms);
+
+  auto in_flight = std::make_shared<RDCPProcessedRequest>("slowcmd");
+  auto queued = std::make_shared<RDCPProcessedRequest>("slowcmd");
+  std::atomic<int> completed{0};
+  context_->SendCommandAsync(in_flight, [&]() { ++completed; });
+  context_->SendCommandAsync(queued, [&]() { ++completed; });
+
+  context_->Shutdown();
+
+  BOOST_TEST(completed == 2);
+  BOOST_TEST(queued->status == ERR_ABANDONED);
+}
+
+XBDM_CONTEXT_TEST_CASE(SendBatchWritesRequestsWithoutWaiting) {
+  static constexpr int kBatchSize = 8;
+
+  // Responses are withheld until every request in the batch has been
+  // received, which only succeeds if the requests are pipelined.
+  std::vector<std::string> received;
+  server->SetCommandHandler(
+      "batchcmd", [&](ClientTransport& client, const std::string& params) {
+        received.push_back(params);
+        if (received.size() == kBatchSize) {
+          for (const auto& entry : received) {
+            if (entry == "fail") {
+              server->SendResponse(client, ERR_UNEXPECTED, entry);
+            } else {
+              server->SendResponse(client, OK, entry);
+            }
+          }
+        }
+        return true;
+      });
+
+  std::vector<std::shared_ptr<RDCPProcessedRequest>> requests;
+  for (int i = 0; i < kBatchSize; ++i) {
+    auto request = std::make_shared<RDCPProcessedRequest>("batchcmd");
+    request->SetData(i == 3 ? " fail" : " " + std::to_string(i));
+    requests.push_back(request);
+  }
+
+  XBDMContext::BatchTiming timing;
+  BOOST_TEST(!context_->SendBatch(requests, &timing));
+
+  BOOST_REQUIRE(received.size() == kBatchSize);
+  for (int i = 0; i < kBatchSize; ++i) {
+    if (i == 3) {
+      BOOST_TEST(requests[i]->status == ERR_UNEXPECTED);
+      BOOST_TEST(requests[i]->message == "fail");
+    } else {
+      BOOST_TEST(requests[i]->status == OK);
+      BOOST_TEST(requests[i]->message == std::to_string(i));
+    }
+  }
+
+  BOOST_REQUIRE(timing.completion_milliseconds.size() == kBatchSize);
+  BOOST_TEST(std::is_sorted(timing.completion_milliseconds.begin(),
+                            timing.completion_milliseconds.end()));
+  BOOST_TEST(timing.total_milliseconds >=
+             timing.completion_milliseconds.back());
+}
+
+XBDM_CONTEXT_TEST_CASE(SendBatchOnDedicatedChannel) {
+  SetDelayedOKHandler("fastcmd", 0ms);
+
+  std::vector<std::shared_ptr<RDCPProcessedRequest>> requests = {
+      std::make_shared<RDCPProcessedRequest>("fastcmd"),
+      std::make_shared<RDCPProcessedRequest>("fastcmd"),
+  };
+
+  BOOST_TEST(context_->SendBatch(requests, "dedicated"));
+  BOOST_TEST(requests[0]->status == OK);
+  BOOST_TEST(requests[1]->status == OK);
+}
+
+XBDM_CONTEXT_TEST_CASE(ConnectionMetricsTrackAcceptedConnections) {
+  SetDelayedOKHandler("fastcmd", 0ms);
+
+  auto request = std::make_shared<RDCPProcessedRequest>("fastcmd");
+  context_->SendCommandSync(request);
+  BOOST_REQUIRE(request->status == OK);
+
+  auto metrics = context_->GetConnectionMetrics();
+  BOOST_TEST(metrics.connections == 1);
+  BOOST_TEST(metrics.reconnects == 0);
+  BOOST_TEST(metrics.last_connect_milliseconds > 0);
+  BOOST_TEST(metrics.total_connect_milliseconds ==
+             metrics.last_connect_milliseconds);
+
+  BOOST_REQUIRE(context_->Reconnect());
+  request = std::make_shared<RDCPProcessedRequest>("fastcmd");
+  context_->SendCommandSync(request);
+  BOOST_REQUIRE(request->status == OK);
+
+  metrics = context_->GetConnectionMetrics();
+  BOOST_TEST(metrics.connections == 2);
+  BOOST_TEST(metrics.reconnects == 1);
+  BOOST_TEST(metrics.failed_connects == 0);
+  BOOST_TEST(metrics.max_connect_milliseconds >=
+             metrics.last_connect_milliseconds);
+}
+
+XBDM_CONTEXT_TEST_CASE(TransportMetricsTrackCommands) {
+  SetDelayedOKHandler("fastcmd", 0ms);
+  SetDelayedOKHandler("slowcmd", 20ms);
+
+  for (int i = 0; i < 3; ++i) {
+    auto request = std::make_shared<RDCPProcessedRequest>("fastcmd");
+    context_->SendCommandSync(request);
+    BOOST_REQUIRE(request->status == OK);
+  }
+  auto request = std::make_shared<RDCPProcessedRequest>("slowcmd");
+  context_->SendCommandSync(request);
+  BOOST_REQUIRE(request->status == OK);
+
+  auto metrics = context_->GetTransportMetrics();
+  BOOST_REQUIRE(metrics.size() == 1);
+  const auto& snapshot = metrics.begin()->second;
+  BOOST_TEST(snapshot.executor_wait.Count() == 4);
+  BOOST_TEST(snapshot.queue_wait.Count() == 4);
+  BOOST_TEST(snapshot.max_queue_depth >= 1);
+
+  const auto& fast = snapshot.commands.at("fastcmd");
+  BOOST_TEST(fast.count == 3);
+  BOOST_TEST(fast.bytes_sent == 3 * (sizeof("fastcmd") - 1 + 2));
+  BOOST_TEST(fast.bytes_received > 0);
+  BOOST_TEST(fast.round_trip.Count() == 3);
+
+  const auto& slow = snapshot.commands.at("slowcmd");
+  BOOST_TEST(slow.count == 1);
+  BOOST_TEST(slow.round_trip.MinMicroseconds() >= 20000);
+
+  context_->ResetTransportMetrics();
+  BOOST_TEST(context_->GetTransportMetrics().begin()->second.commands.empty());
+}
+
+XBDM_CONTEXT_TEST_CASE(UnsentRequestsSurviveDroppedConnection) {
+  SetDelayedOKHandler("fastcmd", 0ms);
+
+  // Never responds, so that requests queued behind it are unsent when the
+  // connection is dropped.
+  std::mutex received_lock;
+  std::condition_variable received_condition;
+  bool received = false;
+  server->SetCommandHandler("hangcmd",
+                            [&](ClientTransport&, const std::string&) {
+                              const std::lock_guard lock(received_lock);
+                              received = true;
+                              received_condition.notify_all();
+                              return true;
+                            });
+
+  auto in_flight = std::make_shared<RDCPProcessedRequest>("hangcmd");
+  auto in_flight_future = context_->SendCommand(in_flight);
+  {
+    std::unique_lock lock(received_lock);
+    BOOST_REQUIRE(
+        received_condition.wait_for(lock, 5s, [&]() { return received; }));
+  }
+
+  auto first = std::make_shared<RDCPProcessedRequest>("fastcmd");
+  auto second = std::make_shared<RDCPProcessedRequest>("fastcmd");
+  auto first_future = context_->SendCommand(first);
+  auto second_future = context_->SendCommand(second);
+
+  context_->CloseActiveConnections();
+
+  in_flight_future.get();
+  BOOST_TEST(in_flight->status == ERR_ABANDONED);
+
+  first_future.get();
+  second_future.get();
+  BOOST_TEST(first->status == OK);
+  BOOST_TEST(second->status == OK);
+  BOOST_TEST(context_->GetConnectionMetrics().reconnects >= 1);
+}
+
+XBDM_CONTEXT_TEST_CASE(SlowNotificationHandlerDoesNotBlockOtherKeys) {
+  server->SetExecutionState(S_STARTED);
+  IPAddress address;
+  BOOST_REQUIRE(context_->StartNotificationListener(address));
+  BOOST_REQUIRE(context_->GetNotificationServerAddress(address));
+  auto notify_at = std::make_shared<NotifyAt>(address.Port(), false, true);
+  context_->SendCommandSync(notify_at);
+  BOOST_REQUIRE(notify_at->IsOK());
+
+  std::mutex lock;
+  std::condition_variable condition;
+  bool release_slow = false;
+  bool fast_saw_final_state = false;
+  size_t fast_calls = 0;
+  std::vector<std::string> slow_calls;
+
+  auto is_final_state = [](const std::shared_ptr<XBDMNotification>& n) {
+    auto state_changed =
+        std::dynamic_pointer_cast<NotificationExecutionStateChanged>(n);
+    return state_changed && state_changed->state == S_PENDING;
+  };
+
+  // Blocks until the fast handler has seen every notification, which can only
+  // happen if the handlers are not dispatched serially.
+  auto first = context_->RegisterNotificationHandler(
+      [&](const std::shared_ptr<XBDMNotification>&, XBDMContext&) {
+        std::unique_lock guard(lock);
+        condition.wait(guard, [&]() { return release_slow; });
+        slow_calls.emplace_back("first");
+      },
+      "slow");
+  auto second = context_->RegisterNotificationHandler(
+      [&](const std::shared_ptr<XBDMNotification>&, XBDMContext&) {
+        const std::lock_guard guard(lock);
+        slow_calls.emplace_back("second");
+        condition.notify_all();
+      },
+      "slow");
+  auto fast = context_->RegisterNotificationHandler(
+      [&](const std::shared_ptr<XBDMNotification>& notification,
+          XBDMContext&) {
+        const std::lock_guard guard(lock);
+        ++fast_calls;
+        if (is_final_state(notification)) {
+          fast_saw_final_state = true;
+          condition.notify_all();
+        }
+      },
+      "fast");
+
+  server->SetExecutionState(S_STOPPED);
+  server->SetExecutionState(S_STARTED);
+  server->SetExecutionState(S_PENDING);
+
+  {
+    std::unique_lock guard(lock);
+    BOOST_TEST(condition.wait_for(guard, 1s,
+                                  [&]() { return fast_saw_final_state; }));
+    release_slow = true;
+    condition.notify_all();
+
+    // Unregistering skips notifications that have not been delivered yet.
+    BOOST_TEST(condition.wait_for(guard, 1s, [&]() {
+      return slow_calls.size() == fast_calls * 2;
+    }));
+  }
+
+  context_->UnregisterNotificationHandler(fast);
+  context_->UnregisterNotificationHandler(second);
+  context_->UnregisterNotificationHandler(first);
+  context_->Shutdown();
+
+  // Handlers sharing a key always run in registration order.
+  BOOST_REQUIRE(!slow_calls.empty());
+  BOOST_REQUIRE(slow_calls.size() % 2 == 0);
+  for (size_t i = 0; i < slow_calls.size(); i += 2) {
+    BOOST_TEST(slow_calls[i] == "first");
+    BOOST_TEST(slow_calls[i + 1] == "second");
+  }
+}
+
+XBDM_CONTEXT_TEST_CASE(UnregisterWaitsForRunningNotificationHandler) {
+  server->SetExecutionState(S_STARTED);
+  IPAddress address;
+  BOOST_REQUIRE(context_->StartNotificationListener(address));
+  BOOST_REQUIRE(context_->GetNotificationServerAddress(address));
+  auto notify_at = std::make_shared<NotifyAt>(address.Port(), false, true);
+  context_->SendCommandSync(notify_at);
+  BOOST_REQUIRE(notify_at->IsOK());
+
+  std::mutex lock;
+  std::condition_variable condition;
+  bool release = false;
+  int calls = 0;
+  auto id = context_->RegisterNotificationHandler(
+      [&](const std::shared_ptr<XBDMNotification>&, XBDMContext&) {
+        std::unique_lock guard(lock);
+        ++calls;
+        condition.notify_all();
+        condition.wait(guard, [&]() { return release; });
+      });
+
+  server->SetExecutionState(S_STOPPED);
+  server->SetExecutionState(S_PENDING);
+  {
+    std::unique_lock guard(lock);
+    BOOST_REQUIRE(condition.wait_for(guard, 1s, [&]() { return calls > 0; }));
+  }
+
+  std::atomic<bool> unregistered{false};
+  std::thread unregister([&]() {
+    context_->UnregisterNotificationHandler(id);
+    unregistered = true;
+  });
+  std::this_thread::sleep_for(50ms);
+  BOOST_TEST(!unregistered);
+
+  {
+    const std::lock_guard guard(lock);
+    release = true;
+    condition.notify_all();
+  }
+  unregister.join();
+
+  // The notification queued behind the running one is not delivered.
+  const std::lock_guard guard(lock);
+  BOOST_TEST(calls == 1);
+}
+
+BOOST_AUTO_TEST_CASE(UnreachableXBOXFailsAfterRetries,
+                     *boost::unit_test::timeout(TEST_TIMEOUT_SECONDS)) {
+  IPAddress address;
+  {
+    MockXBDMServer unused(TEST_MOCK_XBDM_PORT);
+    BOOST_REQUIRE(unused.Start());
+    address = unused.GetAddress();
+    unused.Stop();
+  }
+
+  auto select_thread = std::make_shared<SelectThread>("ST_Unreachable");
+  auto context = std::make_shared<XBDMContext>("Client", address,
+                                               select_thread);
+  select_thread->Start();
+
+  XBDMContext::ReconnectPolicy policy;
+  policy.max_retries = 2;
+  policy.initial_backoff_milliseconds = 10;
+  policy.connect_timeout_milliseconds = 100;
+  context->SetReconnectPolicy(policy);
+
+  auto request = std::make_shared<RDCPProcessedRequest>("fastcmd");
+  context->SendCommandSync(request);
+  BOOST_TEST(request->status == ERR_NOT_CONNECTED);
+  BOOST_TEST(context->GetConnectionMetrics().failed_connects ==
+             policy.max_retries + 1);
+  BOOST_TEST(context->GetConnectionMetrics().connections == 0);
+
+  context->Shutdown();
+  select_thread->Stop();
+}
+
+XBDM_CONTEXT_TEST_CASE(CapturedSessionReplays) {
+  SetDelayedOKHandler("fastcmd", 0ms);
+  SetDelayedOKHandler("slowcmd", 20ms);
+
+  auto path = std::filesystem::temp_directory_path() /
+              "xbdm_gdb_bridge_context_capture.cap";
+  BOOST_REQUIRE(context_->StartCapture(path));
+  for (int i = 0; i < 2; ++i) {
+    auto request = std::make_shared<RDCPProcessedRequest>("fastcmd");
+    context_->SendCommandSync(request);
+    BOOST_REQUIRE(request->status == OK);
+  }
+  auto slow = std::make_shared<RDCPProcessedRequest>("slowcmd");
+  context_->SendCommandSync(slow);
+  auto threads = std::make_shared<Threads>();
+  context_->SendCommandSync(threads);
+  BOOST_REQUIRE(threads->IsOK());
+  context_->StopCapture();
+  BOOST_TEST(!context_->GetCapture());
+
+  std::vector<session_capture::Record> records;
+  BOOST_REQUIRE(session_capture::ReadCapture(path, records));
+  auto count_type = [&records](session_capture::RecordType type) {
+    return std::count_if(records.begin(), records.end(),
+                         [type](const auto& r) { return r.type == type; });
+  };
+  BOOST_TEST(count_type(session_capture::RecordType::REQUEST) == 4);
+  // The connection banner may also have been recorded.
+  BOOST_TEST(count_type(session_capture::RecordType::RESPONSE) >= 4);
+  BOOST_TEST(count_type(session_capture::RecordType::STREAM_CLOSED) == 1);
+
+  SessionReplayServer replay;
+  BOOST_REQUIRE(replay.Load(path));
+  BOOST_REQUIRE(replay.Start(IPAddress(static_cast<uint16_t>(0))));
+
+  auto select_thread = std::make_shared<SelectThread>("ST_Replay");
+  auto context = std::make_shared<XBDMContext>("Replay", replay.Address(),
+                                               select_thread);
+  select_thread->Start();
+
+  auto replayed_threads = std::make_shared<Threads>();
+  context->SendCommandSync(replayed_threads);
+  BOOST_TEST(replayed_threads->IsOK());
+  BOOST_TEST(replayed_threads->threads == threads->threads);
+
+  auto start = std::chrono::steady_clock::now();
+  auto replayed_slow = std::make_shared<RDCPProcessedRequest>("slowcmd");
+  context->SendCommandSync(replayed_slow);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  BOOST_TEST(replayed_slow->status == OK);
+  BOOST_TEST(elapsed >= 20ms);
+
+  // Requests beyond those recorded reuse the last matching exchange.
+  for (int i = 0; i < 3; ++i) {
+    auto request = std::make_shared<RDCPProcessedRequest>("fastcmd");
+    context->SendCommandSync(request);
+    BOOST_TEST(request->status == OK);
+  }
+
+  auto unknown = std::make_shared<RDCPProcessedRequest>("unrecorded");
+  context->SendCommandSync(unknown);
+  BOOST_TEST(unknown->status == ERR_UNKNOWN_COMMAND);
+
+  auto stats = replay.GetStats();
+  BOOST_TEST(stats.requests == 6);
+  BOOST_TEST(stats.reused_exchanges == 1);
+  BOOST_TEST(stats.unmatched_requests == 1);
+
+  context->Shutdown();
+  select_thread->Stop();
+  replay.Stop();
+}
+
+XBDM_CONTEXT_TEST_CASE(ReplayConnectsNotificationStream) {
+  using session_capture::RecordType;
+  using session_capture::StreamKind;
+
+  auto path = std::filesystem::temp_directory_path() /
+              "xbdm_gdb_bridge_notification_capture.cap";
+  {
+    auto writer = SessionCaptureWriter::Create(path);
+    BOOST_REQUIRE(writer);
+    auto control = writer->OpenStream(StreamKind::CONTROL, "XBDM");
+    auto notification =
+        writer->OpenStream(StreamKind::NOTIFICATION, "XBDMNotif");
+    std::string request = "notifyat port=0x1234\r\n";
+    std::string response = "200- OK\r\n";
+    std::string message = "hello\r\n";
+    writer->Record(control, RecordType::REQUEST, request.data(),
+                   request.size());
+    writer->Record(control, RecordType::RESPONSE, response.data(),
+                   response.size());
+    writer->Record(notification, RecordType::NOTIFICATION, message.data(),
+                   message.size());
+  }
+
+  SessionReplayServer replay(0);
+  BOOST_REQUIRE(replay.Load(path));
+  BOOST_REQUIRE(replay.Start(IPAddress(static_cast<uint16_t>(0))));
+
+  // Returns up to `len` bytes from `sock`, or an empty string on timeout.
+  auto receive = [](int sock, size_t len) {
+    struct pollfd fd{sock, POLLIN, 0};
+    std::string ret(len, '\0');
+    if (poll(&fd, 1, 1000) != 1) {
+      return std::string();
+    }
+    auto bytes = recv(sock, ret.data(), ret.size(), 0);
+    ret.resize(std::max<ssize_t>(bytes, 0));
+    return ret;
+  };
+
+  int listener = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+  struct sockaddr_in listen_addr{};
+  listen_addr.sin_family = AF_INET;
+  listen_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t addr_len = sizeof(listen_addr);
+  BOOST_REQUIRE(!bind(listener, reinterpret_cast<sockaddr*>(&listen_addr),
+                      sizeof(listen_addr)));
+  BOOST_REQUIRE(!listen(listener, 1));
+  BOOST_REQUIRE(!getsockname(
+      listener, reinterpret_cast<sockaddr*>(&listen_addr), &addr_len));
+
+  int client = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+  struct sockaddr_in replay_addr = replay.Address().Address();
+  replay_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  BOOST_REQUIRE(!connect(client, reinterpret_cast<sockaddr*>(&replay_addr),
+                         sizeof(replay_addr)));
+  BOOST_TEST(!receive(client, 64).empty());
+
+  char request[64];
+  auto request_len = snprintf(request, sizeof(request),
+                              "notifyat port=0x%x\r\n",
+                              ntohs(listen_addr.sin_port));
+  BOOST_REQUIRE(send(client, request, request_len, 0) == request_len);
+
+  struct pollfd pending{listener, POLLIN, 0};
+  BOOST_REQUIRE(poll(&pending, 1, 1000) == 1);
+  int notification = accept(listener, nullptr, nullptr);
+  BOOST_REQUIRE(notification >= 0);
+  BOOST_TEST(receive(notification, 64) == "hello\r\n");
+  BOOST_TEST(replay.GetStats().notification_streams == 1);
+
+  close(notification);
+  close(client);
+  close(listener);
+  replay.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+
+# ruff: noqa: T201 `print` found
+
+"""Converts images written by the fast `trace images <fmt>` modes into optimized PNGs."""
+
+from __future__ import annotations
+
+import argparse
+import json
+import os
+import sys
+from argparse import Namespace
+
+from PIL import Image
+
+# Maps (channels, bit_depth) in a raw image sidecar to a Pillow mode/rawmode.
+RAW_MODES = {
+    (1, 8): ("L", "L"),
+    (1, 16): ("I;16", "I;16B"),
+    (3, 8): ("RGB", "RGB"),
+    (4, 8): ("RGBA", "RGBA"),
+}
+
+
+def _load_raw(raw_file: str) -> Image.Image | None:
+    with open(raw_file + ".json") as infile:
+        description = json.load(infile)
+
+    layout = (description["channels"], description["bit_depth"])
+    modes = RAW_MODES.get(layout)
+    if not modes:
+        print(f"WARNING: Unsupported raw layout {layout} for {raw_file}")
+        return None
+
+    mode, rawmode = modes
+    with open(raw_file, "rb") as infile:
+        data = infile.read()
+
+    return Image.frombytes(mode, (description["width"], description["height"]), data, "raw", rawmode)
+
+
+class Processor:
+    def __init__(self, *, keep_originals: bool, reencode_png: bool):
+        self._keep_originals = keep_originals
+        self._reencode_png = reencode_png
+
+    def process(self, artifact_path: str) -> int:
+        converted = 0
+        for root, _dirs, files in os.walk(artifact_path):
+            for filename in sorted(files):
+                if self._process_file(os.path.join(root, filename)):
+                    converted += 1
+
+        if converted:
+            self._update_texture_references(artifact_path)
+
+        print(f"Converted {converted} images.")
+        return 0
+
+    @staticmethod
+    def _update_texture_references(artifact_path: str):
+        """Points texture descriptions at the converted PNG content images."""
+        for root, _dirs, files in os.walk(artifact_path):
+            for filename in files:
+                if not filename.endswith(".txt"):
+                    continue
+
+                description_path = os.path.join(root, filename)
+                try:
+                    with open(description_path) as infile:
+                        description = json.load(infile)
+                except (OSError, ValueError):
+                    continue
+
+                texture = description.get("texture") if isinstance(description, dict) else None
+                content_image = texture.get("content_image") if texture else None
+                if not content_image or content_image.endswith(".png"):
+                    continue
+
+                png_image = os.path.splitext(content_image)[0] + ".png"
+                if not os.path.isfile(os.path.join(root, png_image)):
+                    continue
+
+                texture["content_image"] = png_image
+                with open(description_path, "w") as outfile:
+                    json.dump(description, outfile, indent=2)
+
+    def _process_file(self, path: str) -> bool:
+        base, extension = os.path.splitext(path)
+
+        if extension == ".qoi":
+            with Image.open(path) as img:
+                img.load()
+                image = img
+            originals = [path]
+        elif extension == ".raw" and os.path.isfile(path + ".json"):
+            image = _load_raw(path)
+            originals = [path, path + ".json"]
+        elif extension == ".png" and self._reencode_png:
+            with Image.open(path) as img:
+                img.load()
+                image = img
+            originals = []
+        else:
+            return False
+
+        if not image:
+            return False
+
+        output_path = base + ".png"
+        image.save(output_path, optimize=True)
+
+        if not self._keep_originals:
+            for original in originals:
+                os.remove(original)
+        return True
+
+
+def _main(args: Namespace) -> int:
+    artifact_path = os.path.abspath(os.path.expanduser(args.artifact_path))
+
+    processor = Processor(keep_originals=args.keep, reencode_png=args.reencode_png)
+    return processor.process(artifact_path)
+
+
+if __name__ == "__main__":
+
+    def _parse_args():
+        parser = argparse.ArgumentParser()
+
+        parser.add_argument(
+            "artifact_path",
+            help="Trace artifact directory to process recursively.",
+        )
+
+        parser.add_argument("--keep", "-k", action="store_true", help="Keep the original .qoi/.raw files")
+        parser.add_argument(
+            "--reencode-png",
+            "-p",
+            action="store_true",
+            help="Also re-encode existing PNG files (e.g., those written in 'fastpng' mode)",
+        )
+
+        return parser.parse_args()
+
+    sys.exit(_main(_parse_args()))
@@ -0,0 +1,174 @@
+// Measures ParseXBDMNotification against a recorded notification stream and
+// compares debugstr parsing with the previous std::regex implementation.
+//
+// Usage: notification_benchmark [recording [iterations]]
+//
+// A recording contains one notification per line, exactly as sent by XBDM on
+// the notification channel. If no recording is given, a synthetic stream
+// dominated by debugstr output is used.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "notification/xbdm_notification.h"
+
+static const int kDefaultIterations = 20;
+static const int kSyntheticLines = 20000;
+
+static std::vector<std::string> LoadRecording(const char* path) {
+  std::vector<std::string> ret;
+  std::ifstream file(path);
+  std::string line;
+  while (std::getline(file, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (!line.empty()) {
+      ret.push_back(line);
+    }
+  }
+  return ret;
+}
+
+static std::vector<std::string> BuildSyntheticStream() {
+  std::vector<std::string> ret;
+  ret.reserve(kSyntheticLines);
+  for (int i = 0; i < kSyntheticLines; ++i) {
+    auto thread = std::to_string(28 + i % 4);
+    switch (i % 16) {
+      case 0:
+        ret.push_back("execution started");
+        break;
+      case 1:
+        ret.push_back("create thread=" + thread + " start=0x00012000");
+        break;
+      case 2:
+        ret.push_back("debugstr thread=" + thread + " string=Partial ");
+        break;
+      default:
+        ret.push_back("debugstr thread=" + thread +
+                      " lf string=Frame " + std::to_string(i) +
+                      ": PushBuffer 0x80012345 flushed 1024 bytes");
+        break;
+    }
+  }
+  return ret;
+}
+
+// The NotificationDebugStr parser prior to the hand written tokenizer.
+static bool RegexParseDebugStr(const std::string& line, int& thread_id,
+                               std::string& text) {
+  static const std::regex notification_regex(
+      R"(thread=(\d+)\s+(lf|cr|crlf)?\s*string=(.*))");
+  static const std::string prefix = "debugstr ";
+
+  std::string buffer(line.begin() + static_cast<long>(prefix.size()),
+                     line.end());
+  std::smatch match;
+  if (!std::regex_match(buffer, match, notification_regex)) {
+    return false;
+  }
+  thread_id = std::stoi(match[1]);
+  text = match[3];
+  return true;
+}
+
+template <typename Func>
+static double TimeNanosPerLine(int iterations, size_t lines, Func&& func) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    func();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() /
+         (static_cast<double>(iterations) * static_cast<double>(lines));
+}
+
+int main(int argc, const char* argv[]) {
+  std::vector<std::string> stream;
+  if (argc > 1) {
+    stream = LoadRecording(argv[1]);
+    if (stream.empty()) {
+      fprintf(stderr, "No notifications loaded from '%s'\n", argv[1]);
+      return EXIT_FAILURE;
+    }
+  } else {
+    stream = BuildSyntheticStream();
+  }
+
+  int iterations = kDefaultIterations;
+  if (argc > 2) {
+    iterations = atoi(argv[2]);
+    if (iterations <= 0) {
+      fprintf(stderr, "Invalid iteration count '%s'\n", argv[2]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::vector<const std::string*> debugstrs;
+  for (const auto& line : stream) {
+    if (line.starts_with("debugstr ")) {
+      debugstrs.push_back(&line);
+    }
+  }
+
+  size_t unparsed = 0;
+  auto parse_ns = TimeNanosPerLine(iterations, stream.size(), [&]() {
+    for (const auto& line : stream) {
+      if (!ParseXBDMNotification(line.c_str(),
+                                 static_cast<long>(line.size()))) {
+        ++unparsed;
+      }
+    }
+  });
+
+  // Compare the debugstr lines alone with the regex implementation, checking
+  // that both produce the same result.
+  bool matches = true;
+  auto regex_ns = 0.0;
+  auto tokenizer_ns = 0.0;
+  if (!debugstrs.empty()) {
+    regex_ns = TimeNanosPerLine(iterations, debugstrs.size(), [&]() {
+      int thread_id;
+      std::string text;
+      for (const auto* line : debugstrs) {
+        RegexParseDebugStr(*line, thread_id, text);
+      }
+    });
+    tokenizer_ns = TimeNanosPerLine(iterations, debugstrs.size(), [&]() {
+      for (const auto* line : debugstrs) {
+        NotificationDebugStr notification(line->c_str() + 9,
+                                          line->c_str() + line->size());
+      }
+    });
+
+    for (const auto* line : debugstrs) {
+      int thread_id = -1;
+      std::string text;
+      bool regex_ok = RegexParseDebugStr(*line, thread_id, text);
+      NotificationDebugStr notification(line->c_str() + 9,
+                                        line->c_str() + line->size());
+      if (regex_ok && (notification.thread_id != thread_id ||
+                       notification.text != text)) {
+        fprintf(stderr, "Mismatch parsing '%s'\n", line->c_str());
+        matches = false;
+      }
+    }
+  }
+
+  printf("%zu notifications (%zu debugstr) x %d iterations\n", stream.size(),
+         debugstrs.size(), iterations);
+  printf("ParseXBDMNotification: %8.1f ns/notification, %zu unparsed\n",
+         parse_ns, unparsed / iterations);
+  if (!debugstrs.empty()) {
+    printf("debugstr regex       : %8.1f ns/line\n", regex_ns);
+    printf("debugstr tokenizer   : %8.1f ns/line (%.2fx)%s\n", tokenizer_ns,
+           regex_ns / tokenizer_ns, matches ? "" : "  OUTPUT MISMATCH");
+  }
+  return matches ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,76 @@
+// Compares UnswizzleRect against the reference xemu unswizzle_rect.
+//
+// Usage: unswizzle_benchmark [iterations]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "tracer/unswizzle.h"
+extern "C" {
+#include "swizzle.h"
+}
+
+static const int kDefaultIterations = 50;
+static const uint32_t kBytesPerPixel = 4;
+
+template <typename Func>
+static double TimeMillis(int iterations, Func&& func) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    func();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::milli>(elapsed).count() /
+         iterations;
+}
+
+static bool Benchmark(uint32_t width, uint32_t height, int iterations) {
+  auto pitch = width * kBytesPerPixel;
+  std::vector<uint8_t> src(pitch * height);
+  for (size_t i = 0; i < src.size(); ++i) {
+    src[i] = static_cast<uint8_t>(i * 31);
+  }
+  std::vector<uint8_t> reference(src.size());
+  std::vector<uint8_t> optimized(src.size());
+
+  auto reference_ms = TimeMillis(iterations, [&]() {
+    // Match the previous capture path, which allocated a fresh buffer for each
+    // image.
+    auto buffer = std::unique_ptr<uint8_t[]>(new uint8_t[src.size()]);
+    unswizzle_rect(src.data(), width, height, buffer.get(), pitch,
+                   kBytesPerPixel);
+    memcpy(reference.data(), buffer.get(), src.size());
+  });
+
+  auto optimized_ms = TimeMillis(iterations, [&]() {
+    auto buffer = GetUnswizzleScratchBuffer(src.size());
+    UnswizzleRect(src.data(), width, height, buffer, pitch, kBytesPerPixel);
+    memcpy(optimized.data(), buffer, src.size());
+  });
+
+  bool matches = reference == optimized;
+  printf("%4ux%-4u RGBA: unswizzle_rect %8.3f ms  UnswizzleRect %8.3f ms  "
+         "(%.2fx)%s\n",
+         width, height, reference_ms, optimized_ms,
+         reference_ms / optimized_ms, matches ? "" : "  OUTPUT MISMATCH");
+  return matches;
+}
+
+int main(int argc, const char* argv[]) {
+  int iterations = kDefaultIterations;
+  if (argc > 1) {
+    iterations = atoi(argv[1]);
+    if (iterations <= 0) {
+      fprintf(stderr, "Invalid iteration count '%s'\n", argv[1]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  bool ok = Benchmark(512, 512, iterations);
+  ok = Benchmark(1024, 1024, iterations) && ok;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,63 @@
+// Serves an XBDM session recorded with the shell's `capture` command so that
+// GDB sessions, syncs and traces may be benchmarked without hardware.
+//
+// Usage: xbdm_replay_server capture [port [latency_scale]]
+//
+// The server listens on the given port (731 by default) and delays each
+// response by the recorded latency multiplied by latency_scale (1 by default,
+// 0 to respond immediately). Statistics are printed on SIGINT or SIGTERM.
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+#include "net/ip_address.h"
+#include "rdcp/session_replay_server.h"
+
+static constexpr uint16_t kDefaultPort = 731;
+
+static volatile std::sig_atomic_t stop_requested = 0;
+
+static void OnSignal(int) { stop_requested = 1; }
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " capture [port [latency_scale]]"
+              << std::endl;
+    return 1;
+  }
+
+  auto port = argc > 2 ? static_cast<uint16_t>(strtoul(argv[2], nullptr, 0))
+                       : kDefaultPort;
+  double latency_scale = argc > 3 ? strtod(argv[3], nullptr) : 1.0;
+
+  SessionReplayServer server(latency_scale);
+  if (!server.Load(argv[1])) {
+    std::cerr << "Failed to load capture " << argv[1] << std::endl;
+    return 1;
+  }
+  if (!server.Start(IPAddress(port))) {
+    std::cerr << "Failed to listen on port " << port << std::endl;
+    return 1;
+  }
+
+  std::cout << "Replaying " << argv[1] << " on " << server.Address()
+            << " with latency scale " << latency_scale << std::endl;
+
+  signal(SIGINT, OnSignal);
+  signal(SIGTERM, OnSignal);
+  while (!stop_requested) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  server.Stop();
+
+  auto stats = server.GetStats();
+  std::cout << "Requests: " << stats.requests
+            << "\nReused exchanges: " << stats.reused_exchanges
+            << "\nUnmatched requests: " << stats.unmatched_requests
+            << "\nNotification streams: " << stats.notification_streams
+            << std::endl;
+  return 0;
+}